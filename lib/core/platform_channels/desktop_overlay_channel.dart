@@ -12,6 +12,13 @@ class DesktopOverlayChannel {
   Stream<Map<String, dynamic>>? _selectionEventStream;
   Stream<Map<String, dynamic>>? _clipboardEventStream;
 
+  /// The one subscription to the event channel. The native side has a single
+  /// handler and sink per channel, so every typed stream is filtered from
+  /// this one; the native monitors stop only when the last listener cancels.
+  late final Stream<Map<String, dynamic>> _events = _eventChannel
+      .receiveBroadcastStream()
+      .map((event) => Map<String, dynamic>.from(event as Map));
+
   Future<bool> showOverlay() async {
     if (!Platform.isWindows && !Platform.isMacOS) return false;
     try {
@@ -58,6 +65,69 @@ class DesktopOverlayChannel {
     }
   }
 
+  /// Sends any combination of geometry changes in one call. The native side
+  /// merges them with other pending changes and updates the window at most
+  /// once per display refresh, so prefer this over separate setters while
+  /// dragging or resizing.
+  Future<bool> applyGeometry({
+    double? x,
+    double? y,
+    double? width,
+    double? height,
+    bool? alwaysOnTop,
+    bool? minimized,
+  }) async {
+    if (!Platform.isWindows && !Platform.isMacOS) return false;
+    try {
+      return await _methodChannel.invokeMethod('applyGeometry', {
+        if (x != null) 'x': x,
+        if (y != null) 'y': y,
+        if (width != null) 'width': width,
+        if (height != null) 'height': height,
+        if (alwaysOnTop != null) 'alwaysOnTop': alwaysOnTop,
+        if (minimized != null) 'minimized': minimized,
+      }) ?? false;
+    } on PlatformException catch (e) {
+      print('Failed to apply overlay geometry: ${e.message}');
+      return false;
+    }
+  }
+
+  /// Keeps the overlay next to [target] in another application and moves it
+  /// natively as that target moves, scrolls or changes monitor. [target] is
+  /// `'focus'` (the focused element), `'selection'` (the focused element's
+  /// selected text) or `'window'` (the window [windowHandle]). [width] and
+  /// [height] are in logical pixels and scaled for the target's monitor.
+  Future<bool> anchorOverlay({
+    String target = 'focus',
+    int? windowHandle,
+    double? width,
+    double? height,
+  }) async {
+    if (!Platform.isWindows) return false;
+    try {
+      return await _methodChannel.invokeMethod('anchorOverlay', {
+        'target': target,
+        if (windowHandle != null) 'handle': windowHandle,
+        if (width != null) 'width': width,
+        if (height != null) 'height': height,
+      }) ?? false;
+    } on PlatformException catch (e) {
+      print('Failed to anchor overlay: ${e.message}');
+      return false;
+    }
+  }
+
+  Future<bool> detachOverlay() async {
+    if (!Platform.isWindows) return false;
+    try {
+      return await _methodChannel.invokeMethod('detachOverlay') ?? false;
+    } on PlatformException catch (e) {
+      print('Failed to detach overlay: ${e.message}');
+      return false;
+    }
+  }
+
   Future<bool> setAlwaysOnTop(bool alwaysOnTop) async {
     if (!Platform.isWindows && !Platform.isMacOS) return false;
     try {
@@ -149,9 +219,7 @@ class DesktopOverlayChannel {
     if (!Platform.isWindows && !Platform.isMacOS) {
       return const Stream.empty();
     }
-    _selectionEventStream ??= _eventChannel
-        .receiveBroadcastStream('selectionEvent')
-        .map((event) => Map<String, dynamic>.from(event as Map));
+    _selectionEventStream ??= _events.where((event) => event['type'] == 'selection');
     return _selectionEventStream!;
   }
 
@@ -159,9 +227,7 @@ class DesktopOverlayChannel {
     if (!Platform.isWindows && !Platform.isMacOS) {
       return const Stream.empty();
     }
-    _clipboardEventStream ??= _eventChannel
-        .receiveBroadcastStream('clipboardEvent')
-        .map((event) => Map<String, dynamic>.from(event as Map));
+    _clipboardEventStream ??= _events.where((event) => event['type'] == 'clipboard');
     return _clipboardEventStream!;
   }
 
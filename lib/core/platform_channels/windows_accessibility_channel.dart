@@ -1,9 +1,12 @@
 import 'dart:io';
+import 'dart:typed_data';
 import 'package:flutter/services.dart';
+import 'package:legalease/core/utils/memory_utils.dart';
 
 class WindowsAccessibilityChannel {
   static const MethodChannel _channel = MethodChannel('legalease_windows_accessibility');
   static const EventChannel _eventChannel = EventChannel('legalease_windows_accessibility_events');
+  static const EventChannel _memoryEventChannel = EventChannel('legalease_windows_memory_events');
   
   static final WindowsAccessibilityChannel _instance = WindowsAccessibilityChannel._internal();
   factory WindowsAccessibilityChannel() => _instance;
@@ -11,6 +14,20 @@ class WindowsAccessibilityChannel {
   
   Stream<Map<String, dynamic>>? _windowChangeStream;
   Stream<Map<String, dynamic>>? _tcContentStream;
+  Stream<Map<String, dynamic>>? _treeDeltaStream;
+  Stream<Map<String, dynamic>>? _windowTextStream;
+  Stream<Map<String, dynamic>>? _viewportTextStream;
+  Stream<Map<String, dynamic>>? _windowContentStream;
+  Stream<MemoryPressureLevel>? _memoryPressureStream;
+
+  /// The one subscription to the event channel. The native side has a single
+  /// handler and sink per channel, and cancelling it stops monitoring, so
+  /// every typed stream is filtered from this one; monitoring stops only
+  /// when the last listener cancels.
+  late final Stream<Map<String, dynamic>> _events = _eventChannel
+      .receiveBroadcastStream()
+      .map((event) => Map<String, dynamic>.from(event as Map));
+  final Map<int, String> _patchedTexts = {};
   
   Future<bool> isAvailable() async {
     if (!Platform.isWindows) return false;
@@ -58,6 +75,320 @@ class WindowsAccessibilityChannel {
     }
   }
   
+  /// Diffs the window's accessibility tree against the previous snapshot of
+  /// the same window and emits a `treeDelta` event when anything changed.
+  /// Defaults to the foreground window when [handle] is omitted.
+  Future<Map<String, dynamic>?> extractWindowDelta({int? handle}) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final args = <String, dynamic>{};
+      if (handle != null) args['handle'] = handle;
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('extractWindowDelta', args);
+      return result == null ? null : Map<String, dynamic>.from(result);
+    } on PlatformException {
+      return null;
+    }
+  }
+  
+  /// Fetches the window's text as insert/delete patches against the text
+  /// returned by the previous call for the same window. The returned map
+  /// always carries the reconstructed `text`; `patches` is present when the
+  /// native side sent a delta instead of the full string.
+  Future<Map<String, dynamic>?> extractScreenTextPatch({int? handle}) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final args = <String, dynamic>{};
+      if (handle != null) {
+        args['handle'] = handle;
+        args['reset'] = !_patchedTexts.containsKey(handle);
+      }
+      final raw = await _channel.invokeMethod<Map<dynamic, dynamic>>('extractScreenTextPatch', args);
+      if (raw == null || raw['success'] != true) return null;
+      final result = Map<String, dynamic>.from(raw);
+      final windowHandle = result['handle'] as int;
+
+      if (result['full'] == true) {
+        _patchedTexts[windowHandle] = result['text'] as String? ?? '';
+        return result;
+      }
+
+      final base = _patchedTexts[windowHandle];
+      if (base == null) {
+        // Lost our copy of the base text; ask for a fresh full extraction.
+        _patchedTexts.remove(windowHandle);
+        return extractScreenTextPatch(handle: windowHandle);
+      }
+      final text = applyTextPatches(base, result['patches'] as List<dynamic>);
+      _patchedTexts[windowHandle] = text;
+      result['text'] = text;
+      return result;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Returns the text currently visible in the window. The remainder of the
+  /// window follows on [viewportTextStream] in scroll order, one viewport
+  /// height at a time, ending with a `viewportTextComplete` event.
+  Future<String?> extractScreenTextViewportFirst({int? handle}) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final args = <String, dynamic>{};
+      if (handle != null) args['handle'] = handle;
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('extractScreenTextViewportFirst', args);
+      if (result == null || result['success'] != true) return null;
+      return result['text'] as String?;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Extracts text from several windows in parallel on native worker
+  /// threads. Returns the batch id; each window's result arrives on
+  /// [windowTextStream] as a `windowText` event as soon as it completes,
+  /// followed by one `extractWindowsComplete` event for the batch.
+  Future<int?> extractWindows(List<int> handles) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('extractWindows', {
+        'handles': handles,
+      });
+      if (result == null || result['success'] != true) return null;
+      return result['batchId'] as int;
+    } on PlatformException catch (e) {
+      print('Failed to extract windows: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Start-up milestones recorded by the runner. `marks` maps each
+  /// milestone (`main`, `first_frame`, `uia_ready`, ...) to microseconds since
+  /// process start; `automationState` is `notStarted`, `initializing`,
+  /// `ready` or `failed`.
+  Future<Map<String, dynamic>?> getStartupMetrics() async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getStartupMetrics');
+      if (result == null) return null;
+      return {
+        'marks': Map<String, int>.from(result['marks'] as Map),
+        'automationState': result['automationState'] as String,
+      };
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Returns the native extraction buffers' memory use: `extractions`,
+  /// `lastAllocations` (heap growths during the last extraction, 0 in steady
+  /// state), `peakBytes` and `retainedBytes`.
+  Future<Map<String, int>?> getExtractionMemoryStats() async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getExtractionMemoryStats');
+      if (result == null) return null;
+      return Map<String, int>.from(result);
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Prepares a rendered page for OCR natively, in memory: grayscale,
+  /// downscale from [sourceDpi] to [targetDpi], adaptive binarisation,
+  /// deskew and crop to the inked area. [rgba] is raw RGBA as produced by
+  /// `Image.toByteData(format: ImageByteFormat.rawRgba)`.
+  ///
+  /// Returns `pixels` (8-bit grayscale, one byte per pixel, no row padding),
+  /// `width`, `height`, `skewDegrees` (the skew removed), the crop rectangle
+  /// `cropX`/`cropY`/`cropWidth`/`cropHeight` in scaled-page pixels, and
+  /// `elapsedMicros`; or null off Windows or on failure.
+  Future<Map<String, dynamic>?> preprocessImageForOcr(
+    Uint8List rgba, {
+    required int width,
+    required int height,
+    int? stride,
+    int sourceDpi = 300,
+    int targetDpi = 300,
+    bool binarize = true,
+    bool deskew = true,
+    bool crop = true,
+  }) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('preprocessImageForOcr', {
+        'pixels': rgba,
+        'width': width,
+        'height': height,
+        'stride': stride ?? width * 4,
+        'sourceDpi': sourceDpi,
+        'targetDpi': targetDpi,
+        'binarize': binarize,
+        'deskew': deskew,
+        'crop': crop,
+      });
+      if (result == null || result['success'] != true) return null;
+      return Map<String, dynamic>.from(result);
+    } on PlatformException catch (e) {
+      print('Failed to preprocess image: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Writes an analysis report PDF to [path] natively, page by page, from a
+  /// buffer made by `AnalysisReportBuffer.encode`. Fonts are subset from the
+  /// Windows font directory and embedded.
+  ///
+  /// Returns `pages`, `bytes` and `elapsedMicros`; or null off Windows or
+  /// on failure, in which case no file is left at [path].
+  Future<Map<String, dynamic>?> writeAnalysisReport(Uint8List report, String path) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('writeAnalysisReport', {
+        'report': report,
+        'path': path,
+      });
+      if (result == null || result['success'] != true) return null;
+      return Map<String, dynamic>.from(result);
+    } on PlatformException catch (e) {
+      print('Failed to write report: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Splits [text] into sentences and clauses natively, reading legal
+  /// abbreviations ("Inc.", "U.S.C.", "et seq.") and references
+  /// ("§ 4.2(a)") as part of a sentence, and measures readability in the
+  /// same pass.
+  ///
+  /// Returns `sentences` and `clauses` as flat `Int32List`s of start/end
+  /// pairs in UTF-16 code units, `words`, `syllables`,
+  /// `passiveConstructions`, `passiveSentences`, `averageSentenceWords`,
+  /// `fleschReadingEase`, `fleschKincaidGrade` and `elapsedMicros`; or null
+  /// off Windows or on failure.
+  Future<Map<String, dynamic>?> segmentText(String text) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('segmentText', {
+        'text': text,
+      });
+      if (result == null) return null;
+      return Map<String, dynamic>.from(result);
+    } on PlatformException catch (e) {
+      print('Failed to segment text: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Health of the UI Automation providers the app has read from, per
+  /// process. `abandonedCalls` counts calls the native watchdog gave up on;
+  /// each entry of `processes` has `processId`, `state` (`closed`, `open`
+  /// while the process is skipped, or `halfOpen` while one probe call is
+  /// in flight), `consecutiveFailures`, `successes`, `failures`,
+  /// `timeouts`, `rejected`, `retryInMillis` and `lastLatencyMicros`.
+  Future<Map<String, dynamic>?> getProviderHealth() async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getProviderHealth');
+      if (result == null) return null;
+      return {
+        'abandonedCalls': result['abandonedCalls'] as int,
+        'processes': [
+          for (final process in result['processes'] as List) Map<String, dynamic>.from(process as Map),
+        ],
+      };
+    } on PlatformException catch (e) {
+      print('Failed to get provider health: ${e.message}');
+      return null;
+    }
+  }
+
+  /// State of the native refresh scheduler, which re-reads monitored
+  /// windows while monitoring is on. `active` is false when it is not
+  /// running; otherwise `refreshes`, `changes` and `failures` count checks
+  /// so far, and each entry of `windows` has `handle`, `foreground`,
+  /// `visible` and the `intervalMillis` its next check is scheduled with.
+  Future<Map<String, dynamic>?> getRefreshStats() async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getRefreshStats');
+      if (result == null) return null;
+      return {
+        ...Map<String, dynamic>.from(result),
+        if (result['windows'] != null)
+          'windows': [
+            for (final window in result['windows'] as List) Map<String, dynamic>.from(window as Map),
+          ],
+      };
+    } on PlatformException catch (e) {
+      print('Failed to get refresh stats: ${e.message}');
+      return null;
+    }
+  }
+
+  /// The native memory governor's budget and usage. `level` is `none`,
+  /// `moderate` or `critical`; `budgetBytes`, `bytes`, `peakBytes`,
+  /// `pendingBytes`, `evictions` and `evictedBytes` cover all native caches,
+  /// and each entry of `pools` has `name`, `priority` (`low`, `high` or
+  /// `pinned`), `bytes`, `entries`, `evictions` and `evictedBytes`.
+  Future<Map<String, dynamic>?> getMemoryBudget() async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>('getMemoryBudget');
+      return result == null ? null : _memoryBudgetFromMap(result);
+    } on PlatformException catch (e) {
+      print('Failed to get memory budget: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Sets the native memory budget and returns the state as
+  /// [getMemoryBudget] does. Lowering it below current usage evicts at once.
+  Future<Map<String, dynamic>?> setMemoryBudget(int budgetBytes) async {
+    if (!Platform.isWindows) return null;
+    try {
+      final result = await _channel.invokeMethod<Map<dynamic, dynamic>>(
+        'setMemoryBudget',
+        {'budgetBytes': budgetBytes},
+      );
+      return result == null ? null : _memoryBudgetFromMap(result);
+    } on PlatformException catch (e) {
+      print('Failed to set memory budget: ${e.message}');
+      return null;
+    }
+  }
+
+  static Map<String, dynamic> _memoryBudgetFromMap(Map<dynamic, dynamic> result) {
+    return {
+      ...Map<String, dynamic>.from(result),
+      'pools': [
+        for (final pool in result['pools'] as List) Map<String, dynamic>.from(pool as Map),
+      ],
+    };
+  }
+
+  /// Applies native text patches in order. Offsets are UTF-16 code units in
+  /// the text as it stands after the preceding patches.
+  static String applyTextPatches(String text, List<dynamic> patches) {
+    final buffer = StringBuffer();
+    var current = text;
+    for (final raw in patches) {
+      final patch = Map<String, dynamic>.from(raw as Map);
+      final offset = patch['offset'] as int;
+      buffer
+        ..clear()
+        ..write(current.substring(0, offset));
+      if (patch['op'] == 'insert') {
+        buffer
+          ..write(patch['text'] as String)
+          ..write(current.substring(offset));
+      } else {
+        buffer.write(current.substring(offset + (patch['length'] as int)));
+      }
+      current = buffer.toString();
+    }
+    return current;
+  }
+  
   Future<bool> showOverlay({String? title, String? content}) async {
     if (!Platform.isWindows) return false;
     try {
@@ -84,9 +415,7 @@ class WindowsAccessibilityChannel {
     if (!Platform.isWindows) {
       return const Stream.empty();
     }
-    _windowChangeStream ??= _eventChannel
-        .receiveBroadcastStream('windowChange')
-        .map((event) => Map<String, dynamic>.from(event as Map));
+    _windowChangeStream ??= _events.where((event) => event['type'] == 'foregroundWindowChanged');
     return _windowChangeStream!;
   }
   
@@ -94,15 +423,78 @@ class WindowsAccessibilityChannel {
     if (!Platform.isWindows) {
       return const Stream.empty();
     }
-    _tcContentStream ??= _eventChannel
-        .receiveBroadcastStream('tcContent')
-        .map((event) => Map<String, dynamic>.from(event as Map));
+    _tcContentStream ??= windowContentStream.where((event) => event['hasTCKeywords'] == true);
     return _tcContentStream!;
   }
+
+  /// Text of a monitored window whenever the native refresh scheduler finds
+  /// it changed, with `handle`, `windowTitle`, `text`, `hasTCKeywords` and
+  /// `hasPrivacyKeywords`.
+  Stream<Map<String, dynamic>> get windowContentStream {
+    if (!Platform.isWindows) {
+      return const Stream.empty();
+    }
+    _windowContentStream ??= _events.where((event) => event['type'] == 'windowContentChanged');
+    return _windowContentStream!;
+  }
+  
+  Stream<Map<String, dynamic>> get treeDeltaStream {
+    if (!Platform.isWindows) {
+      return const Stream.empty();
+    }
+    _treeDeltaStream ??= _events.where((event) => event['type'] == 'treeDelta');
+    return _treeDeltaStream!;
+  }
   
+  Stream<Map<String, dynamic>> get windowTextStream {
+    if (!Platform.isWindows) {
+      return const Stream.empty();
+    }
+    _windowTextStream ??= _events
+        .where((event) => event['type'] == 'windowText' || event['type'] == 'extractWindowsComplete');
+    return _windowTextStream!;
+  }
+  
+  Stream<Map<String, dynamic>> get viewportTextStream {
+    if (!Platform.isWindows) {
+      return const Stream.empty();
+    }
+    _viewportTextStream ??= _events
+        .where((event) => event['type'] == 'viewportText' || event['type'] == 'viewportTextComplete');
+    return _viewportTextStream!;
+  }
+  
+  /// The native memory governor's pressure level: the current one on
+  /// listening, then each change. Listening does not start monitoring.
+  Stream<MemoryPressureLevel> get memoryPressureStream {
+    if (!Platform.isWindows) {
+      return const Stream.empty();
+    }
+    _memoryPressureStream ??= _memoryEventChannel
+        .receiveBroadcastStream()
+        .map((event) => Map<String, dynamic>.from(event as Map))
+        .where((event) => event['type'] == 'memoryPressure')
+        .map((event) {
+          switch (event['level']) {
+            case 'critical':
+              return MemoryPressureLevel.critical;
+            case 'moderate':
+              return MemoryPressureLevel.moderate;
+            default:
+              return MemoryPressureLevel.none;
+          }
+        });
+    return _memoryPressureStream!;
+  }
+
   Future<void> dispose() async {
     await stopMonitoring();
     _windowChangeStream = null;
     _tcContentStream = null;
+    _treeDeltaStream = null;
+    _windowTextStream = null;
+    _viewportTextStream = null;
+    _windowContentStream = null;
+    _patchedTexts.clear();
   }
 }
\ No newline at end of file
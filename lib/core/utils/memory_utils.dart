@@ -60,11 +60,11 @@ enum MemoryPressureLevel {
   critical,
 }
 
-/// A monitor for system memory pressure levels.
+/// A monitor for memory pressure levels.
 ///
-/// This is a stub implementation that always reports no memory pressure.
-/// Platform-specific implementations should override [currentLevel] to
-/// provide actual memory pressure information.
+/// Reports [MemoryPressureLevel.none] until a platform source is attached.
+/// On Windows the app attaches the native memory governor's levels, which
+/// reflect the native caches and buffers against their shared budget.
 ///
 /// Example:
 /// ```dart
@@ -75,19 +75,38 @@ enum MemoryPressureLevel {
 /// };
 /// ```
 class MemoryPressureMonitor {
+  static MemoryPressureLevel _currentLevel = MemoryPressureLevel.none;
+  static StreamSubscription<MemoryPressureLevel>? _subscription;
+
   /// The current memory pressure level.
-  ///
-  /// Returns [MemoryPressureLevel.none] in this stub implementation.
-  static MemoryPressureLevel get currentLevel => MemoryPressureLevel.none;
+  static MemoryPressureLevel get currentLevel => _currentLevel;
 
   /// Whether the system is currently under any memory pressure.
   static bool get isUnderPressure => currentLevel != MemoryPressureLevel.none;
 
   /// Callback invoked when memory pressure level changes.
-  ///
-  /// Platform-specific implementations should call this when the
-  /// system memory pressure state changes.
   static void Function(MemoryPressureLevel)? onLevelChanged;
+
+  /// Follows the levels reported by [levels], replacing any source
+  /// attached before.
+  static void attach(Stream<MemoryPressureLevel> levels) {
+    _subscription?.cancel();
+    _subscription = levels.listen(report);
+  }
+
+  /// Stops following the attached source and reports no pressure.
+  static Future<void> detach() async {
+    await _subscription?.cancel();
+    _subscription = null;
+    report(MemoryPressureLevel.none);
+  }
+
+  /// Sets the current level, calling [onLevelChanged] if it changed.
+  static void report(MemoryPressureLevel level) {
+    if (level == _currentLevel) return;
+    _currentLevel = level;
+    onLevelChanged?.call(level);
+  }
 }
 
 /// A pool that limits the number of concurrent operations.
@@ -1,8 +1,10 @@
 import 'dart:io';
+import 'dart:ui';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:legalease/features/document_scan/data/models/ocr_result_model.dart';
 import 'package:legalease/features/document_scan/data/services/document_processor.dart';
 import 'package:legalease/features/document_scan/data/services/ocr_service.dart';
+import 'package:legalease/features/document_scan/data/services/page_pipeline.dart';
 import 'package:legalease/shared/models/document_model.dart';
 import 'package:legalease/shared/providers/ocr_provider.dart';
 
@@ -26,8 +28,7 @@ class DocumentRepositoryImpl implements DocumentRepository {
       List<OcrResultModel> ocrResults = [];
 
       if (_processor.isPdfFile(file)) {
-        final images = await _processor.pdfToImages(file);
-        ocrResults = await _ocrService.extractTextFromImages(images);
+        ocrResults = await _recognizePdfPages(file);
         extractedText = ocrResults.map((r) => r.text).join('\n\n');
       } else if (_processor.isImageFile(file)) {
         final result = await _ocrService.extractTextFromImage(file);
@@ -56,6 +57,50 @@ class DocumentRepositoryImpl implements DocumentRepository {
     }
   }
 
+  /// Renders and recognises PDF pages as a pipeline: the next page renders
+  /// while earlier ones are in OCR, and each rendered page is deleted once
+  /// recognised, so only a few pages exist at a time.
+  Future<List<OcrResultModel>> _recognizePdfPages(File file) async {
+    final renderer = await _processor.openPageRenderer(file);
+    try {
+      final pipeline = PagePipeline(stages: [
+        PipelineStage('render', (_, page) async {
+          try {
+            return await renderer.render(page);
+          } catch (_) {
+            return null;
+          }
+        }),
+        PipelineStage('ocr', (image, page) async {
+          return image == null ? null : _recognizePage(renderer, image as File, page);
+        }, concurrency: 2),
+      ]);
+      // Pages that fail to render are skipped, as before.
+      final results = await pipeline.run<OcrResultModel?>(renderer.pageCount).toList();
+      return results.whereType<OcrResultModel>().toList();
+    } finally {
+      renderer.dispose();
+    }
+  }
+
+  Future<OcrResultModel> _recognizePage(PdfPageRenderer renderer, File image, int pageIndex) async {
+    try {
+      final result = await _ocrService.extractTextFromImage(image);
+      return result.copyWith(pageIndex: pageIndex);
+    } catch (_) {
+      return OcrResultModel(
+        text: '',
+        blocks: [],
+        imageSize: Size.zero,
+        processingTime: Duration.zero,
+        filePath: image.path,
+        pageIndex: pageIndex,
+      );
+    } finally {
+      await renderer.release(image);
+    }
+  }
+
   @override
   Future<DocumentModel?> processImages(
     List<File> images,
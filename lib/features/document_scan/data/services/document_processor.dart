@@ -1,7 +1,8 @@
 import 'dart:async';
 import 'dart:io';
-import 'dart:typed_data';
 import 'dart:ui';
+import 'package:legalease/core/utils/memory_utils.dart' as memory;
+import 'package:legalease/features/document_scan/data/services/pdf_text_streamer.dart';
 import 'package:legalease/shared/models/document_model.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:syncfusion_flutter_pdf/pdf.dart';
@@ -93,12 +94,62 @@ class DocumentSection {
       };
 }
 
+/// Renders the pages of one open PDF on demand; see
+/// [DocumentProcessor.openPageRenderer].
+class PdfPageRenderer {
+  final DocumentProcessor _owner;
+  final PdfDocument _document;
+  final Directory _tempDir;
+  final int dpi;
+
+  PdfPageRenderer._(this._owner, this._document, this._tempDir, this.dpi);
+
+  int get pageCount => _document.pages.count.clamp(0, DocumentProcessor._maxPageCount);
+
+  Future<File> render(int index) async {
+    final page = _document.pages[index];
+    final template = page.createTemplate();
+    final newDoc = PdfDocument();
+    final newPage = newDoc.pages.add();
+    newPage.graphics.drawPdfTemplate(
+      template,
+      const Offset(0, 0),
+      Size(
+        page.size.width * dpi / 72,
+        page.size.height * dpi / 72,
+      ),
+    );
+
+    final pdfBytes = await newDoc.save();
+    newDoc.dispose();
+
+    final file = File('${_tempDir.path}/pdf_page_$index.pdf');
+    await file.writeAsBytes(pdfBytes);
+    _owner._tempFiles.add(file.path);
+    return file;
+  }
+
+  /// Deletes a rendered page once it is no longer needed, rather than
+  /// keeping every page on disk until [DocumentProcessor.cleanupTempFiles].
+  Future<void> release(File page) async {
+    _owner._tempFiles.remove(page.path);
+    try {
+      await page.delete();
+    } catch (_) {}
+  }
+
+  void dispose() {
+    _document.dispose();
+  }
+}
+
 class DocumentProcessor {
   static const int _defaultDpi = 200;
   static const int _maxPageCount = 50;
   static const int _defaultBatchSize = 10;
   static const int _defaultMaxMemoryBytes = 50 * 1024 * 1024;
 
+  final PdfTextStreamer _pdfTextStreamer = PdfTextStreamer();
   final Set<String> _tempFiles = {};
   bool _isDisposed = false;
 
@@ -109,53 +160,42 @@ class DocumentProcessor {
     CancellationToken? cancellationToken,
     int batchSize = _defaultBatchSize,
   }) async {
-    final bytes = await pdfFile.readAsBytes();
-    final document = PdfDocument(inputBytes: bytes);
+    final renderer = await openPageRenderer(pdfFile, dpi: dpi);
     final images = <File>[];
-    final tempDir = await getTemporaryDirectory();
+    final pageCount = renderer.pageCount;
 
-    final pageCount = document.pages.count.clamp(0, _maxPageCount);
+    try {
+      for (var i = 0; i < pageCount; i++) {
+        cancellationToken?.throwIfCancelled();
 
-    for (var i = 0; i < pageCount; i++) {
-      cancellationToken?.throwIfCancelled();
+        onProgress?.call(i + 1, pageCount, 'Processing page ${i + 1} of $pageCount');
 
-      onProgress?.call(i + 1, pageCount, 'Processing page ${i + 1} of $pageCount');
-
-      if (i > 0 && i % batchSize == 0) {
-        await Future.delayed(const Duration(milliseconds: 10));
-      }
-
-      try {
-        final page = document.pages[i];
-        final template = page.createTemplate();
-        final newDoc = PdfDocument();
-        final newPage = newDoc.pages.add();
-        newPage.graphics.drawPdfTemplate(
-          template,
-          const Offset(0, 0),
-          Size(
-            page.size.width * dpi / 72,
-            page.size.height * dpi / 72,
-          ),
-        );
-
-        final pdfBytes = await newDoc.save();
-        newDoc.dispose();
+        if (i > 0 && i % batchSize == 0) {
+          await Future.delayed(const Duration(milliseconds: 10));
+        }
 
-        final file = File('${tempDir.path}/pdf_page_$i.pdf');
-        await file.writeAsBytes(pdfBytes);
-        _tempFiles.add(file.path);
-        images.add(file);
-      } catch (e) {
-        if (e is CancellationException) rethrow;
-        continue;
+        try {
+          images.add(await renderer.render(i));
+        } catch (e) {
+          if (e is CancellationException) rethrow;
+          continue;
+        }
       }
+    } finally {
+      renderer.dispose();
     }
-
-    document.dispose();
     return images;
   }
 
+  /// Opens [pdfFile] for rendering one page at a time, so rendering can
+  /// overlap later stages instead of finishing for every page first. At most
+  /// 50 pages are rendered. Dispose the renderer when done.
+  Future<PdfPageRenderer> openPageRenderer(File pdfFile, {int dpi = _defaultDpi}) async {
+    final bytes = await pdfFile.readAsBytes();
+    final tempDir = await getTemporaryDirectory();
+    return PdfPageRenderer._(this, PdfDocument(inputBytes: bytes), tempDir, dpi);
+  }
+
   Future<List<File>> extractPdfPages(
     File pdfFile, {
     ProgressCallback? onProgress,
@@ -458,6 +498,20 @@ class DocumentProcessor {
     return text;
   }
 
+  /// Emits the text of each page as it is read, without loading the whole
+  /// file. Throws [PdfStreamingException] for files the streamer cannot read.
+  Stream<PdfPageText> extractPdfPagesStreaming(
+    File pdfFile, {
+    CancellationToken? cancellationToken,
+  }) {
+    return _pdfTextStreamer.extract(pdfFile, cancellationToken: cancellationToken);
+  }
+
+  /// Extracts all page text, reading the file page by page so memory does not
+  /// grow with the document. Files the streamer cannot read (encrypted or with
+  /// a damaged cross-reference table) are parsed whole instead, which is only
+  /// allowed up to [maxMemoryBytes], halved under moderate memory pressure
+  /// and quartered under critical pressure.
   Future<String> extractTextFromPdfStreaming(
     File pdfFile, {
     int maxMemoryBytes = _defaultMaxMemoryBytes,
@@ -465,44 +519,74 @@ class DocumentProcessor {
     ProgressCallback? onProgress,
     CancellationToken? cancellationToken,
   }) async {
-    final fileStream = pdfFile.openRead();
-    final chunks = <int>[];
-    int totalBytesRead = 0;
-
-    await for (final chunk in fileStream) {
-      cancellationToken?.throwIfCancelled();
-
-      totalBytesRead += chunk.length;
-      if (totalBytesRead > maxMemoryBytes) {
-        throw Exception('PDF exceeds maximum memory limit of $maxMemoryBytes bytes');
+    final textBuffer = StringBuffer();
+    try {
+      await for (final page in extractPdfPagesStreaming(pdfFile, cancellationToken: cancellationToken)) {
+        onProgress?.call(
+          page.pageIndex + 1,
+          page.pageCount,
+          'Extracting text from page ${page.pageIndex + 1} of ${page.pageCount}',
+        );
+        if (page.pageIndex > 0) textBuffer.write('\n');
+        textBuffer.write(page.text);
       }
-      chunks.addAll(chunk);
+      return textBuffer.toString();
+    } on PdfStreamingException {
+      return _extractTextFromPdfInMemory(
+        pdfFile,
+        maxMemoryBytes: maxMemoryBytes,
+        batchSize: batchSize,
+        onProgress: onProgress,
+        cancellationToken: cancellationToken,
+      );
+    }
+  }
+
+  Future<String> _extractTextFromPdfInMemory(
+    File pdfFile, {
+    required int maxMemoryBytes,
+    required int batchSize,
+    ProgressCallback? onProgress,
+    CancellationToken? cancellationToken,
+  }) async {
+    cancellationToken?.throwIfCancelled();
+    final limit = switch (checkMemoryPressure()) {
+      MemoryPressureLevel.none => maxMemoryBytes,
+      MemoryPressureLevel.moderate => maxMemoryBytes ~/ 2,
+      MemoryPressureLevel.critical => maxMemoryBytes ~/ 4,
+    };
+    final length = await pdfFile.length();
+    if (length > limit) {
+      throw Exception('PDF exceeds maximum memory limit of $limit bytes');
     }
 
-    final bytes = Uint8List.fromList(chunks);
+    final bytes = await pdfFile.readAsBytes();
     final document = PdfDocument(inputBytes: bytes);
     final pageCount = document.pages.count;
     final textBuffer = StringBuffer();
 
-    for (var i = 0; i < pageCount; i++) {
-      cancellationToken?.throwIfCancelled();
+    try {
+      for (var i = 0; i < pageCount; i++) {
+        cancellationToken?.throwIfCancelled();
 
-      onProgress?.call(i + 1, pageCount, 'Extracting text from page ${i + 1} of $pageCount');
+        onProgress?.call(i + 1, pageCount, 'Extracting text from page ${i + 1} of $pageCount');
 
-      if (i > 0 && i % batchSize == 0) {
-        await Future.delayed(const Duration(milliseconds: 10));
-      }
+        if (i > 0 && i % batchSize == 0) {
+          await Future.delayed(const Duration(milliseconds: 10));
+        }
 
-      try {
-        final pageText = PdfTextExtractor(document).extractText(startPageIndex: i, endPageIndex: i);
-        textBuffer.write(pageText);
-      } catch (e) {
-        if (e is CancellationException) rethrow;
-        continue;
+        try {
+          final pageText = PdfTextExtractor(document).extractText(startPageIndex: i, endPageIndex: i);
+          if (i > 0) textBuffer.write('\n');
+          textBuffer.write(pageText);
+        } catch (e) {
+          if (e is CancellationException) rethrow;
+          continue;
+        }
       }
+    } finally {
+      document.dispose();
     }
-
-    document.dispose();
     return textBuffer.toString();
   }
 
@@ -521,7 +605,14 @@ class DocumentProcessor {
   }
 
   MemoryPressureLevel checkMemoryPressure() {
-    return MemoryPressureLevel.none;
+    switch (memory.MemoryPressureMonitor.currentLevel) {
+      case memory.MemoryPressureLevel.none:
+        return MemoryPressureLevel.none;
+      case memory.MemoryPressureLevel.moderate:
+        return MemoryPressureLevel.moderate;
+      case memory.MemoryPressureLevel.critical:
+        return MemoryPressureLevel.critical;
+    }
   }
 
   void dispose() {
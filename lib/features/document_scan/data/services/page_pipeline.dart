@@ -0,0 +1,314 @@
+import 'dart:async';
+import 'dart:collection';
+import 'dart:io';
+import 'dart:isolate';
+import 'dart:math' as math;
+
+import 'package:legalease/features/document_scan/data/services/document_processor.dart';
+
+typedef PageStageFunction = Future<Object?> Function(Object? input, int pageIndex);
+
+/// One step of a [PagePipeline]. Up to [concurrency] pages are in [process]
+/// at once; each receives the previous stage's output for the page (the page
+/// index itself for the first stage).
+class PipelineStage {
+  final String name;
+  final PageStageFunction process;
+  final int concurrency;
+
+  const PipelineStage(this.name, this.process, {this.concurrency = 1});
+
+  /// A CPU-bound stage run on background isolates, by default one per core.
+  /// [compute] and the values it receives must be sendable between isolates,
+  /// e.g. a top-level or static function working on bytes.
+  factory PipelineStage.isolate(
+    String name,
+    FutureOr<Object?> Function(Object? input, int pageIndex) compute, {
+    int? concurrency,
+  }) {
+    return PipelineStage(
+      name,
+      (input, pageIndex) => Isolate.run(() => compute(input, pageIndex)),
+      concurrency: concurrency ?? Platform.numberOfProcessors,
+    );
+  }
+}
+
+class PipelineStats {
+  final int pages;
+  final Duration elapsed;
+
+  /// Most pages admitted but not yet delivered at any one time.
+  final int peakInFlight;
+
+  /// Time spent inside each stage, summed over its concurrent slots.
+  final Map<String, Duration> stageBusy;
+
+  const PipelineStats({
+    required this.pages,
+    required this.elapsed,
+    required this.peakInFlight,
+    required this.stageBusy,
+  });
+
+  double get pagesPerSecond => elapsed.inMicroseconds == 0 ? 0 : pages * 1e6 / elapsed.inMicroseconds;
+}
+
+/// Runs pages through a sequence of stages concurrently, so rendering the
+/// next page overlaps recognising the current one instead of every page
+/// being rendered before any is recognised.
+///
+/// Stages are joined by queues holding at most [queueCapacity] pages; a
+/// stage that gets ahead waits for the one after it. At most [maxInFlight]
+/// pages are admitted and not yet delivered, which bounds memory however
+/// long the document is and however unevenly pages finish. Output is in
+/// page order. A stage error or cancellation stops the run and surfaces on
+/// the returned stream.
+class PagePipeline {
+  final List<PipelineStage> stages;
+  final int queueCapacity;
+  final int maxInFlight;
+
+  /// Statistics of the most recent run, available once its stream is done.
+  PipelineStats? lastStats;
+
+  PagePipeline({
+    required this.stages,
+    this.queueCapacity = 2,
+    int? maxInFlight,
+  }) : maxInFlight = maxInFlight ??
+            stages.fold<int>(0, (total, stage) => total + math.max(1, stage.concurrency) + queueCapacity) {
+    if (stages.isEmpty) {
+      throw ArgumentError.value(stages, 'stages', 'must not be empty');
+    }
+  }
+
+  /// Processes pages `0..pageCount - 1` and emits the last stage's output
+  /// for each, in order. Work stops when the listener cancels.
+  Stream<T> run<T>(int pageCount, {CancellationToken? cancellationToken}) async* {
+    if (pageCount <= 0) return;
+    cancellationToken?.throwIfCancelled();
+
+    final run = _PipelineRun(this, pageCount, cancellationToken)..start();
+    try {
+      for (var i = 0; i < pageCount; i++) {
+        cancellationToken?.throwIfCancelled();
+        final value = await run.result(i);
+        run.delivered(i);
+        yield value as T;
+      }
+    } finally {
+      run.stop();
+      lastStats = run.stats();
+    }
+  }
+}
+
+class _PageItem {
+  final int pageIndex;
+  final Object? value;
+  const _PageItem(this.pageIndex, this.value);
+}
+
+/// FIFO with a capacity: [put] waits while it is full and [take] waits while
+/// it is empty. After [close], [take] drains what is left and then returns
+/// null; [abort] also discards it and releases waiting producers.
+class _BoundedQueue<T extends Object> {
+  final int capacity;
+  final Queue<T> _items = Queue<T>();
+  final Queue<Completer<void>> _producers = Queue<Completer<void>>();
+  final Queue<Completer<T?>> _consumers = Queue<Completer<T?>>();
+  bool _closed = false;
+
+  _BoundedQueue(int capacity) : capacity = math.max(1, capacity);
+
+  Future<void> put(T item) async {
+    while (_items.length >= capacity && !_closed) {
+      final slot = Completer<void>();
+      _producers.add(slot);
+      await slot.future;
+    }
+    if (_closed) return;
+    if (_consumers.isNotEmpty) {
+      _consumers.removeFirst().complete(item);
+    } else {
+      _items.add(item);
+    }
+  }
+
+  Future<T?> take() {
+    if (_items.isNotEmpty) {
+      final item = _items.removeFirst();
+      if (_producers.isNotEmpty) _producers.removeFirst().complete();
+      return Future.value(item);
+    }
+    if (_closed) return Future.value(null);
+    final waiter = Completer<T?>();
+    _consumers.add(waiter);
+    return waiter.future;
+  }
+
+  void close() {
+    _closed = true;
+    // Consumers only wait on an empty queue, so none is owed an item.
+    while (_consumers.isNotEmpty) {
+      _consumers.removeFirst().complete(null);
+    }
+  }
+
+  void abort() {
+    _items.clear();
+    close();
+    while (_producers.isNotEmpty) {
+      _producers.removeFirst().complete();
+    }
+  }
+}
+
+class _PipelineRun {
+  final PagePipeline _pipeline;
+  final int _pageCount;
+  final CancellationToken? _cancellationToken;
+
+  final List<_BoundedQueue<_PageItem>> _queues = [];
+  final List<int> _activeWorkers = [];
+  final List<int> _busyMicros = [];
+  // Results of finished pages until they are delivered, plus the page the
+  // stream is waiting for.
+  final Map<int, Completer<Object?>> _results = {};
+  final Stopwatch _clock = Stopwatch();
+
+  int _delivered = 0;
+  int _peakInFlight = 0;
+  Completer<void>? _admission;
+  Object? _error;
+  StackTrace? _errorStack;
+  bool _stopped = false;
+
+  _PipelineRun(this._pipeline, this._pageCount, this._cancellationToken);
+
+  void start() {
+    _clock.start();
+    final stages = _pipeline.stages;
+    for (var s = 0; s < stages.length; s++) {
+      _queues.add(_BoundedQueue<_PageItem>(_pipeline.queueCapacity));
+      _activeWorkers.add(math.max(1, stages[s].concurrency));
+      _busyMicros.add(0);
+    }
+    unawaited(_feed());
+    for (var s = 0; s < stages.length; s++) {
+      for (var w = 0; w < _activeWorkers[s]; w++) {
+        unawaited(_work(s));
+      }
+    }
+  }
+
+  Future<Object?> result(int pageIndex) {
+    if (_error != null) return Future.error(_error!, _errorStack);
+    return _results.putIfAbsent(pageIndex, Completer<Object?>.new).future;
+  }
+
+  void delivered(int pageIndex) {
+    _results.remove(pageIndex);
+    _delivered = pageIndex + 1;
+    _wakeAdmission();
+  }
+
+  void stop() {
+    _stopped = true;
+    for (final queue in _queues) {
+      queue.abort();
+    }
+    _wakeAdmission();
+  }
+
+  PipelineStats stats() {
+    _clock.stop();
+    return PipelineStats(
+      pages: _delivered,
+      elapsed: _clock.elapsed,
+      peakInFlight: _peakInFlight,
+      stageBusy: {
+        for (var s = 0; s < _pipeline.stages.length; s++)
+          _pipeline.stages[s].name: Duration(microseconds: _busyMicros[s]),
+      },
+    );
+  }
+
+  void _wakeAdmission() {
+    final admission = _admission;
+    _admission = null;
+    admission?.complete();
+  }
+
+  void _checkCancelled() {
+    if (_cancellationToken?.isCancelled == true) {
+      throw const CancellationException();
+    }
+  }
+
+  void _fail(Object error, StackTrace stack) {
+    if (_stopped) return;
+    _error = error;
+    _errorStack = stack;
+    // Only the page the stream is waiting on has a listener; completing the
+    // others with an error would report it as unhandled.
+    final waiting = _results[_delivered];
+    if (waiting != null && !waiting.isCompleted) {
+      waiting.completeError(error, stack);
+    }
+    stop();
+  }
+
+  Future<void> _feed() async {
+    try {
+      for (var i = 0; i < _pageCount; i++) {
+        while (i - _delivered >= _pipeline.maxInFlight && !_stopped) {
+          final admission = Completer<void>();
+          _admission = admission;
+          await admission.future;
+        }
+        if (_stopped) return;
+        _checkCancelled();
+        _peakInFlight = math.max(_peakInFlight, i + 1 - _delivered);
+        await _queues.first.put(_PageItem(i, i));
+      }
+      _queues.first.close();
+    } catch (error, stack) {
+      _fail(error, stack);
+    }
+  }
+
+  Future<void> _work(int s) async {
+    final stage = _pipeline.stages[s];
+    final input = _queues[s];
+    final isLast = s == _queues.length - 1;
+    try {
+      while (true) {
+        final item = await input.take();
+        if (item == null || _stopped) break;
+        _checkCancelled();
+
+        final started = _clock.elapsedMicroseconds;
+        final value = await stage.process(item.value, item.pageIndex);
+        _busyMicros[s] += _clock.elapsedMicroseconds - started;
+        if (_stopped) break;
+
+        if (isLast) {
+          final result = _results.putIfAbsent(item.pageIndex, Completer<Object?>.new);
+          if (!result.isCompleted) result.complete(value);
+        } else {
+          await _queues[s + 1].put(_PageItem(item.pageIndex, value));
+        }
+      }
+    } catch (error, stack) {
+      _fail(error, stack);
+    } finally {
+      // The last worker of a stage to finish ends the next stage's input.
+      _activeWorkers[s]--;
+      if (_activeWorkers[s] == 0 && !isLast) {
+        _queues[s + 1].close();
+      }
+    }
+  }
+}
@@ -0,0 +1,1307 @@
+import 'dart:io';
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'package:legalease/features/document_scan/data/services/document_processor.dart';
+
+/// Text of one PDF page, emitted by [PdfTextStreamer] as soon as the page has
+/// been read.
+class PdfPageText {
+  final int pageIndex;
+  final int pageCount;
+  final String text;
+
+  /// Whether the page draws images. A page with images but no text is a
+  /// scanned page and needs OCR.
+  final bool hasImages;
+
+  const PdfPageText({
+    required this.pageIndex,
+    required this.pageCount,
+    required this.text,
+    this.hasImages = false,
+  });
+
+  bool get needsOcr => hasImages && text.trim().isEmpty;
+}
+
+/// Thrown when a file cannot be read by [PdfTextStreamer]: it is encrypted,
+/// its cross-reference table is missing or damaged, or a page shows text in
+/// fonts whose codes cannot be mapped to Unicode (such as Identity-H fonts
+/// without a ToUnicode CMap). Callers can fall back to a full-document
+/// parser.
+class PdfStreamingException implements Exception {
+  final String message;
+  const PdfStreamingException(this.message);
+
+  @override
+  String toString() => 'PdfStreamingException: $message';
+}
+
+/// Extracts PDF text one page at a time without loading the file.
+///
+/// Objects are read on demand through random access at the offsets given by
+/// the cross-reference table (classic tables, xref streams and compressed
+/// object streams are supported, including incremental updates). Each page's
+/// content streams are inflated and parsed on their own, so memory is bounded
+/// by the largest page rather than by the document, and image data of scanned
+/// pages is never read at all.
+class PdfTextStreamer {
+  /// Largest decoded stream held in memory; bigger streams are skipped.
+  final int maxStreamBytes;
+
+  /// Indirect objects kept resolved between pages (fonts, resources).
+  final int maxCachedObjects;
+
+  PdfTextStreamer({
+    this.maxStreamBytes = 32 * 1024 * 1024,
+    this.maxCachedObjects = 4096,
+  });
+
+  /// Emits the text of every page in order. Stops with a
+  /// [CancellationException] once [cancellationToken] is cancelled, and closes
+  /// the file however the stream ends.
+  Stream<PdfPageText> extract(File file, {CancellationToken? cancellationToken}) async* {
+    cancellationToken?.throwIfCancelled();
+    final raf = await file.open();
+    try {
+      final document = _PdfDocument(raf, maxStreamBytes, maxCachedObjects);
+      document.open();
+      final pages = document.pageList();
+      for (var i = 0; i < pages.length; i++) {
+        cancellationToken?.throwIfCancelled();
+        final extractor = _PageTextExtractor(document);
+        final text = extractor.extract(pages[i]);
+        yield PdfPageText(
+          pageIndex: i,
+          pageCount: pages.length,
+          text: text,
+          hasImages: extractor.hasImages,
+        );
+      }
+    } finally {
+      await raf.close();
+    }
+  }
+}
+
+class _PdfRef {
+  final int number;
+  final int generation;
+  const _PdfRef(this.number, this.generation);
+}
+
+class _PdfName {
+  final String value;
+  const _PdfName(this.value);
+
+  @override
+  bool operator ==(Object other) => other is _PdfName && other.value == value;
+
+  @override
+  int get hashCode => value.hashCode;
+}
+
+class _PdfString {
+  final Uint8List bytes;
+  const _PdfString(this.bytes);
+}
+
+/// A bare keyword: an operator in a content stream, or obj/R/stream and
+/// the like in the file body.
+class _PdfKeyword {
+  final String value;
+  const _PdfKeyword(this.value);
+}
+
+class _PdfStream {
+  final Map<String, Object?> dict;
+  // Absolute file offset of the data, or -1 for data already in [data].
+  final int offset;
+  final Uint8List? data;
+  const _PdfStream(this.dict, this.offset, this.data);
+}
+
+class _XrefEntry {
+  // 1: at file offset [a]; 2: index [b] of object stream [a].
+  final int type;
+  final int a;
+  final int b;
+  const _XrefEntry(this.type, this.a, this.b);
+}
+
+/// Signals that the lexer ran off the end of a window that is not the end of
+/// the file; the caller re-reads a larger window.
+class _NeedMoreData implements Exception {
+  const _NeedMoreData();
+}
+
+class _EndOfData {
+  const _EndOfData();
+}
+
+const _endOfData = _EndOfData();
+
+bool _isWhitespace(int c) => c == 0x20 || c == 0x0A || c == 0x0D || c == 0x09 || c == 0x0C || c == 0x00;
+
+bool _isDelimiter(int c) =>
+    c == 0x28 || c == 0x29 || c == 0x3C || c == 0x3E || c == 0x5B || c == 0x5D || c == 0x7B || c == 0x7D ||
+    c == 0x2F || c == 0x25;
+
+int _hexValue(int c) {
+  if (c >= 0x30 && c <= 0x39) return c - 0x30;
+  if (c >= 0x41 && c <= 0x46) return c - 0x41 + 10;
+  if (c >= 0x61 && c <= 0x66) return c - 0x61 + 10;
+  return -1;
+}
+
+/// Tokenizer over an in-memory window of PDF bytes.
+class _Lexer {
+  final Uint8List bytes;
+  final bool complete;
+  int pos;
+
+  _Lexer(this.bytes, {this.pos = 0, this.complete = true});
+
+  int _peek() {
+    if (pos < bytes.length) return bytes[pos];
+    if (!complete) throw const _NeedMoreData();
+    return -1;
+  }
+
+  void _skipWhitespaceAndComments() {
+    while (true) {
+      final c = _peek();
+      if (c < 0) return;
+      if (_isWhitespace(c)) {
+        pos++;
+      } else if (c == 0x25) {
+        while (true) {
+          final d = _peek();
+          if (d < 0 || d == 0x0A || d == 0x0D) break;
+          pos++;
+        }
+      } else {
+        return;
+      }
+    }
+  }
+
+  /// Returns num, bool, null, [_PdfName], [_PdfString], [_PdfKeyword] (also
+  /// for `[ ] << >> { }`), or [_endOfData].
+  Object? next() {
+    _skipWhitespaceAndComments();
+    final c = _peek();
+    if (c < 0) return _endOfData;
+
+    if (c == 0x2F) {
+      pos++;
+      return _PdfName(_readRegular(decodeHex: true));
+    }
+    if (c == 0x28) {
+      pos++;
+      return _PdfString(_readLiteralString());
+    }
+    if (c == 0x3C) {
+      pos++;
+      if (_peek() == 0x3C) {
+        pos++;
+        return const _PdfKeyword('<<');
+      }
+      return _PdfString(_readHexString());
+    }
+    if (c == 0x3E) {
+      pos++;
+      if (_peek() == 0x3E) pos++;
+      return const _PdfKeyword('>>');
+    }
+    if (c == 0x5B) {
+      pos++;
+      return const _PdfKeyword('[');
+    }
+    if (c == 0x5D) {
+      pos++;
+      return const _PdfKeyword(']');
+    }
+    if (c == 0x7B || c == 0x7D) {
+      pos++;
+      return _PdfKeyword(String.fromCharCode(c));
+    }
+    if (c == 0x29) {
+      // Stray close parenthesis; skip it.
+      pos++;
+      return next();
+    }
+    if ((c >= 0x30 && c <= 0x39) || c == 0x2B || c == 0x2D || c == 0x2E) {
+      return _readNumber();
+    }
+
+    final word = _readRegular(decodeHex: false);
+    switch (word) {
+      case 'true':
+        return true;
+      case 'false':
+        return false;
+      case 'null':
+        return null;
+    }
+    return _PdfKeyword(word);
+  }
+
+  String _readRegular({required bool decodeHex}) {
+    final buffer = StringBuffer();
+    while (true) {
+      final c = _peek();
+      if (c < 0 || _isWhitespace(c) || _isDelimiter(c)) break;
+      pos++;
+      if (decodeHex && c == 0x23 && pos + 1 < bytes.length) {
+        final high = _hexValue(bytes[pos]);
+        final low = _hexValue(bytes[pos + 1]);
+        if (high >= 0 && low >= 0) {
+          buffer.writeCharCode(high * 16 + low);
+          pos += 2;
+          continue;
+        }
+      }
+      buffer.writeCharCode(c);
+    }
+    if (buffer.isEmpty && !decodeHex) {
+      // A byte that starts no token; consume it so lexing always advances.
+      pos++;
+    }
+    return buffer.toString();
+  }
+
+  num _readNumber() {
+    final start = pos;
+    var sawDigit = false;
+    var sawPoint = false;
+    if (_peek() == 0x2B || _peek() == 0x2D) pos++;
+    while (true) {
+      final c = _peek();
+      if (c >= 0x30 && c <= 0x39) {
+        sawDigit = true;
+        pos++;
+      } else if (c == 0x2E && !sawPoint) {
+        sawPoint = true;
+        pos++;
+      } else {
+        break;
+      }
+    }
+    if (!sawDigit) return 0;
+    final text = String.fromCharCodes(bytes, start, pos);
+    return sawPoint ? (double.tryParse(text) ?? 0) : (int.tryParse(text) ?? 0);
+  }
+
+  Uint8List _readLiteralString() {
+    final chunk = <int>[];
+    var depth = 1;
+    while (true) {
+      var c = _peek();
+      if (c < 0) break;
+      pos++;
+      if (c == 0x28) {
+        depth++;
+      } else if (c == 0x29) {
+        depth--;
+        if (depth == 0) break;
+      } else if (c == 0x5C) {
+        c = _peek();
+        if (c < 0) break;
+        pos++;
+        switch (c) {
+          case 0x6E:
+            chunk.add(0x0A);
+            continue;
+          case 0x72:
+            chunk.add(0x0D);
+            continue;
+          case 0x74:
+            chunk.add(0x09);
+            continue;
+          case 0x62:
+            chunk.add(0x08);
+            continue;
+          case 0x66:
+            chunk.add(0x0C);
+            continue;
+          case 0x0D:
+            if (_peek() == 0x0A) pos++;
+            continue;
+          case 0x0A:
+            continue;
+        }
+        if (c >= 0x30 && c <= 0x37) {
+          var value = c - 0x30;
+          for (var i = 0; i < 2; i++) {
+            final d = _peek();
+            if (d < 0x30 || d > 0x37) break;
+            value = value * 8 + (d - 0x30);
+            pos++;
+          }
+          chunk.add(value & 0xFF);
+          continue;
+        }
+      }
+      chunk.add(c);
+    }
+    return Uint8List.fromList(chunk);
+  }
+
+  Uint8List _readHexString() {
+    final out = <int>[];
+    var high = -1;
+    while (true) {
+      final c = _peek();
+      if (c < 0) break;
+      pos++;
+      if (c == 0x3E) break;
+      final value = _hexValue(c);
+      if (value < 0) continue;
+      if (high < 0) {
+        high = value;
+      } else {
+        out.add(high * 16 + value);
+        high = -1;
+      }
+    }
+    if (high >= 0) out.add(high * 16);
+    return Uint8List.fromList(out);
+  }
+
+  /// Skips inline image data after the `ID` operator up to `EI`.
+  void skipInlineImage() {
+    if (pos < bytes.length) pos++;
+    while (pos + 1 < bytes.length) {
+      if (bytes[pos] == 0x45 &&
+          bytes[pos + 1] == 0x49 &&
+          _isWhitespace(bytes[pos - 1]) &&
+          (pos + 2 >= bytes.length || _isWhitespace(bytes[pos + 2]) || _isDelimiter(bytes[pos + 2]))) {
+        pos += 2;
+        return;
+      }
+      pos++;
+    }
+    pos = bytes.length;
+  }
+}
+
+/// Parses objects from a [_Lexer]. Indirect references are recognised by
+/// looking ahead for `n g R`.
+class _Parser {
+  final _Lexer lexer;
+  _Parser(this.lexer);
+
+  Object? parse() => _parseToken(lexer.next());
+
+  Object? _parseToken(Object? token) {
+    if (token is _PdfKeyword) {
+      if (token.value == '[') {
+        final list = <Object?>[];
+        while (true) {
+          final next = lexer.next();
+          if (next is _EndOfData) break;
+          if (next is _PdfKeyword && next.value == ']') break;
+          list.add(_parseToken(next));
+        }
+        return list;
+      }
+      if (token.value == '<<') {
+        final dict = <String, Object?>{};
+        while (true) {
+          final key = lexer.next();
+          if (key is _EndOfData) break;
+          if (key is _PdfKeyword && key.value == '>>') break;
+          if (key is! _PdfName) continue;
+          dict[key.value] = _parseToken(lexer.next());
+        }
+        return dict;
+      }
+      return token;
+    }
+    if (token is int && token >= 0) {
+      final mark = lexer.pos;
+      final generation = lexer.next();
+      if (generation is int && generation >= 0) {
+        final keyword = lexer.next();
+        if (keyword is _PdfKeyword && keyword.value == 'R') {
+          return _PdfRef(token, generation);
+        }
+      }
+      lexer.pos = mark;
+    }
+    return token;
+  }
+}
+
+/// Random-access view of a PDF file: cross-reference table, object lookup
+/// with a bounded cache, and stream decoding.
+class _PdfDocument {
+  final RandomAccessFile _file;
+  final int _maxStreamBytes;
+  final int _maxCachedObjects;
+  late final int _length;
+
+  final Map<int, _XrefEntry> _xref = {};
+  Map<String, Object?> _trailer = {};
+  final Map<int, Object?> _objectCache = {};
+  // Decoded object streams, most recently used last.
+  final Map<int, _ObjectStream> _objectStreams = {};
+  static const int _maxObjectStreams = 4;
+
+  _PdfDocument(this._file, this._maxStreamBytes, this._maxCachedObjects);
+
+  void open() {
+    _length = _file.lengthSync();
+    final start = _findStartXref();
+    final visited = <int>{};
+    int? offset = start;
+    var first = true;
+    while (offset != null && visited.add(offset)) {
+      final trailer = _readXrefSection(offset);
+      if (first) {
+        _trailer = trailer;
+        first = false;
+      }
+      // Hybrid files keep compressed objects in a separate xref stream.
+      final hybrid = trailer['XRefStm'];
+      if (hybrid is int && visited.add(hybrid)) {
+        _readXrefSection(hybrid);
+      }
+      final previous = trailer['Prev'];
+      offset = previous is int ? previous : null;
+    }
+    if (_trailer.containsKey('Encrypt')) {
+      throw const PdfStreamingException('encrypted documents are not supported');
+    }
+    if (resolve(_trailer['Root']) is! Map) {
+      throw const PdfStreamingException('missing document catalog');
+    }
+  }
+
+  Uint8List _read(int offset, int length) {
+    final count = math.max(0, math.min(length, _length - offset));
+    _file.setPositionSync(offset);
+    return _file.readSync(count);
+  }
+
+  int _findStartXref() {
+    final tailLength = math.min(_length, 2048);
+    final tail = _read(_length - tailLength, tailLength);
+    const marker = 'startxref';
+    for (var i = tail.length - marker.length; i >= 0; i--) {
+      var match = true;
+      for (var k = 0; k < marker.length; k++) {
+        if (tail[i + k] != marker.codeUnitAt(k)) {
+          match = false;
+          break;
+        }
+      }
+      if (!match) continue;
+      final value = _Lexer(tail, pos: i + marker.length).next();
+      if (value is int && value > 0 && value < _length) return value;
+      break;
+    }
+    throw const PdfStreamingException('startxref not found');
+  }
+
+  /// Runs [parse] over a window at [offset], doubling the window until the
+  /// parse fits or the end of the file is reached.
+  T _withWindow<T>(int offset, T Function(_Lexer lexer) parse) {
+    var size = 4096;
+    while (true) {
+      final bytes = _read(offset, size);
+      final complete = offset + bytes.length >= _length;
+      try {
+        return parse(_Lexer(bytes, complete: complete));
+      } on _NeedMoreData {
+        if (size >= _maxStreamBytes) {
+          throw const PdfStreamingException('object too large');
+        }
+        size *= 2;
+      }
+    }
+  }
+
+  Map<String, Object?> _readXrefSection(int offset) {
+    final isTable = _withWindow(offset, (lexer) {
+      final token = lexer.next();
+      return token is _PdfKeyword && token.value == 'xref';
+    });
+    return isTable ? _readXrefTable(offset) : _readXrefStream(offset);
+  }
+
+  Map<String, Object?> _readXrefTable(int offset) {
+    return _withWindow(offset, (lexer) {
+      lexer.next();
+      final parser = _Parser(lexer);
+      while (true) {
+        final token = lexer.next();
+        if (token is _PdfKeyword && token.value == 'trailer') {
+          final trailer = parser.parse();
+          return trailer is Map<String, Object?> ? trailer : <String, Object?>{};
+        }
+        if (token is! int) {
+          throw const PdfStreamingException('malformed xref table');
+        }
+        final count = lexer.next();
+        if (count is! int) {
+          throw const PdfStreamingException('malformed xref table');
+        }
+        for (var i = 0; i < count; i++) {
+          final entryOffset = lexer.next();
+          final generation = lexer.next();
+          final kind = lexer.next();
+          if (entryOffset is! int || generation is! int || kind is! _PdfKeyword) {
+            throw const PdfStreamingException('malformed xref entry');
+          }
+          // Sections are read newest first, so the first entry seen wins.
+          // Free entries are not recorded: hybrid files list compressed
+          // objects as free here and give their location in /XRefStm.
+          if (kind.value == 'n') {
+            _xref.putIfAbsent(token + i, () => _XrefEntry(1, entryOffset, generation));
+          }
+        }
+      }
+    });
+  }
+
+  Map<String, Object?> _readXrefStream(int offset) {
+    final object = _readObjectAt(offset);
+    if (object is! _PdfStream || _name(object.dict['Type']) != 'XRef') {
+      throw const PdfStreamingException('malformed xref stream');
+    }
+    final dict = object.dict;
+    final widths = (dict['W'] as List?)?.whereType<int>().toList() ?? const <int>[];
+    if (widths.length != 3) {
+      throw const PdfStreamingException('malformed xref stream widths');
+    }
+    final size = dict['Size'] is int ? dict['Size'] as int : 0;
+    final index = (dict['Index'] as List?)?.whereType<int>().toList() ?? [0, size];
+    final data = decodeStream(object);
+    if (data == null) {
+      throw const PdfStreamingException('undecodable xref stream');
+    }
+
+    final entryLength = widths[0] + widths[1] + widths[2];
+    var position = 0;
+    int field(int width, int defaultValue) {
+      if (width == 0) return defaultValue;
+      var value = 0;
+      for (var k = 0; k < width; k++) {
+        value = (value << 8) | data[position++];
+      }
+      return value;
+    }
+
+    for (var i = 0; i + 1 < index.length; i += 2) {
+      final first = index[i];
+      final count = index[i + 1];
+      for (var k = 0; k < count && position + entryLength <= data.length; k++) {
+        final type = field(widths[0], 1);
+        final a = field(widths[1], 0);
+        final b = field(widths[2], 0);
+        _xref.putIfAbsent(first + k, () => _XrefEntry(type, a, b));
+      }
+    }
+    return dict;
+  }
+
+  /// Reads the indirect object whose header starts at [offset].
+  Object? _readObjectAt(int offset) {
+    return _withWindow(offset, (lexer) {
+      final number = lexer.next();
+      final generation = lexer.next();
+      final keyword = lexer.next();
+      if (number is! int || generation is! int || keyword is! _PdfKeyword || keyword.value != 'obj') {
+        return null;
+      }
+      final value = _Parser(lexer).parse();
+      if (value is Map<String, Object?>) {
+        final mark = lexer.pos;
+        final next = lexer.next();
+        if (next is _PdfKeyword && next.value == 'stream') {
+          // Data starts after the end-of-line that follows the keyword.
+          var dataStart = lexer.pos;
+          if (dataStart < lexer.bytes.length && lexer.bytes[dataStart] == 0x0D) dataStart++;
+          if (dataStart < lexer.bytes.length && lexer.bytes[dataStart] == 0x0A) dataStart++;
+          return _PdfStream(value, offset + dataStart, null);
+        }
+        lexer.pos = mark;
+      }
+      return value;
+    });
+  }
+
+  Object? resolve(Object? value) {
+    var current = value;
+    // Chains of references are legal but short; the bound stops cycles.
+    for (var depth = 0; current is _PdfRef && depth < 16; depth++) {
+      current = _load(current.number);
+    }
+    return current is _PdfRef ? null : current;
+  }
+
+  Object? _load(int number) {
+    if (_objectCache.containsKey(number)) return _objectCache[number];
+    final entry = _xref[number];
+    Object? value;
+    if (entry != null && entry.type == 1) {
+      value = _readObjectAt(entry.a);
+    } else if (entry != null && entry.type == 2) {
+      value = _objectStream(entry.a)?.objectAt(entry.b);
+    }
+    if (_objectCache.length >= _maxCachedObjects) _objectCache.clear();
+    _objectCache[number] = value;
+    return value;
+  }
+
+  _ObjectStream? _objectStream(int number) {
+    final cached = _objectStreams.remove(number);
+    if (cached != null) {
+      _objectStreams[number] = cached;
+      return cached;
+    }
+    final entry = _xref[number];
+    if (entry == null || entry.type != 1) return null;
+    final stream = _readObjectAt(entry.a);
+    if (stream is! _PdfStream) return null;
+    final data = decodeStream(stream);
+    if (data == null) return null;
+    final first = resolve(stream.dict['First']);
+    final count = resolve(stream.dict['N']);
+    if (first is! int || count is! int) return null;
+    final objectStream = _ObjectStream(data, first, count);
+    if (_objectStreams.length >= _maxObjectStreams) {
+      _objectStreams.remove(_objectStreams.keys.first);
+    }
+    _objectStreams[number] = objectStream;
+    return objectStream;
+  }
+
+  String? _name(Object? value) {
+    final resolved = resolve(value);
+    return resolved is _PdfName ? resolved.value : null;
+  }
+
+  Map<String, Object?>? dict(Object? value) {
+    final resolved = resolve(value);
+    if (resolved is Map<String, Object?>) return resolved;
+    if (resolved is _PdfStream) return resolved.dict;
+    return null;
+  }
+
+  /// Raw stream bytes with every filter applied, or null when a filter is
+  /// unsupported or the result would exceed the stream limit.
+  Uint8List? decodeStream(_PdfStream stream) {
+    Uint8List data;
+    final inline = stream.data;
+    if (inline != null) {
+      data = inline;
+    } else {
+      final length = resolve(stream.dict['Length']);
+      if (length is! int || length < 0 || length > _maxStreamBytes) return null;
+      data = _read(stream.offset, length);
+    }
+
+    final filterValue = resolve(stream.dict['Filter']);
+    final paramsValue = resolve(stream.dict['DecodeParms']);
+    final filters = filterValue is List ? filterValue : [filterValue];
+    final params = paramsValue is List ? paramsValue : [paramsValue];
+    for (var i = 0; i < filters.length; i++) {
+      final filter = _name(filters[i]);
+      if (filter == null) continue;
+      final decodeParams = dict(i < params.length ? params[i] : null);
+      Uint8List? decoded;
+      switch (filter) {
+        case 'FlateDecode':
+        case 'Fl':
+          decoded = _inflate(data);
+          if (decoded != null && decodeParams != null) {
+            decoded = _applyPredictor(decoded, decodeParams);
+          }
+          break;
+        case 'ASCIIHexDecode':
+        case 'AHx':
+          decoded = _Lexer(Uint8List.fromList([...data, 0x3E]))._readHexString();
+          break;
+        case 'ASCII85Decode':
+        case 'A85':
+          decoded = _decodeAscii85(data);
+          break;
+        default:
+          return null;
+      }
+      if (decoded == null) return null;
+      data = decoded;
+    }
+    return data;
+  }
+
+  Uint8List? _inflate(Uint8List data) {
+    final sink = _LimitedByteSink(_maxStreamBytes);
+    try {
+      final input = ZLibDecoder().startChunkedConversion(sink);
+      input.add(data);
+      input.close();
+    } on _StreamTooLarge {
+      return null;
+    } on FormatException {
+      // Truncated or corrupt data: keep whatever inflated cleanly, as
+      // viewers do.
+    }
+    return sink.takeBytes();
+  }
+
+  Uint8List _applyPredictor(Uint8List data, Map<String, Object?> params) {
+    final predictor = resolve(params['Predictor']);
+    if (predictor is! int || predictor < 10) return data;
+    final columnsValue = resolve(params['Columns']);
+    final colorsValue = resolve(params['Colors']);
+    final bitsValue = resolve(params['BitsPerComponent']);
+    final columns = columnsValue is int ? columnsValue : 1;
+    final colors = colorsValue is int ? colorsValue : 1;
+    final bits = bitsValue is int ? bitsValue : 8;
+    final bytesPerPixel = math.max(1, (colors * bits + 7) ~/ 8);
+    final rowLength = (columns * colors * bits + 7) ~/ 8;
+    if (rowLength <= 0) return data;
+
+    final rows = data.length ~/ (rowLength + 1);
+    final out = Uint8List(rows * rowLength);
+    for (var row = 0; row < rows; row++) {
+      final type = data[row * (rowLength + 1)];
+      final source = row * (rowLength + 1) + 1;
+      final target = row * rowLength;
+      for (var i = 0; i < rowLength; i++) {
+        final raw = data[source + i];
+        final left = i >= bytesPerPixel ? out[target + i - bytesPerPixel] : 0;
+        final up = row > 0 ? out[target - rowLength + i] : 0;
+        final upLeft = row > 0 && i >= bytesPerPixel ? out[target - rowLength + i - bytesPerPixel] : 0;
+        int value;
+        switch (type) {
+          case 1:
+            value = raw + left;
+            break;
+          case 2:
+            value = raw + up;
+            break;
+          case 3:
+            value = raw + ((left + up) >> 1);
+            break;
+          case 4:
+            final p = left + up - upLeft;
+            final pa = (p - left).abs();
+            final pb = (p - up).abs();
+            final pc = (p - upLeft).abs();
+            value = raw + (pa <= pb && pa <= pc ? left : (pb <= pc ? up : upLeft));
+            break;
+          default:
+            value = raw;
+        }
+        out[target + i] = value & 0xFF;
+      }
+    }
+    return out;
+  }
+
+  Uint8List _decodeAscii85(Uint8List data) {
+    final out = BytesBuilder();
+    final group = <int>[];
+    for (var i = 0; i < data.length; i++) {
+      final c = data[i];
+      if (c == 0x7E) break;
+      if (_isWhitespace(c)) continue;
+      if (c == 0x7A && group.isEmpty) {
+        out.add(const [0, 0, 0, 0]);
+        continue;
+      }
+      if (c < 0x21 || c > 0x75) continue;
+      group.add(c - 0x21);
+      if (group.length == 5) {
+        var value = 0;
+        for (final digit in group) {
+          value = value * 85 + digit;
+        }
+        out.add([(value >> 24) & 0xFF, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF]);
+        group.clear();
+      }
+    }
+    if (group.isNotEmpty) {
+      final count = group.length - 1;
+      while (group.length < 5) {
+        group.add(84);
+      }
+      var value = 0;
+      for (final digit in group) {
+        value = value * 85 + digit;
+      }
+      final bytes = [(value >> 24) & 0xFF, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF];
+      out.add(bytes.sublist(0, count));
+    }
+    return out.takeBytes();
+  }
+
+  /// Leaf page dictionaries in document order, each with its inherited
+  /// resources resolved.
+  List<_PageInfo> pageList() {
+    final catalog = dict(_trailer['Root'])!;
+    final pages = <_PageInfo>[];
+    final visited = <Map<String, Object?>>{};
+    void walk(Object? node, Map<String, Object?>? inheritedResources, int depth) {
+      final nodeDict = dict(node);
+      if (nodeDict == null || depth > 64 || !visited.add(nodeDict)) return;
+      final resources = dict(nodeDict['Resources']) ?? inheritedResources;
+      final kids = resolve(nodeDict['Kids']);
+      if (kids is List && _name(nodeDict['Type']) != 'Page') {
+        for (final kid in kids) {
+          walk(kid, resources, depth + 1);
+        }
+      } else {
+        pages.add(_PageInfo(nodeDict, resources ?? const {}));
+      }
+    }
+
+    walk(catalog['Pages'], null, 0);
+    return pages;
+  }
+}
+
+class _PageInfo {
+  final Map<String, Object?> dict;
+  final Map<String, Object?> resources;
+  const _PageInfo(this.dict, this.resources);
+}
+
+class _ObjectStream {
+  final Uint8List data;
+  final List<int> offsets = [];
+
+  _ObjectStream(this.data, int first, int count) {
+    final lexer = _Lexer(data);
+    for (var i = 0; i < count; i++) {
+      final number = lexer.next();
+      final offset = lexer.next();
+      if (number is! int || offset is! int) break;
+      offsets.add(first + offset);
+    }
+  }
+
+  Object? objectAt(int index) {
+    if (index < 0 || index >= offsets.length) return null;
+    return _Parser(_Lexer(data, pos: offsets[index])).parse();
+  }
+}
+
+class _StreamTooLarge implements Exception {
+  const _StreamTooLarge();
+}
+
+class _LimitedByteSink implements Sink<List<int>> {
+  final int limit;
+  final BytesBuilder _builder = BytesBuilder(copy: false);
+
+  _LimitedByteSink(this.limit);
+
+  @override
+  void add(List<int> chunk) {
+    if (_builder.length + chunk.length > limit) throw const _StreamTooLarge();
+    _builder.add(chunk);
+  }
+
+  @override
+  void close() {}
+
+  Uint8List takeBytes() => _builder.takeBytes();
+}
+
+/// Character codes a page showed, and how many of them no font could map.
+class _CodeCount {
+  int shown = 0;
+  int unmapped = 0;
+}
+
+/// Maps character codes of one font to text: through its ToUnicode CMap
+/// when present, otherwise through its simple-font encoding. A null entry in
+/// [encoding] is a glyph name that could not be mapped.
+class _FontDecoder {
+  final int codeBytes;
+  final Map<int, String> toUnicode;
+  final List<String?>? encoding;
+
+  _FontDecoder(this.codeBytes, this.toUnicode, this.encoding);
+
+  static final _FontDecoder fallback = _FontDecoder(1, const {}, _winAnsi);
+
+  String decode(Uint8List bytes, _CodeCount count) {
+    final buffer = StringBuffer();
+    if (codeBytes == 2) {
+      for (var i = 0; i + 1 < bytes.length; i += 2) {
+        final mapped = toUnicode[(bytes[i] << 8) | bytes[i + 1]];
+        _write(buffer, mapped, count);
+      }
+      return buffer.toString();
+    }
+    for (final code in bytes) {
+      _write(buffer, toUnicode[code] ?? encoding?[code], count);
+    }
+    return buffer.toString();
+  }
+
+  static void _write(StringBuffer buffer, String? mapped, _CodeCount count) {
+    count.shown++;
+    if (mapped == null) {
+      count.unmapped++;
+    } else {
+      buffer.write(mapped);
+    }
+  }
+}
+
+/// Walks one page's content streams, and the forms they draw, collecting
+/// shown text with line breaks where the text position moves down.
+class _PageTextExtractor {
+  final _PdfDocument _document;
+  final StringBuffer _text = StringBuffer();
+  final Map<Map<String, Object?>, _FontDecoder> _fonts = {};
+  final _CodeCount _codes = _CodeCount();
+  bool hasImages = false;
+  int _lastChar = 0x0A;
+
+  _PageTextExtractor(this._document);
+
+  static const int _maxFormDepth = 4;
+
+  /// Share of a page's character codes that may go unmapped, such as a few
+  /// symbols in a font without a usable encoding, before the page is given
+  /// up on.
+  static const double _maxUnmappedShare = 0.25;
+
+  String extract(_PageInfo page) {
+    final contents = _document.resolve(page.dict['Contents']);
+    final parts = contents is List ? contents : [contents];
+    final data = BytesBuilder(copy: false);
+    for (final part in parts) {
+      final stream = _document.resolve(part);
+      if (stream is! _PdfStream) continue;
+      final decoded = _document.decodeStream(stream);
+      if (decoded == null) continue;
+      data
+        ..add(decoded)
+        ..addByte(0x0A);
+    }
+    _run(data.takeBytes(), page.resources, 0);
+    final text = _text.toString().trim();
+    if (_codes.unmapped > 0 && (text.isEmpty || _codes.unmapped > _codes.shown * _maxUnmappedShare)) {
+      throw const PdfStreamingException('page text uses fonts without a Unicode mapping');
+    }
+    return text;
+  }
+
+  void _write(String text) {
+    if (text.isEmpty) return;
+    _text.write(text);
+    _lastChar = text.codeUnitAt(text.length - 1);
+  }
+
+  void _newLine() {
+    if (_lastChar != 0x0A) _write('\n');
+  }
+
+  void _space() {
+    if (_lastChar != 0x0A && _lastChar != 0x20) _write(' ');
+  }
+
+  void _run(Uint8List content, Map<String, Object?> resources, int depth) {
+    final lexer = _Lexer(content);
+    final operands = <Object?>[];
+    var font = _FontDecoder.fallback;
+    var lineY = double.nan;
+    final parser = _Parser(lexer);
+
+    while (true) {
+      final token = lexer.next();
+      if (token is _EndOfData) break;
+      if (token is! _PdfKeyword || token.value == '[' || token.value == '<<') {
+        operands.add(token is _PdfKeyword ? parser._parseToken(token) : token);
+        continue;
+      }
+
+      switch (token.value) {
+        case 'Tf':
+          if (operands.length >= 2 && operands[operands.length - 2] is _PdfName) {
+            font = _font(resources, (operands[operands.length - 2] as _PdfName).value);
+          }
+          break;
+        case 'Tj':
+          if (operands.isNotEmpty && operands.last is _PdfString) {
+            _write(font.decode((operands.last as _PdfString).bytes, _codes));
+          }
+          break;
+        case "'":
+        case '"':
+          _newLine();
+          if (operands.isNotEmpty && operands.last is _PdfString) {
+            _write(font.decode((operands.last as _PdfString).bytes, _codes));
+          }
+          break;
+        case 'TJ':
+          if (operands.isNotEmpty && operands.last is List) {
+            for (final item in operands.last as List) {
+              if (item is _PdfString) {
+                _write(font.decode(item.bytes, _codes));
+              } else if (item is num && item < -200) {
+                // A large negative adjustment is how many writers encode a
+                // word space.
+                _space();
+              }
+            }
+          }
+          break;
+        case 'Td':
+        case 'TD':
+          if (operands.length >= 2 && operands[operands.length - 1] is num) {
+            final ty = (operands[operands.length - 1] as num).toDouble();
+            final tx = operands[operands.length - 2] is num ? (operands[operands.length - 2] as num).toDouble() : 0.0;
+            if (ty != 0) {
+              _newLine();
+            } else if (tx != 0) {
+              _space();
+            }
+          }
+          break;
+        case 'T*':
+          _newLine();
+          break;
+        case 'Tm':
+          if (operands.length >= 6 && operands[5] is num) {
+            final y = (operands[operands.length - 1] as num).toDouble();
+            if (!lineY.isNaN && (y - lineY).abs() > 0.5) {
+              _newLine();
+            } else {
+              _space();
+            }
+            lineY = y;
+          }
+          break;
+        case 'ET':
+          _space();
+          break;
+        case 'ID':
+          lexer.skipInlineImage();
+          hasImages = true;
+          break;
+        case 'Do':
+          if (operands.isNotEmpty && operands.last is _PdfName) {
+            _drawXObject(resources, (operands.last as _PdfName).value, depth);
+          }
+          break;
+      }
+      operands.clear();
+    }
+  }
+
+  void _drawXObject(Map<String, Object?> resources, String name, int depth) {
+    final xobjects = _document.dict(resources['XObject']);
+    final object = _document.resolve(xobjects?[name]);
+    if (object is! _PdfStream) return;
+    final subtype = _document._name(object.dict['Subtype']);
+    if (subtype == 'Image') {
+      // Only the dictionary was read; the image data stays on disk.
+      hasImages = true;
+    } else if (subtype == 'Form' && depth < _maxFormDepth) {
+      final content = _document.decodeStream(object);
+      if (content == null) return;
+      final formResources = _document.dict(object.dict['Resources']) ?? resources;
+      _run(content, formResources, depth + 1);
+    }
+  }
+
+  _FontDecoder _font(Map<String, Object?> resources, String name) {
+    final fonts = _document.dict(resources['Font']);
+    final fontDict = _document.dict(fonts?[name]);
+    if (fontDict == null) return _FontDecoder.fallback;
+    return _fonts.putIfAbsent(fontDict, () => _buildFont(fontDict));
+  }
+
+  _FontDecoder _buildFont(Map<String, Object?> fontDict) {
+    final isComposite = _document._name(fontDict['Subtype']) == 'Type0';
+    final toUnicode = <int, String>{};
+    var codeBytes = isComposite ? 2 : 1;
+    final cmap = _document.resolve(fontDict['ToUnicode']);
+    if (cmap is _PdfStream) {
+      final data = _document.decodeStream(cmap);
+      if (data != null) {
+        codeBytes = _parseToUnicode(data, toUnicode) ?? codeBytes;
+      }
+    }
+    if (isComposite) return _FontDecoder(codeBytes, toUnicode, null);
+    return _FontDecoder(codeBytes, toUnicode, _simpleEncoding(fontDict));
+  }
+
+  List<String?> _simpleEncoding(Map<String, Object?> fontDict) {
+    final encodingValue = _document.resolve(fontDict['Encoding']);
+    var base = _winAnsi;
+    Object? differences;
+    if (encodingValue is _PdfName) {
+      base = encodingValue.value == 'MacRomanEncoding' ? _macRoman : _winAnsi;
+    } else if (encodingValue is Map<String, Object?>) {
+      final baseName = _document._name(encodingValue['BaseEncoding']);
+      base = baseName == 'MacRomanEncoding' ? _macRoman : _winAnsi;
+      differences = _document.resolve(encodingValue['Differences']);
+    }
+    if (differences is! List) return base;
+
+    final table = List<String?>.of(base);
+    var code = 0;
+    for (final item in differences) {
+      if (item is int) {
+        code = item;
+      } else if (item is _PdfName) {
+        // A name that cannot be mapped, such as a subset font's /g17, says
+        // nothing about the text; the base encoding's character would be
+        // wrong, so the code is left unmapped.
+        if (code >= 0 && code < 256) table[code] = _glyphToText(item.value);
+        code++;
+      }
+    }
+    return table;
+  }
+
+  /// Fills [map] from a ToUnicode CMap and returns the code width in bytes
+  /// declared by its codespace range.
+  int? _parseToUnicode(Uint8List data, Map<int, String> map) {
+    final lexer = _Lexer(data);
+    final parser = _Parser(lexer);
+    int? codeBytes;
+    int code(_PdfString value) {
+      var result = 0;
+      for (final byte in value.bytes) {
+        result = (result << 8) | byte;
+      }
+      return result;
+    }
+
+    String text(_PdfString value) {
+      final units = <int>[];
+      for (var i = 0; i + 1 < value.bytes.length; i += 2) {
+        units.add((value.bytes[i] << 8) | value.bytes[i + 1]);
+      }
+      if (value.bytes.length.isOdd) units.add(value.bytes.last);
+      return String.fromCharCodes(units);
+    }
+
+    while (true) {
+      final token = lexer.next();
+      if (token is _EndOfData) break;
+      if (token is! _PdfKeyword) continue;
+      switch (token.value) {
+        case 'begincodespacerange':
+          final low = lexer.next();
+          lexer.next();
+          if (low is _PdfString && low.bytes.isNotEmpty) {
+            codeBytes ??= math.min(2, low.bytes.length);
+          }
+          break;
+        case 'beginbfchar':
+          while (true) {
+            final source = lexer.next();
+            if (source is! _PdfString) break;
+            final target = lexer.next();
+            if (target is _PdfString) map[code(source)] = text(target);
+          }
+          break;
+        case 'beginbfrange':
+          while (true) {
+            final low = lexer.next();
+            if (low is! _PdfString) break;
+            final high = lexer.next();
+            final target = parser.parse();
+            if (high is! _PdfString) break;
+            final first = code(low);
+            final last = math.min(code(high), first + 0xFFFF);
+            if (target is _PdfString && target.bytes.length >= 2) {
+              final base = text(target);
+              final prefix = base.substring(0, base.length - 1);
+              final lastUnit = base.codeUnitAt(base.length - 1);
+              for (var c = first; c <= last; c++) {
+                map[c] = prefix + String.fromCharCode(lastUnit + (c - first));
+              }
+            } else if (target is List) {
+              for (var c = first; c <= last && c - first < target.length; c++) {
+                final item = target[c - first];
+                if (item is _PdfString) map[c] = text(item);
+              }
+            }
+          }
+          break;
+      }
+    }
+    return codeBytes;
+  }
+}
+
+String? _glyphToText(String glyph) {
+  // Variants such as /a.sc read as their base glyph, and ligatures such as
+  // /f_i as their components.
+  final dot = glyph.indexOf('.');
+  final name = dot > 0 ? glyph.substring(0, dot) : glyph;
+  if (name.contains('_')) {
+    final parts = name.split('_').map(_glyphToText).toList();
+    return parts.contains(null) ? null : parts.join();
+  }
+  if (name.length == 1) return name;
+  if (name.startsWith('uni') && name.length >= 7) {
+    final value = int.tryParse(name.substring(3, 7), radix: 16);
+    if (value != null) return String.fromCharCode(value);
+  }
+  if (name.startsWith('u') && name.length >= 5 && name.length <= 7) {
+    final value = int.tryParse(name.substring(1), radix: 16);
+    if (value != null) return String.fromCharCode(value);
+  }
+  return _glyphNames[name];
+}
+
+const Map<String, String> _glyphNames = {
+  'space': ' ', 'exclam': '!', 'quotedbl': '"', 'numbersign': '#', 'dollar': r'$', 'percent': '%',
+  'ampersand': '&', 'quotesingle': "'", 'parenleft': '(', 'parenright': ')', 'asterisk': '*',
+  'plus': '+', 'comma': ',', 'hyphen': '-', 'period': '.', 'slash': '/', 'zero': '0', 'one': '1',
+  'two': '2', 'three': '3', 'four': '4', 'five': '5', 'six': '6', 'seven': '7', 'eight': '8',
+  'nine': '9', 'colon': ':', 'semicolon': ';', 'less': '<', 'equal': '=', 'greater': '>',
+  'question': '?', 'at': '@', 'bracketleft': '[', 'backslash': r'\', 'bracketright': ']',
+  'underscore': '_', 'quoteleft': '‘', 'quoteright': '’', 'quotedblleft': '“',
+  'quotedblright': '”', 'endash': '–', 'emdash': '—', 'bullet': '•',
+  'ellipsis': '…', 'section': '§', 'paragraph': '¶', 'copyright': '©',
+  'registered': '®', 'trademark': '™', 'fi': 'fi', 'fl': 'fl', 'ff': 'ff', 'ffi': 'ffi',
+  'ffl': 'ffl', 'dagger': '†', 'daggerdbl': '‡', 'minus': '-', 'nbspace': ' ',
+};
+
+/// WinAnsiEncoding: Latin-1 with the Windows-1252 characters in 0x80-0x9F.
+/// StandardEncoding differs only in rarely used positions and shares it.
+final List<String> _winAnsi = List<String>.generate(256, (code) {
+  const high = [
+    0x20AC, 0x00, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x00,
+    0x017D, 0x00, 0x00, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A,
+    0x0153, 0x00, 0x017E, 0x0178,
+  ];
+  if (code < 0x20) return code == 0x09 || code == 0x0A || code == 0x0D ? ' ' : '';
+  if (code >= 0x80 && code < 0xA0) {
+    final mapped = high[code - 0x80];
+    return mapped == 0 ? '' : String.fromCharCode(mapped);
+  }
+  return String.fromCharCode(code);
+});
+
+final List<String> _macRoman = List<String>.generate(256, (code) {
+  const high = 'ÄÅÇÉÑÖÜáàâäãåçéè'
+      'êëíìîïñóòôöõúùûü'
+      '†°¢£§•¶ß®©™´¨≠ÆØ'
+      '∞±≤≥¥µ∂∑∏π∫ªºΩæø'
+      '¿¡¬√ƒ≈∆«»… ÀÃÕŒœ'
+      '–—“”‘’÷◊ÿŸ⁄€‹›ﬁﬂ'
+      '‡·‚„‰ÂÊÁËÈÍÎÏÌÓÔ'
+      'ÒÚÛÙıˆ˜¯˘˙˚¸˝˛ˇ';
+  if (code < 0x20) return code == 0x09 || code == 0x0A || code == 0x0D ? ' ' : '';
+  if (code >= 0x80) return high[code - 0x80];
+  return String.fromCharCode(code);
+});
@@ -0,0 +1,75 @@
+import 'dart:convert';
+import 'dart:typed_data';
+import 'package:intl/intl.dart';
+import 'package:legalease/features/document_scan/domain/models/analysis_result.dart';
+
+/// Encodes an [AnalysisResult] in the compact binary form the native report
+/// writer lays out, instead of building a widget tree for every page. The
+/// layout is documented with `WriteAnalysisReport` in
+/// `windows/runner/report_writer.h`.
+class AnalysisReportBuffer {
+  static const int version = 1;
+  static const List<int> magic = [0x4C, 0x45, 0x52, 0x50]; // 'LERP'
+  static const int _maxClauseLength = 200;
+
+  final BytesBuilder _bytes = BytesBuilder();
+  final ByteData _scratch = ByteData(4);
+
+  AnalysisReportBuffer._();
+
+  /// With [includeSourceText] the report ends with the full original text,
+  /// flagged clauses highlighted by severity.
+  static Uint8List encode(AnalysisResult result, {bool includeSourceText = true}) {
+    final buffer = AnalysisReportBuffer._();
+    final source = includeSourceText ? result.originalText : '';
+
+    buffer._bytes.add(magic);
+    buffer._u16(version);
+    buffer._string(result.metadata.fileName ?? 'Document');
+    buffer._string(DateFormat('MMMM d, yyyy').format(result.analyzedAt));
+    buffer._u32(result.metadata.wordCount);
+    buffer._string(result.metadata.typeName);
+    buffer._u8(_percent(result.metadata.confidence));
+    buffer._string(result.summary);
+    buffer._string(result.plainEnglishTranslation);
+
+    buffer._u32(result.redFlags.length);
+    for (final flag in result.redFlags) {
+      final start = flag.startIndex.clamp(0, source.length);
+      final end = flag.endIndex.clamp(start, source.length);
+      buffer._u8(flag.severity.index);
+      buffer._u8(_percent(flag.confidenceScore));
+      buffer._u32(start);
+      buffer._u32(end);
+      buffer._string(_quote(flag.originalClause));
+      buffer._string(flag.explanation);
+    }
+    buffer._string(source);
+
+    return buffer._bytes.takeBytes();
+  }
+
+  static int _percent(double value) => (value * 100).toInt().clamp(0, 100);
+
+  static String _quote(String clause) => clause.length > _maxClauseLength
+      ? '"${clause.substring(0, _maxClauseLength)}..."'
+      : '"$clause"';
+
+  void _u8(int value) => _bytes.addByte(value);
+
+  void _u16(int value) {
+    _scratch.setUint16(0, value, Endian.little);
+    _bytes.add(_scratch.buffer.asUint8List(0, 2));
+  }
+
+  void _u32(int value) {
+    _scratch.setUint32(0, value, Endian.little);
+    _bytes.add(_scratch.buffer.asUint8List(0, 4));
+  }
+
+  void _string(String value) {
+    final encoded = utf8.encode(value);
+    _u32(encoded.length);
+    _bytes.add(encoded);
+  }
+}
@@ -6,7 +6,9 @@ import 'package:printing/printing.dart';
 import 'package:path_provider/path_provider.dart';
 import 'package:flutter_email_sender/flutter_email_sender.dart';
 import 'package:intl/intl.dart';
+import 'package:legalease/core/platform_channels/windows_accessibility_channel.dart';
 import 'package:legalease/features/document_scan/domain/models/analysis_result.dart';
+import 'package:legalease/features/export/domain/services/analysis_report_buffer.dart';
 
 class ExportService {
   Future<Uint8List> generatePdf(AnalysisResult result) async {
@@ -336,6 +338,28 @@ class ExportService {
     return file.path;
   }
 
+  /// Writes the report for [result] to [filename] in the documents
+  /// directory and returns its path. On Windows the native writer streams it
+  /// to disk page by page, including the annotated source text when
+  /// [includeSourceText] is set; elsewhere, or if that fails, it falls back
+  /// to [generatePdf].
+  Future<String> writeReportToFile(
+    AnalysisResult result,
+    String filename, {
+    bool includeSourceText = true,
+  }) async {
+    final directory = await getApplicationDocumentsDirectory();
+    final path = '${directory.path}/$filename';
+    final written = await WindowsAccessibilityChannel().writeAnalysisReport(
+      AnalysisReportBuffer.encode(result, includeSourceText: includeSourceText),
+      path,
+    );
+    if (written != null) return path;
+
+    await File(path).writeAsBytes(await generatePdf(result));
+    return path;
+  }
+
   Future<void> shareDocument(Uint8List data, String filename) async {
     await Printing.sharePdf(bytes: data, filename: filename);
   }
@@ -350,9 +374,8 @@ class ExportService {
     String? attorneyName,
     String? customMessage,
   }) async {
-    final pdfData = await generatePdf(result);
     final filename = 'LegalEase_Analysis_${DateTime.now().millisecondsSinceEpoch}.pdf';
-    final filePath = await saveToFile(pdfData, filename);
+    final filePath = await writeReportToFile(result, filename);
 
     final email = Email(
       body: _buildEmailBody(result, customMessage),
@@ -102,12 +102,11 @@ class ExportButton extends ConsumerWidget {
 
     try {
       final exportService = ref.read(exportServiceProvider);
-      final pdfData = await exportService.generatePdf(analysisResult);
       final filename = 'LegalEase_${analysisResult.metadata.fileName ?? 'Analysis'}_${DateTime.now().millisecondsSinceEpoch}.pdf';
 
       switch (format) {
         case ExportFormat.pdf:
-          final path = await exportService.saveToFile(pdfData, filename);
+          final path = await exportService.writeReportToFile(analysisResult, filename);
           if (context.mounted) {
             ScaffoldMessenger.of(context).showSnackBar(
               SnackBar(
@@ -123,10 +122,10 @@ class ExportButton extends ConsumerWidget {
           }
           break;
         case ExportFormat.share:
-          await exportService.shareDocument(pdfData, filename);
+          await exportService.shareDocument(await exportService.generatePdf(analysisResult), filename);
           break;
         case ExportFormat.print:
-          await exportService.printDocument(pdfData);
+          await exportService.printDocument(await exportService.generatePdf(analysisResult));
           break;
       }
     } catch (e) {
@@ -233,12 +232,11 @@ class QuickExportFAB extends ConsumerWidget {
 
     try {
       final exportService = ref.read(exportServiceProvider);
-      final pdfData = await exportService.generatePdf(analysisResult);
       final filename = 'LegalEase_Analysis_${DateTime.now().millisecondsSinceEpoch}.pdf';
 
       switch (format) {
         case ExportFormat.pdf:
-          final path = await exportService.saveToFile(pdfData, filename);
+          final path = await exportService.writeReportToFile(analysisResult, filename);
           if (context.mounted) {
             ScaffoldMessenger.of(context).showSnackBar(
               SnackBar(
@@ -249,10 +247,10 @@ class QuickExportFAB extends ConsumerWidget {
           }
           break;
         case ExportFormat.share:
-          await exportService.shareDocument(pdfData, filename);
+          await exportService.shareDocument(await exportService.generatePdf(analysisResult), filename);
           break;
         case ExportFormat.print:
-          await exportService.printDocument(pdfData);
+          await exportService.printDocument(await exportService.generatePdf(analysisResult));
           break;
       }
     } catch (e) {
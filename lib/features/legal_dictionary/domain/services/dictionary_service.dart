@@ -1,7 +1,17 @@
 import 'package:legalease/features/legal_dictionary/data/models/legal_term.dart';
+import 'package:legalease/features/legal_dictionary/domain/services/fuzzy_term_index.dart';
 
 class DictionaryService {
   static final List<LegalTerm> _legalTerms = _initializeLegalTerms();
+  static final FuzzyTermIndex _termIndex = FuzzyTermIndex(
+    [for (final term in _legalTerms) [term.term, ...term.synonyms]],
+    popularity: [for (final term in _legalTerms) term.isCommonTerm ? 1.0 : 0.0],
+  );
+  // Lower-cased once for the substring fallback of searchTerms.
+  static final List<String> _searchableText = [
+    for (final term in _legalTerms)
+      [term.term, ...term.synonyms, term.definition].join('\n').toLowerCase(),
+  ];
   List<LegalTerm> get allTerms => _legalTerms;
 
   static List<LegalTerm> _initializeLegalTerms() {
@@ -1659,15 +1669,23 @@ class DictionaryService {
     ];
   }
 
+  /// Terms whose name or synonym matches [query] despite typos, best first,
+  /// followed by the other terms that contain it in their name, synonyms or
+  /// definition, in dictionary order.
   List<LegalTerm> searchTerms(String query) {
     if (query.isEmpty) return _legalTerms;
 
+    final fuzzy = _termIndex.search(query, limit: _legalTerms.length);
+    final included = {for (final match in fuzzy) match.index};
+    final results = [for (final match in fuzzy) _legalTerms[match.index]];
+
     final lowerQuery = query.toLowerCase();
-    return _legalTerms.where((term) {
-      return term.term.toLowerCase().contains(lowerQuery) ||
-          term.definition.toLowerCase().contains(lowerQuery) ||
-          term.synonyms.any((s) => s.toLowerCase().contains(lowerQuery));
-    }).toList();
+    for (var i = 0; i < _legalTerms.length; i++) {
+      if (!included.contains(i) && _searchableText[i].contains(lowerQuery)) {
+        results.add(_legalTerms[i]);
+      }
+    }
+    return results;
   }
 
   LegalTerm? getTerm(String termId) {
@@ -1702,15 +1720,14 @@ class DictionaryService {
     return _legalTerms.where((t) => t.isCommonTerm).toList();
   }
 
+  /// Names of the terms closest to what has been typed so far, tolerating
+  /// up to two typos ("indemnfy", "arbitartion").
   List<String> getAutocompleteSuggestions(String query, {int limit = 10}) {
     if (query.isEmpty) return _legalTerms.take(limit).map((t) => t.term).toList();
 
-    final lowerQuery = query.toLowerCase();
-    final matches = _legalTerms
-        .where((t) => t.term.toLowerCase().startsWith(lowerQuery))
-        .take(limit)
-        .map((t) => t.term)
+    return _termIndex
+        .search(query, limit: limit)
+        .map((match) => _legalTerms[match.index].term)
         .toList();
-    return matches;
   }
 }
@@ -0,0 +1,268 @@
+import 'dart:typed_data';
+
+/// A term found by [FuzzyTermIndex.search].
+class FuzzyTermMatch {
+  /// Position of the term in the list the index was built from.
+  final int index;
+
+  /// Edit distance to the matched name, or to its closest prefix when
+  /// [isPrefix] is set. Swapping two adjacent letters counts as one edit.
+  final int distance;
+
+  /// Whether the query matched the start of a longer name, as it does while
+  /// the user is still typing.
+  final bool isPrefix;
+
+  /// Lower ranks first.
+  final double score;
+
+  const FuzzyTermMatch({
+    required this.index,
+    required this.distance,
+    required this.isPrefix,
+    required this.score,
+  });
+}
+
+/// Typo-tolerant lookup over term names and their synonyms.
+///
+/// Names are kept in a trie, from the start of the name and from the start
+/// of each later word, so "majeure" finds "Force Majeure". A search walks
+/// the trie once with one row of a Damerau-Levenshtein table per level and
+/// leaves a branch as soon as no row entry is within the allowed distance,
+/// so it touches only the names that can still match instead of every term.
+class FuzzyTermIndex {
+  static const int _distanceWeight = 3;
+  static const double _prefixPenalty = 1;
+  static const double _synonymPenalty = 0.5;
+  static const double _innerWordPenalty = 0.5;
+
+  static const int _synonymFlag = 1;
+  static const int _innerWordFlag = 2;
+
+  // The trie in breadth-first order, so the children of a node are the
+  // contiguous range [_childStart[n], _childStart[n + 1]).
+  final Uint16List _char;
+  final Int32List _childStart;
+  // Names ending at node n are _postings[_postingStart[n] ..
+  // _postingStart[n + 1]), each a term index shifted left by two with the
+  // flags in the low bits.
+  final Int32List _postingStart;
+  final Int32List _postings;
+  final int _maxDepth;
+  final List<double> _popularity;
+  final List<int> _nameLengths;
+
+  FuzzyTermIndex._(
+    this._char,
+    this._childStart,
+    this._postingStart,
+    this._postings,
+    this._maxDepth,
+    this._popularity,
+    this._nameLengths,
+  );
+
+  /// Builds the index from [names], where `names[i]` holds the primary name
+  /// of term `i` followed by its synonyms. [popularity] holds a weight in
+  /// 0..1 per term; more popular terms rank first among equally close
+  /// matches.
+  factory FuzzyTermIndex(List<List<String>> names, {List<double>? popularity}) {
+    final root = _BuildNode();
+    var maxDepth = 0;
+    for (var term = 0; term < names.length; term++) {
+      for (var n = 0; n < names[term].length; n++) {
+        final key = normalize(names[term][n]);
+        if (key.isEmpty) continue;
+        final flags = n == 0 ? 0 : _synonymFlag;
+        for (var start = 0; start < key.length; start++) {
+          if (start > 0 && key.codeUnitAt(start - 1) != 0x20) continue;
+          if (key.codeUnitAt(start) == 0x20) continue;
+          var node = root;
+          for (var i = start; i < key.length; i++) {
+            node = node.children.putIfAbsent(key.codeUnitAt(i), _BuildNode.new);
+          }
+          node.postings.add(term << 2 | flags | (start > 0 ? _innerWordFlag : 0));
+          if (key.length - start > maxDepth) maxDepth = key.length - start;
+        }
+      }
+    }
+
+    final order = <_BuildNode>[root];
+    final chars = <int>[0];
+    for (var i = 0; i < order.length; i++) {
+      final children = order[i].children;
+      final keys = children.keys.toList()..sort();
+      for (final key in keys) {
+        order.add(children[key]!);
+        chars.add(key);
+      }
+    }
+
+    final childStart = Int32List(order.length + 1);
+    final postingStart = Int32List(order.length + 1);
+    final postings = <int>[];
+    var nextChild = 1;
+    for (var i = 0; i < order.length; i++) {
+      childStart[i] = nextChild;
+      nextChild += order[i].children.length;
+      postingStart[i] = postings.length;
+      postings.addAll(order[i].postings);
+    }
+    childStart[order.length] = nextChild;
+    postingStart[order.length] = postings.length;
+
+    return FuzzyTermIndex._(
+      Uint16List.fromList(chars),
+      childStart,
+      postingStart,
+      Int32List.fromList(postings),
+      maxDepth,
+      popularity ?? List.filled(names.length, 0.0),
+      [for (final termNames in names) termNames.isEmpty ? 0 : termNames.first.length],
+    );
+  }
+
+  /// Number of trie nodes, for diagnostics.
+  int get nodeCount => _char.length;
+
+  /// Lower case, with runs of anything other than letters and digits
+  /// collapsed to one space, so "Non-Disclosure Agreement (NDA)" and
+  /// "non disclosure agreement nda" are the same key.
+  static String normalize(String text) {
+    final buffer = StringBuffer();
+    var pendingSpace = false;
+    for (final unit in text.toLowerCase().codeUnits) {
+      final isWordUnit = (unit >= 0x61 && unit <= 0x7A) || (unit >= 0x30 && unit <= 0x39) || unit >= 0xC0;
+      if (!isWordUnit) {
+        pendingSpace = buffer.isNotEmpty;
+        continue;
+      }
+      if (pendingSpace) buffer.writeCharCode(0x20);
+      pendingSpace = false;
+      buffer.writeCharCode(unit);
+    }
+    return buffer.toString();
+  }
+
+  /// Edits tolerated for a query of [length] characters: none for one or
+  /// two, where any edit matches nearly everything, one up to five and two
+  /// beyond.
+  static int defaultMaxDistance(int length) => length <= 2 ? 0 : (length <= 5 ? 1 : 2);
+
+  /// Returns up to [limit] terms whose name or synonym is within
+  /// [maxDistance] edits of [query], or starts with a string that is, best
+  /// first. Ranking prefers fewer edits, then whole-name over prefix
+  /// matches, primary names over synonyms and first words over later ones,
+  /// then popularity and shorter names.
+  List<FuzzyTermMatch> search(String query, {int limit = 10, int? maxDistance}) {
+    final key = normalize(query);
+    if (key.isEmpty || limit <= 0) return const [];
+    return _Search(this, key.codeUnits, maxDistance ?? defaultMaxDistance(key.length)).run(limit);
+  }
+}
+
+class _BuildNode {
+  final Map<int, _BuildNode> children = {};
+  final List<int> postings = [];
+}
+
+class _Search {
+  final FuzzyTermIndex _index;
+  final List<int> _query;
+  final int _maxDistance;
+  final int _width;
+  // Row d holds the edit distances between the first d characters of the
+  // current trie path and every prefix of the query.
+  final Int32List _rows;
+  final Map<int, FuzzyTermMatch> _best = {};
+
+  _Search(this._index, this._query, this._maxDistance)
+      : _width = _query.length + 1,
+        _rows = Int32List((_query.length + 1) * (_index._maxDepth + 1)) {
+    for (var j = 0; j < _width; j++) {
+      _rows[j] = j;
+    }
+  }
+
+  List<FuzzyTermMatch> run(int limit) {
+    _walk(0, 0, _maxDistance + 1);
+    final matches = _best.values.toList()
+      ..sort((a, b) {
+        final byScore = a.score.compareTo(b.score);
+        if (byScore != 0) return byScore;
+        final byLength = _index._nameLengths[a.index].compareTo(_index._nameLengths[b.index]);
+        return byLength != 0 ? byLength : a.index.compareTo(b.index);
+      });
+    return matches.length > limit ? matches.sublist(0, limit) : matches;
+  }
+
+  void _walk(int node, int depth, int bestPrefix) {
+    final queryLength = _query.length;
+    final previous = depth * _width;
+    final current = previous + _width;
+    final beforePrevious = previous - _width;
+    final parentChar = _index._char[node];
+
+    for (var child = _index._childStart[node]; child < _index._childStart[node + 1]; child++) {
+      final c = _index._char[child];
+      _rows[current] = depth + 1;
+      var rowMin = depth + 1;
+      for (var j = 1; j <= queryLength; j++) {
+        final q = _query[j - 1];
+        var value = _rows[previous + j - 1] + (q == c ? 0 : 1);
+        final insert = _rows[current + j - 1] + 1;
+        final delete = _rows[previous + j] + 1;
+        if (insert < value) value = insert;
+        if (delete < value) value = delete;
+        if (depth > 0 && j > 1 && q == parentChar && _query[j - 2] == c) {
+          final transpose = _rows[beforePrevious + j - 2] + 1;
+          if (transpose < value) value = transpose;
+        }
+        _rows[current + j] = value;
+        if (value < rowMin) rowMin = value;
+      }
+
+      final full = _rows[current + queryLength];
+      final prefix = full < bestPrefix ? full : bestPrefix;
+      _record(child, full, prefix);
+      if (rowMin <= _maxDistance) {
+        _walk(child, depth + 1, prefix);
+      } else if (prefix <= _maxDistance) {
+        // Nothing deeper can match the whole query any more, but every
+        // name below still starts with a close enough prefix.
+        _collect(child, prefix);
+      }
+    }
+  }
+
+  void _collect(int node, int prefix) {
+    for (var child = _index._childStart[node]; child < _index._childStart[node + 1]; child++) {
+      _record(child, _maxDistance + 1, prefix);
+      _collect(child, prefix);
+    }
+  }
+
+  void _record(int node, int full, int prefix) {
+    final start = _index._postingStart[node];
+    final end = _index._postingStart[node + 1];
+    if (start == end) return;
+    final isPrefix = full > prefix;
+    final distance = isPrefix ? prefix : full;
+    if (distance > _maxDistance) return;
+
+    for (var p = start; p < end; p++) {
+      final posting = _index._postings[p];
+      final term = posting >> 2;
+      var score = distance * FuzzyTermIndex._distanceWeight - _index._popularity[term];
+      if (isPrefix) score += FuzzyTermIndex._prefixPenalty;
+      if (posting & FuzzyTermIndex._synonymFlag != 0) score += FuzzyTermIndex._synonymPenalty;
+      if (posting & FuzzyTermIndex._innerWordFlag != 0) score += FuzzyTermIndex._innerWordPenalty;
+
+      final existing = _best[term];
+      if (existing == null || score < existing.score) {
+        _best[term] = FuzzyTermMatch(index: term, distance: distance, isPrefix: isPrefix, score: score);
+      }
+    }
+  }
+}
@@ -67,7 +67,7 @@ class _WritingAssistantOverlayScreenState extends ConsumerState<WritingAssistant
             final newPosition = details.globalPosition + _dragOffset;
             ref.read(overlayPositionProvider.notifier).state = 
                 OverlayPosition(x: newPosition.dx, y: newPosition.dy);
-            _overlayChannel.setPosition(newPosition.dx, newPosition.dy);
+            _overlayChannel.applyGeometry(x: newPosition.dx, y: newPosition.dy);
           }
         },
         onPanEnd: (_) {
@@ -1,8 +1,12 @@
+import 'dart:io';
+
 import 'package:flutter/material.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:firebase_core/firebase_core.dart';
 import 'package:flutter_dotenv/flutter_dotenv.dart';
 import 'package:legalease/app.dart';
+import 'package:legalease/core/platform_channels/windows_accessibility_channel.dart';
+import 'package:legalease/core/utils/memory_utils.dart';
 import 'package:legalease/firebase_options.dart';
 
 void main() async {
@@ -13,6 +17,10 @@ void main() async {
   await Firebase.initializeApp(
     options: DefaultFirebaseOptions.currentPlatform,
   );
+
+  if (Platform.isWindows) {
+    MemoryPressureMonitor.attach(WindowsAccessibilityChannel().memoryPressureStream);
+  }
   
   runApp(
     const ProviderScope(
@@ -50,6 +50,9 @@ class DesktopOverlayPlugin: NSObject, FlutterStreamHandler {
         case "setSize":
             handleSetSize(call: call, result: result)
             
+        case "applyGeometry":
+            handleApplyGeometry(call: call, result: result)
+            
         case "setAlwaysOnTop":
             handleSetAlwaysOnTop(call: call, result: result)
             
@@ -130,6 +133,43 @@ class DesktopOverlayPlugin: NSObject, FlutterStreamHandler {
         }
     }
     
+    private func handleApplyGeometry(call: FlutterMethodCall, result: @escaping FlutterResult) {
+        guard let args = call.arguments as? [String: Any] else {
+            result(false)
+            return
+        }
+        
+        DispatchQueue.main.async { [weak self] in
+            guard let window = self?.overlayWindow else {
+                result(true)
+                return
+            }
+            
+            let frame = window.frame
+            if args["x"] != nil || args["y"] != nil {
+                let x = args["x"] as? Double ?? Double(frame.origin.x)
+                let y = args["y"] as? Double ?? Double(frame.origin.y)
+                window.setPosition(NSPoint(x: x, y: y))
+            }
+            if args["width"] != nil || args["height"] != nil {
+                let width = args["width"] as? Double ?? Double(frame.size.width)
+                let height = args["height"] as? Double ?? Double(frame.size.height)
+                window.setSize(NSSize(width: width, height: height))
+            }
+            if let minimized = args["minimized"] as? Bool {
+                if minimized {
+                    window.minimize()
+                } else {
+                    window.expand()
+                }
+            }
+            if let alwaysOnTop = args["alwaysOnTop"] as? Bool {
+                window.setAlwaysOnTop(alwaysOnTop)
+            }
+            result(true)
+        }
+    }
+    
     private func handleSetAlwaysOnTop(call: FlutterMethodCall, result: @escaping FlutterResult) {
         guard let args = call.arguments as? [String: Any],
               let alwaysOnTop = args["alwaysOnTop"] as? Bool else {
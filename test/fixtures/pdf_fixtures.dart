@@ -0,0 +1,198 @@
+import 'dart:convert';
+import 'dart:io';
+import 'dart:typed_data';
+
+/// Assembles small PDF files object by object for parser tests.
+class PdfFixtureBuilder {
+  final Map<int, List<int>> _objects = {};
+  final Set<int> _streams = {};
+  final Set<int> _changed = {};
+  int _next = 1;
+  int _lastXrefOffset = 0;
+
+  int reserve() => _next++;
+
+  int addObject(String body, {int? number}) {
+    number ??= reserve();
+    _objects[number] = latin1.encode(body);
+    _changed.add(number);
+    return number;
+  }
+
+  int addStream(String dict, List<int> data, {bool compress = false, int? number}) {
+    number ??= reserve();
+    final payload = compress ? zlib.encode(data) : data;
+    final filter = compress ? ' /Filter /FlateDecode' : '';
+    _objects[number] = [
+      ...latin1.encode('<< $dict /Length ${payload.length}$filter >>\nstream\n'),
+      ...payload,
+      ...latin1.encode('\nendstream'),
+    ];
+    _streams.add(number);
+    _changed.add(number);
+    return number;
+  }
+
+  /// Writes the file with a classic xref table or, when [xrefStream] is set,
+  /// with every non-stream object packed in an object stream and indexed by
+  /// a compressed xref stream.
+  Uint8List build({required int root, bool xrefStream = false, String trailerExtra = ''}) {
+    _changed.clear();
+    final out = BytesBuilder();
+    out.add(latin1.encode('%PDF-1.7\n%\xE2\xE3\xCF\xD3\n'));
+    if (xrefStream) return _buildWithXrefStream(out, root);
+
+    final offsets = <int, int>{};
+    for (final number in _objects.keys.toList()..sort()) {
+      offsets[number] = out.length;
+      _writeObject(out, number);
+    }
+    _writeXrefTable(out, offsets, 'trailer\n<< /Size $_next /Root $root 0 R $trailerExtra>>\n');
+    return out.takeBytes();
+  }
+
+  /// Appends the objects added or replaced since the last build as an
+  /// incremental update of [base].
+  Uint8List buildIncrement(Uint8List base, {required int root}) {
+    final out = BytesBuilder()..add(base);
+    final offsets = <int, int>{};
+    for (final number in _changed.toList()..sort()) {
+      offsets[number] = out.length;
+      _writeObject(out, number);
+    }
+    _changed.clear();
+    _writeXrefTable(out, offsets, 'trailer\n<< /Size $_next /Root $root 0 R /Prev $_lastXrefOffset >>\n');
+    return out.takeBytes();
+  }
+
+  void _writeObject(BytesBuilder out, int number) {
+    out
+      ..add(latin1.encode('$number 0 obj\n'))
+      ..add(_objects[number]!)
+      ..add(latin1.encode('\nendobj\n'));
+  }
+
+  void _writeXrefTable(BytesBuilder out, Map<int, int> offsets, String trailer) {
+    _lastXrefOffset = out.length;
+    final xref = StringBuffer('xref\n');
+    if (offsets.length == _objects.length) {
+      xref.write('0 $_next\n0000000000 65535 f \n');
+      for (var n = 1; n < _next; n++) {
+        final offset = offsets[n];
+        xref.write(offset == null
+            ? '0000000000 00000 f \n'
+            : '${offset.toString().padLeft(10, '0')} 00000 n \n');
+      }
+    } else {
+      for (final number in offsets.keys.toList()..sort()) {
+        xref.write('$number 1\n${offsets[number].toString().padLeft(10, '0')} 00000 n \n');
+      }
+    }
+    out.add(latin1.encode('$xref$trailer'
+        'startxref\n$_lastXrefOffset\n%%EOF\n'));
+  }
+
+  Uint8List _buildWithXrefStream(BytesBuilder out, int root) {
+    final packed = _objects.keys.where((n) => !_streams.contains(n)).toList()..sort();
+    final objectStreamNumber = _next;
+    final xrefNumber = _next + 1;
+    final size = _next + 2;
+
+    final header = StringBuffer();
+    final body = BytesBuilder();
+    for (final number in packed) {
+      header.write('$number ${body.length} ');
+      body
+        ..add(_objects[number]!)
+        ..addByte(0x0A);
+    }
+    final headerBytes = latin1.encode(header.toString());
+    final objectStreamData = zlib.encode([...headerBytes, ...body.takeBytes()]);
+
+    final entries = <int, List<int>>{};
+    for (final number in _streams.toList()..sort()) {
+      entries[number] = [1, out.length, 0];
+      _writeObject(out, number);
+    }
+    for (var i = 0; i < packed.length; i++) {
+      entries[packed[i]] = [2, objectStreamNumber, i];
+    }
+    entries[objectStreamNumber] = [1, out.length, 0];
+    out
+      ..add(latin1.encode('$objectStreamNumber 0 obj\n<< /Type /ObjStm /N ${packed.length} '
+          '/First ${headerBytes.length} /Length ${objectStreamData.length} /Filter /FlateDecode >>\nstream\n'))
+      ..add(objectStreamData)
+      ..add(latin1.encode('\nendstream\nendobj\n'));
+
+    final xrefOffset = out.length;
+    entries[xrefNumber] = [1, xrefOffset, 0];
+    // Rows use PNG Up prediction, as most writers emit them.
+    final rows = <int>[];
+    var previous = List<int>.filled(7, 0);
+    for (var n = 0; n < size; n++) {
+      final entry = entries[n] ?? [0, 0, n == 0 ? 0xFFFF : 0];
+      final row = [
+        entry[0],
+        (entry[1] >> 24) & 0xFF, (entry[1] >> 16) & 0xFF, (entry[1] >> 8) & 0xFF, entry[1] & 0xFF,
+        (entry[2] >> 8) & 0xFF, entry[2] & 0xFF,
+      ];
+      rows.add(2);
+      for (var i = 0; i < row.length; i++) {
+        rows.add((row[i] - previous[i]) & 0xFF);
+      }
+      previous = row;
+    }
+    final xrefData = zlib.encode(rows);
+    out
+      ..add(latin1.encode('$xrefNumber 0 obj\n<< /Type /XRef /Size $size /W [1 4 2] /Root $root 0 R '
+          '/Filter /FlateDecode /DecodeParms << /Predictor 12 /Columns 7 >> /Length ${xrefData.length} >>\nstream\n'))
+      ..add(xrefData)
+      ..add(latin1.encode('\nendstream\nendobj\nstartxref\n$xrefOffset\n%%EOF\n'));
+    return out.takeBytes();
+  }
+}
+
+/// Builds a catalog and page tree around [contents], one content stream per
+/// page, with the standard Helvetica font as /F1. Objects the resources refer
+/// to can be added to [builder] beforehand.
+({PdfFixtureBuilder builder, int root, List<int> pages}) textDocument(
+  List<String> contents, {
+  PdfFixtureBuilder? builder,
+  bool compress = false,
+  String extraFonts = '',
+  String extraResources = '',
+}) {
+  builder ??= PdfFixtureBuilder();
+  final root = builder.reserve();
+  final pagesNode = builder.reserve();
+  final font = builder.addObject('<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica /Encoding /WinAnsiEncoding >>');
+  final pages = <int>[];
+  for (final content in contents) {
+    final stream = builder.addStream('', latin1.encode(content), compress: compress);
+    pages.add(builder.addObject('<< /Type /Page /Parent $pagesNode 0 R /MediaBox [0 0 612 792] '
+        '/Contents $stream 0 R >>'));
+  }
+  final kids = pages.map((p) => '$p 0 R').join(' ');
+  builder.addObject('<< /Type /Pages /Kids [$kids] /Count ${pages.length} '
+      '/Resources << /Font << /F1 $font 0 R $extraFonts>> $extraResources>> >>', number: pagesNode);
+  builder.addObject('<< /Type /Catalog /Pages $pagesNode 0 R >>', number: root);
+  return (builder: builder, root: root, pages: pages);
+}
+
+/// Content stream showing each line of [lines] on its own text line.
+String textContent(List<String> lines) {
+  final buffer = StringBuffer('BT /F1 12 Tf 72 720 Td\n');
+  for (var i = 0; i < lines.length; i++) {
+    if (i > 0) buffer.write('0 -14 Td\n');
+    final escaped = lines[i].replaceAll(r'\', r'\\').replaceAll('(', r'\(').replaceAll(')', r'\)');
+    buffer.write('($escaped) Tj\n');
+  }
+  buffer.write('ET\n');
+  return buffer.toString();
+}
+
+Future<File> writePdfFixture(Directory directory, String name, List<int> bytes) async {
+  final file = File('${directory.path}/$name');
+  await file.writeAsBytes(bytes, flush: true);
+  return file;
+}
@@ -0,0 +1,116 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:legalease/features/document_scan/domain/models/analysis_result.dart';
+import 'package:legalease/features/export/domain/services/analysis_report_buffer.dart';
+
+/// Reads the buffer back the way windows/runner/report_writer.cpp does.
+class _Reader {
+  final ByteData _data;
+  int _at = 0;
+
+  _Reader(Uint8List bytes) : _data = ByteData.sublistView(bytes);
+
+  bool get isAtEnd => _at == _data.lengthInBytes;
+
+  int u8() => _data.getUint8(_at++);
+
+  int u16() {
+    final value = _data.getUint16(_at, Endian.little);
+    _at += 2;
+    return value;
+  }
+
+  int u32() {
+    final value = _data.getUint32(_at, Endian.little);
+    _at += 4;
+    return value;
+  }
+
+  String string() {
+    final length = u32();
+    final value = utf8.decode(_data.buffer.asUint8List(_data.offsetInBytes + _at, length));
+    _at += length;
+    return value;
+  }
+}
+
+void main() {
+  group('AnalysisReportBuffer', () {
+    const source = 'Rent is due monthly. The Tenant waives all claims — ünconditionally.';
+    final result = AnalysisResult(
+      documentId: 'doc-1',
+      originalText: source,
+      summary: 'A residential lease.',
+      plainEnglishTranslation: 'You pay rent every month.',
+      metadata: const DocumentMetadata(
+        fileName: 'lease.pdf',
+        wordCount: 11,
+        type: DocumentType.lease,
+        confidence: 0.87,
+      ),
+      redFlags: [
+        RedFlagItem(
+          id: 'f1',
+          originalClause: 'The Tenant waives all claims',
+          explanation: 'You give up the right to sue.',
+          severity: RedFlagSeverity.critical,
+          startIndex: source.indexOf('The Tenant'),
+          endIndex: source.indexOf(' —'),
+          confidenceScore: 0.9,
+        ),
+        RedFlagItem(
+          id: 'f2',
+          originalClause: 'x' * 250,
+          explanation: 'Out of range.',
+          severity: RedFlagSeverity.info,
+          startIndex: 10,
+          endIndex: 1000,
+        ),
+      ],
+      status: AnalysisStatus.completed,
+      analyzedAt: DateTime(2026, 10, 19),
+    );
+
+    test('encodes the header, flags and source in the native layout', () {
+      final reader = _Reader(AnalysisReportBuffer.encode(result));
+
+      expect([reader.u8(), reader.u8(), reader.u8(), reader.u8()], AnalysisReportBuffer.magic);
+      expect(reader.u16(), AnalysisReportBuffer.version);
+      expect(reader.string(), 'lease.pdf');
+      expect(reader.string(), 'October 19, 2026');
+      expect(reader.u32(), 11);
+      expect(reader.string(), result.metadata.typeName);
+      expect(reader.u8(), 87);
+      expect(reader.string(), 'A residential lease.');
+      expect(reader.string(), 'You pay rent every month.');
+
+      expect(reader.u32(), 2);
+      expect(reader.u8(), RedFlagSeverity.critical.index);
+      expect(reader.u8(), 90);
+      expect(reader.u32(), source.indexOf('The Tenant'));
+      expect(reader.u32(), source.indexOf(' —'));
+      expect(reader.string(), '"The Tenant waives all claims"');
+      expect(reader.string(), 'You give up the right to sue.');
+
+      expect(reader.u8(), RedFlagSeverity.info.index);
+      expect(reader.u8(), 80);
+      expect(reader.u32(), 10);
+      expect(reader.u32(), source.length);
+      expect(reader.string(), '"${'x' * 200}..."');
+      expect(reader.string(), 'Out of range.');
+
+      expect(reader.string(), source);
+      expect(reader.isAtEnd, isTrue);
+    });
+
+    test('leaves out the source text on request', () {
+      final withSource = AnalysisReportBuffer.encode(result);
+      final withoutSource = AnalysisReportBuffer.encode(result, includeSourceText: false);
+
+      expect(withSource.length - withoutSource.length, utf8.encode(source).length);
+      expect(withoutSource.sublist(withoutSource.length - 4), [0, 0, 0, 0]);
+    });
+  });
+}
@@ -0,0 +1,75 @@
+import 'package:flutter_test/flutter_test.dart';
+import 'package:legalease/features/legal_dictionary/domain/services/dictionary_service.dart';
+import 'package:legalease/features/legal_dictionary/domain/services/fuzzy_term_index.dart';
+
+void main() {
+  group('FuzzyTermIndex', () {
+    final index = FuzzyTermIndex(
+      [
+        ['Indemnity', 'Compensation'],
+        ['Indemnification'],
+        ['Arbitration'],
+        ['Force Majeure', 'Act of God'],
+        ['Void'],
+        ['Voidable'],
+        ['Non-Disclosure Agreement (NDA)'],
+      ],
+      popularity: [1, 0, 1, 1, 0, 0, 1],
+    );
+
+    List<int> search(String query, {int? maxDistance}) =>
+        index.search(query, maxDistance: maxDistance).map((m) => m.index).toList();
+
+    test('finds names despite typos and swapped letters', () {
+      expect(search('indemnfy').first, 0);
+      expect(search('arbitartion'), [2]);
+      expect(index.search('arbitartion').single.distance, 1);
+      expect(search('xyzzy'), isEmpty);
+    });
+
+    test('matches the start of a name while it is typed', () {
+      final matches = index.search('indem');
+      expect(matches.map((m) => m.index), [0, 1]);
+      expect(matches.every((m) => m.isPrefix && m.distance == 0), isTrue);
+    });
+
+    test('ranks whole names before longer names with the same start', () {
+      expect(search('void'), [4, 5]);
+    });
+
+    test('matches later words, synonyms and normalized punctuation', () {
+      expect(search('majeure'), [3]);
+      expect(search('act of god'), [3]);
+      expect(search('non disclosure'), [6]);
+      expect(search('nda').first, 6);
+    });
+
+    test('tolerates no typos in very short queries', () {
+      expect(search('vo'), [4, 5]);
+      expect(search('vx'), isEmpty);
+      expect(search('vx', maxDistance: 1), isNotEmpty);
+    });
+
+    test('respects the limit', () {
+      expect(index.search('i', limit: 1), hasLength(1));
+      expect(index.search('i', limit: 0), isEmpty);
+    });
+  });
+
+  group('DictionaryService', () {
+    final service = DictionaryService();
+
+    test('suggests terms for misspelled queries', () {
+      expect(service.getAutocompleteSuggestions('arbitartion'), contains('Arbitration'));
+      expect(service.getAutocompleteSuggestions('subpena').first, 'Subpoena');
+    });
+
+    test('keeps definition matches after name matches', () {
+      final results = service.searchTerms('negligance');
+      expect(results.first.term, 'Negligence');
+
+      final byDefinition = service.searchTerms('extraordinary event');
+      expect(byDefinition.map((t) => t.term), contains('Force Majeure'));
+    });
+  });
+}
@@ -0,0 +1,141 @@
+import 'dart:async';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:legalease/features/document_scan/data/services/document_processor.dart';
+import 'package:legalease/features/document_scan/data/services/page_pipeline.dart';
+
+void main() {
+  group('PagePipeline', () {
+    PipelineStage delayed(String name, Duration Function(int page) delay, {int concurrency = 1}) {
+      return PipelineStage(name, (input, page) async {
+        await Future.delayed(delay(page));
+        return '$input>$name';
+      }, concurrency: concurrency);
+    }
+
+    test('emits pages in order when later pages finish first', () async {
+      final pipeline = PagePipeline(stages: [
+        delayed('render', (_) => Duration.zero),
+        delayed('ocr', (page) => Duration(milliseconds: page.isEven ? 20 : 1), concurrency: 4),
+      ]);
+
+      final output = await pipeline.run<String>(8).toList();
+
+      expect(output, List.generate(8, (i) => '$i>render>ocr'));
+      expect(pipeline.lastStats!.pages, 8);
+    });
+
+    test('bounds the pages in flight when the consumer is slow', () async {
+      final pipeline = PagePipeline(
+        stages: [
+          delayed('render', (_) => Duration.zero, concurrency: 2),
+          delayed('ocr', (_) => Duration.zero, concurrency: 2),
+        ],
+        queueCapacity: 1,
+        maxInFlight: 3,
+      );
+
+      var count = 0;
+      await for (final _ in pipeline.run<String>(20)) {
+        count++;
+        await Future.delayed(const Duration(milliseconds: 2));
+      }
+
+      expect(count, 20);
+      expect(pipeline.lastStats!.peakInFlight, lessThanOrEqualTo(3));
+    });
+
+    test('bounds the pages in flight behind a slow stage', () async {
+      var active = 0;
+      var peak = 0;
+      final pipeline = PagePipeline(
+        stages: [
+          PipelineStage('render', (_, page) async {
+            active++;
+            peak = peak > active ? peak : active;
+            return page;
+          }),
+          PipelineStage('ocr', (input, _) async {
+            await Future.delayed(const Duration(milliseconds: 5));
+            active--;
+            return input;
+          }),
+        ],
+        queueCapacity: 2,
+      );
+
+      await pipeline.run<int>(30).toList();
+
+      expect(peak, lessThanOrEqualTo(pipeline.maxInFlight));
+      expect(pipeline.lastStats!.peakInFlight, lessThanOrEqualTo(pipeline.maxInFlight));
+    });
+
+    test('overlaps pages across concurrent workers', () async {
+      Future<PipelineStats> measure(int workers) async {
+        final pipeline = PagePipeline(stages: [
+          delayed('render', (_) => const Duration(milliseconds: 2)),
+          delayed('ocr', (_) => const Duration(milliseconds: 20), concurrency: workers),
+        ]);
+        await pipeline.run<String>(24).toList();
+        return pipeline.lastStats!;
+      }
+
+      final serial = await measure(1);
+      final parallel = await measure(4);
+
+      expect(parallel.elapsed * 2, lessThan(serial.elapsed));
+      // ignore: avoid_print
+      print('PagePipeline: ${serial.pagesPerSecond.round()} pages/s with 1 worker, '
+          '${parallel.pagesPerSecond.round()} pages/s with 4');
+    });
+
+    test('stops with CancellationException when cancelled', () async {
+      final token = CancellationToken();
+      final processed = <int>[];
+      final pipeline = PagePipeline(stages: [
+        PipelineStage('ocr', (_, page) async {
+          processed.add(page);
+          await Future.delayed(const Duration(milliseconds: 1));
+          return page;
+        }),
+      ]);
+
+      Future<void> consume() async {
+        await for (final page in pipeline.run<int>(100, cancellationToken: token)) {
+          if (page == 2) token.cancel();
+        }
+      }
+
+      await expectLater(consume(), throwsA(isA<CancellationException>()));
+      expect(processed.length, lessThan(100));
+    });
+
+    test('surfaces a stage error on the stream', () async {
+      final pipeline = PagePipeline(stages: [
+        PipelineStage('render', (_, page) async => page),
+        PipelineStage('ocr', (input, page) async {
+          if (page == 3) throw StateError('page 3 failed');
+          return input;
+        }, concurrency: 2),
+      ]);
+
+      expect(pipeline.run<int>(10).toList(), throwsA(isA<StateError>()));
+    });
+
+    test('stops feeding pages when the listener cancels', () async {
+      final processed = <int>[];
+      final pipeline = PagePipeline(stages: [
+        PipelineStage('ocr', (_, page) async {
+          processed.add(page);
+          return page;
+        }),
+      ], maxInFlight: 4);
+
+      final first = await pipeline.run<int>(1000).first;
+      await Future.delayed(const Duration(milliseconds: 10));
+
+      expect(first, 0);
+      expect(processed.length, lessThan(10));
+    });
+  });
+}
@@ -0,0 +1,237 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:legalease/features/document_scan/data/services/document_processor.dart';
+import 'package:legalease/features/document_scan/data/services/pdf_text_streamer.dart';
+import '../../fixtures/pdf_fixtures.dart';
+
+void main() {
+  group('PdfTextStreamer', () {
+    late Directory tempDir;
+    late PdfTextStreamer streamer;
+
+    setUp(() async {
+      tempDir = await Directory.systemTemp.createTemp('pdf_text_streamer_test');
+      streamer = PdfTextStreamer();
+    });
+
+    tearDown(() async {
+      await tempDir.delete(recursive: true);
+    });
+
+    Future<List<PdfPageText>> extract(List<int> bytes) async {
+      final file = await writePdfFixture(tempDir, 'document.pdf', bytes);
+      return streamer.extract(file).toList();
+    }
+
+    test('reads pages in order from a classic xref table', () async {
+      final doc = textDocument([
+        textContent(['TERMS OF SERVICE', 'Section 1']),
+        textContent(['Section 2']),
+      ]);
+      final pages = await extract(doc.builder.build(root: doc.root));
+
+      expect(pages.map((p) => p.text), ['TERMS OF SERVICE\nSection 1', 'Section 2']);
+      expect(pages.map((p) => p.pageIndex), [0, 1]);
+      expect(pages.every((p) => p.pageCount == 2), isTrue);
+      expect(pages.any((p) => p.needsOcr), isFalse);
+    });
+
+    test('inflates compressed content streams', () async {
+      final doc = textDocument([textContent(['Limitation of liability'])], compress: true);
+      final pages = await extract(doc.builder.build(root: doc.root));
+
+      expect(pages.single.text, 'Limitation of liability');
+    });
+
+    test('resolves objects stored in object streams via an xref stream', () async {
+      final doc = textDocument([
+        textContent(['Privacy Policy']),
+        textContent(['Data retention']),
+      ], compress: true);
+      final pages = await extract(doc.builder.build(root: doc.root, xrefStream: true));
+
+      expect(pages.map((p) => p.text), ['Privacy Policy', 'Data retention']);
+    });
+
+    test('maps composite font codes through ToUnicode', () async {
+      final builder = PdfFixtureBuilder();
+      const cmap = '/CIDInit /ProcSet findresource begin 12 dict begin begincmap\n'
+          '1 begincodespacerange <0000> <FFFF> endcodespacerange\n'
+          '2 beginbfchar <0001> <00C4> <0002> <0020> endbfchar\n'
+          '1 beginbfrange <0010> <0012> <0061> endbfrange\n'
+          'endcmap CMapName currentdict /CMap defineresource pop end end\n';
+      final toUnicode = builder.addStream('', latin1.encode(cmap), compress: true);
+      final font = builder.addObject('<< /Type /Font /Subtype /Type0 /BaseFont /Embedded '
+          '/Encoding /Identity-H /ToUnicode $toUnicode 0 R >>');
+      final doc = textDocument(
+        ['BT /F2 12 Tf 72 720 Td <0001000200100011001200990012> Tj ET\n'],
+        builder: builder,
+        extraFonts: '/F2 $font 0 R ',
+      );
+      final pages = await extract(builder.build(root: doc.root));
+
+      expect(pages.single.text, 'Ä abcc');
+    });
+
+    test('maps simple font codes through Differences glyph names', () async {
+      final builder = PdfFixtureBuilder();
+      final font = builder.addObject('<< /Type /Font /Subtype /Type1 /BaseFont /Embedded '
+          '/Encoding << /Type /Encoding /BaseEncoding /WinAnsiEncoding '
+          '/Differences [65 /uni00C4 /section /f_i /a.sc] >> >>');
+      final doc = textDocument(
+        ['BT /F2 12 Tf 72 720 Td (ABCDE) Tj ET\n'],
+        builder: builder,
+        extraFonts: '/F2 $font 0 R ',
+      );
+      final pages = await extract(builder.build(root: doc.root));
+
+      expect(pages.single.text, 'Ä§fiaE');
+    });
+
+    test('drops a few codes whose glyph names cannot be mapped', () async {
+      final builder = PdfFixtureBuilder();
+      final font = builder.addObject('<< /Type /Font /Subtype /Type1 /BaseFont /Embedded '
+          '/Encoding << /Differences [66 /g17] >> >>');
+      final doc = textDocument(
+        ['BT /F2 12 Tf 72 720 Td (AAAAAB) Tj ET\n'],
+        builder: builder,
+        extraFonts: '/F2 $font 0 R ',
+      );
+      final pages = await extract(builder.build(root: doc.root));
+
+      expect(pages.single.text, 'AAAAA');
+    });
+
+    test('rejects pages in composite fonts without ToUnicode', () async {
+      final builder = PdfFixtureBuilder();
+      final font = builder.addObject('<< /Type /Font /Subtype /Type0 /BaseFont /Embedded '
+          '/Encoding /Identity-H >>');
+      final doc = textDocument(
+        [textContent(['Cover letter']), 'BT /F2 12 Tf 72 720 Td <002A0033002F> Tj ET\n'],
+        builder: builder,
+        extraFonts: '/F2 $font 0 R ',
+      );
+
+      expect(extract(builder.build(root: doc.root)), throwsA(isA<PdfStreamingException>()));
+    });
+
+    test('rejects pages whose Differences names are mostly unmapped', () async {
+      final builder = PdfFixtureBuilder();
+      final font = builder.addObject('<< /Type /Font /Subtype /Type1 /BaseFont /Embedded '
+          '/Encoding << /Differences [1 /g1 /g2 /g3] >> >>');
+      final doc = textDocument(
+        ['BT /F2 12 Tf 72 720 Td <010203> Tj ET\n'],
+        builder: builder,
+        extraFonts: '/F2 $font 0 R ',
+      );
+
+      expect(extract(builder.build(root: doc.root)), throwsA(isA<PdfStreamingException>()));
+    });
+
+    test('turns wide TJ adjustments into word spaces', () async {
+      final doc = textDocument(['BT /F1 12 Tf 72 720 Td [(Gover) -15 (ning) -320 (law) 40 (.)] TJ ET\n']);
+      final pages = await extract(doc.builder.build(root: doc.root));
+
+      expect(pages.single.text, 'Governing law.');
+    });
+
+    test('flags image-only pages for OCR without reading image data', () async {
+      final builder = PdfFixtureBuilder();
+      final image = builder.addStream(
+        '/Type /XObject /Subtype /Image /Width 2 /Height 2 /ColorSpace /DeviceGray /BitsPerComponent 8',
+        [0, 255, 255, 0],
+      );
+      final doc = textDocument(
+        [textContent(['Cover letter']), 'q 612 0 0 792 0 0 cm /Im1 Do Q\n'],
+        builder: builder,
+        extraResources: '/XObject << /Im1 $image 0 R >> ',
+      );
+      final pages = await extract(builder.build(root: doc.root));
+
+      expect(pages[0].needsOcr, isFalse);
+      expect(pages[1].hasImages, isTrue);
+      expect(pages[1].needsOcr, isTrue);
+    });
+
+    test('prefers objects from the latest incremental update', () async {
+      final doc = textDocument([textContent(['Draft agreement'])]);
+      final base = doc.builder.build(root: doc.root);
+      final content = doc.builder.addStream('', latin1.encode(textContent(['Final agreement'])));
+      doc.builder.addObject('<< /Type /Page /MediaBox [0 0 612 792] /Contents $content 0 R >>', number: doc.pages.single);
+      final pages = await extract(doc.builder.buildIncrement(base, root: doc.root));
+
+      expect(pages.single.text, 'Final agreement');
+    });
+
+    test('rejects encrypted documents', () async {
+      final doc = textDocument([textContent(['Secret'])]);
+      final bytes = doc.builder.build(
+        root: doc.root,
+        trailerExtra: '/Encrypt << /Filter /Standard /V 1 /R 2 /O <00> /U <00> /P -4 >> ',
+      );
+
+      expect(extract(bytes), throwsA(isA<PdfStreamingException>()));
+    });
+
+    test('rejects files without a cross-reference table', () async {
+      expect(extract(latin1.encode('%PDF-1.4\nnot a pdf\n')), throwsA(isA<PdfStreamingException>()));
+    });
+
+    test('stops between pages when cancelled', () async {
+      final doc = textDocument(List.generate(5, (i) => textContent(['Page $i'])));
+      final file = await writePdfFixture(tempDir, 'document.pdf', doc.builder.build(root: doc.root));
+      final token = CancellationToken();
+      final seen = <int>[];
+
+      Future<void> consume() async {
+        await for (final page in streamer.extract(file, cancellationToken: token)) {
+          seen.add(page.pageIndex);
+          token.cancel();
+        }
+      }
+
+      await expectLater(consume(), throwsA(isA<CancellationException>()));
+      expect(seen, [0]);
+    });
+
+    test('streams a 1000-page document', () async {
+      final doc = textDocument(
+        List.generate(1000, (i) => textContent(['Clause $i', 'The parties agree to the terms of clause $i.'])),
+        compress: true,
+      );
+      final file = await writePdfFixture(tempDir, 'large.pdf', doc.builder.build(root: doc.root, xrefStream: true));
+
+      final stopwatch = Stopwatch()..start();
+      var count = 0;
+      await for (final page in streamer.extract(file)) {
+        expect(page.text, startsWith('Clause ${page.pageIndex}\n'));
+        count++;
+      }
+      stopwatch.stop();
+
+      expect(count, 1000);
+      // ignore: avoid_print
+      print('PdfTextStreamer: ${(count * 1000 / (stopwatch.elapsedMilliseconds + 1)).round()} pages/s');
+    });
+  });
+
+  group('DocumentProcessor.extractTextFromPdfStreaming', () {
+    test('joins streamed pages and reports progress', () async {
+      final tempDir = await Directory.systemTemp.createTemp('pdf_streaming_test');
+      addTearDown(() => tempDir.delete(recursive: true));
+      final doc = textDocument([textContent(['First']), textContent(['Second'])], compress: true);
+      final file = await writePdfFixture(tempDir, 'document.pdf', doc.builder.build(root: doc.root));
+      final progress = <int>[];
+
+      final text = await DocumentProcessor().extractTextFromPdfStreaming(
+        file,
+        onProgress: (current, total, _) => progress.add(current),
+      );
+
+      expect(text, 'First\nSecond');
+      expect(progress, [1, 2]);
+    });
+  });
+}
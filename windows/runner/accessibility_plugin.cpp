@@ -1,11 +1,23 @@
 #include "accessibility_plugin.h"
+#include "image_preprocess.h"
+#include "keyword_detector.h"
+#include "report_writer.h"
+#include "startup_trace.h"
+#include "text_segmenter.h"
+#include "utils.h"
 #include <flutter/standard_method_codec.h>
 #include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
 #include <string>
 #include <sstream>
+#include <thread>
 
 static const char* kMethodChannelName = "legalease_windows_accessibility";
 static const char* kEventChannelName = "legalease_windows_accessibility_events";
+static const char* kMemoryEventChannelName = "legalease_windows_memory_events";
 
 static const char* kMethodIsAccessibilityEnabled = "isAccessibilityEnabled";
 static const char* kMethodExtractScreenText = "extractScreenText";
@@ -13,6 +25,40 @@ static const char* kMethodGetForegroundWindow = "getForegroundWindow";
 static const char* kMethodHasOverlayPermission = "hasOverlayPermission";
 static const char* kMethodStartMonitoring = "startMonitoring";
 static const char* kMethodStopMonitoring = "stopMonitoring";
+static const char* kMethodExtractWindowDelta = "extractWindowDelta";
+static const char* kMethodExtractScreenTextPatch = "extractScreenTextPatch";
+static const char* kMethodExtractWindows = "extractWindows";
+static const char* kMethodExtractScreenTextViewportFirst = "extractScreenTextViewportFirst";
+static const char* kMethodGetStartupMetrics = "getStartupMetrics";
+static const char* kMethodGetExtractionMemoryStats = "getExtractionMemoryStats";
+static const char* kMethodPreprocessImageForOcr = "preprocessImageForOcr";
+static const char* kMethodWriteAnalysisReport = "writeAnalysisReport";
+static const char* kMethodSegmentText = "segmentText";
+static const char* kMethodGetProviderHealth = "getProviderHealth";
+static const char* kMethodGetRefreshStats = "getRefreshStats";
+static const char* kMethodGetMemoryBudget = "getMemoryBudget";
+static const char* kMethodSetMemoryBudget = "setMemoryBudget";
+
+// Methods that need UI Automation and so run on its thread.
+static const char* const kAutomationMethods[] = {
+    kMethodIsAccessibilityEnabled,
+    kMethodExtractScreenText,
+    kMethodGetForegroundWindow,
+    kMethodStartMonitoring,
+    kMethodStopMonitoring,
+    kMethodExtractWindowDelta,
+    kMethodExtractScreenTextPatch,
+    kMethodExtractScreenTextViewportFirst,
+    kMethodGetExtractionMemoryStats,
+    kMethodGetRefreshStats,
+};
+
+// Event kinds that supersede undelivered events of the same kind.
+static const uint32_t kForegroundWindowEvent = 1;
+// Keyed by window handle.
+static const uint32_t kWindowContentEvent = 2;
+static const uint32_t kMemoryPressureEvent = 3;
+static const size_t kMaxExtractionWorkers = 4;
 
 static std::string WstringToString(const std::wstring& wstr) {
     if (wstr.empty()) return std::string();
@@ -22,7 +68,118 @@ static std::string WstringToString(const std::wstring& wstr) {
     return result;
 }
 
-void AccessibilityPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
+static std::wstring StringToWstring(const std::string& str) {
+    if (str.empty()) return std::wstring();
+    int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.length()), nullptr, 0);
+    std::wstring result(sizeNeeded, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.length()), &result[0], sizeNeeded);
+    return result;
+}
+
+static flutter::EncodableValue EncodeSnapshotElements(const std::vector<SnapshotElement>& elements) {
+    flutter::EncodableList list;
+    list.reserve(elements.size());
+    for (const auto& element : elements) {
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("key")] = flutter::EncodableValue(element.key);
+        item[flutter::EncodableValue("parent")] = flutter::EncodableValue(element.parentKey);
+        item[flutter::EncodableValue("controlType")] = flutter::EncodableValue(element.controlType);
+        item[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(element.text));
+        list.push_back(flutter::EncodableValue(item));
+    }
+    return flutter::EncodableValue(list);
+}
+
+static int IntArgument(const flutter::EncodableMap& args, const char* key, int fallback) {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it == args.end()) return fallback;
+    if (const auto* value = std::get_if<int32_t>(&it->second)) return *value;
+    if (const auto* value = std::get_if<int64_t>(&it->second)) return static_cast<int>(*value);
+    return fallback;
+}
+
+static bool BoolArgument(const flutter::EncodableMap& args, const char* key, bool fallback) {
+    auto it = args.find(flutter::EncodableValue(key));
+    if (it == args.end()) return fallback;
+    const auto* value = std::get_if<bool>(&it->second);
+    return value ? *value : fallback;
+}
+
+static const char* MemoryPressureName(MemoryPressure level) {
+    switch (level) {
+    case MemoryPressure::kNone: return "none";
+    case MemoryPressure::kModerate: return "moderate";
+    case MemoryPressure::kCritical: return "critical";
+    }
+    return "none";
+}
+
+static flutter::EncodableMap MemoryPressureEvent(MemoryPressure level, size_t bytes, size_t budgetBytes) {
+    flutter::EncodableMap event;
+    event[flutter::EncodableValue("type")] = flutter::EncodableValue("memoryPressure");
+    event[flutter::EncodableValue("level")] = flutter::EncodableValue(MemoryPressureName(level));
+    event[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(bytes));
+    event[flutter::EncodableValue("budgetBytes")] = flutter::EncodableValue(static_cast<int64_t>(budgetBytes));
+    return event;
+}
+
+static HWND WindowFromArguments(const flutter::EncodableValue* arguments) {
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    if (!args) return nullptr;
+    auto handle_it = args->find(flutter::EncodableValue("handle"));
+    if (handle_it == args->end()) return nullptr;
+    return reinterpret_cast<HWND>(static_cast<intptr_t>(handle_it->second.LongValue()));
+}
+
+// Runs |extract| against |hwnd|'s process under |watchdog|, on the thread
+// that owns |automation|. Every provider answer restarts the watchdog's
+// timeout, so only a call that hangs is abandoned, not a long walk. A
+// provider error counts against the process even when |extract| still
+// returned a partial result.
+static bool RunGuarded(ProviderWatchdog& watchdog, UIAutomation& automation, HWND hwnd,
+                       const std::function<bool()>& extract, std::function<void()> onAbandoned = nullptr) {
+    DWORD processId = 0;
+    GetWindowThreadProcessId(hwnd, &processId);
+    ProviderCall call(watchdog, static_cast<uint32_t>(processId), GetCurrentThreadId(), std::move(onAbandoned));
+    if (!call.Allowed()) return false;
+    automation.SetProgressCallback([&call] { call.Progress(); });
+    const bool ok = extract();
+    automation.SetProgressCallback(nullptr);
+    return call.Finish(automation.ProviderError() == S_OK) && ok;
+}
+
+namespace {
+
+// Each instance lives on one scheduler worker thread and owns that thread's
+// MTA apartment and IUIAutomation object.
+class UIAutomationExtractionProvider : public TextExtractionProvider {
+public:
+    explicit UIAutomationExtractionProvider(ProviderWatchdog& watchdog) : watchdog_(watchdog) {
+        if (!automation_.Initialize()) {
+            OutputDebugStringW(L"Warning: UI Automation worker initialization failed\n");
+        }
+    }
+
+    bool ExtractText(uint64_t target, std::wstring& text) override {
+        HWND hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(target));
+        if (!automation_.IsInitialized() || !IsWindow(hwnd)) return false;
+        const bool ok = RunGuarded(watchdog_, automation_, hwnd, [&] {
+            text = automation_.ExtractTextFromWindow(hwnd);
+            return true;
+        });
+        if (!ok) text.clear();
+        return ok;
+    }
+
+private:
+    ProviderWatchdog& watchdog_;
+    UIAutomation automation_;
+};
+
+}  // namespace
+
+AccessibilityPlugin* AccessibilityPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar,
+                                                                EventBus& eventBus) {
     auto methodChannel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
         registrar->messenger(),
         kMethodChannelName,
@@ -35,15 +192,28 @@ void AccessibilityPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows*
         &flutter::StandardMethodCodec::GetInstance()
     );
 
+    auto memoryEventChannel = std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+        registrar->messenger(),
+        kMemoryEventChannelName,
+        &flutter::StandardMethodCodec::GetInstance()
+    );
+
     auto plugin = std::make_unique<AccessibilityPlugin>();
+    plugin->registrar_ = registrar;
+    plugin->eventBus_ = &eventBus;
+    MemoryGovernor::Instance().SetPressureCallback(
+        [plugin_ptr = plugin.get()](MemoryPressure level, size_t bytes, size_t budgetBytes) {
+            plugin_ptr->OnMemoryPressure(level, bytes, budgetBytes);
+        });
 
-    plugin->uiAutomation_ = std::make_unique<UIAutomation>();
-    if (!plugin->uiAutomation_->Initialize()) {
-        OutputDebugStringW(L"Warning: UI Automation initialization failed\n");
-    }
+    // UI Automation is not initialised here: CoCreateInstance(CUIAutomation)
+    // and the first provider connection cost tens of milliseconds on the
+    // start-up path. The runner calls StartDeferredInitialization() after the
+    // first frame instead.
 
-    auto handler = std::make_unique<AccessibilityStreamHandler>(plugin->uiAutomation_.get());
+    auto handler = std::make_unique<AccessibilityStreamHandler>(plugin.get());
     eventChannel->SetStreamHandler(std::move(handler));
+    memoryEventChannel->SetStreamHandler(std::make_unique<MemoryPressureStreamHandler>(plugin.get()));
 
     methodChannel->SetMethodCallHandler(
         [plugin_ptr = plugin.get()](const auto& call, auto result) {
@@ -51,12 +221,37 @@ void AccessibilityPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows*
         }
     );
 
+    AccessibilityPlugin* plugin_ptr = plugin.get();
     registrar->AddPlugin(std::move(plugin));
+    return plugin_ptr;
 }
 
-AccessibilityPlugin::AccessibilityPlugin() {}
+// The watchdog unblocks a hung call by cancelling it on the calling thread;
+// UIAutomation enables call cancellation on every thread it initialises.
+AccessibilityPlugin::AccessibilityPlugin()
+    : providerWatchdog_([](uint64_t thread) { CoCancelCall(static_cast<DWORD>(thread), 0); }),
+      reportFontPool_(MemoryGovernor::Instance(), "reportFonts", PoolPriority::kPinned) {}
 
-AccessibilityPlugin::~AccessibilityPlugin() {}
+AccessibilityPlugin::~AccessibilityPlugin() {
+    // Returns once a callback in progress has finished; the caches released
+    // below no longer reach this plugin.
+    MemoryGovernor::Instance().SetPressureCallback(nullptr);
+    // The workers are joined below; a provider call in progress would
+    // otherwise hold that up until the watchdog's timeout.
+    providerWatchdog_.CancelAll();
+    automationWorker_.Stop();
+    imageWorker_.Stop();
+    reportWorker_.Stop();
+    textWorker_.Stop();
+    if (extractionScheduler_) {
+        extractionScheduler_->Stop();
+    }
+    // Nothing posts any more; drop what has not been delivered, since it
+    // refers to this plugin.
+    if (eventBus_) {
+        eventBus_->Discard(this);
+    }
+}
 
 void AccessibilityPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
@@ -64,25 +259,118 @@ void AccessibilityPlugin::HandleMethodCall(
     
     const std::string& method_name = method_call.method_name();
 
-    if (method_name == kMethodIsAccessibilityEnabled) {
-        result->Success(IsAccessibilityEnabled());
-    } else if (method_name == kMethodExtractScreenText) {
-        result->Success(ExtractScreenText());
-    } else if (method_name == kMethodGetForegroundWindow) {
-        result->Success(GetForegroundWindow());
-    } else if (method_name == kMethodHasOverlayPermission) {
+    for (const char* automationMethod : kAutomationMethods) {
+        if (method_name == automationMethod) {
+            RunOnAutomationThread(method_call, std::move(result));
+            return;
+        }
+    }
+
+    if (method_name == kMethodHasOverlayPermission) {
         result->Success(HasOverlayPermission());
-    } else if (method_name == kMethodStartMonitoring) {
-        result->Success(StartMonitoring());
-    } else if (method_name == kMethodStopMonitoring) {
-        result->Success(StopMonitoring());
+    } else if (method_name == kMethodExtractWindows) {
+        result->Success(ExtractWindows(method_call.arguments()));
+    } else if (method_name == kMethodGetStartupMetrics) {
+        result->Success(GetStartupMetrics());
+    } else if (method_name == kMethodPreprocessImageForOcr) {
+        PreprocessImageForOcr(method_call.arguments(), std::move(result));
+    } else if (method_name == kMethodWriteAnalysisReport) {
+        WriteAnalysisReport(method_call.arguments(), std::move(result));
+    } else if (method_name == kMethodSegmentText) {
+        SegmentText(method_call.arguments(), std::move(result));
+    } else if (method_name == kMethodGetProviderHealth) {
+        result->Success(GetProviderHealth());
+    } else if (method_name == kMethodGetMemoryBudget) {
+        result->Success(GetMemoryBudget());
+    } else if (method_name == kMethodSetMemoryBudget) {
+        SetMemoryBudget(method_call.arguments(), std::move(result));
     } else {
         result->NotImplemented();
     }
 }
 
+void AccessibilityPlugin::StartDeferredInitialization() {
+    if (automationWorker_.IsStarted()) return;
+
+    StartupTrace::Instance().Mark("uia_init_requested");
+    automationWorker_.Start(
+        [this] {
+            uiAutomation_ = std::make_unique<UIAutomation>();
+            if (!uiAutomation_->Initialize()) {
+                OutputDebugStringW(L"Warning: UI Automation initialization failed\n");
+                return false;
+            }
+            return true;
+        },
+        [this] {
+            refreshScheduler_.reset();
+            uiAutomation_.reset();
+        });
+
+    automationWorker_.Post([this](bool ready) {
+        StartupTrace& trace = StartupTrace::Instance();
+        trace.MarkAt("uia_init_started", automationWorker_.InitStartedMicros());
+        trace.MarkAt(ready ? "uia_ready" : "uia_failed", automationWorker_.InitFinishedMicros());
+        OutputDebugStringA(("Startup: " + trace.Format() + "\n").c_str());
+    });
+}
+
+void AccessibilityPlugin::RunOnAutomationThread(
+    const flutter::MethodCall<flutter::EncodableValue>& method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    // A call that arrives before the runner's first frame starts the worker.
+    StartDeferredInitialization();
+
+    // The call and its arguments do not outlive this function, and
+    // std::function needs copyable captures, so the task owns copies.
+    std::string method = method_call.method_name();
+    auto arguments = std::make_shared<flutter::EncodableValue>(
+        method_call.arguments() ? *method_call.arguments() : flutter::EncodableValue());
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> sharedResult(std::move(result));
+
+    const bool queued = automationWorker_.Post([this, method, arguments, sharedResult](bool ready) {
+        // Answered once: by the method, or by the watchdog if a provider
+        // call made on its behalf hangs.
+        auto answered = std::make_shared<std::atomic<bool>>(false);
+        Reply reply = [this, sharedResult, answered](flutter::EncodableValue value) {
+            if (answered->exchange(true)) return;
+            PostToPlatformThread([sharedResult, value = std::move(value)] { sharedResult->Success(value); });
+        };
+        abandonCurrentCall_ = [this, sharedResult, answered] {
+            if (answered->exchange(true)) return;
+            PostToPlatformThread(
+                [sharedResult] { sharedResult->Error("timeout", "The target application is not responding"); });
+        };
+
+        if (method == kMethodExtractScreenTextViewportFirst) {
+            // Completes the call itself once the visible band is in.
+            ExtractScreenTextViewportFirst(arguments.get(), reply);
+        } else {
+            reply(HandleAutomationCall(method, arguments.get()));
+        }
+        abandonCurrentCall_ = nullptr;
+    });
+    if (!queued) {
+        sharedResult->Error("unavailable", "UI Automation has shut down");
+    }
+}
+
+flutter::EncodableValue AccessibilityPlugin::HandleAutomationCall(
+    const std::string& method, const flutter::EncodableValue* arguments) {
+    if (method == kMethodIsAccessibilityEnabled) return IsAccessibilityEnabled();
+    if (method == kMethodExtractScreenText) return ExtractScreenText();
+    if (method == kMethodGetForegroundWindow) return GetForegroundWindow();
+    if (method == kMethodStartMonitoring) return StartMonitoring();
+    if (method == kMethodStopMonitoring) return StopMonitoring();
+    if (method == kMethodExtractWindowDelta) return ExtractWindowDelta(arguments);
+    if (method == kMethodExtractScreenTextPatch) return ExtractScreenTextPatch(arguments);
+    if (method == kMethodGetExtractionMemoryStats) return GetExtractionMemoryStats();
+    if (method == kMethodGetRefreshStats) return GetRefreshStats();
+    return flutter::EncodableValue();
+}
+
 flutter::EncodableValue AccessibilityPlugin::IsAccessibilityEnabled() {
-    return flutter::EncodableValue(true);
+    return flutter::EncodableValue(uiAutomation_ && uiAutomation_->IsInitialized());
 }
 
 flutter::EncodableValue AccessibilityPlugin::ExtractScreenText() {
@@ -90,8 +378,10 @@ flutter::EncodableValue AccessibilityPlugin::ExtractScreenText() {
         return flutter::EncodableValue("");
     }
 
-    std::wstring text = uiAutomation_->ExtractTextFromForegroundWindow();
-    return flutter::EncodableValue(WstringToString(text));
+    std::string text;
+    HWND hwnd = uiAutomation_->GetForegroundWindowHandle();
+    GuardedAutomationCall(hwnd, [&] { return uiAutomation_->ExtractTextFromWindowUtf8(hwnd, text); });
+    return flutter::EncodableValue(std::move(text));
 }
 
 flutter::EncodableValue AccessibilityPlugin::GetForegroundWindow() {
@@ -111,10 +401,21 @@ flutter::EncodableValue AccessibilityPlugin::GetForegroundWindow() {
     result[flutter::EncodableValue("hasTCKeywords")] = flutter::EncodableValue(false);
     result[flutter::EncodableValue("hasPrivacyKeywords")] = flutter::EncodableValue(false);
 
-    if (uiAutomation_->IsInitialized()) {
-        std::wstring text = uiAutomation_->ExtractTextFromForegroundWindow();
-        result[flutter::EncodableValue("hasTCKeywords")] = flutter::EncodableValue(uiAutomation_->ContainsTCKewords(text));
-        result[flutter::EncodableValue("hasPrivacyKeywords")] = flutter::EncodableValue(uiAutomation_->ContainsPrivacyKeywords(text));
+    WindowClassification classification;
+    if (uiAutomation_->IsInitialized() && GuardedAutomationCall(handle, [&] {
+            return uiAutomation_->ClassifyWindow(handle, kKeywordCategoryTerms | kKeywordCategoryPrivacy, classification);
+        })) {
+        const uint32_t categories = classification.categories;
+        result[flutter::EncodableValue("hasTCKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryTerms) != 0);
+        result[flutter::EncodableValue("hasPrivacyKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryPrivacy) != 0);
+        result[flutter::EncodableValue("elementsVisited")] = flutter::EncodableValue(static_cast<int64_t>(classification.elementsVisited));
+        if (classification.matchedElement != KeywordStream::kNoElement) {
+            flutter::EncodableMap matched;
+            matched[flutter::EncodableValue("index")] = flutter::EncodableValue(static_cast<int64_t>(classification.matchedElement));
+            matched[flutter::EncodableValue("controlType")] = flutter::EncodableValue(classification.matchedControlType);
+            matched[flutter::EncodableValue("name")] = flutter::EncodableValue(WstringToString(classification.matchedName));
+            result[flutter::EncodableValue("matchedElement")] = flutter::EncodableValue(matched);
+        }
     }
 
     return flutter::EncodableValue(result);
@@ -124,10 +425,57 @@ flutter::EncodableValue AccessibilityPlugin::HasOverlayPermission() {
     return flutter::EncodableValue(true);
 }
 
+// Samples what the refresh policy adapts to. Windows of this process are
+// never monitored, so while one is in front no window is.
+static RefreshSignals SampleRefreshSignals() {
+    RefreshSignals signals;
+    HWND foreground = ::GetForegroundWindow();
+    DWORD processId = 0;
+    if (foreground) GetWindowThreadProcessId(foreground, &processId);
+    if (processId != 0 && processId != GetCurrentProcessId()) {
+        signals.foreground = static_cast<uint64_t>(reinterpret_cast<intptr_t>(foreground));
+    }
+
+    SYSTEM_POWER_STATUS power;
+    if (GetSystemPowerStatus(&power)) {
+        signals.onBattery = power.ACLineStatus == 0;
+        signals.batterySaver = power.SystemStatusFlag != 0;
+    }
+
+    // GetLastInputInfo reports a tick count; rebase it onto the steady clock
+    // the scheduler runs on.
+    LASTINPUTINFO input = {sizeof(LASTINPUTINFO), 0};
+    const int64_t now = RefreshScheduler::NowMicros();
+    if (GetLastInputInfo(&input)) {
+        const DWORD idleMillis = GetTickCount() - input.dwTime;
+        signals.lastInputMicros = now - static_cast<int64_t>(idleMillis) * 1000;
+    } else {
+        signals.lastInputMicros = now;
+    }
+    return signals;
+}
+
+static bool ProbeRefreshWindow(uint64_t window, bool& visible) {
+    HWND hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(window));
+    if (!IsWindow(hwnd)) return false;
+    visible = IsWindowVisible(hwnd) && !IsIconic(hwnd);
+    return true;
+}
+
 flutter::EncodableValue AccessibilityPlugin::StartMonitoring() {
     if (uiAutomation_) {
         uiAutomation_->StartMonitoring();
     }
+    if (uiAutomation_ && uiAutomation_->IsInitialized() && !refreshScheduler_) {
+        refreshScheduler_ = std::make_unique<RefreshScheduler>(
+            SampleRefreshSignals, ProbeRefreshWindow,
+            [this](uint64_t window) {
+                // Only fails once the worker is shutting down, and with it
+                // the scheduler.
+                automationWorker_.Post([this, window](bool ready) { RefreshWindow(window); });
+            });
+        refreshScheduler_->Start();
+    }
     return flutter::EncodableValue(true);
 }
 
@@ -135,11 +483,625 @@ flutter::EncodableValue AccessibilityPlugin::StopMonitoring() {
     if (uiAutomation_) {
         uiAutomation_->StopMonitoring();
     }
+    // Checks already queued find no scheduler and are dropped.
+    refreshScheduler_.reset();
     return flutter::EncodableValue(true);
 }
 
-AccessibilityStreamHandler::AccessibilityStreamHandler(UIAutomation* uiAutomation)
-    : uiAutomation_(uiAutomation), sink_(nullptr) {}
+void AccessibilityPlugin::RefreshWindow(uint64_t window) {
+    if (!refreshScheduler_) return;
+    if (!hasListener_.load() || !uiAutomation_ || !uiAutomation_->IsInitialized()) {
+        refreshScheduler_->Skip(window);
+        return;
+    }
+
+    HWND hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(window));
+    std::wstring text;
+    if (!GuardedAutomationCall(hwnd, [&] {
+            text = uiAutomation_->ExtractTextFromWindow(hwnd);
+            return true;
+        })) {
+        refreshScheduler_->Fail(window);
+        return;
+    }
+    if (!refreshScheduler_->Complete(window, ContentFingerprint(text.data(), text.size()))) return;
+
+    const uint32_t categories = KeywordDetector::Default().Scan(text);
+    wchar_t title[256] = {};
+    GetWindowTextW(hwnd, title, 256);
+
+    flutter::EncodableMap event;
+    event[flutter::EncodableValue("type")] = flutter::EncodableValue("windowContentChanged");
+    event[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(window));
+    event[flutter::EncodableValue("windowTitle")] = flutter::EncodableValue(WstringToString(title));
+    event[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(text));
+    event[flutter::EncodableValue("hasTCKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryTerms) != 0);
+    event[flutter::EncodableValue("hasPrivacyKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryPrivacy) != 0);
+    PostEventFromWorker(std::move(event), EventBus::Priority::kBulk, kWindowContentEvent, window);
+}
+
+flutter::EncodableValue AccessibilityPlugin::ExtractWindowDelta(const flutter::EncodableValue* arguments) {
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(false);
+
+    if (!uiAutomation_ || !uiAutomation_->IsInitialized()) {
+        return flutter::EncodableValue(result);
+    }
+
+    HWND hwnd = WindowFromArguments(arguments);
+    if (!hwnd) {
+        hwnd = uiAutomation_->GetForegroundWindowHandle();
+    }
+
+    TreeDelta delta;
+    bool isFullSnapshot = false;
+    bool extracted = false;
+    if (!GuardedAutomationCall(hwnd, [&] {
+            extracted = uiAutomation_->ExtractWindowDelta(hwnd, delta, isFullSnapshot);
+            return extracted;
+        })) {
+        // Dart never sees a delta from an abandoned call, so the next one
+        // has to start from a full snapshot.
+        if (extracted) uiAutomation_->ForgetWindowSnapshot(hwnd);
+        return flutter::EncodableValue(result);
+    }
+
+    const int64_t handle = static_cast<int64_t>(reinterpret_cast<intptr_t>(hwnd));
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(true);
+    result[flutter::EncodableValue("handle")] = flutter::EncodableValue(handle);
+    result[flutter::EncodableValue("full")] = flutter::EncodableValue(isFullSnapshot);
+    result[flutter::EncodableValue("inserted")] = flutter::EncodableValue(static_cast<int>(delta.inserted.size()));
+    result[flutter::EncodableValue("changed")] = flutter::EncodableValue(static_cast<int>(delta.changed.size()));
+    result[flutter::EncodableValue("removed")] = flutter::EncodableValue(static_cast<int>(delta.removed.size()));
+
+    if (!delta.IsEmpty()) {
+        flutter::EncodableList removed;
+        removed.reserve(delta.removed.size());
+        for (const auto& key : delta.removed) {
+            removed.push_back(flutter::EncodableValue(key));
+        }
+
+        flutter::EncodableMap event;
+        event[flutter::EncodableValue("type")] = flutter::EncodableValue("treeDelta");
+        event[flutter::EncodableValue("handle")] = flutter::EncodableValue(handle);
+        event[flutter::EncodableValue("full")] = flutter::EncodableValue(isFullSnapshot);
+        event[flutter::EncodableValue("inserted")] = EncodeSnapshotElements(delta.inserted);
+        event[flutter::EncodableValue("changed")] = EncodeSnapshotElements(delta.changed);
+        event[flutter::EncodableValue("removed")] = flutter::EncodableValue(removed);
+        // Same priority as the method result, so the delta still arrives
+        // first.
+        PostEventFromWorker(std::move(event), EventBus::Priority::kNormal);
+    }
+
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::ExtractScreenTextPatch(const flutter::EncodableValue* arguments) {
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(false);
+
+    if (!uiAutomation_ || !uiAutomation_->IsInitialized()) {
+        return flutter::EncodableValue(result);
+    }
+
+    HWND hwnd = WindowFromArguments(arguments);
+    if (!hwnd) {
+        hwnd = uiAutomation_->GetForegroundWindowHandle();
+    }
+
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    if (args && BoolArgument(*args, "reset", false)) {
+        uiAutomation_->ForgetWindowText(hwnd);
+    }
+
+    std::vector<TextPatch> patches;
+    std::wstring fullText;
+    bool isFullText = true;
+    bool extracted = false;
+    if (!GuardedAutomationCall(hwnd, [&] {
+            extracted = uiAutomation_->ExtractWindowTextPatch(hwnd, patches, fullText, isFullText);
+            return extracted;
+        })) {
+        // As for deltas: the next patch must not build on unseen text.
+        if (extracted) uiAutomation_->ForgetWindowText(hwnd);
+        return flutter::EncodableValue(result);
+    }
+
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(true);
+    result[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(reinterpret_cast<intptr_t>(hwnd)));
+    result[flutter::EncodableValue("full")] = flutter::EncodableValue(isFullText);
+
+    if (isFullText) {
+        result[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(fullText));
+        return flutter::EncodableValue(result);
+    }
+
+    flutter::EncodableList encoded;
+    encoded.reserve(patches.size());
+    for (const auto& patch : patches) {
+        flutter::EncodableMap item;
+        const bool isInsert = patch.kind == TextPatch::Kind::kInsert;
+        item[flutter::EncodableValue("op")] = flutter::EncodableValue(isInsert ? "insert" : "delete");
+        item[flutter::EncodableValue("offset")] = flutter::EncodableValue(static_cast<int64_t>(patch.offset));
+        item[flutter::EncodableValue("length")] = flutter::EncodableValue(static_cast<int64_t>(patch.length));
+        if (isInsert) {
+            item[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(patch.text));
+        }
+        encoded.push_back(flutter::EncodableValue(item));
+    }
+    result[flutter::EncodableValue("patches")] = flutter::EncodableValue(encoded);
+    return flutter::EncodableValue(result);
+}
+
+void AccessibilityPlugin::ExtractScreenTextViewportFirst(const flutter::EncodableValue* arguments,
+                                                         const Reply& reply) {
+    flutter::EncodableMap visible;
+    visible[flutter::EncodableValue("success")] = flutter::EncodableValue(false);
+
+    if (!uiAutomation_ || !uiAutomation_->IsInitialized()) {
+        reply(flutter::EncodableValue(visible));
+        return;
+    }
+
+    HWND hwnd = WindowFromArguments(arguments);
+    if (!hwnd) {
+        hwnd = uiAutomation_->GetForegroundWindowHandle();
+    }
+    const int64_t handle = static_cast<int64_t>(reinterpret_cast<intptr_t>(hwnd));
+
+    // The visible band completes the method call so Dart can start analysing
+    // it; the rest of the window follows as viewportText events.
+    const bool ok = GuardedAutomationCall(hwnd, [&] {
+        return uiAutomation_->ExtractTextByViewport(hwnd, [&](size_t band, const std::wstring& text) {
+            if (band == 0) {
+                visible[flutter::EncodableValue("success")] = flutter::EncodableValue(true);
+                visible[flutter::EncodableValue("handle")] = flutter::EncodableValue(handle);
+                visible[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(text));
+                reply(flutter::EncodableValue(visible));
+                return hasListener_.load();
+            }
+            flutter::EncodableMap event;
+            event[flutter::EncodableValue("type")] = flutter::EncodableValue("viewportText");
+            event[flutter::EncodableValue("handle")] = flutter::EncodableValue(handle);
+            event[flutter::EncodableValue("band")] = flutter::EncodableValue(static_cast<int>(band));
+            event[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(text));
+            PostEventFromWorker(std::move(event), EventBus::Priority::kBulk);
+            return true;
+        });
+    });
+
+    if (!ok) {
+        // No-op if the visible band already answered the call.
+        reply(flutter::EncodableValue(visible));
+        return;
+    }
+
+    flutter::EncodableMap done;
+    done[flutter::EncodableValue("type")] = flutter::EncodableValue("viewportTextComplete");
+    done[flutter::EncodableValue("handle")] = flutter::EncodableValue(handle);
+    PostEventFromWorker(std::move(done), EventBus::Priority::kBulk);
+}
+
+bool AccessibilityPlugin::GuardedAutomationCall(HWND hwnd, const std::function<bool()>& extract) {
+    return RunGuarded(providerWatchdog_, *uiAutomation_, hwnd, extract, abandonCurrentCall_);
+}
+
+bool AccessibilityPlugin::EnsureExtractionScheduler() {
+    if (extractionScheduler_ && extractionScheduler_->IsRunning()) return true;
+
+    extractionScheduler_ = std::make_unique<ExtractionScheduler>(
+        [this](uint64_t batchId, uint64_t target, bool success, std::wstring text) {
+            flutter::EncodableMap event;
+            event[flutter::EncodableValue("type")] = flutter::EncodableValue("windowText");
+            event[flutter::EncodableValue("batchId")] = flutter::EncodableValue(static_cast<int64_t>(batchId));
+            event[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(target));
+            event[flutter::EncodableValue("success")] = flutter::EncodableValue(success);
+            event[flutter::EncodableValue("text")] = flutter::EncodableValue(WstringToString(text));
+            PostEventFromWorker(std::move(event), EventBus::Priority::kBulk);
+        },
+        [this](uint64_t batchId) {
+            flutter::EncodableMap event;
+            event[flutter::EncodableValue("type")] = flutter::EncodableValue("extractWindowsComplete");
+            event[flutter::EncodableValue("batchId")] = flutter::EncodableValue(static_cast<int64_t>(batchId));
+            PostEventFromWorker(std::move(event), EventBus::Priority::kBulk);
+        }
+    );
+
+    const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    return extractionScheduler_->Start(std::min(kMaxExtractionWorkers, cores), [this] {
+        return std::unique_ptr<TextExtractionProvider>(new UIAutomationExtractionProvider(providerWatchdog_));
+    });
+}
+
+flutter::EncodableValue AccessibilityPlugin::ExtractWindows(const flutter::EncodableValue* arguments) {
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(false);
+
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    if (!args) return flutter::EncodableValue(result);
+    auto handles_it = args->find(flutter::EncodableValue("handles"));
+    if (handles_it == args->end()) return flutter::EncodableValue(result);
+    const auto* handles = std::get_if<flutter::EncodableList>(&handles_it->second);
+    if (!handles) return flutter::EncodableValue(result);
+
+    if (!EnsureExtractionScheduler()) {
+        return flutter::EncodableValue(result);
+    }
+
+    std::vector<ExtractionTarget> targets;
+    targets.reserve(handles->size());
+    for (const auto& value : *handles) {
+        HWND hwnd = reinterpret_cast<HWND>(static_cast<intptr_t>(value.LongValue()));
+        DWORD processId = 0;
+        GetWindowThreadProcessId(hwnd, &processId);
+        targets.push_back({static_cast<uint64_t>(reinterpret_cast<intptr_t>(hwnd)), static_cast<uint32_t>(processId)});
+    }
+
+    const uint64_t batchId = extractionScheduler_->Submit(targets);
+    result[flutter::EncodableValue("success")] = flutter::EncodableValue(true);
+    result[flutter::EncodableValue("batchId")] = flutter::EncodableValue(static_cast<int64_t>(batchId));
+    result[flutter::EncodableValue("count")] = flutter::EncodableValue(static_cast<int>(targets.size()));
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::GetStartupMetrics() {
+    flutter::EncodableMap marks;
+    for (const StartupMark& mark : StartupTrace::Instance().Marks()) {
+        marks[flutter::EncodableValue(mark.name)] = flutter::EncodableValue(mark.micros);
+    }
+
+    const char* state = "notStarted";
+    switch (automationWorker_.GetState()) {
+    case DeferredWorker::State::kNotStarted: state = "notStarted"; break;
+    case DeferredWorker::State::kInitializing: state = "initializing"; break;
+    case DeferredWorker::State::kReady: state = "ready"; break;
+    case DeferredWorker::State::kFailed: state = "failed"; break;
+    }
+
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("marks")] = flutter::EncodableValue(marks);
+    result[flutter::EncodableValue("automationState")] = flutter::EncodableValue(state);
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::GetExtractionMemoryStats() {
+    flutter::EncodableMap result;
+    if (!uiAutomation_) return flutter::EncodableValue(result);
+
+    const ExtractionContext::Stats stats = uiAutomation_->GetExtractionMemoryStats();
+    result[flutter::EncodableValue("extractions")] = flutter::EncodableValue(static_cast<int64_t>(stats.extractions));
+    result[flutter::EncodableValue("lastAllocations")] = flutter::EncodableValue(static_cast<int64_t>(stats.lastAllocations));
+    result[flutter::EncodableValue("peakBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.peakBytes));
+    result[flutter::EncodableValue("retainedBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.retainedBytes));
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::GetProviderHealth() {
+    const int64_t now = ProviderWatchdog::NowMicros();
+    flutter::EncodableList processes;
+    for (const ProcessHealth& health : providerWatchdog_.Snapshot()) {
+        const char* state = "closed";
+        switch (health.state) {
+        case BreakerState::kClosed: state = "closed"; break;
+        case BreakerState::kOpen: state = "open"; break;
+        case BreakerState::kHalfOpen: state = "halfOpen"; break;
+        }
+        const int64_t retryIn = health.state == BreakerState::kOpen ? std::max<int64_t>(0, health.retryAtMicros - now) : 0;
+
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("processId")] = flutter::EncodableValue(static_cast<int64_t>(health.processId));
+        item[flutter::EncodableValue("state")] = flutter::EncodableValue(state);
+        item[flutter::EncodableValue("consecutiveFailures")] = flutter::EncodableValue(static_cast<int64_t>(health.consecutiveFailures));
+        item[flutter::EncodableValue("successes")] = flutter::EncodableValue(static_cast<int64_t>(health.successes));
+        item[flutter::EncodableValue("failures")] = flutter::EncodableValue(static_cast<int64_t>(health.failures));
+        item[flutter::EncodableValue("timeouts")] = flutter::EncodableValue(static_cast<int64_t>(health.timeouts));
+        item[flutter::EncodableValue("rejected")] = flutter::EncodableValue(static_cast<int64_t>(health.rejected));
+        item[flutter::EncodableValue("retryInMillis")] = flutter::EncodableValue(retryIn / 1000);
+        item[flutter::EncodableValue("lastLatencyMicros")] = flutter::EncodableValue(health.lastLatencyMicros);
+        processes.push_back(flutter::EncodableValue(item));
+    }
+
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("abandonedCalls")] = flutter::EncodableValue(static_cast<int64_t>(providerWatchdog_.AbandonedCalls()));
+    result[flutter::EncodableValue("processes")] = flutter::EncodableValue(processes);
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::GetRefreshStats() {
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("active")] = flutter::EncodableValue(refreshScheduler_ != nullptr);
+    if (!refreshScheduler_) return flutter::EncodableValue(result);
+
+    const RefreshStats stats = refreshScheduler_->Stats();
+    flutter::EncodableList windows;
+    for (const RefreshWindowState& state : stats.windows) {
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(state.window));
+        item[flutter::EncodableValue("foreground")] = flutter::EncodableValue(state.foreground);
+        item[flutter::EncodableValue("visible")] = flutter::EncodableValue(state.visible);
+        item[flutter::EncodableValue("intervalMillis")] = flutter::EncodableValue(state.intervalMicros / 1000);
+        windows.push_back(flutter::EncodableValue(item));
+    }
+    result[flutter::EncodableValue("refreshes")] = flutter::EncodableValue(static_cast<int64_t>(stats.refreshes));
+    result[flutter::EncodableValue("changes")] = flutter::EncodableValue(static_cast<int64_t>(stats.changes));
+    result[flutter::EncodableValue("failures")] = flutter::EncodableValue(static_cast<int64_t>(stats.failures));
+    result[flutter::EncodableValue("windows")] = flutter::EncodableValue(windows);
+    return flutter::EncodableValue(result);
+}
+
+flutter::EncodableValue AccessibilityPlugin::GetMemoryBudget() {
+    const MemoryGovernorStats stats = MemoryGovernor::Instance().Stats();
+    flutter::EncodableList pools;
+    for (const MemoryPoolStats& pool : stats.pools) {
+        const char* priority = "low";
+        switch (pool.priority) {
+        case PoolPriority::kLow: priority = "low"; break;
+        case PoolPriority::kHigh: priority = "high"; break;
+        case PoolPriority::kPinned: priority = "pinned"; break;
+        }
+
+        flutter::EncodableMap item;
+        item[flutter::EncodableValue("name")] = flutter::EncodableValue(pool.name);
+        item[flutter::EncodableValue("priority")] = flutter::EncodableValue(priority);
+        item[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(pool.bytes));
+        item[flutter::EncodableValue("entries")] = flutter::EncodableValue(static_cast<int64_t>(pool.entries));
+        item[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(pool.evictions));
+        item[flutter::EncodableValue("evictedBytes")] = flutter::EncodableValue(static_cast<int64_t>(pool.evictedBytes));
+        pools.push_back(flutter::EncodableValue(item));
+    }
+
+    flutter::EncodableMap result;
+    result[flutter::EncodableValue("level")] = flutter::EncodableValue(MemoryPressureName(stats.level));
+    result[flutter::EncodableValue("budgetBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.budgetBytes));
+    result[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes));
+    result[flutter::EncodableValue("peakBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.peakBytes));
+    result[flutter::EncodableValue("pendingBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.pendingBytes));
+    result[flutter::EncodableValue("evictions")] = flutter::EncodableValue(static_cast<int64_t>(stats.evictions));
+    result[flutter::EncodableValue("evictedBytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.evictedBytes));
+    result[flutter::EncodableValue("pools")] = flutter::EncodableValue(pools);
+    return flutter::EncodableValue(result);
+}
+
+void AccessibilityPlugin::SetMemoryBudget(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    int64_t budgetBytes = 0;
+    if (args) {
+        auto budget_it = args->find(flutter::EncodableValue("budgetBytes"));
+        if (budget_it != args->end()) budgetBytes = budget_it->second.LongValue();
+    }
+    if (budgetBytes <= 0) {
+        result->Error("invalid_arguments", "Expected a positive budgetBytes");
+        return;
+    }
+    MemoryGovernor::Instance().SetBudget(static_cast<size_t>(budgetBytes));
+    result->Success(GetMemoryBudget());
+}
+
+void AccessibilityPlugin::OnMemoryPressure(MemoryPressure level, size_t bytes, size_t budgetBytes) {
+    eventBus_->Post(
+        this,
+        [this, event = MemoryPressureEvent(level, bytes, budgetBytes)]() mutable {
+            if (memoryEventSink_) memoryEventSink_->Success(flutter::EncodableValue(std::move(event)));
+        },
+        EventBus::Priority::kUrgent, kMemoryPressureEvent);
+    // The automation thread's caches are otherwise only trimmed after its
+    // next extraction.
+    if (level != MemoryPressure::kNone) {
+        automationWorker_.Post([this](bool ready) {
+            if (uiAutomation_) uiAutomation_->ApplyMemoryEvictions();
+        });
+    }
+}
+
+void AccessibilityPlugin::PreprocessImageForOcr(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    const std::vector<uint8_t>* pixels = nullptr;
+    if (args) {
+        auto pixels_it = args->find(flutter::EncodableValue("pixels"));
+        if (pixels_it != args->end()) pixels = std::get_if<std::vector<uint8_t>>(&pixels_it->second);
+    }
+    const int width = args ? IntArgument(*args, "width", 0) : 0;
+    const int height = args ? IntArgument(*args, "height", 0) : 0;
+    const size_t stride = args ? static_cast<size_t>(std::max(0, IntArgument(*args, "stride", width * 4))) : 0;
+    if (!pixels || width <= 0 || height <= 0 || stride < static_cast<size_t>(width) * 4 ||
+        pixels->size() < stride * static_cast<size_t>(height - 1) + static_cast<size_t>(width) * 4) {
+        result->Error("invalid_arguments", "Expected RGBA pixels with width, height and optional stride");
+        return;
+    }
+
+    OcrPreprocessOptions options;
+    options.sourceDpi = IntArgument(*args, "sourceDpi", options.sourceDpi);
+    options.targetDpi = IntArgument(*args, "targetDpi", options.targetDpi);
+    options.binarize = BoolArgument(*args, "binarize", options.binarize);
+    options.deskew = BoolArgument(*args, "deskew", options.deskew);
+    options.crop = BoolArgument(*args, "crop", options.crop);
+
+    imageWorker_.Start([] { return true; });
+
+    // The codec's buffer does not outlive the call, so the task takes a copy;
+    // everything after that stays in memory on the image thread.
+    auto input = std::make_shared<std::vector<uint8_t>>(*pixels);
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> sharedResult(std::move(result));
+    const bool queued = imageWorker_.Post([this, input, width, height, stride, options, sharedResult](bool) {
+        const auto started = std::chrono::steady_clock::now();
+        OcrPreprocessResult processed;
+        flutter::EncodableMap value;
+        value[flutter::EncodableValue("success")] = flutter::EncodableValue(
+            PreprocessForOcr(input->data(), width, height, stride, options, processed));
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+        value[flutter::EncodableValue("width")] = flutter::EncodableValue(processed.image.width);
+        value[flutter::EncodableValue("height")] = flutter::EncodableValue(processed.image.height);
+        value[flutter::EncodableValue("pixels")] = flutter::EncodableValue(std::move(processed.image.pixels));
+        value[flutter::EncodableValue("skewDegrees")] = flutter::EncodableValue(processed.skewDegrees);
+        value[flutter::EncodableValue("cropX")] = flutter::EncodableValue(processed.cropX);
+        value[flutter::EncodableValue("cropY")] = flutter::EncodableValue(processed.cropY);
+        value[flutter::EncodableValue("cropWidth")] = flutter::EncodableValue(processed.cropWidth);
+        value[flutter::EncodableValue("cropHeight")] = flutter::EncodableValue(processed.cropHeight);
+        value[flutter::EncodableValue("elapsedMicros")] = flutter::EncodableValue(static_cast<int64_t>(elapsed.count()));
+        PostToPlatformThread([sharedResult, value = std::move(value)] {
+            sharedResult->Success(flutter::EncodableValue(value));
+        });
+    });
+    if (!queued) {
+        sharedResult->Error("unavailable", "Image processing has shut down");
+    }
+}
+
+bool AccessibilityPlugin::LoadReportFonts() {
+    wchar_t windowsDir[MAX_PATH];
+    const UINT length = GetWindowsDirectoryW(windowsDir, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) return false;
+    const std::wstring fontsDir = std::wstring(windowsDir, length) + L"\\Fonts\\";
+
+    // Arial first, for its coverage of Western, Greek and Cyrillic text;
+    // Segoe UI where it is missing.
+    auto load = [&fontsDir](TrueTypeFont& font, std::initializer_list<const wchar_t*> names) {
+        for (const wchar_t* name : names) {
+            std::string data;
+            if (ReadFileContents(fontsDir + name, data) && font.Load(std::move(data))) return true;
+        }
+        return false;
+    };
+    const bool ok = load(reportRegular_, {L"arial.ttf", L"segoeui.ttf"}) &&
+                    load(reportBold_, {L"arialbd.ttf", L"segoeuib.ttf"});
+    load(reportItalic_, {L"ariali.ttf", L"segoeuii.ttf"});
+    reportFontPool_.Charge(0, reportRegular_.DataSize());
+    reportFontPool_.Charge(1, reportBold_.DataSize());
+    reportFontPool_.Charge(2, reportItalic_.DataSize());
+    return ok;
+}
+
+void AccessibilityPlugin::WriteAnalysisReport(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    const std::vector<uint8_t>* report = nullptr;
+    const std::string* path = nullptr;
+    if (args) {
+        auto report_it = args->find(flutter::EncodableValue("report"));
+        if (report_it != args->end()) report = std::get_if<std::vector<uint8_t>>(&report_it->second);
+        auto path_it = args->find(flutter::EncodableValue("path"));
+        if (path_it != args->end()) path = std::get_if<std::string>(&path_it->second);
+    }
+    if (!report || report->empty() || !path || path->empty()) {
+        result->Error("invalid_arguments", "Expected report bytes and an output path");
+        return;
+    }
+
+    reportWorker_.Start([this] { return LoadReportFonts(); });
+
+    auto input = std::make_shared<std::vector<uint8_t>>(*report);
+    const std::wstring outputPath = StringToWstring(*path);
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> sharedResult(std::move(result));
+    const bool queued = reportWorker_.Post([this, input, outputPath, sharedResult](bool ready) {
+        const auto started = std::chrono::steady_clock::now();
+        ReportWriteStats stats;
+        bool written = false;
+        std::FILE* out = nullptr;
+        if (ready && _wfopen_s(&out, outputPath.c_str(), L"wb") == 0 && out) {
+            std::setvbuf(out, nullptr, _IOFBF, 64 * 1024);
+            ReportFonts fonts;
+            fonts.regular = &reportRegular_;
+            fonts.bold = &reportBold_;
+            fonts.italic = reportItalic_.IsLoaded() ? &reportItalic_ : nullptr;
+            written = ::WriteAnalysisReport(input->data(), input->size(), fonts, out, stats);
+            written = std::fclose(out) == 0 && written;
+            if (!written) DeleteFileW(outputPath.c_str());
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+        flutter::EncodableMap value;
+        value[flutter::EncodableValue("success")] = flutter::EncodableValue(written);
+        value[flutter::EncodableValue("fontsAvailable")] = flutter::EncodableValue(ready);
+        value[flutter::EncodableValue("pages")] = flutter::EncodableValue(stats.pages);
+        value[flutter::EncodableValue("bytes")] = flutter::EncodableValue(static_cast<int64_t>(stats.bytes));
+        value[flutter::EncodableValue("elapsedMicros")] = flutter::EncodableValue(static_cast<int64_t>(elapsed.count()));
+        PostToPlatformThread([sharedResult, value = std::move(value)] {
+            sharedResult->Success(flutter::EncodableValue(value));
+        });
+    });
+    if (!queued) {
+        sharedResult->Error("unavailable", "Report writing has shut down");
+    }
+}
+
+void AccessibilityPlugin::SegmentText(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+    const std::string* text = nullptr;
+    if (args) {
+        auto text_it = args->find(flutter::EncodableValue("text"));
+        if (text_it != args->end()) text = std::get_if<std::string>(&text_it->second);
+    }
+    if (!text) {
+        result->Error("invalid_arguments", "Expected text");
+        return;
+    }
+
+    textWorker_.Start([] { return true; });
+
+    // Offsets come back in UTF-16 code units, which is what Dart strings
+    // index by.
+    auto input = std::make_shared<std::wstring>(StringToWstring(*text));
+    std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> sharedResult(std::move(result));
+    const bool queued = textWorker_.Post([this, input, sharedResult](bool) {
+        const auto started = std::chrono::steady_clock::now();
+        TextSegmentation segmentation;
+        SegmentLegalText(input->data(), input->size(), segmentation);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+
+        const auto offsets = [](const std::vector<uint32_t>& pairs) {
+            return flutter::EncodableValue(std::vector<int32_t>(pairs.begin(), pairs.end()));
+        };
+        const TextMetrics& metrics = segmentation.metrics;
+        flutter::EncodableMap value;
+        value[flutter::EncodableValue("sentences")] = offsets(segmentation.sentences);
+        value[flutter::EncodableValue("clauses")] = offsets(segmentation.clauses);
+        value[flutter::EncodableValue("words")] = flutter::EncodableValue(static_cast<int32_t>(metrics.words));
+        value[flutter::EncodableValue("syllables")] = flutter::EncodableValue(static_cast<int32_t>(metrics.syllables));
+        value[flutter::EncodableValue("passiveConstructions")] =
+            flutter::EncodableValue(static_cast<int32_t>(metrics.passiveConstructions));
+        value[flutter::EncodableValue("passiveSentences")] =
+            flutter::EncodableValue(static_cast<int32_t>(metrics.passiveSentences));
+        value[flutter::EncodableValue("averageSentenceWords")] = flutter::EncodableValue(metrics.averageSentenceWords);
+        value[flutter::EncodableValue("fleschReadingEase")] = flutter::EncodableValue(metrics.fleschReadingEase);
+        value[flutter::EncodableValue("fleschKincaidGrade")] = flutter::EncodableValue(metrics.fleschKincaidGrade);
+        value[flutter::EncodableValue("elapsedMicros")] = flutter::EncodableValue(static_cast<int64_t>(elapsed.count()));
+        PostToPlatformThread([sharedResult, value = std::move(value)] {
+            sharedResult->Success(flutter::EncodableValue(value));
+        });
+    });
+    if (!queued) {
+        sharedResult->Error("unavailable", "Text segmentation has shut down");
+    }
+}
+
+void AccessibilityPlugin::SendEvent(flutter::EncodableMap event) {
+    if (eventSink_) {
+        eventSink_->Success(flutter::EncodableValue(std::move(event)));
+    }
+}
+
+void AccessibilityPlugin::PostEventFromWorker(flutter::EncodableMap event, EventBus::Priority priority,
+                                              uint32_t supersedeKind, uint64_t supersedeKey) {
+    eventBus_->Post(
+        this, [this, event = std::move(event)]() mutable { SendEvent(std::move(event)); }, priority, supersedeKind,
+        supersedeKey);
+}
+
+void AccessibilityPlugin::PostToPlatformThread(std::function<void()> task) {
+    eventBus_->Post(this, std::move(task));
+}
+
+AccessibilityStreamHandler::AccessibilityStreamHandler(AccessibilityPlugin* plugin)
+    : plugin_(plugin) {}
 
 AccessibilityStreamHandler::~AccessibilityStreamHandler() {}
 
@@ -147,22 +1109,24 @@ std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> Accessibil
     const flutter::EncodableValue* arguments,
     std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events) {
     
-    sink_ = std::move(events);
+    plugin_->eventSink_ = std::move(events);
+    plugin_->hasListener_.store(true);
+    plugin_->StartDeferredInitialization();
 
-    if (uiAutomation_) {
-        uiAutomation_->SetForegroundWindowChangedCallback(
-            [this](HWND hwnd, const std::wstring& title) {
-                if (sink_) {
-                    flutter::EncodableMap event;
-                    event[flutter::EncodableValue("type")] = flutter::EncodableValue("foregroundWindowChanged");
-                    event[flutter::EncodableValue("title")] = flutter::EncodableValue(WstringToString(title));
-                    event[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(reinterpret_cast<intptr_t>(hwnd)));
-                    sink_->Success(flutter::EncodableValue(event));
-                }
+    plugin_->automationWorker_.Post([plugin = plugin_](bool ready) {
+        UIAutomation* uiAutomation = plugin->uiAutomation_.get();
+        if (!uiAutomation) return;
+        uiAutomation->SetForegroundWindowChangedCallback(
+            [plugin](HWND hwnd, const std::wstring& title) {
+                flutter::EncodableMap event;
+                event[flutter::EncodableValue("type")] = flutter::EncodableValue("foregroundWindowChanged");
+                event[flutter::EncodableValue("title")] = flutter::EncodableValue(WstringToString(title));
+                event[flutter::EncodableValue("handle")] = flutter::EncodableValue(static_cast<int64_t>(reinterpret_cast<intptr_t>(hwnd)));
+                plugin->PostEventFromWorker(std::move(event), EventBus::Priority::kUrgent, kForegroundWindowEvent);
             }
         );
-        uiAutomation_->StartMonitoring();
-    }
+        plugin->StartMonitoring();
+    });
 
     return nullptr;
 }
@@ -170,11 +1134,38 @@ std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> Accessibil
 std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> AccessibilityStreamHandler::OnCancelInternal(
     const flutter::EncodableValue* arguments) {
     
-    if (uiAutomation_) {
-        uiAutomation_->StopMonitoring();
-        uiAutomation_->SetForegroundWindowChangedCallback(nullptr);
-    }
-    sink_.reset();
+    plugin_->hasListener_.store(false);
+    plugin_->automationWorker_.Post([plugin = plugin_](bool ready) {
+        UIAutomation* uiAutomation = plugin->uiAutomation_.get();
+        if (!uiAutomation) return;
+        plugin->StopMonitoring();
+        uiAutomation->SetForegroundWindowChangedCallback(nullptr);
+        uiAutomation->ClearWindowSnapshots();
+    });
+    plugin_->eventSink_.reset();
     
     return nullptr;
-}
\ No newline at end of file
+}
+
+MemoryPressureStreamHandler::MemoryPressureStreamHandler(AccessibilityPlugin* plugin)
+    : plugin_(plugin) {}
+
+MemoryPressureStreamHandler::~MemoryPressureStreamHandler() {}
+
+std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> MemoryPressureStreamHandler::OnListenInternal(
+    const flutter::EncodableValue* arguments,
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events) {
+    plugin_->memoryEventSink_ = std::move(events);
+
+    // The current level first; changes follow as they happen.
+    const MemoryGovernorStats stats = MemoryGovernor::Instance().Stats();
+    plugin_->memoryEventSink_->Success(
+        flutter::EncodableValue(MemoryPressureEvent(stats.level, stats.bytes, stats.budgetBytes)));
+    return nullptr;
+}
+
+std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> MemoryPressureStreamHandler::OnCancelInternal(
+    const flutter::EncodableValue* arguments) {
+    plugin_->memoryEventSink_.reset();
+    return nullptr;
+}
@@ -6,13 +6,31 @@
 #include <flutter/event_sink.h>
 #include <flutter/event_stream_handler.h>
 #include <flutter/plugin_registrar_windows.h>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+#include "deferred_worker.h"
+#include "event_bus.h"
+#include "extraction_scheduler.h"
+#include "memory_governor.h"
+#include "provider_watchdog.h"
+#include "refresh_scheduler.h"
+#include "truetype_font.h"
 #include "ui_automation.h"
 
+class AccessibilityStreamHandler;
+class MemoryPressureStreamHandler;
+
 class AccessibilityPlugin : public flutter::Plugin {
 public:
-    static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
+    // Returns the plugin, which the registrar owns, so the runner can start
+    // UI Automation once the first frame is up. Events and completions from
+    // worker threads reach the platform thread through |eventBus|, which
+    // must outlive the plugin.
+    static AccessibilityPlugin* RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar,
+                                                      EventBus& eventBus);
 
     AccessibilityPlugin();
     virtual ~AccessibilityPlugin();
@@ -20,25 +38,113 @@ public:
     AccessibilityPlugin(const AccessibilityPlugin&) = delete;
     AccessibilityPlugin& operator=(const AccessibilityPlugin&) = delete;
 
+    // Starts initialising UI Automation on its own thread and returns
+    // immediately. Method calls that need it queue behind the initialisation.
+    // The first such call starts it if the runner has not.
+    void StartDeferredInitialization();
+
 private:
+    friend class AccessibilityStreamHandler;
+    friend class MemoryPressureStreamHandler;
+
+    using Reply = std::function<void(flutter::EncodableValue value)>;
+
     void HandleMethodCall(
         const flutter::MethodCall<flutter::EncodableValue>& method_call,
         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
+    flutter::EncodableValue HandleAutomationCall(const std::string& method, const flutter::EncodableValue* arguments);
+    void RunOnAutomationThread(const flutter::MethodCall<flutter::EncodableValue>& method_call,
+                               std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
     flutter::EncodableValue IsAccessibilityEnabled();
     flutter::EncodableValue ExtractScreenText();
     flutter::EncodableValue GetForegroundWindow();
     flutter::EncodableValue HasOverlayPermission();
     flutter::EncodableValue StartMonitoring();
     flutter::EncodableValue StopMonitoring();
+    flutter::EncodableValue ExtractWindowDelta(const flutter::EncodableValue* arguments);
+    flutter::EncodableValue ExtractScreenTextPatch(const flutter::EncodableValue* arguments);
+    flutter::EncodableValue ExtractWindows(const flutter::EncodableValue* arguments);
+    flutter::EncodableValue GetStartupMetrics();
+    flutter::EncodableValue GetExtractionMemoryStats();
+    flutter::EncodableValue GetProviderHealth();
+    flutter::EncodableValue GetRefreshStats();
+    flutter::EncodableValue GetMemoryBudget();
+    void SetMemoryBudget(const flutter::EncodableValue* arguments,
+                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    // Runs on whichever thread changed the governor's level: sends the level
+    // to Dart and has the automation thread free what it was asked to.
+    void OnMemoryPressure(MemoryPressure level, size_t bytes, size_t budgetBytes);
+    // Runs PreprocessForOcr on imageWorker_ and completes |result| from there.
+    void PreprocessImageForOcr(const flutter::EncodableValue* arguments,
+                               std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    // Writes an analysis report PDF on reportWorker_ and completes |result|
+    // from there.
+    void WriteAnalysisReport(const flutter::EncodableValue* arguments,
+                             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    // Loads the report fonts from the Windows font directory. Runs on
+    // reportWorker_.
+    bool LoadReportFonts();
+    // Runs SegmentLegalText on textWorker_ and completes |result| from there.
+    void SegmentText(const flutter::EncodableValue* arguments,
+                     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void ExtractScreenTextViewportFirst(const flutter::EncodableValue* arguments, const Reply& reply);
+    // Runs |extract|, which reads |hwnd| through uiAutomation_, under the
+    // provider watchdog. Returns false without running it while the
+    // window's process is refused, and false if it was abandoned, in which
+    // case the method call has already been answered with an error.
+    bool GuardedAutomationCall(HWND hwnd, const std::function<bool()>& extract);
+    // Re-reads |window| for refreshScheduler_ and posts a
+    // windowContentChanged event if its text changed. Automation thread.
+    void RefreshWindow(uint64_t window);
 
+    void SendEvent(flutter::EncodableMap event);
+    // Window changes go out as kUrgent, each superseding the last one not
+    // yet delivered; streamed text as kBulk, in order.
+    void PostEventFromWorker(flutter::EncodableMap event, EventBus::Priority priority, uint32_t supersedeKind = 0,
+                             uint64_t supersedeKey = 0);
+    void PostToPlatformThread(std::function<void()> task);
+    bool EnsureExtractionScheduler();
+
+    flutter::PluginRegistrarWindows* registrar_ = nullptr;
+    EventBus* eventBus_ = nullptr;
+    // Guards provider calls from the automation and extraction threads, and
+    // keeps a circuit breaker per target process.
+    ProviderWatchdog providerWatchdog_;
+
+    // Created, used and destroyed only on automationWorker_'s thread.
     std::unique_ptr<UIAutomation> uiAutomation_;
+    // Automation thread only: answers the method call being served with a
+    // timeout error if the watchdog abandons a provider call it made.
+    std::function<void()> abandonCurrentCall_;
+    DeferredWorker automationWorker_;
+    // Exists while monitoring; created and destroyed on automationWorker_'s
+    // thread, which also runs its checks.
+    std::unique_ptr<RefreshScheduler> refreshScheduler_;
+    std::unique_ptr<ExtractionScheduler> extractionScheduler_;
+    // Started on first use; keeps page preprocessing off the platform thread.
+    DeferredWorker imageWorker_;
+    // Started on first use; its initialisation loads the report fonts, which
+    // are then only touched on its thread.
+    DeferredWorker reportWorker_;
+    TrueTypeFont reportRegular_;
+    TrueTypeFont reportBold_;
+    TrueTypeFont reportItalic_;
+    // Counts the report fonts against the memory budget; never evicted.
+    MemoryPool reportFontPool_;
+    // Started on first use; keeps segmentation of long documents off the
+    // platform thread.
+    DeferredWorker textWorker_;
     std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> eventSink_;
+    // Mirrors eventSink_ for worker threads, which must not touch the sink.
+    std::atomic<bool> hasListener_{false};
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> memoryEventSink_;
 };
 
 class AccessibilityStreamHandler : public flutter::StreamHandler<flutter::EncodableValue> {
 public:
-    AccessibilityStreamHandler(UIAutomation* uiAutomation);
+    AccessibilityStreamHandler(AccessibilityPlugin* plugin);
     virtual ~AccessibilityStreamHandler();
 
 protected:
@@ -50,8 +156,26 @@ protected:
         const flutter::EncodableValue* arguments) override;
 
 private:
-    UIAutomation* uiAutomation_;
-    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink_;
+    AccessibilityPlugin* plugin_;
+};
+
+// Memory pressure has its own channel, so listening to it does not start
+// window monitoring.
+class MemoryPressureStreamHandler : public flutter::StreamHandler<flutter::EncodableValue> {
+public:
+    MemoryPressureStreamHandler(AccessibilityPlugin* plugin);
+    virtual ~MemoryPressureStreamHandler();
+
+protected:
+    std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OnListenInternal(
+        const flutter::EncodableValue* arguments,
+        std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events) override;
+
+    std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OnCancelInternal(
+        const flutter::EncodableValue* arguments) override;
+
+private:
+    AccessibilityPlugin* plugin_;
 };
 
 #endif
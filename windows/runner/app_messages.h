@@ -0,0 +1,16 @@
+#ifndef RUNNER_APP_MESSAGES_H_
+#define RUNNER_APP_MESSAGES_H_
+
+#include <windows.h>
+
+// Private window messages posted by the runner. They are kept together, as
+// small offsets into the WM_APP range, so that no two can collide.
+
+// Posted to the Flutter window when the event bus has events to deliver.
+constexpr UINT kEventBusMessage = WM_APP + 0x10;
+
+// Posted to the overlay when pending geometry can be applied right away;
+// requests arriving before it is handled are merged into the same update.
+constexpr UINT kApplyGeometryMessage = WM_APP + 0x11;
+
+#endif
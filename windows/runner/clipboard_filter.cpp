@@ -0,0 +1,109 @@
+#include "clipboard_filter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+inline uint64_t RotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t MixChunk(uint64_t chunk) {
+    chunk *= 0x87C37B91114253D5ULL;
+    chunk = RotateLeft(chunk, 31);
+    return chunk * 0x4CF5AD432745937FULL;
+}
+
+inline bool IsHighSurrogate(wchar_t ch) {
+    return ch >= 0xD800 && ch <= 0xDBFF;
+}
+
+}  // namespace
+
+uint64_t HashClipboardText(const wchar_t* text, size_t length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text);
+    const size_t byteCount = length * sizeof(wchar_t);
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (byteCount * 0xFF51AFD7ED558CCDULL);
+
+    size_t offset = 0;
+    for (; offset + 8 <= byteCount; offset += 8) {
+        uint64_t chunk;
+        std::memcpy(&chunk, bytes + offset, sizeof(chunk));
+        hash ^= MixChunk(chunk);
+        hash = RotateLeft(hash, 27) * 5 + 0x52DCE729;
+    }
+    if (offset < byteCount) {
+        uint64_t chunk = 0;
+        std::memcpy(&chunk, bytes + offset, byteCount - offset);
+        hash ^= MixChunk(chunk);
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+ClipboardFilter::ClipboardFilter(const ClipboardFilterOptions& options, const KeywordDetector* detector)
+    : options_(options), detector_(detector ? detector : &KeywordDetector::Default()) {}
+
+void ClipboardFilter::Reset() {
+    rejected_.clear();
+    rejectedNext_ = 0;
+    hasAccepted_ = false;
+}
+
+bool ClipboardFilter::RejectedRecently(uint64_t hash, size_t length) const {
+    for (const HistoryEntry& entry : rejected_) {
+        if (entry.hash == hash && entry.length == length) return true;
+    }
+    return false;
+}
+
+void ClipboardFilter::RememberRejected(uint64_t hash, size_t length) {
+    if (options_.historySize == 0) return;
+    if (rejected_.size() < options_.historySize) {
+        rejected_.push_back({hash, length});
+        return;
+    }
+    rejected_[rejectedNext_] = {hash, length};
+    rejectedNext_ = (rejectedNext_ + 1) % rejected_.size();
+}
+
+ClipboardVerdict ClipboardFilter::Process(const wchar_t* text, size_t length, int64_t nowMicros,
+                                          ClipboardCapture& capture) {
+    if (!text || length == 0) return ClipboardVerdict::kEmpty;
+
+    const size_t scanned = std::min(length, options_.maxScannedChars);
+    const uint64_t hash = HashClipboardText(text, scanned);
+    if (hasAccepted_ && lastAccepted_.hash == hash && lastAccepted_.length == length &&
+        nowMicros - lastAcceptedMicros_ < options_.duplicateWindowMicros) {
+        lastAcceptedMicros_ = nowMicros;
+        return ClipboardVerdict::kDuplicate;
+    }
+    if (RejectedRecently(hash, length)) return ClipboardVerdict::kDuplicate;
+
+    const uint32_t categories = detector_->Scan(text, scanned, options_.requiredCategories);
+    if ((categories & options_.requiredCategories) == 0) {
+        RememberRejected(hash, length);
+        return ClipboardVerdict::kNotLegal;
+    }
+    hasAccepted_ = true;
+    lastAccepted_ = {hash, length};
+    lastAcceptedMicros_ = nowMicros;
+
+    size_t shipped = std::min(length, options_.maxShippedChars);
+    if (shipped < length && shipped > 0 && IsHighSurrogate(text[shipped - 1])) {
+        shipped--;
+    }
+
+    capture.text.assign(text, shipped);
+    capture.originalLength = length;
+    capture.truncated = shipped < length;
+    capture.categories = categories;
+    capture.hash = hash;
+    return ClipboardVerdict::kAccepted;
+}
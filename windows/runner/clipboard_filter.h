@@ -0,0 +1,81 @@
+#ifndef RUNNER_CLIPBOARD_FILTER_H_
+#define RUNNER_CLIPBOARD_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "keyword_detector.h"
+
+struct ClipboardFilterOptions {
+    // Longest text handed on; longer copies are cut and flagged as truncated.
+    size_t maxShippedChars = 256 * 1024;
+    // Longest prefix hashed and scanned for keywords. Anything past it is
+    // ignored entirely, which bounds the cost of pathological copies.
+    size_t maxScannedChars = 16 * 1024 * 1024;
+    // Number of recent rejected payloads remembered, so copying one again is
+    // refused without another scan.
+    size_t historySize = 8;
+    // How long a copy of the last accepted payload counts as a duplicate.
+    // Each repeat restarts it, so a clipboard manager re-announcing the
+    // same text stays quiet; copying it again later is a new capture.
+    int64_t duplicateWindowMicros = 2000000;
+    // A copy is accepted if it matches any of these keyword categories.
+    uint32_t requiredCategories = kKeywordCategoryTerms | kKeywordCategoryPrivacy;
+};
+
+// A clipboard payload that passed the filter. |text| holds at most
+// |maxShippedChars| characters; |originalLength| is the full copy's length.
+struct ClipboardCapture {
+    std::wstring text;
+    size_t originalLength = 0;
+    bool truncated = false;
+    uint32_t categories = 0;
+    uint64_t hash = 0;
+};
+
+enum class ClipboardVerdict {
+    kAccepted,
+    kEmpty,
+    kDuplicate,
+    kNotLegal,
+};
+
+// 64-bit hash over the raw code units, eight bytes per step.
+uint64_t HashClipboardText(const wchar_t* text, size_t length);
+
+// Decides which clipboard changes are worth sending to Dart. Payloads are
+// compared by hash before any keyword scan. Only a repeat of the last accepted
+// payload within the duplicate window is suppressed, so copying A, then B,
+// then A again captures A twice. Rejected payloads are remembered in a small
+// ring, so a large non-legal copy is scanned once however often it recurs.
+class ClipboardFilter {
+public:
+    explicit ClipboardFilter(const ClipboardFilterOptions& options = ClipboardFilterOptions(),
+                             const KeywordDetector* detector = nullptr);
+
+    // |nowMicros| is on any steady clock; it only times the duplicate window.
+    ClipboardVerdict Process(const wchar_t* text, size_t length, int64_t nowMicros, ClipboardCapture& capture);
+    void Reset();
+
+    const ClipboardFilterOptions& Options() const { return options_; }
+
+private:
+    bool RejectedRecently(uint64_t hash, size_t length) const;
+    void RememberRejected(uint64_t hash, size_t length);
+
+    struct HistoryEntry {
+        uint64_t hash;
+        size_t length;
+    };
+
+    ClipboardFilterOptions options_;
+    const KeywordDetector* detector_;
+    std::vector<HistoryEntry> rejected_;
+    size_t rejectedNext_ = 0;
+    bool hasAccepted_ = false;
+    HistoryEntry lastAccepted_ = {};
+    int64_t lastAcceptedMicros_ = 0;
+};
+
+#endif
@@ -0,0 +1,159 @@
+#include "clipboard_monitor.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <utility>
+
+namespace {
+
+constexpr wchar_t kWindowClassName[] = L"LEGALEASE_CLIPBOARD_MONITOR";
+
+// Another application may hold the clipboard briefly right after announcing
+// a change, so opening it is retried a few times before giving up.
+constexpr int kOpenAttempts = 4;
+
+bool OwnedByCurrentProcess(HWND owner) {
+    if (!owner) return false;
+    DWORD processId = 0;
+    GetWindowThreadProcessId(owner, &processId);
+    return processId == GetCurrentProcessId();
+}
+
+}  // namespace
+
+ClipboardMonitor::ClipboardMonitor(Callback callback, const ClipboardFilterOptions& options)
+    : callback_(std::move(callback)), filter_(options) {}
+
+ClipboardMonitor::~ClipboardMonitor() {
+    Stop();
+}
+
+bool ClipboardMonitor::Start() {
+    if (thread_.joinable()) return true;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_ = false;
+    window_ = nullptr;
+    thread_ = std::thread(&ClipboardMonitor::ThreadMain, this);
+    started_.wait(lock, [this] { return ready_; });
+    if (window_) return true;
+
+    lock.unlock();
+    thread_.join();
+    return false;
+}
+
+void ClipboardMonitor::Stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (window_) {
+            PostMessage(window_, WM_CLOSE, 0, 0);
+        }
+    }
+    thread_.join();
+}
+
+LRESULT CALLBACK ClipboardMonitor::WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+    if (message == WM_NCCREATE) {
+        auto* create = reinterpret_cast<CREATESTRUCT*>(lparam);
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+    }
+
+    auto* monitor = reinterpret_cast<ClipboardMonitor*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+    switch (message) {
+        case WM_CLIPBOARDUPDATE:
+            if (monitor) monitor->OnClipboardUpdate();
+            return 0;
+        case WM_CLOSE:
+            DestroyWindow(hwnd);
+            return 0;
+        case WM_DESTROY:
+            RemoveClipboardFormatListener(hwnd);
+            PostQuitMessage(0);
+            return 0;
+    }
+    return DefWindowProc(hwnd, message, wparam, lparam);
+}
+
+void ClipboardMonitor::ThreadMain() {
+    WNDCLASS windowClass{};
+    windowClass.lpfnWndProc = ClipboardMonitor::WindowProc;
+    windowClass.hInstance = GetModuleHandle(nullptr);
+    windowClass.lpszClassName = kWindowClassName;
+    RegisterClass(&windowClass);
+
+    HWND window = CreateWindowEx(0, kWindowClassName, L"", 0, 0, 0, 0, 0,
+                                 HWND_MESSAGE, nullptr, windowClass.hInstance, this);
+    if (window && !AddClipboardFormatListener(window)) {
+        DestroyWindow(window);
+        window = nullptr;
+    }
+
+    lastSequence_ = GetClipboardSequenceNumber();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        window_ = window;
+        ready_ = true;
+    }
+    started_.notify_all();
+    if (!window) return;
+
+    MSG message;
+    while (GetMessage(&message, nullptr, 0, 0) > 0) {
+        TranslateMessage(&message);
+        DispatchMessage(&message);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_ = nullptr;
+}
+
+void ClipboardMonitor::OnClipboardUpdate() {
+    // Listeners are notified once per change, but clipboard managers and
+    // delayed rendering can repeat the notification for the same contents.
+    const DWORD sequence = GetClipboardSequenceNumber();
+    if (sequence == lastSequence_) return;
+    lastSequence_ = sequence;
+
+    if (!IsClipboardFormatAvailable(CF_UNICODETEXT)) return;
+    if (OwnedByCurrentProcess(GetClipboardOwner())) return;
+    if (!CopyClipboardText()) return;
+
+    ClipboardCapture capture;
+    const int64_t nowMicros = static_cast<int64_t>(GetTickCount64()) * 1000;
+    if (filter_.Process(buffer_.data(), buffer_.size(), nowMicros, capture) != ClipboardVerdict::kAccepted) return;
+
+    if (buffer_.size() < bufferLength_) {
+        capture.originalLength = bufferLength_;
+        capture.truncated = true;
+    }
+    if (callback_) {
+        callback_(capture);
+    }
+}
+
+bool ClipboardMonitor::CopyClipboardText() {
+    bool opened = false;
+    for (int attempt = 0; attempt < kOpenAttempts && !opened; attempt++) {
+        if (attempt > 0) Sleep(5 * attempt);
+        opened = OpenClipboard(window_) != FALSE;
+    }
+    if (!opened) return false;
+
+    // Only the scanned prefix is copied; the clipboard is held just long
+    // enough for one memcpy, and the hash and scan run after it is closed.
+    bool copied = false;
+    HANDLE data = GetClipboardData(CF_UNICODETEXT);
+    const wchar_t* text = data ? static_cast<const wchar_t*>(GlobalLock(data)) : nullptr;
+    if (text) {
+        const size_t capacity = GlobalSize(data) / sizeof(wchar_t);
+        bufferLength_ = wcsnlen(text, capacity);
+        const size_t length = std::min(bufferLength_, filter_.Options().maxScannedChars);
+        buffer_.assign(text, length);
+        GlobalUnlock(data);
+        copied = true;
+    }
+    CloseClipboard();
+    return copied;
+}
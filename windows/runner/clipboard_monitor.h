@@ -0,0 +1,51 @@
+#ifndef RUNNER_CLIPBOARD_MONITOR_H_
+#define RUNNER_CLIPBOARD_MONITOR_H_
+
+#include <windows.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "clipboard_filter.h"
+
+// Watches the system clipboard for text copied in other applications. The
+// monitor owns a message-only window on its own thread registered with
+// AddClipboardFormatListener, so it wakes only on WM_CLIPBOARDUPDATE, and the
+// copy, hash and keyword scan never run on the platform thread.
+class ClipboardMonitor {
+public:
+    using Callback = std::function<void(const ClipboardCapture& capture)>;
+
+    explicit ClipboardMonitor(Callback callback, const ClipboardFilterOptions& options = ClipboardFilterOptions());
+    ~ClipboardMonitor();
+
+    ClipboardMonitor(const ClipboardMonitor&) = delete;
+    ClipboardMonitor& operator=(const ClipboardMonitor&) = delete;
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return thread_.joinable(); }
+
+private:
+    static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+
+    void ThreadMain();
+    void OnClipboardUpdate();
+    bool CopyClipboardText();
+
+    Callback callback_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable started_;
+    bool ready_ = false;
+    HWND window_ = nullptr;
+
+    // Owned by the monitor thread.
+    ClipboardFilter filter_;
+    DWORD lastSequence_ = 0;
+    std::wstring buffer_;
+    size_t bufferLength_ = 0;
+};
+
+#endif
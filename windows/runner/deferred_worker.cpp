@@ -0,0 +1,80 @@
+#include "deferred_worker.h"
+
+#include <chrono>
+#include <utility>
+
+namespace {
+
+int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+DeferredWorker::DeferredWorker()
+    : state_(State::kNotStarted), ready_(readyPromise_.get_future().share()), initStarted_(0), initFinished_(0) {}
+
+DeferredWorker::~DeferredWorker() {
+    Stop();
+}
+
+void DeferredWorker::Start(std::function<bool()> initialize, std::function<void()> shutdown) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_ || GetState() != State::kNotStarted) return;
+    state_.store(State::kInitializing, std::memory_order_release);
+    thread_ = std::thread(&DeferredWorker::ThreadMain, this, std::move(initialize), std::move(shutdown));
+}
+
+void DeferredWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+        tasks_.clear();
+        if (GetState() == State::kNotStarted) {
+            // Never started: resolve the future so no waiter hangs.
+            state_.store(State::kFailed, std::memory_order_release);
+            readyPromise_.set_value(false);
+        }
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool DeferredWorker::Post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return false;
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void DeferredWorker::ThreadMain(std::function<bool()> initialize, std::function<void()> shutdown) {
+    initStarted_.store(NowMicros(), std::memory_order_release);
+    const bool ready = initialize ? initialize() : true;
+    initFinished_.store(NowMicros(), std::memory_order_release);
+    state_.store(ready ? State::kReady : State::kFailed, std::memory_order_release);
+    readyPromise_.set_value(ready);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (stopping_) break;
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task(ready);
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (shutdown) {
+        shutdown();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef RUNNER_DEFERRED_WORKER_H_
+#define RUNNER_DEFERRED_WORKER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// A single worker thread whose first job is an expensive initialisation.
+// Tasks can be posted at any time, even before Start(); they queue behind
+// the initialisation and receive its outcome, so callers never block
+// waiting for it. The thread is only created by Start(), which lets
+// start-up defer it until the first frame is on screen.
+class DeferredWorker {
+public:
+    enum class State {
+        kNotStarted,
+        kInitializing,
+        kReady,
+        kFailed,
+    };
+
+    using Task = std::function<void(bool ready)>;
+
+    DeferredWorker();
+    ~DeferredWorker();
+
+    DeferredWorker(const DeferredWorker&) = delete;
+    DeferredWorker& operator=(const DeferredWorker&) = delete;
+
+    // Starts the thread. |initialize| runs first on it and decides the
+    // ready state; |shutdown| runs last on it. Later calls are ignored.
+    void Start(std::function<bool()> initialize, std::function<void()> shutdown = nullptr);
+
+    // Drops queued tasks, runs |shutdown| and joins the thread.
+    void Stop();
+
+    // Queues |task| to run on the worker after initialisation. Returns false
+    // once Stop() has been called.
+    bool Post(Task task);
+
+    State GetState() const { return state_.load(std::memory_order_acquire); }
+    bool IsStarted() const { return GetState() != State::kNotStarted; }
+
+    // Resolves with the initialisation outcome.
+    std::shared_future<bool> Ready() const { return ready_; }
+
+    // Steady-clock microseconds at which initialisation began and ended, or
+    // 0 if it has not.
+    int64_t InitStartedMicros() const { return initStarted_.load(std::memory_order_acquire); }
+    int64_t InitFinishedMicros() const { return initFinished_.load(std::memory_order_acquire); }
+
+private:
+    void ThreadMain(std::function<bool()> initialize, std::function<void()> shutdown);
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Task> tasks_;
+    bool stopping_ = false;
+
+    std::atomic<State> state_;
+    std::promise<bool> readyPromise_;
+    std::shared_future<bool> ready_;
+    std::atomic<int64_t> initStarted_;
+    std::atomic<int64_t> initFinished_;
+};
+
+#endif
@@ -1,9 +1,19 @@
 #include "desktop_overlay.h"
 #include <dwmapi.h>
+#include <chrono>
+
+#include "app_messages.h"
 
 const wchar_t* DesktopOverlay::kOverlayClassName = L"LegalEaseOverlayWindow";
 bool DesktopOverlay::class_registered_ = false;
 
+static const UINT_PTR kApplyGeometryTimer = 1;
+
+static int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 DesktopOverlay::DesktopOverlay() {}
 
 DesktopOverlay::~DesktopOverlay() {
@@ -30,11 +40,13 @@ bool DesktopOverlay::Create(int x, int y, int width, int height) {
     
     RegisterWindowClass();
     
-    position_x_ = x;
-    position_y_ = y;
-    width_ = width;
-    height_ = height;
-    expanded_height_ = height;
+    OverlayGeometry geometry = geometry_.Target();
+    geometry.x = x;
+    geometry.y = y;
+    geometry.width = width;
+    geometry.expandedHeight = height;
+    geometry.minimized = false;
+    geometry_.Reset(geometry);
     
     DWORD ex_style = WS_EX_LAYERED | WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_TRANSPARENT;
     DWORD style = WS_POPUP;
@@ -63,6 +75,8 @@ bool DesktopOverlay::Create(int x, int y, int width, int height) {
     
     BOOL dark_mode = TRUE;
     DwmSetWindowAttribute(window_handle_, 20, &dark_mode, sizeof(dark_mode));
+
+    UpdateFrameInterval();
     
     return true;
 }
@@ -77,6 +91,7 @@ void DesktopOverlay::Destroy() {
 
 void DesktopOverlay::Show() {
     if (window_handle_) {
+        FlushGeometry();
         ShowWindow(window_handle_, SW_SHOWNOACTIVATE);
         SetWindowPos(window_handle_, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
         is_visible_ = true;
@@ -91,44 +106,82 @@ void DesktopOverlay::Hide() {
 }
 
 void DesktopOverlay::SetPosition(int x, int y) {
-    position_x_ = x;
-    position_y_ = y;
-    if (window_handle_) {
-        SetWindowPos(window_handle_, nullptr, x, y, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
-    }
+    geometry_.SetPosition(x, y);
+    ScheduleGeometryFlush();
 }
 
 void DesktopOverlay::SetSize(int width, int height) {
-    width_ = width;
-    expanded_height_ = height;
-    if (window_handle_ && !is_minimized_) {
-        SetWindowPos(window_handle_, nullptr, 0, 0, width, height, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-    }
+    geometry_.SetSize(width, height);
+    ScheduleGeometryFlush();
 }
 
 void DesktopOverlay::SetAlwaysOnTop(bool alwaysOnTop) {
-    always_on_top_ = alwaysOnTop;
-    if (window_handle_) {
-        SetWindowPos(
-            window_handle_,
-            alwaysOnTop ? HWND_TOPMOST : HWND_NOTOPMOST,
-            0, 0, 0, 0,
-            SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE
-        );
-    }
+    geometry_.SetAlwaysOnTop(alwaysOnTop);
+    ScheduleGeometryFlush();
 }
 
 void DesktopOverlay::Minimize() {
-    is_minimized_ = true;
-    if (window_handle_) {
-        SetWindowPos(window_handle_, nullptr, 0, 0, width_, minimized_height_, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
-    }
+    geometry_.SetMinimized(true);
+    ScheduleGeometryFlush();
 }
 
 void DesktopOverlay::Expand() {
-    is_minimized_ = false;
+    geometry_.SetMinimized(false);
+    ScheduleGeometryFlush();
+}
+
+void DesktopOverlay::FlushGeometry() {
     if (window_handle_) {
-        SetWindowPos(window_handle_, nullptr, 0, 0, width_, expanded_height_, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+        KillTimer(window_handle_, kApplyGeometryTimer);
+    }
+    ApplyGeometry(true);
+}
+
+void DesktopOverlay::ScheduleGeometryFlush() {
+    if (!window_handle_) return;
+
+    int64_t delay = 0;
+    if (!geometry_.ScheduleFlush(NowMicros(), delay)) return;
+    if (delay <= 0) {
+        PostMessage(window_handle_, kApplyGeometryMessage, 0, 0);
+    } else {
+        SetTimer(window_handle_, kApplyGeometryTimer, static_cast<UINT>((delay + 999) / 1000), nullptr);
+    }
+}
+
+void DesktopOverlay::ApplyGeometry(bool force) {
+    GeometryUpdate update;
+    if (!geometry_.TakeUpdate(NowMicros(), update, force)) {
+        // Woken before a full frame passed; wait for the rest of it.
+        ScheduleGeometryFlush();
+        return;
+    }
+    if (!window_handle_) return;
+
+    const OverlayGeometry& geometry = update.geometry;
+    UINT flags = SWP_NOACTIVATE;
+    if (!(update.changes & kGeometryMove)) flags |= SWP_NOMOVE;
+    if (!(update.changes & kGeometryResize)) flags |= SWP_NOSIZE;
+    if (!(update.changes & kGeometryZOrder)) flags |= SWP_NOZORDER;
+    HWND insert_after = geometry.alwaysOnTop ? HWND_TOPMOST : HWND_NOTOPMOST;
+
+    HDWP batch = BeginDeferWindowPos(1);
+    if (batch) {
+        batch = DeferWindowPos(batch, window_handle_, insert_after, geometry.x, geometry.y,
+                               geometry.width, geometry.Height(), flags);
+    }
+    if (!batch || !EndDeferWindowPos(batch)) {
+        SetWindowPos(window_handle_, insert_after, geometry.x, geometry.y,
+                     geometry.width, geometry.Height(), flags);
+    }
+}
+
+void DesktopOverlay::UpdateFrameInterval() {
+    DWM_TIMING_INFO timing = {};
+    timing.cbSize = sizeof(timing);
+    if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &timing)) &&
+        timing.rateRefresh.uiNumerator > 0 && timing.rateRefresh.uiDenominator > 0) {
+        geometry_.SetFrameInterval(1000000LL * timing.rateRefresh.uiDenominator / timing.rateRefresh.uiNumerator);
     }
 }
 
@@ -137,17 +190,17 @@ bool DesktopOverlay::IsVisible() const {
 }
 
 bool DesktopOverlay::IsMinimized() const {
-    return is_minimized_;
+    return geometry_.Target().minimized;
 }
 
 void DesktopOverlay::GetPosition(int& x, int& y) const {
-    x = position_x_;
-    y = position_y_;
+    x = geometry_.Target().x;
+    y = geometry_.Target().y;
 }
 
 void DesktopOverlay::GetSize(int& width, int& height) const {
-    width = width_;
-    height = is_minimized_ ? minimized_height_ : expanded_height_;
+    width = geometry_.Target().width;
+    height = geometry_.Target().Height();
 }
 
 void DesktopOverlay::SetFlutterViewController(flutter::FlutterViewController* controller) {
@@ -198,6 +251,18 @@ LRESULT DesktopOverlay::MessageHandler(HWND window, UINT message, WPARAM wparam,
             }
             return 0;
             
+        case WM_TIMER:
+            if (wparam == kApplyGeometryTimer) {
+                KillTimer(window, kApplyGeometryTimer);
+                ApplyGeometry(false);
+                return 0;
+            }
+            return DefWindowProc(window, message, wparam, lparam);
+
+        case WM_DISPLAYCHANGE:
+            UpdateFrameInterval();
+            return DefWindowProc(window, message, wparam, lparam);
+            
         case WM_ERASEBKGND:
             return 1;
             
@@ -211,6 +276,10 @@ LRESULT DesktopOverlay::MessageHandler(HWND window, UINT message, WPARAM wparam,
             return 0;
         }
             
+        case kApplyGeometryMessage:
+            ApplyGeometry(false);
+            return 0;
+            
         default:
             return DefWindowProc(window, message, wparam, lparam);
     }
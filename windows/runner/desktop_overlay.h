@@ -6,6 +6,7 @@
 #include <memory>
 #include <functional>
 #include <string>
+#include "geometry_coalescer.h"
 
 class DesktopOverlay {
 public:
@@ -21,18 +22,24 @@ public:
     void Show();
     void Hide();
     
+    // Geometry setters only record the request; the window is updated at
+    // most once per display refresh with everything requested meanwhile.
     void SetPosition(int x, int y);
     void SetSize(int width, int height);
     void SetAlwaysOnTop(bool alwaysOnTop);
     
     void Minimize();
     void Expand();
+
+    // Applies any pending geometry now instead of at the next frame.
+    void FlushGeometry();
     
     bool IsVisible() const;
     bool IsMinimized() const;
     
     void GetPosition(int& x, int& y) const;
     void GetSize(int& width, int& height) const;
+    const OverlayGeometry& GetGeometry() const { return geometry_.Target(); }
     
     HWND GetHandle() const { return window_handle_; }
     
@@ -47,18 +54,15 @@ private:
     LRESULT MessageHandler(HWND window, UINT message, WPARAM wparam, LPARAM lparam);
     
     void UpdateWindowStyle();
+
+    void ScheduleGeometryFlush();
+    void ApplyGeometry(bool force);
+    void UpdateFrameInterval();
     
     HWND window_handle_ = nullptr;
     bool is_visible_ = false;
-    bool is_minimized_ = false;
-    bool always_on_top_ = true;
     
-    int position_x_ = 100;
-    int position_y_ = 100;
-    int width_ = 400;
-    int height_ = 500;
-    int minimized_height_ = 40;
-    int expanded_height_ = 500;
+    GeometryCoalescer geometry_;
     
     flutter::FlutterViewController* flutter_controller_ = nullptr;
     std::function<void()> on_close_callback_;
@@ -0,0 +1,123 @@
+#include "event_bus.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+size_t EventBus::SupersedeKeyHash::operator()(const SupersedeKey& k) const {
+    uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(k.owner));
+    h = (h ^ (h >> 29)) * 0x9E3779B97F4A7C15ull;
+    h ^= (static_cast<uint64_t>(k.kind) << 32) ^ k.key;
+    h = (h ^ (h >> 32)) * 0xD6E8FEB86659FD93ull;
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+EventBus::EventBus(std::function<void()> wake, size_t batchLimit)
+    : wake_(std::move(wake)), batchLimit_(std::max<size_t>(1, batchLimit)) {}
+
+EventBus::~EventBus() {
+    Node* node = incoming_.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void EventBus::Post(const void* owner, Task task, Priority priority, uint32_t kind, uint64_t key) {
+    Node* node = new Node{nullptr, owner, std::move(task), priority, kind, key};
+    Node* head = incoming_.load(std::memory_order_relaxed);
+    do {
+        node->next = head;
+    } while (!incoming_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    // Only the push that finds the list empty wakes the consumer; later ones
+    // ride along with it.
+    if (!head && wake_) wake_();
+}
+
+void EventBus::TakeIncoming() {
+    // The consumer only ever takes the whole list, so pushes cannot run into
+    // ABA problems.
+    Node* node = incoming_.exchange(nullptr, std::memory_order_acquire);
+    if (!node) return;
+
+    // Pushed newest first; reverse into arrival order.
+    Node* ordered = nullptr;
+    size_t count = 0;
+    while (node) {
+        Node* next = node->next;
+        node->next = ordered;
+        ordered = node;
+        node = next;
+        ++count;
+    }
+    stats_.largestIntake = std::max(stats_.largestIntake, count);
+
+    while (ordered) {
+        Node* next = ordered->next;
+        const uint64_t sequence = nextSequence_++;
+        if (ordered->kind != 0) {
+            auto inserted = newest_.insert({SupersedeKey{ordered->owner, ordered->kind, ordered->key}, sequence});
+            if (!inserted.second) {
+                inserted.first->second = sequence;
+                ++stats_.superseded;
+            }
+        }
+        queues_[static_cast<size_t>(ordered->priority)].push_back(
+            Pending{ordered->owner, std::move(ordered->task), ordered->kind, ordered->key, sequence});
+        delete ordered;
+        ordered = next;
+    }
+}
+
+bool EventBus::Deliver(Pending& pending) {
+    if (pending.kind != 0) {
+        auto it = newest_.find(SupersedeKey{pending.owner, pending.kind, pending.key});
+        if (it == newest_.end() || it->second != pending.sequence) return false;
+        newest_.erase(it);
+    }
+    ++stats_.delivered;
+    if (pending.task) pending.task();
+    return true;
+}
+
+bool EventBus::Drain() {
+    ++stats_.drains;
+    TakeIncoming();
+
+    // Each event is moved out before it runs, so a task may post or discard.
+    auto& urgent = queues_[static_cast<size_t>(Priority::kUrgent)];
+    while (!urgent.empty()) {
+        Pending pending = std::move(urgent.front());
+        urgent.pop_front();
+        Deliver(pending);
+    }
+
+    size_t budget = batchLimit_;
+    for (size_t priority = static_cast<size_t>(Priority::kNormal); priority < 3 && budget > 0; ++priority) {
+        auto& queue = queues_[priority];
+        while (!queue.empty() && budget > 0) {
+            Pending pending = std::move(queue.front());
+            queue.pop_front();
+            if (Deliver(pending)) --budget;
+        }
+    }
+
+    const bool more = !queues_[0].empty() || !queues_[1].empty() || !queues_[2].empty();
+    if (more && wake_) wake_();
+    return more;
+}
+
+void EventBus::Discard(const void* owner) {
+    TakeIncoming();
+    for (auto& queue : queues_) {
+        const size_t before = queue.size();
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [owner](const Pending& pending) { return pending.owner == owner; }),
+                    queue.end());
+        stats_.discarded += before - queue.size();
+    }
+    for (auto it = newest_.begin(); it != newest_.end();) {
+        it = it->first.owner == owner ? newest_.erase(it) : std::next(it);
+    }
+}
@@ -0,0 +1,117 @@
+#ifndef RUNNER_EVENT_BUS_H_
+#define RUNNER_EVENT_BUS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+
+struct EventBusStats {
+    uint64_t delivered = 0;
+    // Dropped because a newer event of the same kind and key arrived first.
+    uint64_t superseded = 0;
+    // Dropped by Discard().
+    uint64_t discarded = 0;
+    uint64_t drains = 0;
+    size_t largestIntake = 0;
+};
+
+// Carries events and completions from any thread to one consumer thread,
+// which in the runner is the platform thread: the only one allowed to
+// touch method results and event sinks.
+//
+// Producers push onto a lock-free list and call |wake| only when they find
+// it empty, so a burst costs one wake-up. The consumer takes the whole list
+// at once and delivers it by priority: all urgent events, then normal and
+// bulk events up to the batch limit, waking itself again for the rest so
+// input and painting interleave with long streams of text. An event with a
+// non-zero |kind| replaces an undelivered one from the same owner with the
+// same kind and key, so a burst of window changes or selections arrives as
+// its newest state.
+class EventBus {
+public:
+    enum class Priority : uint8_t {
+        kUrgent,
+        kNormal,
+        kBulk,
+    };
+
+    using Task = std::function<void()>;
+
+    static constexpr size_t kDefaultBatchLimit = 64;
+
+    // |wake| is called from producer threads, and from Drain(), to ask for
+    // Drain() to run on the consumer thread.
+    explicit EventBus(std::function<void()> wake, size_t batchLimit = kDefaultBatchLimit);
+    ~EventBus();
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    // Any thread; never blocks. |owner| identifies the producer for
+    // superseding and Discard().
+    void Post(const void* owner, Task task, Priority priority = Priority::kNormal, uint32_t kind = 0,
+              uint64_t key = 0);
+
+    // Consumer thread only. Runs one batch and returns whether events are
+    // left, in which case another wake has been requested.
+    bool Drain();
+
+    // Consumer thread only. Drops every undelivered event from |owner|;
+    // owners call it once their producers have stopped, before going away.
+    void Discard(const void* owner);
+
+    // Consumer thread only.
+    const EventBusStats& Stats() const { return stats_; }
+
+private:
+    struct Node {
+        Node* next;
+        const void* owner;
+        Task task;
+        Priority priority;
+        uint32_t kind;
+        uint64_t key;
+    };
+
+    struct Pending {
+        const void* owner;
+        Task task;
+        uint32_t kind;
+        uint64_t key;
+        uint64_t sequence;
+    };
+
+    struct SupersedeKey {
+        const void* owner;
+        uint32_t kind;
+        uint64_t key;
+
+        bool operator==(const SupersedeKey& other) const {
+            return owner == other.owner && kind == other.kind && key == other.key;
+        }
+    };
+
+    struct SupersedeKeyHash {
+        size_t operator()(const SupersedeKey& k) const;
+    };
+
+    // Moves everything producers have pushed into the priority queues.
+    void TakeIncoming();
+    // Runs |pending| unless a newer event superseded it.
+    bool Deliver(Pending& pending);
+
+    std::function<void()> wake_;
+    const size_t batchLimit_;
+    std::atomic<Node*> incoming_{nullptr};
+
+    // Consumer side.
+    std::deque<Pending> queues_[3];
+    std::unordered_map<SupersedeKey, uint64_t, SupersedeKeyHash> newest_;
+    uint64_t nextSequence_ = 0;
+    EventBusStats stats_;
+};
+
+#endif
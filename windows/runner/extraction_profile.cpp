@@ -0,0 +1,251 @@
+#include "extraction_profile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cwctype>
+#include <sstream>
+
+namespace {
+
+// Indexed by control type id minus kFirstControlTypeId.
+const char* const kControlTypeNames[kControlTypeCount] = {
+    "Button", "Calendar", "CheckBox", "ComboBox", "Edit", "Hyperlink", "Image",
+    "ListItem", "List", "Menu", "MenuBar", "MenuItem", "ProgressBar", "RadioButton",
+    "ScrollBar", "Slider", "Spinner", "StatusBar", "Tab", "TabItem", "Text",
+    "ToolBar", "ToolTip", "Tree", "TreeItem", "Custom", "Group", "Thumb",
+    "DataGrid", "DataItem", "Document", "SplitButton", "Window", "Pane", "Header",
+    "HeaderItem", "Table", "TitleBar", "Separator", "SemanticZoom", "AppBar",
+};
+
+constexpr int kDocumentControlTypeId = 50030;
+constexpr int kEditControlTypeId = 50004;
+
+int ControlTypeBit(int controlType) {
+    const int bit = controlType - kFirstControlTypeId;
+    return bit >= 0 && bit < static_cast<int>(kControlTypeCount) ? bit : -1;
+}
+
+std::string Trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return std::string();
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> SplitWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::istringstream stream(text);
+    std::string word;
+    while (stream >> word) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Names in the profile file are ASCII; anything else cannot match a process
+// or class name reliably, so it is rejected rather than guessed at.
+bool WidenLower(const std::string& text, std::wstring& wide) {
+    wide.clear();
+    wide.reserve(text.size());
+    for (unsigned char ch : text) {
+        if (ch >= 0x80) return false;
+        wide.push_back(static_cast<wchar_t>(ch >= 'A' && ch <= 'Z' ? ch - 'A' + 'a' : ch));
+    }
+    return true;
+}
+
+bool EqualsIgnoreCase(const std::wstring& lower, const std::wstring& text) {
+    if (lower.size() != text.size()) return false;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (static_cast<wchar_t>(std::towlower(text[i])) != lower[i]) return false;
+    }
+    return true;
+}
+
+bool Contains(const std::vector<std::wstring>& lowerNames, const std::wstring& name) {
+    if (name.empty()) return false;
+    for (const auto& candidate : lowerNames) {
+        if (EqualsIgnoreCase(candidate, name)) return true;
+    }
+    return false;
+}
+
+std::string LineError(size_t line, const std::string& message) {
+    return "line " + std::to_string(line) + ": " + message;
+}
+
+}  // namespace
+
+int ControlTypeIdFromName(const std::string& name) {
+    for (size_t i = 0; i < kControlTypeCount; i++) {
+        if (name == kControlTypeNames[i]) return kFirstControlTypeId + static_cast<int>(i);
+    }
+    return 0;
+}
+
+bool ExtractionProfile::Skips(int controlType, const std::wstring& className) const {
+    const int bit = ControlTypeBit(controlType);
+    if (bit >= 0 && skip.test(bit)) return true;
+    return Contains(skipClasses, className);
+}
+
+bool ExtractionProfile::Reads(int controlType) const {
+    if (read.none()) return true;
+    const int bit = ControlTypeBit(controlType);
+    return bit >= 0 && read.test(bit);
+}
+
+ProfileAction ExtractionProfile::Classify(int controlType, const std::wstring& className, bool hasTextPattern) const {
+    if (Skips(controlType, className)) return ProfileAction::kSkipSubtree;
+    // A document's text range already covers everything below it, so
+    // walking its children as well would read the content twice.
+    if (prefer == PreferredPattern::kText && hasTextPattern &&
+        (controlType == kDocumentControlTypeId || controlType == kEditControlTypeId)) {
+        return ProfileAction::kReadDocument;
+    }
+    return Reads(controlType) ? ProfileAction::kReadAndDescend : ProfileAction::kDescend;
+}
+
+std::vector<int> ExtractionProfile::SkippedControlTypes() const {
+    std::vector<int> types;
+    for (size_t i = 0; i < kControlTypeCount; i++) {
+        if (skip.test(i)) types.push_back(kFirstControlTypeId + static_cast<int>(i));
+    }
+    return types;
+}
+
+const ExtractionProfile& ExtractionProfile::GenericDocument() {
+    static const ExtractionProfile profile = [] {
+        ExtractionProfile generic;
+        generic.name = "generic-document";
+        generic.prefer = PreferredPattern::kText;
+        return generic;
+    }();
+    return profile;
+}
+
+ExtractionStrategy ChooseExtractionStrategy(const ExtractionProfile* profile, bool hasTextDocument) {
+    if (profile) return ExtractionStrategy::kProfileWalk;
+    return hasTextDocument ? ExtractionStrategy::kDocumentFastPath : ExtractionStrategy::kFullWalk;
+}
+
+bool ExtractionProfileSet::Parse(const std::string& text, std::string& error) {
+    int version = 0;
+    std::vector<ExtractionProfile> profiles;
+
+    std::istringstream stream(text);
+    std::string raw;
+    size_t lineNumber = 0;
+    while (std::getline(stream, raw)) {
+        lineNumber++;
+        const size_t comment = raw.find('#');
+        const std::string line = Trim(comment == std::string::npos ? raw : raw.substr(0, comment));
+        if (line.empty()) continue;
+
+        if (version == 0) {
+            const std::vector<std::string> words = SplitWords(line);
+            if (words.size() != 2 || words[0] != "version") {
+                error = LineError(lineNumber, "expected 'version N' before any profile");
+                return false;
+            }
+            version = std::atoi(words[1].c_str());
+            if (version != kVersion) {
+                error = LineError(lineNumber, "unsupported version " + words[1]);
+                return false;
+            }
+            continue;
+        }
+
+        if (line.front() == '[') {
+            if (line.back() != ']' || line.size() < 3) {
+                error = LineError(lineNumber, "malformed profile header");
+                return false;
+            }
+            profiles.emplace_back();
+            profiles.back().name = Trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = LineError(lineNumber, "expected 'key = values'");
+            return false;
+        }
+        if (profiles.empty()) {
+            error = LineError(lineNumber, "setting outside a profile");
+            return false;
+        }
+
+        ExtractionProfile& profile = profiles.back();
+        const std::string key = Trim(line.substr(0, equals));
+        const std::vector<std::string> values = SplitWords(line.substr(equals + 1));
+
+        if (key == "process" || key == "window_class" || key == "skip_class") {
+            std::vector<std::wstring>& names = key == "process" ? profile.processes
+                                             : key == "window_class" ? profile.windowClasses
+                                             : profile.skipClasses;
+            for (const auto& value : values) {
+                std::wstring name;
+                if (!WidenLower(value, name)) {
+                    error = LineError(lineNumber, "non-ASCII name '" + value + "'");
+                    return false;
+                }
+                names.push_back(std::move(name));
+            }
+        } else if (key == "skip" || key == "read") {
+            for (const auto& value : values) {
+                const int bit = ControlTypeBit(ControlTypeIdFromName(value));
+                if (bit < 0) {
+                    error = LineError(lineNumber, "unknown control type '" + value + "'");
+                    return false;
+                }
+                (key == "skip" ? profile.skip : profile.read).set(bit);
+            }
+        } else if (key == "prefer") {
+            const std::string value = values.size() == 1 ? values[0] : std::string();
+            if (value == "any") {
+                profile.prefer = PreferredPattern::kAny;
+            } else if (value == "text") {
+                profile.prefer = PreferredPattern::kText;
+            } else if (value == "value") {
+                profile.prefer = PreferredPattern::kValue;
+            } else if (value == "name") {
+                profile.prefer = PreferredPattern::kName;
+            } else {
+                error = LineError(lineNumber, "prefer must be any, text, value or name");
+                return false;
+            }
+        } else {
+            error = LineError(lineNumber, "unknown key '" + key + "'");
+            return false;
+        }
+    }
+
+    if (version == 0) {
+        error = "missing version";
+        return false;
+    }
+    for (const auto& profile : profiles) {
+        if (profile.processes.empty() && profile.windowClasses.empty()) {
+            error = "profile '" + profile.name + "' matches no process or window class";
+            return false;
+        }
+    }
+
+    version_ = version;
+    profiles_ = std::move(profiles);
+    return true;
+}
+
+const ExtractionProfile* ExtractionProfileSet::Match(const std::wstring& processName,
+                                                     const std::wstring& windowClass) const {
+    for (const auto& profile : profiles_) {
+        if (Contains(profile.processes, processName)) return &profile;
+    }
+    // Window classes are the fallback for hosts such as Electron apps, which
+    // share a class but not an executable name.
+    for (const auto& profile : profiles_) {
+        if (Contains(profile.windowClasses, windowClass)) return &profile;
+    }
+    return nullptr;
+}
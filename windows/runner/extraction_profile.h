@@ -0,0 +1,105 @@
+#ifndef RUNNER_EXTRACTION_PROFILE_H_
+#define RUNNER_EXTRACTION_PROFILE_H_
+
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// UIA control type ids are the contiguous range 50000 (Button) to 50040
+// (AppBar); profiles keep them as bits relative to the first.
+constexpr int kFirstControlTypeId = 50000;
+constexpr size_t kControlTypeCount = 41;
+
+// Returns the UIA control type id for a name such as "ToolBar", or 0.
+int ControlTypeIdFromName(const std::string& name);
+
+enum class PreferredPattern {
+    // Name and value of every element read.
+    kAny,
+    // Read text-pattern documents whole instead of walking their children.
+    kText,
+    kValue,
+    kName,
+};
+
+// What the walker does with one element.
+enum class ProfileAction {
+    kSkipSubtree,
+    kDescend,
+    kReadAndDescend,
+    kReadDocument,
+};
+
+// Per-application extraction rules. Elements whose control type or class
+// name is skipped are pruned along with their subtree; |read| limits which
+// of the remaining elements contribute text (all when empty).
+struct ExtractionProfile {
+    std::string name;
+    std::vector<std::wstring> processes;
+    std::vector<std::wstring> windowClasses;
+    std::bitset<kControlTypeCount> skip;
+    std::vector<std::wstring> skipClasses;
+    std::bitset<kControlTypeCount> read;
+    PreferredPattern prefer = PreferredPattern::kAny;
+
+    bool Skips(int controlType, const std::wstring& className) const;
+    bool Reads(int controlType) const;
+    ProfileAction Classify(int controlType, const std::wstring& className, bool hasTextPattern) const;
+
+    // Skipped control type ids, for compiling into a native condition.
+    std::vector<int> SkippedControlTypes() const;
+
+    // Rules for windows without a profile that expose a text-pattern
+    // document, as browsers do: nothing is skipped, the document is read
+    // through one text range and the rest of the window element by element.
+    static const ExtractionProfile& GenericDocument();
+};
+
+enum class ExtractionStrategy {
+    // FindAll over every descendant, reading each one.
+    kFullWalk,
+    // Level-by-level walk with a profile's skip-set and preferences.
+    kProfileWalk,
+    // Generic walk that reads text-pattern documents whole.
+    kDocumentFastPath,
+};
+
+// A matching profile always wins; otherwise the fast path is taken when the
+// window has a document that supports TextPattern.
+ExtractionStrategy ChooseExtractionStrategy(const ExtractionProfile* profile, bool hasTextDocument);
+
+// Versioned set of profiles parsed from a text file:
+//
+//   version 1
+//   [chromium]
+//   process = chrome.exe msedge.exe
+//   skip = ToolBar TitleBar Tab
+//   prefer = text
+//
+// Keys are process, window_class, skip, skip_class, read and prefer. Process
+// and class names are matched case-insensitively.
+class ExtractionProfileSet {
+public:
+    static constexpr int kVersion = 1;
+
+    // Replaces the current profiles. On failure the set is left unchanged and
+    // |error| names the offending line.
+    bool Parse(const std::string& text, std::string& error);
+
+    // Profile for a process image name (without directory) or, failing that,
+    // the top-level window class. Returns nullptr when none applies, in which
+    // case the caller reads the whole tree.
+    const ExtractionProfile* Match(const std::wstring& processName, const std::wstring& windowClass) const;
+
+    int Version() const { return version_; }
+    size_t Size() const { return profiles_.size(); }
+    bool Empty() const { return profiles_.empty(); }
+    const ExtractionProfile& At(size_t index) const { return profiles_[index]; }
+
+private:
+    int version_ = 0;
+    std::vector<ExtractionProfile> profiles_;
+};
+
+#endif
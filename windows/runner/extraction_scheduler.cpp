@@ -0,0 +1,131 @@
+#include "extraction_scheduler.h"
+
+#include <utility>
+
+ExtractionScheduler::ExtractionScheduler(ResultCallback onResult, BatchCallback onBatchComplete)
+    : onResult_(std::move(onResult)), onBatchComplete_(std::move(onBatchComplete)) {}
+
+ExtractionScheduler::~ExtractionScheduler() {
+    Stop();
+}
+
+bool ExtractionScheduler::Start(size_t workerCount, ProviderFactory factory) {
+    if (!workers_.empty() || workerCount == 0) return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+    }
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        workers_.emplace_back(&ExtractionScheduler::WorkerLoop, this, factory);
+    }
+    return true;
+}
+
+void ExtractionScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queues_.clear();
+        readyProcesses_.clear();
+        batchRemaining_.clear();
+        pending_ = 0;
+    }
+    workAvailable_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+    workers_.clear();
+    busyProcesses_.clear();
+}
+
+uint64_t ExtractionScheduler::Submit(const std::vector<ExtractionTarget>& targets) {
+    uint64_t batchId = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batchId = ++nextBatchId_;
+        if (!targets.empty()) {
+            batchRemaining_[batchId] = targets.size();
+        }
+        for (const auto& target : targets) {
+            auto& queue = queues_[target.processId];
+            // A process is listed as ready only while it is idle and has work,
+            // so it never appears in |readyProcesses_| twice.
+            if (queue.empty() && busyProcesses_.count(target.processId) == 0) {
+                readyProcesses_.push_back(target.processId);
+            }
+            queue.push_back({batchId, target.target});
+            pending_++;
+        }
+    }
+
+    if (targets.empty()) {
+        if (onBatchComplete_) onBatchComplete_(batchId);
+    } else {
+        workAvailable_.notify_all();
+    }
+    return batchId;
+}
+
+size_t ExtractionScheduler::PendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+void ExtractionScheduler::WorkerLoop(ProviderFactory factory) {
+    std::unique_ptr<TextExtractionProvider> provider = factory ? factory() : nullptr;
+
+    while (true) {
+        uint32_t processId = 0;
+        Job job{};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this] { return stopping_ || !readyProcesses_.empty(); });
+            if (stopping_) break;
+
+            processId = readyProcesses_.front();
+            readyProcesses_.pop_front();
+            auto& queue = queues_[processId];
+            job = queue.front();
+            queue.pop_front();
+            busyProcesses_.insert(processId);
+        }
+
+        std::wstring text;
+        const bool success = provider && provider->ExtractText(job.target, text);
+        {
+            // Most likely cut short by the cancellation that lets Stop()
+            // return.
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) break;
+        }
+        if (onResult_) onResult_(job.batchId, job.target, success, std::move(text));
+
+        bool batchComplete = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) break;
+
+            busyProcesses_.erase(processId);
+            auto queue = queues_.find(processId);
+            if (queue != queues_.end()) {
+                if (queue->second.empty()) {
+                    queues_.erase(queue);
+                } else {
+                    readyProcesses_.push_back(processId);
+                    workAvailable_.notify_one();
+                }
+            }
+
+            pending_--;
+            auto remaining = batchRemaining_.find(job.batchId);
+            if (remaining != batchRemaining_.end() && --remaining->second == 0) {
+                batchRemaining_.erase(remaining);
+                batchComplete = true;
+            }
+        }
+        if (batchComplete && onBatchComplete_) onBatchComplete_(job.batchId);
+    }
+}
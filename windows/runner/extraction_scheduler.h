@@ -0,0 +1,85 @@
+#ifndef RUNNER_EXTRACTION_SCHEDULER_H_
+#define RUNNER_EXTRACTION_SCHEDULER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Reads text for one target. An instance is created on, and only used from,
+// a single worker thread, so implementations may hold thread-affine state
+// such as a COM apartment and an IUIAutomation instance.
+class TextExtractionProvider {
+public:
+    virtual ~TextExtractionProvider() = default;
+    virtual bool ExtractText(uint64_t target, std::wstring& text) = 0;
+};
+
+struct ExtractionTarget {
+    uint64_t target = 0;
+    // Targets sharing a process id are extracted one at a time, so a hung
+    // process can occupy at most one worker.
+    uint32_t processId = 0;
+};
+
+// Fixed pool of extraction workers fed from per-process FIFO queues. Ready
+// processes are served round-robin; results are reported from the worker
+// thread as soon as each target completes.
+class ExtractionScheduler {
+public:
+    using ProviderFactory = std::function<std::unique_ptr<TextExtractionProvider>()>;
+    using ResultCallback = std::function<void(uint64_t batchId, uint64_t target, bool success, std::wstring text)>;
+    using BatchCallback = std::function<void(uint64_t batchId)>;
+
+    ExtractionScheduler(ResultCallback onResult, BatchCallback onBatchComplete);
+    ~ExtractionScheduler();
+
+    ExtractionScheduler(const ExtractionScheduler&) = delete;
+    ExtractionScheduler& operator=(const ExtractionScheduler&) = delete;
+
+    // |factory| runs once on each worker thread before it takes any work.
+    bool Start(size_t workerCount, ProviderFactory factory);
+    // Drops queued work and joins the workers. A worker inside a provider
+    // call is waited for: Stop() relies on that call returning, which in the
+    // runner means the provider watchdog's CoCancelCall succeeding. Results
+    // that arrive once Stop() has begun are not reported.
+    void Stop();
+    bool IsRunning() const { return !workers_.empty(); }
+
+    // Queues every target and returns the batch id used in callbacks.
+    uint64_t Submit(const std::vector<ExtractionTarget>& targets);
+
+    size_t PendingCount() const;
+
+private:
+    struct Job {
+        uint64_t batchId;
+        uint64_t target;
+    };
+
+    void WorkerLoop(ProviderFactory factory);
+
+    ResultCallback onResult_;
+    BatchCallback onBatchComplete_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::unordered_map<uint32_t, std::deque<Job>> queues_;
+    std::deque<uint32_t> readyProcesses_;
+    std::unordered_set<uint32_t> busyProcesses_;
+    std::unordered_map<uint64_t, size_t> batchRemaining_;
+    uint64_t nextBatchId_ = 0;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+#endif
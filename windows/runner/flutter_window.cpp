@@ -4,7 +4,9 @@
 
 #include "flutter/generated_plugin_registrant.h"
 #include "accessibility_plugin.h"
+#include "app_messages.h"
 #include "overlay_plugin.h"
+#include "startup_trace.h"
 
 FlutterWindow::FlutterWindow(const flutter::DartProject& project)
     : project_(project) {}
@@ -26,15 +28,28 @@ bool FlutterWindow::OnCreate() {
   if (!flutter_controller_->engine() || !flutter_controller_->view()) {
     return false;
   }
+  StartupTrace::Instance().Mark("engine_created");
   RegisterPlugins(flutter_controller_->engine());
-  AccessibilityPlugin::RegisterWithRegistrar(
-      flutter_controller_->engine()->GetRegistrarForPlugin("AccessibilityPlugin"));
+  HWND window = GetHandle();
+  event_bus_ = std::make_unique<EventBus>(
+      [window]() { PostMessage(window, kEventBusMessage, 0, 0); });
+  accessibility_plugin_ = AccessibilityPlugin::RegisterWithRegistrar(
+      flutter_controller_->engine()->GetRegistrarForPlugin("AccessibilityPlugin"),
+      *event_bus_);
   OverlayPlugin::RegisterWithRegistrar(
-      flutter_controller_->engine()->GetRegistrarForPlugin("OverlayPlugin"));
+      flutter_controller_->engine()->GetRegistrarForPlugin("OverlayPlugin"),
+      *event_bus_);
+  StartupTrace::Instance().Mark("plugins_registered");
   SetChildContent(flutter_controller_->view()->GetNativeWindow());
 
   flutter_controller_->engine()->SetNextFrameCallback([&]() {
     this->Show();
+    StartupTrace::Instance().Mark("first_frame");
+    // UI Automation is not needed to draw the first frame, so it starts only
+    // once the window is visible.
+    if (accessibility_plugin_) {
+      accessibility_plugin_->StartDeferredInitialization();
+    }
   });
 
   // Flutter can complete the first frame before the "show window" callback is
@@ -47,8 +62,10 @@ bool FlutterWindow::OnCreate() {
 
 void FlutterWindow::OnDestroy() {
   if (flutter_controller_) {
+    accessibility_plugin_ = nullptr;
     flutter_controller_ = nullptr;
   }
+  event_bus_ = nullptr;
 
   Win32Window::OnDestroy();
 }
@@ -57,6 +74,11 @@ LRESULT
 FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
                               WPARAM const wparam,
                               LPARAM const lparam) noexcept {
+  if (message == kEventBusMessage && event_bus_) {
+    event_bus_->Drain();
+    return 0;
+  }
+
   // Give Flutter, including plugins, an opportunity to handle window messages.
   if (flutter_controller_) {
     std::optional<LRESULT> result =
@@ -6,8 +6,11 @@
 
 #include <memory>
 
+#include "event_bus.h"
 #include "win32_window.h"
 
+class AccessibilityPlugin;
+
 // A window that does nothing but host a Flutter view.
 class FlutterWindow : public Win32Window {
  public:
@@ -26,8 +29,15 @@ class FlutterWindow : public Win32Window {
   // The project to run.
   flutter::DartProject project_;
 
+  // Carries plugin events from worker threads to this window's thread.
+  // Declared before the controller so it outlives the plugins.
+  std::unique_ptr<EventBus> event_bus_;
+
   // The Flutter instance hosted by this window.
   std::unique_ptr<flutter::FlutterViewController> flutter_controller_;
+
+  // Owned by the engine's registrar; valid while flutter_controller_ is.
+  AccessibilityPlugin* accessibility_plugin_ = nullptr;
 };
 
 #endif  // RUNNER_FLUTTER_WINDOW_H_
@@ -0,0 +1,75 @@
+#include "geometry_coalescer.h"
+
+#include <algorithm>
+
+GeometryCoalescer::GeometryCoalescer(int64_t frameIntervalMicros)
+    : frameIntervalMicros_(std::max<int64_t>(frameIntervalMicros, 0)) {}
+
+void GeometryCoalescer::Reset(const OverlayGeometry& geometry) {
+    target_ = geometry;
+    applied_ = geometry;
+    pending_ = false;
+    scheduled_ = false;
+}
+
+void GeometryCoalescer::SetFrameInterval(int64_t frameIntervalMicros) {
+    frameIntervalMicros_ = std::max<int64_t>(frameIntervalMicros, 0);
+}
+
+void GeometryCoalescer::SetPosition(int x, int y) {
+    target_.x = x;
+    target_.y = y;
+    pending_ = true;
+}
+
+void GeometryCoalescer::SetSize(int width, int height) {
+    target_.width = width;
+    target_.expandedHeight = height;
+    pending_ = true;
+}
+
+void GeometryCoalescer::SetAlwaysOnTop(bool alwaysOnTop) {
+    target_.alwaysOnTop = alwaysOnTop;
+    pending_ = true;
+}
+
+void GeometryCoalescer::SetMinimized(bool minimized) {
+    target_.minimized = minimized;
+    pending_ = true;
+}
+
+bool GeometryCoalescer::ScheduleFlush(int64_t nowMicros, int64_t& delayMicros) {
+    if (!pending_ || scheduled_) return false;
+    scheduled_ = true;
+    delayMicros = 0;
+    if (hasApplied_) {
+        delayMicros = std::max<int64_t>(lastApplyMicros_ + frameIntervalMicros_ - nowMicros, 0);
+    }
+    return true;
+}
+
+bool GeometryCoalescer::TakeUpdate(int64_t nowMicros, GeometryUpdate& update, bool force) {
+    scheduled_ = false;
+    if (!pending_) return false;
+    if (!force && hasApplied_ && nowMicros < lastApplyMicros_ + frameIntervalMicros_) return false;
+
+    pending_ = false;
+    uint32_t changes = 0;
+    if (target_.x != applied_.x || target_.y != applied_.y) {
+        changes |= kGeometryMove;
+    }
+    if (target_.width != applied_.width || target_.Height() != applied_.Height()) {
+        changes |= kGeometryResize;
+    }
+    if (target_.alwaysOnTop != applied_.alwaysOnTop) {
+        changes |= kGeometryZOrder;
+    }
+    applied_ = target_;
+    if (changes == 0) return false;
+
+    hasApplied_ = true;
+    lastApplyMicros_ = nowMicros;
+    update.geometry = target_;
+    update.changes = changes;
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef RUNNER_GEOMETRY_COALESCER_H_
+#define RUNNER_GEOMETRY_COALESCER_H_
+
+#include <cstdint>
+
+// Placement of the overlay window. |expandedHeight| is kept while minimized
+// so expanding restores the last size requested.
+struct OverlayGeometry {
+    int x = 100;
+    int y = 100;
+    int width = 400;
+    int expandedHeight = 500;
+    int minimizedHeight = 40;
+    bool alwaysOnTop = true;
+    bool minimized = false;
+
+    int Height() const { return minimized ? minimizedHeight : expandedHeight; }
+};
+
+enum GeometryChange : uint32_t {
+    kGeometryMove = 1u << 0,
+    kGeometryResize = 1u << 1,
+    kGeometryZOrder = 1u << 2,
+};
+
+// The window operation a flush has to perform. |changes| names the parts
+// that differ from what was last applied.
+struct GeometryUpdate {
+    OverlayGeometry geometry;
+    uint32_t changes = 0;
+};
+
+// Merges geometry requests into at most one window update per frame,
+// driven by an external microsecond clock. Requests only change the target;
+// the caller asks ScheduleFlush whether and when to wake up and calls
+// TakeUpdate then. Requests that cancel out within a frame produce no
+// update at all.
+class GeometryCoalescer {
+public:
+    explicit GeometryCoalescer(int64_t frameIntervalMicros = 16667);
+
+    // Sets both the target and the applied geometry, e.g. after the window
+    // was created with |geometry|.
+    void Reset(const OverlayGeometry& geometry);
+
+    void SetFrameInterval(int64_t frameIntervalMicros);
+    int64_t FrameInterval() const { return frameIntervalMicros_; }
+
+    void SetPosition(int x, int y);
+    void SetSize(int width, int height);
+    void SetAlwaysOnTop(bool alwaysOnTop);
+    void SetMinimized(bool minimized);
+
+    // The geometry as last requested, which is what getters should report.
+    const OverlayGeometry& Target() const { return target_; }
+    bool HasPending() const { return pending_; }
+
+    // Returns true if the caller has to arm a wake-up, and how far from
+    // |nowMicros| it should be. Returns false while one is already armed.
+    bool ScheduleFlush(int64_t nowMicros, int64_t& delayMicros);
+
+    // Called from the wake-up. Fills |update| and returns true if the window
+    // has to change. Returns false if nothing is pending, if the requests
+    // cancelled out, or if a frame has not yet passed since the last update
+    // and |force| is false; in that last case call ScheduleFlush again.
+    bool TakeUpdate(int64_t nowMicros, GeometryUpdate& update, bool force = false);
+
+private:
+    int64_t frameIntervalMicros_;
+    OverlayGeometry target_;
+    OverlayGeometry applied_;
+    bool pending_ = false;
+    bool scheduled_ = false;
+    bool hasApplied_ = false;
+    int64_t lastApplyMicros_ = 0;
+};
+
+#endif
@@ -0,0 +1,588 @@
+#include "image_preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define RUNNER_IMAGE_SSE2 1
+#endif
+
+namespace {
+
+constexpr uint8_t kInkThreshold = 128;
+constexpr double kPi = 3.14159265358979323846;
+
+// Resampling weights are 2.14 fixed point; intermediate rows carry 8
+// fractional bits.
+constexpr int kWeightBits = 14;
+constexpr int kWeightOne = 1 << kWeightBits;
+constexpr int kRowFractionBits = 8;
+
+constexpr float kSauvolaK = 0.34f;
+constexpr float kSauvolaRange = 128.0f;
+// Keeps window sums of squares, at most 255^2 * (2r + 1)^2, below 2^31.
+constexpr int kMaxBinarizeRadius = 90;
+
+// Source samples covering one output sample along an axis.
+struct Contribution {
+    int first = 0;
+    int count = 0;
+    size_t weightOffset = 0;
+};
+
+// Box-filter weights for shrinking |sourceLength| samples to |targetLength|:
+// each output averages the source interval it covers, counting partially
+// covered samples by the fraction covered. Weights of each output sum to
+// exactly kWeightOne.
+void ComputeContributions(int sourceLength, int targetLength,
+                          std::vector<Contribution>& contributions, std::vector<uint16_t>& weights) {
+    contributions.resize(static_cast<size_t>(targetLength));
+    weights.clear();
+    const double scale = static_cast<double>(sourceLength) / targetLength;
+    for (int o = 0; o < targetLength; o++) {
+        const double start = o * scale;
+        const double end = std::min<double>(sourceLength, (o + 1) * scale);
+        Contribution& c = contributions[static_cast<size_t>(o)];
+        c.first = static_cast<int>(start);
+        const int last = std::min(sourceLength, static_cast<int>(std::ceil(end)));
+        c.count = std::max(1, last - c.first);
+        c.weightOffset = weights.size();
+
+        int total = 0;
+        size_t largest = weights.size();
+        for (int i = c.first; i < c.first + c.count; i++) {
+            const double covered = std::min<double>(end, i + 1) - std::max<double>(start, i);
+            const int w = static_cast<int>(std::lround(std::max(0.0, covered) / scale * kWeightOne));
+            if (weights.size() == c.weightOffset || w > weights[largest]) largest = weights.size();
+            weights.push_back(static_cast<uint16_t>(w));
+            total += w;
+        }
+        weights[largest] = static_cast<uint16_t>(weights[largest] + (kWeightOne - total));
+    }
+}
+
+// One row of |source| resampled horizontally into |out| with 8 fractional
+// bits.
+void ResampleRow(const uint8_t* source, const std::vector<Contribution>& contributions,
+                 const std::vector<uint16_t>& weights, uint16_t* out) {
+    const size_t count = contributions.size();
+    for (size_t x = 0; x < count; x++) {
+        const Contribution& c = contributions[x];
+        const uint8_t* s = source + c.first;
+        const uint16_t* w = weights.data() + c.weightOffset;
+        uint32_t sum = 0;
+        for (int i = 0; i < c.count; i++) {
+            sum += static_cast<uint32_t>(s[i]) * w[i];
+        }
+        out[x] = static_cast<uint16_t>((sum + (1u << (kWeightBits - kRowFractionBits - 1))) >>
+                                       (kWeightBits - kRowFractionBits));
+    }
+}
+
+// |accumulator| += |row| * |weight| for |count| samples.
+void AccumulateRow(const uint16_t* row, uint16_t weight, size_t count, uint32_t* accumulator) {
+    size_t x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+    const __m128i w = _mm_set1_epi16(static_cast<short>(weight));
+    for (; x + 8 <= count; x += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        // Full 32-bit products from the low and high halves.
+        const __m128i lo = _mm_mullo_epi16(v, w);
+        const __m128i hi = _mm_mulhi_epu16(v, w);
+        __m128i* acc = reinterpret_cast<__m128i*>(accumulator + x);
+        _mm_storeu_si128(acc, _mm_add_epi32(_mm_loadu_si128(acc), _mm_unpacklo_epi16(lo, hi)));
+        _mm_storeu_si128(acc + 1, _mm_add_epi32(_mm_loadu_si128(acc + 1), _mm_unpackhi_epi16(lo, hi)));
+    }
+#endif
+    for (; x < count; x++) {
+        accumulator[x] += static_cast<uint32_t>(row[x]) * weight;
+    }
+}
+
+void StoreAccumulated(const uint32_t* accumulator, size_t count, uint8_t* out) {
+    constexpr int shift = kWeightBits + kRowFractionBits;
+    size_t x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+    const __m128i round = _mm_set1_epi32(1 << (shift - 1));
+    for (; x + 8 <= count; x += 8) {
+        const __m128i* acc = reinterpret_cast<const __m128i*>(accumulator + x);
+        const __m128i a = _mm_srli_epi32(_mm_add_epi32(_mm_loadu_si128(acc), round), shift);
+        const __m128i b = _mm_srli_epi32(_mm_add_epi32(_mm_loadu_si128(acc + 1), round), shift);
+        const __m128i packed = _mm_packs_epi32(a, b);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(packed, packed));
+    }
+#endif
+    for (; x < count; x++) {
+        out[x] = static_cast<uint8_t>(std::min<uint32_t>(255, (accumulator[x] + (1u << (shift - 1))) >> shift));
+    }
+}
+
+// |sums| += |row| (or -= when |subtract|), and likewise |squares| with the
+// squared values.
+void UpdateColumnSums(const uint8_t* row, size_t count, bool subtract, uint32_t* sums, uint32_t* squares) {
+    size_t x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 8 <= count; x += 8) {
+        const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + x)), zero);
+        // 255 * 255 fits in 16 bits, so the low half is the whole square.
+        const __m128i sq = _mm_mullo_epi16(v, v);
+        __m128i* s = reinterpret_cast<__m128i*>(sums + x);
+        __m128i* q = reinterpret_cast<__m128i*>(squares + x);
+        const __m128i v0 = _mm_unpacklo_epi16(v, zero);
+        const __m128i v1 = _mm_unpackhi_epi16(v, zero);
+        const __m128i q0 = _mm_unpacklo_epi16(sq, zero);
+        const __m128i q1 = _mm_unpackhi_epi16(sq, zero);
+        if (subtract) {
+            _mm_storeu_si128(s, _mm_sub_epi32(_mm_loadu_si128(s), v0));
+            _mm_storeu_si128(s + 1, _mm_sub_epi32(_mm_loadu_si128(s + 1), v1));
+            _mm_storeu_si128(q, _mm_sub_epi32(_mm_loadu_si128(q), q0));
+            _mm_storeu_si128(q + 1, _mm_sub_epi32(_mm_loadu_si128(q + 1), q1));
+        } else {
+            _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), v0));
+            _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), v1));
+            _mm_storeu_si128(q, _mm_add_epi32(_mm_loadu_si128(q), q0));
+            _mm_storeu_si128(q + 1, _mm_add_epi32(_mm_loadu_si128(q + 1), q1));
+        }
+    }
+#endif
+    for (; x < count; x++) {
+        const uint32_t v = row[x];
+        if (subtract) {
+            sums[x] -= v;
+            squares[x] -= v * v;
+        } else {
+            sums[x] += v;
+            squares[x] += v * v;
+        }
+    }
+}
+
+// Sauvola decision for one row given each pixel's window sum, sum of
+// squares and reciprocal pixel count. The vector and scalar paths evaluate
+// the same float expression in the same order.
+void ThresholdRow(const uint8_t* in, const uint32_t* sums, const uint32_t* squares,
+                  const float* inverseCounts, size_t count, uint8_t* out) {
+    size_t x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 k = _mm_set1_ps(kSauvolaK);
+    const __m128 inverseRange = _mm_set1_ps(1.0f / kSauvolaRange);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 floor = _mm_setzero_ps();
+    for (; x + 8 <= count; x += 8) {
+        const __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + x)), zero);
+        __m128i ink[2];
+        for (int half = 0; half < 2; half++) {
+            const size_t i = x + static_cast<size_t>(half) * 4;
+            const __m128 n = _mm_loadu_ps(inverseCounts + i);
+            const __m128 mean = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i))), n);
+            const __m128 meanSquare =
+                _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(squares + i))), n);
+            const __m128 deviation = _mm_sqrt_ps(_mm_max_ps(floor, _mm_sub_ps(meanSquare, _mm_mul_ps(mean, mean))));
+            const __m128 threshold =
+                _mm_mul_ps(mean, _mm_add_ps(one, _mm_mul_ps(k, _mm_sub_ps(_mm_mul_ps(deviation, inverseRange), one))));
+            const __m128 value = _mm_cvtepi32_ps(half == 0 ? _mm_unpacklo_epi16(pixels, zero) : _mm_unpackhi_epi16(pixels, zero));
+            ink[half] = _mm_castps_si128(_mm_cmple_ps(value, threshold));
+        }
+        // Ink lanes are all ones; background becomes 255, ink 0.
+        const __m128i mask = _mm_packs_epi16(_mm_packs_epi32(ink[0], ink[1]), zero);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_andnot_si128(mask, _mm_set1_epi8(-1)));
+    }
+#endif
+    for (; x < count; x++) {
+        const float n = inverseCounts[x];
+        const float mean = static_cast<float>(static_cast<int32_t>(sums[x])) * n;
+        const float meanSquare = static_cast<float>(static_cast<int32_t>(squares[x])) * n;
+        const float deviation = std::sqrt(std::max(0.0f, meanSquare - mean * mean));
+        const float threshold = mean * (1.0f + kSauvolaK * (deviation * (1.0f / kSauvolaRange) - 1.0f));
+        out[x] = static_cast<uint8_t>(static_cast<float>(in[x]) <= threshold ? 0 : 255);
+    }
+}
+
+void Crop(const GrayImage& source, int x, int y, int width, int height, GrayImage& target) {
+    target.Resize(width, height);
+    for (int row = 0; row < height; row++) {
+        std::memcpy(target.Row(row), source.Row(y + row) + x, static_cast<size_t>(width));
+    }
+}
+
+// First and last index whose count reaches |minimum|, or false if none.
+bool InkExtent(const std::vector<uint32_t>& profile, uint32_t minimum, int& first, int& last) {
+    first = -1;
+    for (size_t i = 0; i < profile.size(); i++) {
+        if (profile[i] >= minimum) {
+            if (first < 0) first = static_cast<int>(i);
+            last = static_cast<int>(i);
+        }
+    }
+    return first >= 0;
+}
+
+}  // namespace
+
+namespace image_kernels {
+
+void GrayFromRgba(const uint8_t* rgba, int width, int height, size_t stride, GrayImage& gray) {
+    gray.Resize(width, height);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = rgba + static_cast<size_t>(y) * stride;
+        uint8_t* dst = gray.Row(y);
+        int x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weights = _mm_setr_epi16(77, 150, 29, 0, 77, 150, 29, 0);
+        const __m128i round = _mm_set1_epi32(128);
+        // Four pixels per 16 bytes: each madd pair yields R*77+G*150 and B*29.
+        auto luma4 = [&](const uint8_t* p) {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), weights);
+            const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), weights);
+            const __m128 flo = _mm_castsi128_ps(lo);
+            const __m128 fhi = _mm_castsi128_ps(hi);
+            const __m128i even = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(2, 0, 2, 0)));
+            const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(flo, fhi, _MM_SHUFFLE(3, 1, 3, 1)));
+            return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), round), 8);
+        };
+        for (; x + 16 <= width; x += 16) {
+            const uint8_t* p = src + static_cast<size_t>(x) * 4;
+            const __m128i a = _mm_packs_epi32(luma4(p), luma4(p + 16));
+            const __m128i b = _mm_packs_epi32(luma4(p + 32), luma4(p + 48));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(a, b));
+        }
+#endif
+        for (; x < width; x++) {
+            const uint8_t* p = src + static_cast<size_t>(x) * 4;
+            dst[x] = static_cast<uint8_t>((p[0] * 77 + p[1] * 150 + p[2] * 29 + 128) >> 8);
+        }
+    }
+}
+
+void Downscale(const GrayImage& source, int targetWidth, int targetHeight, int tileRows, GrayImage& target) {
+    target.Resize(targetWidth, targetHeight);
+    if (targetWidth == source.width && targetHeight == source.height) {
+        target.pixels = source.pixels;
+        return;
+    }
+
+    std::vector<Contribution> columns;
+    std::vector<uint16_t> columnWeights;
+    std::vector<Contribution> rows;
+    std::vector<uint16_t> rowWeights;
+    ComputeContributions(source.width, targetWidth, columns, columnWeights);
+    ComputeContributions(source.height, targetHeight, rows, rowWeights);
+
+    const size_t width = static_cast<size_t>(targetWidth);
+    const int band = std::max(1, tileRows);
+    std::vector<uint16_t> resampled;
+    std::vector<uint32_t> accumulator(width);
+
+    // Each band of output rows resamples only the source rows it covers, so
+    // the intermediate buffer is bounded by the band, not the page.
+    for (int top = 0; top < targetHeight; top += band) {
+        const int bottom = std::min(targetHeight, top + band);
+        const int firstSource = rows[static_cast<size_t>(top)].first;
+        const Contribution& lastRow = rows[static_cast<size_t>(bottom - 1)];
+        const int sourceRows = lastRow.first + lastRow.count - firstSource;
+        resampled.resize(static_cast<size_t>(sourceRows) * width);
+        for (int r = 0; r < sourceRows; r++) {
+            ResampleRow(source.Row(firstSource + r), columns, columnWeights, resampled.data() + static_cast<size_t>(r) * width);
+        }
+
+        for (int y = top; y < bottom; y++) {
+            const Contribution& c = rows[static_cast<size_t>(y)];
+            std::fill(accumulator.begin(), accumulator.end(), 0u);
+            for (int i = 0; i < c.count; i++) {
+                const uint16_t* row = resampled.data() + static_cast<size_t>(c.first - firstSource + i) * width;
+                AccumulateRow(row, rowWeights[c.weightOffset + static_cast<size_t>(i)], width, accumulator.data());
+            }
+            StoreAccumulated(accumulator.data(), width, target.Row(y));
+        }
+    }
+}
+
+void Binarize(const GrayImage& gray, int radius, GrayImage& binary) {
+    const int width = gray.width;
+    const int height = gray.height;
+    binary.Resize(width, height);
+    if (width == 0 || height == 0) return;
+    radius = std::min(std::max(1, radius), kMaxBinarizeRadius);
+
+    const size_t w = static_cast<size_t>(width);
+    std::vector<uint32_t> sums(w, 0);
+    std::vector<uint32_t> squares(w, 0);
+    std::vector<uint32_t> windowSums(w);
+    std::vector<uint32_t> windowSquares(w);
+    std::vector<float> inverseCounts(w);
+    int inverseRows = 0;
+
+    // Column sums start out holding rows [0, radius - 1]; each output row
+    // adds the row entering the window and drops the one leaving it.
+    for (int y = 0; y < std::min(radius, height); y++) {
+        UpdateColumnSums(gray.Row(y), w, false, sums.data(), squares.data());
+    }
+
+    for (int y = 0; y < height; y++) {
+        const int entering = y + radius;
+        const int leaving = y - radius - 1;
+        if (entering < height) UpdateColumnSums(gray.Row(entering), w, false, sums.data(), squares.data());
+        if (leaving >= 0) UpdateColumnSums(gray.Row(leaving), w, true, sums.data(), squares.data());
+
+        // Pixels per window only change near the borders.
+        const int windowRows = std::min(height - 1, y + radius) - std::max(0, y - radius) + 1;
+        if (windowRows != inverseRows) {
+            inverseRows = windowRows;
+            for (int x = 0; x < width; x++) {
+                const int columns = std::min(width, x + radius + 1) - std::max(0, x - radius);
+                inverseCounts[static_cast<size_t>(x)] = 1.0f / static_cast<float>(columns * windowRows);
+            }
+        }
+
+        // Slide the window along the row.
+        uint32_t windowSum = 0;
+        uint32_t windowSquare = 0;
+        for (int x = 0; x < std::min(radius, width); x++) {
+            windowSum += sums[static_cast<size_t>(x)];
+            windowSquare += squares[static_cast<size_t>(x)];
+        }
+        for (int x = 0; x < width; x++) {
+            const int in = x + radius;
+            const int out = x - radius - 1;
+            if (in < width) {
+                windowSum += sums[static_cast<size_t>(in)];
+                windowSquare += squares[static_cast<size_t>(in)];
+            }
+            if (out >= 0) {
+                windowSum -= sums[static_cast<size_t>(out)];
+                windowSquare -= squares[static_cast<size_t>(out)];
+            }
+            windowSums[static_cast<size_t>(x)] = windowSum;
+            windowSquares[static_cast<size_t>(x)] = windowSquare;
+        }
+
+        ThresholdRow(gray.Row(y), windowSums.data(), windowSquares.data(), inverseCounts.data(), w, binary.Row(y));
+    }
+}
+
+double EstimateSkew(const GrayImage& image, double maxDegrees) {
+    if (image.width < 2 || image.height < 2 || maxDegrees <= 0) return 0.0;
+
+    // Sample dark pixels on a grid coarse enough to keep the search cheap on
+    // large pages; text lines are far taller than the grid step.
+    constexpr size_t kMaxPoints = 200000;
+    int step = std::max(1, std::max(image.width, image.height) / 1200);
+    std::vector<float> xs;
+    std::vector<float> ys;
+    while (true) {
+        xs.clear();
+        ys.clear();
+        for (int y = 0; y < image.height && xs.size() <= kMaxPoints; y += step) {
+            const uint8_t* row = image.Row(y);
+            for (int x = 0; x < image.width; x += step) {
+                if (row[x] < kInkThreshold) {
+                    xs.push_back(static_cast<float>(x));
+                    ys.push_back(static_cast<float>(y));
+                }
+            }
+        }
+        if (xs.size() <= kMaxPoints) break;
+        step *= 2;
+    }
+    if (xs.size() < 16) return 0.0;
+
+    const double maxRadians = maxDegrees * kPi / 180.0;
+    const double reach = image.height + image.width * std::sin(maxRadians);
+    const size_t bins = static_cast<size_t>(2 * reach / step) + 4;
+    const double offset = image.width * std::sin(maxRadians) + step;
+    std::vector<uint32_t> histogram(bins);
+
+    // Rows of text concentrate dark pixels into few bins once the
+    // projection angle matches their slope; the sum of squared counts peaks
+    // there.
+    auto score = [&](double degrees) {
+        const double radians = degrees * kPi / 180.0;
+        const float c = static_cast<float>(std::cos(radians) / step);
+        const float s = static_cast<float>(std::sin(radians) / step);
+        const float o = static_cast<float>(offset / step);
+        std::fill(histogram.begin(), histogram.end(), 0u);
+        for (size_t i = 0; i < xs.size(); i++) {
+            const float projected = ys[i] * c + xs[i] * s + o;
+            const size_t bin = static_cast<size_t>(std::max(0.0f, projected));
+            if (bin < bins) histogram[bin]++;
+        }
+        double total = 0;
+        for (uint32_t count : histogram) total += static_cast<double>(count) * count;
+        return total;
+    };
+
+    auto search = [&](double from, double to, double increment) {
+        double best = from;
+        double bestScore = -1;
+        for (double a = from; a <= to + 1e-9; a += increment) {
+            const double value = score(a);
+            if (value > bestScore) {
+                bestScore = value;
+                best = a;
+            }
+        }
+        return best;
+    };
+
+    const double coarse = search(-maxDegrees, maxDegrees, 0.5);
+    return search(std::max(-maxDegrees, coarse - 0.5), std::min(maxDegrees, coarse + 0.5), 0.05);
+}
+
+void Rotate(const GrayImage& source, double degrees, bool bilinear, GrayImage& target) {
+    const int width = source.width;
+    const int height = source.height;
+    target.Resize(width, height);
+    const double radians = degrees * kPi / 180.0;
+    const double c = std::cos(radians);
+    const double s = std::sin(radians);
+    const double cx = (width - 1) / 2.0;
+    const double cy = (height - 1) / 2.0;
+
+    // Each target pixel samples the source point rotated back clockwise;
+    // along a row that point moves by a constant step in 16.16 fixed point.
+    const int32_t stepX = static_cast<int32_t>(std::lround(c * 65536.0));
+    const int32_t stepY = static_cast<int32_t>(std::lround(s * 65536.0));
+    const int64_t limitX = static_cast<int64_t>(width - 1) << 16;
+    const int64_t limitY = static_cast<int64_t>(height - 1) << 16;
+    for (int y = 0; y < height; y++) {
+        const double dy = y - cy;
+        int64_t sx = std::llround((cx - cx * c - dy * s) * 65536.0);
+        int64_t sy = std::llround((cy - cx * s + dy * c) * 65536.0);
+        uint8_t* out = target.Row(y);
+        for (int x = 0; x < width; x++, sx += stepX, sy += stepY) {
+            if (sx < 0 || sy < 0 || sx > limitX || sy > limitY) {
+                out[x] = 255;
+                continue;
+            }
+            if (!bilinear) {
+                out[x] = source.Row(static_cast<int>((sy + 0x8000) >> 16))[(sx + 0x8000) >> 16];
+                continue;
+            }
+            const int x0 = static_cast<int>(sx >> 16);
+            const int y0 = static_cast<int>(sy >> 16);
+            const uint32_t fx = static_cast<uint32_t>((sx >> 8) & 0xFF);
+            const uint32_t fy = static_cast<uint32_t>((sy >> 8) & 0xFF);
+            const int x1 = std::min(x0 + 1, width - 1);
+            const int y1 = std::min(y0 + 1, height - 1);
+            const uint8_t* r0 = source.Row(y0);
+            const uint8_t* r1 = source.Row(y1);
+            const uint32_t top = r0[x0] * (256 - fx) + r0[x1] * fx;
+            const uint32_t bottom = r1[x0] * (256 - fx) + r1[x1] * fx;
+            out[x] = static_cast<uint8_t>((top * (256 - fy) + bottom * fy + 32768) >> 16);
+        }
+    }
+}
+
+void InkProfiles(const GrayImage& image, std::vector<uint32_t>& rows, std::vector<uint32_t>& columns) {
+    rows.assign(static_cast<size_t>(image.height), 0);
+    columns.assign(static_cast<size_t>(image.width), 0);
+    const size_t width = static_cast<size_t>(image.width);
+    for (int y = 0; y < image.height; y++) {
+        const uint8_t* row = image.Row(y);
+        uint32_t count = 0;
+        size_t x = 0;
+#if defined(RUNNER_IMAGE_SSE2)
+        const __m128i limit = _mm_set1_epi8(static_cast<char>(kInkThreshold - 1));
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+            const __m128i ink = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, limit), v), one);
+            const __m128i sums = _mm_sad_epu8(ink, zero);
+            count += static_cast<uint32_t>(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+        }
+#endif
+        for (; x < width; x++) {
+            count += row[x] < kInkThreshold ? 1u : 0u;
+        }
+        rows[static_cast<size_t>(y)] = count;
+        for (x = 0; x < width; x++) {
+            columns[x] += row[x] < kInkThreshold ? 1u : 0u;
+        }
+    }
+}
+
+}  // namespace image_kernels
+
+bool PreprocessForOcr(const uint8_t* rgba, int width, int height, size_t stride,
+                      const OcrPreprocessOptions& options, OcrPreprocessResult& result) {
+    if (!rgba || width <= 0 || height <= 0 || stride < static_cast<size_t>(width) * 4) {
+        return false;
+    }
+
+    GrayImage gray;
+    image_kernels::GrayFromRgba(rgba, width, height, stride, gray);
+
+    GrayImage work;
+    if (options.sourceDpi > 0 && options.targetDpi > 0 && options.targetDpi < options.sourceDpi) {
+        const double scale = static_cast<double>(options.targetDpi) / options.sourceDpi;
+        const int targetWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+        const int targetHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+        image_kernels::Downscale(gray, targetWidth, targetHeight, options.tileRows, work);
+    } else {
+        work = std::move(gray);
+    }
+
+    const int dpi = options.targetDpi > 0 ? options.targetDpi : 300;
+    if (options.binarize) {
+        // About a twelfth of an inch: a little over a line of body text.
+        GrayImage binary;
+        image_kernels::Binarize(work, std::max(7, dpi / 12), binary);
+        work = std::move(binary);
+    }
+
+    result.skewDegrees = 0.0;
+    if (options.deskew) {
+        const double skew = image_kernels::EstimateSkew(work, options.maxSkewDegrees);
+        if (std::fabs(skew) >= 0.1) {
+            GrayImage rotated;
+            // Binary pages stay binary with nearest sampling.
+            image_kernels::Rotate(work, -skew, !options.binarize, rotated);
+            work = std::move(rotated);
+            result.skewDegrees = skew;
+        }
+    }
+
+    result.cropX = 0;
+    result.cropY = 0;
+    result.cropWidth = work.width;
+    result.cropHeight = work.height;
+    if (options.crop) {
+        std::vector<uint32_t> rows;
+        std::vector<uint32_t> columns;
+        image_kernels::InkProfiles(work, rows, columns);
+        // Ignore specks: a line must carry ink across a small share of the
+        // page before it counts as content.
+        const uint32_t minRowInk = static_cast<uint32_t>(std::max(2, work.width / 400));
+        const uint32_t minColumnInk = static_cast<uint32_t>(std::max(2, work.height / 400));
+        int top = 0;
+        int bottom = 0;
+        int left = 0;
+        int right = 0;
+        if (InkExtent(rows, minRowInk, top, bottom) && InkExtent(columns, minColumnInk, left, right)) {
+            const int margin = std::max(4, dpi / 30);
+            top = std::max(0, top - margin);
+            left = std::max(0, left - margin);
+            bottom = std::min(work.height - 1, bottom + margin);
+            right = std::min(work.width - 1, right + margin);
+            if (right - left + 1 < work.width || bottom - top + 1 < work.height) {
+                GrayImage cropped;
+                Crop(work, left, top, right - left + 1, bottom - top + 1, cropped);
+                work = std::move(cropped);
+                result.cropX = left;
+                result.cropY = top;
+                result.cropWidth = work.width;
+                result.cropHeight = work.height;
+            }
+        }
+    }
+
+    result.image = std::move(work);
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef RUNNER_IMAGE_PREPROCESS_H_
+#define RUNNER_IMAGE_PREPROCESS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 8-bit grayscale image, rows stored without padding.
+struct GrayImage {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    void Resize(int w, int h) {
+        width = w;
+        height = h;
+        pixels.resize(static_cast<size_t>(w) * static_cast<size_t>(h));
+    }
+    uint8_t* Row(int y) { return pixels.data() + static_cast<size_t>(y) * static_cast<size_t>(width); }
+    const uint8_t* Row(int y) const { return pixels.data() + static_cast<size_t>(y) * static_cast<size_t>(width); }
+};
+
+struct OcrPreprocessOptions {
+    // Resolution the page was rendered at, and the one the recogniser reads
+    // best at. Images are only ever scaled down.
+    int sourceDpi = 300;
+    int targetDpi = 300;
+    bool binarize = true;
+    bool deskew = true;
+    bool crop = true;
+    // Skew angles searched, in degrees either side of level.
+    double maxSkewDegrees = 5.0;
+    // Output rows produced per resampling pass, so the working set stays in
+    // cache however tall the page is.
+    int tileRows = 64;
+};
+
+struct OcrPreprocessResult {
+    GrayImage image;
+    // Skew that was measured and removed, in degrees, counter-clockwise.
+    double skewDegrees = 0.0;
+    // Region of the scaled page kept by cropping.
+    int cropX = 0;
+    int cropY = 0;
+    int cropWidth = 0;
+    int cropHeight = 0;
+};
+
+// Kernels behind PreprocessForOcr, exposed for measurement. Each uses SSE2
+// where the target has it and an equivalent scalar loop otherwise; both
+// produce identical output.
+namespace image_kernels {
+
+// Rec. 601 luma from RGBA rows, |stride| bytes apart.
+void GrayFromRgba(const uint8_t* rgba, int width, int height, size_t stride, GrayImage& gray);
+
+// Area-averaging downscale by |source| / |target| in both directions.
+void Downscale(const GrayImage& source, int targetWidth, int targetHeight, int tileRows, GrayImage& target);
+
+// Sauvola thresholding over a (2 * radius + 1)-pixel square window: ink
+// becomes 0, background 255. Window sums slide down the image one row at a
+// time, so memory is a few rows whatever the page size.
+void Binarize(const GrayImage& gray, int radius, GrayImage& binary);
+
+// Skew in degrees of the text lines in |image|, found by maximising the
+// variance of the row profile of dark pixels.
+double EstimateSkew(const GrayImage& image, double maxDegrees);
+
+// Rotates counter-clockwise by |degrees| about the centre, filling the
+// uncovered corners white. Nearest sampling keeps binary images binary.
+void Rotate(const GrayImage& source, double degrees, bool bilinear, GrayImage& target);
+
+// Number of dark pixels (below 128) in each row and column.
+void InkProfiles(const GrayImage& image, std::vector<uint32_t>& rows, std::vector<uint32_t>& columns);
+
+}  // namespace image_kernels
+
+// Turns a rendered page into a recogniser-ready image in memory: grayscale,
+// downscale to the target resolution, adaptive binarisation, deskew and
+// crop to the inked area plus a small margin. Returns false for empty or
+// inconsistent input.
+bool PreprocessForOcr(const uint8_t* rgba, int width, int height, size_t stride,
+                      const OcrPreprocessOptions& options, OcrPreprocessResult& result);
+
+#endif
@@ -0,0 +1,432 @@
+#include "keyword_detector.h"
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+#include "unicode_fold.h"
+
+namespace {
+
+constexpr size_t kSymbolTableSize = 0x10000;
+
+// Scanning looks at one UTF-16 code unit at a time, so phrases are limited to
+// the Basic Multilingual Plane; a phrase outside it normalizes to nothing.
+std::wstring NormalizePhrase(const std::wstring& phrase) {
+    std::wstring normalized;
+    normalized.reserve(phrase.size());
+    bool pendingSpace = false;
+    for (wchar_t ch : phrase) {
+        const uint32_t codePoint = static_cast<uint32_t>(ch);
+        if (codePoint >= 0xD800 && (codePoint <= 0xDFFF || codePoint >= kSymbolTableSize)) return std::wstring();
+        if (IsMatchingIgnorable(codePoint)) continue;
+        if (IsMatchingSpace(codePoint)) {
+            pendingSpace = !normalized.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            normalized.push_back(L' ');
+            pendingSpace = false;
+        }
+        normalized.push_back(static_cast<wchar_t>(FoldForMatching(codePoint)));
+    }
+    return normalized;
+}
+
+std::string Trim(const std::string& text) {
+    const size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) return std::string();
+    const size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Strict UTF-8 decoding; code points above the BMP become surrogate pairs
+// where wchar_t is 16 bits wide.
+bool DecodeUtf8(const std::string& text, std::wstring& wide) {
+    wide.clear();
+    wide.reserve(text.size());
+    size_t i = 0;
+    while (i < text.size()) {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        size_t extra = 0;
+        uint32_t codePoint = 0;
+        if (lead < 0x80) {
+            codePoint = lead;
+        } else if (lead >= 0xC2 && lead <= 0xDF) {
+            extra = 1;
+            codePoint = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            extra = 2;
+            codePoint = lead & 0x0F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            extra = 3;
+            codePoint = lead & 0x07;
+        } else {
+            return false;
+        }
+        if (i + extra >= text.size()) return false;
+        for (size_t k = 1; k <= extra; k++) {
+            const unsigned char next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80) return false;
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        static const uint32_t kMinimum[] = {0, 0x80, 0x800, 0x10000};
+        if (codePoint < kMinimum[extra] || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+            return false;
+        }
+        if (sizeof(wchar_t) == 2 && codePoint >= 0x10000) {
+            codePoint -= 0x10000;
+            wide.push_back(static_cast<wchar_t>(0xD800 + (codePoint >> 10)));
+            wide.push_back(static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF)));
+        } else {
+            wide.push_back(static_cast<wchar_t>(codePoint));
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+
+std::string LineError(size_t line, const std::string& message) {
+    return "line " + std::to_string(line) + ": " + message;
+}
+
+std::unique_ptr<KeywordDetector>& ConfiguredDefault() {
+    static std::unique_ptr<KeywordDetector> detector;
+    return detector;
+}
+
+}  // namespace
+
+void KeywordDetector::AddPhrase(const std::wstring& phrase, uint32_t categories) {
+    std::wstring normalized = NormalizePhrase(phrase);
+    if (normalized.empty() || categories == 0) return;
+    phrases_.push_back({std::move(normalized), categories});
+    transitions_.clear();
+}
+
+bool KeywordDetector::LoadPhrases(const std::string& text, std::string& error) {
+    int version = 0;
+    std::vector<std::string> languages;
+    std::vector<Phrase> phrases;
+
+    std::istringstream stream(text);
+    std::string raw;
+    size_t lineNumber = 0;
+    while (std::getline(stream, raw)) {
+        lineNumber++;
+        // A byte order mark left by an editor is not part of the first line.
+        if (lineNumber == 1 && raw.compare(0, 3, "\xEF\xBB\xBF") == 0) raw.erase(0, 3);
+        const size_t comment = raw.find('#');
+        const std::string line = Trim(comment == std::string::npos ? raw : raw.substr(0, comment));
+        if (line.empty()) continue;
+
+        if (version == 0) {
+            if (line.compare(0, 8, "version ") != 0) {
+                error = LineError(lineNumber, "expected 'version N' before any phrase");
+                return false;
+            }
+            const std::string number = Trim(line.substr(8));
+            if (number != std::to_string(kPhraseFileVersion)) {
+                error = LineError(lineNumber, "unsupported version " + number);
+                return false;
+            }
+            version = kPhraseFileVersion;
+            continue;
+        }
+
+        if (line.front() == '[') {
+            if (line.back() != ']' || line.size() < 3) {
+                error = LineError(lineNumber, "malformed language header");
+                return false;
+            }
+            languages.push_back(Trim(line.substr(1, line.size() - 2)));
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            error = LineError(lineNumber, "expected 'category = phrase'");
+            return false;
+        }
+        if (languages.empty()) {
+            error = LineError(lineNumber, "phrase outside a language section");
+            return false;
+        }
+
+        const std::string key = Trim(line.substr(0, equals));
+        uint32_t categories = 0;
+        if (key == "terms") {
+            categories = kKeywordCategoryTerms;
+        } else if (key == "privacy") {
+            categories = kKeywordCategoryPrivacy;
+        } else {
+            error = LineError(lineNumber, "unknown category '" + key + "'");
+            return false;
+        }
+
+        std::wstring phrase;
+        if (!DecodeUtf8(Trim(line.substr(equals + 1)), phrase)) {
+            error = LineError(lineNumber, "invalid UTF-8");
+            return false;
+        }
+        std::wstring normalized = NormalizePhrase(phrase);
+        if (normalized.empty()) {
+            error = LineError(lineNumber, "empty phrase or characters outside the Basic Multilingual Plane");
+            return false;
+        }
+        phrases.push_back({std::move(normalized), categories});
+    }
+
+    if (version == 0) {
+        error = "missing version";
+        return false;
+    }
+
+    languages_.insert(languages_.end(), languages.begin(), languages.end());
+    phrases_.insert(phrases_.end(), std::make_move_iterator(phrases.begin()), std::make_move_iterator(phrases.end()));
+    transitions_.clear();
+    return true;
+}
+
+uint16_t KeywordDetector::SymbolOf(wchar_t ch) const {
+    const size_t index = static_cast<size_t>(ch);
+    return index < symbols_.size() ? symbols_[index] : 0;
+}
+
+void KeywordDetector::Compile() {
+    // Symbol 0 stands for every character that appears in no phrase, which
+    // keeps the transition table as narrow as the phrase alphabet.
+    symbols_.assign(kSymbolTableSize, 0);
+    symbolCount_ = 1;
+    spaceSymbol_ = 0;
+    for (const Phrase& phrase : phrases_) {
+        for (wchar_t ch : phrase.text) {
+            uint16_t& symbol = symbols_[static_cast<size_t>(ch)];
+            if (symbol == 0) symbol = static_cast<uint16_t>(symbolCount_++);
+        }
+    }
+    // Ignorable characters get a column of their own that leaves every state
+    // unchanged, so a combining accent or soft hyphen inside a phrase is
+    // stepped over instead of breaking the match.
+    ignoreSymbol_ = static_cast<uint16_t>(symbolCount_++);
+
+    // Fold every code unit onto the symbol of its matching form so scanning
+    // needs no per-character case or accent handling.
+    std::vector<uint16_t> folded(kSymbolTableSize, 0);
+    spaceSymbol_ = symbols_[L' '];
+    for (size_t unit = 0; unit < kSymbolTableSize; unit++) {
+        const uint32_t codePoint = static_cast<uint32_t>(unit);
+        if (IsMatchingIgnorable(codePoint)) {
+            folded[unit] = ignoreSymbol_;
+        } else if (IsMatchingSpace(codePoint)) {
+            folded[unit] = spaceSymbol_;
+        } else if (codePoint < 0xD800 || codePoint > 0xDFFF) {
+            const uint32_t matching = FoldForMatching(codePoint);
+            folded[unit] = matching < kSymbolTableSize ? symbols_[matching] : 0;
+        }
+    }
+    symbols_.swap(folded);
+
+    // Build the trie with dense rows, then turn it into a DFA by filling every
+    // missing edge from the failure link in breadth-first order.
+    const size_t width = symbolCount_;
+    transitions_.assign(width, -1);
+    outputs_.assign(1, 0);
+    std::vector<uint16_t> incoming(1, 0);
+    for (const Phrase& phrase : phrases_) {
+        int32_t state = 0;
+        for (wchar_t ch : phrase.text) {
+            const size_t symbol = SymbolOf(ch);
+            int32_t next = transitions_[state * width + symbol];
+            if (next < 0) {
+                next = static_cast<int32_t>(outputs_.size());
+                transitions_[state * width + symbol] = next;
+                transitions_.resize(transitions_.size() + width, -1);
+                outputs_.push_back(0);
+                incoming.push_back(static_cast<uint16_t>(symbol));
+            }
+            state = next;
+        }
+        outputs_[state] |= phrase.categories;
+    }
+
+    std::vector<int32_t> failure(outputs_.size(), 0);
+    std::deque<int32_t> queue;
+    for (size_t symbol = 0; symbol < width; symbol++) {
+        int32_t& next = transitions_[symbol];
+        if (next < 0) {
+            next = 0;
+        } else {
+            queue.push_back(next);
+        }
+    }
+    while (!queue.empty()) {
+        const int32_t state = queue.front();
+        queue.pop_front();
+        outputs_[state] |= outputs_[failure[state]];
+        for (size_t symbol = 0; symbol < width; symbol++) {
+            int32_t& next = transitions_[state * width + symbol];
+            const int32_t fallback = transitions_[failure[state] * width + symbol];
+            if (next < 0) {
+                next = fallback;
+            } else {
+                failure[next] = fallback;
+                queue.push_back(next);
+            }
+        }
+    }
+
+    // A state entered on a space loops on further spaces, which collapses
+    // whitespace runs inside the automaton instead of branching per character.
+    if (spaceSymbol_ != 0) {
+        for (size_t state = 1; state < outputs_.size(); state++) {
+            if (incoming[state] == spaceSymbol_) {
+                transitions_[state * width + spaceSymbol_] = static_cast<int32_t>(state);
+            }
+        }
+    }
+    for (size_t state = 0; state < outputs_.size(); state++) {
+        transitions_[state * width + ignoreSymbol_] = static_cast<int32_t>(state);
+    }
+
+    // Renumber states so the accepting ones come last and store each edge as
+    // the target's row offset. Scanning then needs neither a multiply per
+    // character nor an output lookup unless the offset crosses the threshold.
+    const size_t stateCount = outputs_.size();
+    std::vector<int32_t> order(stateCount);
+    int32_t nextIndex = 0;
+    for (size_t state = 0; state < stateCount; state++) {
+        if (outputs_[state] == 0) order[state] = nextIndex++;
+    }
+    acceptingOffset_ = static_cast<int32_t>(nextIndex * width);
+    for (size_t state = 0; state < stateCount; state++) {
+        if (outputs_[state] != 0) order[state] = nextIndex++;
+    }
+
+    std::vector<int32_t> rows(transitions_.size());
+    std::vector<uint32_t> outputs(stateCount);
+    for (size_t state = 0; state < stateCount; state++) {
+        const size_t row = static_cast<size_t>(order[state]) * width;
+        for (size_t symbol = 0; symbol < width; symbol++) {
+            rows[row + symbol] = static_cast<int32_t>(order[transitions_[state * width + symbol]] * width);
+        }
+        outputs[order[state]] = outputs_[state];
+    }
+    transitions_.swap(rows);
+    outputs_.swap(outputs);
+}
+
+uint32_t KeywordDetector::Scan(const wchar_t* text, size_t length, uint32_t stopMask) const {
+    ScanState state;
+    return Feed(state, text, length, stopMask);
+}
+
+uint32_t KeywordDetector::Feed(ScanState& state, const wchar_t* text, size_t length, uint32_t stopMask) const {
+    if (!IsCompiled() || !text) return state.found;
+
+    const size_t width = symbolCount_;
+    const int32_t* transitions = transitions_.data();
+    const int32_t accepting = acceptingOffset_;
+    uint32_t found = state.found;
+    int32_t row = state.row;
+
+    for (size_t i = 0; i < length; i++) {
+        row = transitions[row + SymbolOf(text[i])];
+        if (row >= accepting) {
+            found |= outputs_[row / width];
+            if (stopMask && (found & stopMask) == stopMask) break;
+        }
+    }
+    state.row = row;
+    state.found = found;
+    return found;
+}
+
+KeywordStream::KeywordStream(const KeywordDetector& detector, uint32_t stopMask)
+    : detector_(detector), stopMask_(stopMask) {
+    std::fill(std::begin(categoryMatches_), std::end(categoryMatches_), kNoElement);
+}
+
+void KeywordStream::BeginElement() {
+    if (elements_ > 0) {
+        static const wchar_t kSeparator = L'\n';
+        detector_.Feed(state_, &kSeparator, 1);
+    }
+    elements_++;
+}
+
+bool KeywordStream::Feed(const wchar_t* text, size_t length) {
+    if (elements_ == 0) BeginElement();
+    if (IsComplete()) return false;
+
+    const uint32_t before = state_.found;
+    detector_.Feed(state_, text, length, stopMask_);
+    uint32_t added = state_.found & ~before;
+    if (added != 0 && firstMatch_ == kNoElement) {
+        firstMatch_ = elements_ - 1;
+    }
+    for (size_t bit = 0; added != 0; bit++, added >>= 1) {
+        if (added & 1) categoryMatches_[bit] = elements_ - 1;
+    }
+    return !IsComplete();
+}
+
+size_t KeywordStream::FirstMatchElement(KeywordCategory category) const {
+    for (size_t bit = 0; bit < 32; bit++) {
+        if (category == (1u << bit)) return categoryMatches_[bit];
+    }
+    return kNoElement;
+}
+
+bool KeywordDetector::ConfigureDefault(const std::string& phraseFile, std::string& error) {
+    auto detector = std::make_unique<KeywordDetector>();
+    if (!detector->LoadPhrases(phraseFile, error)) return false;
+    detector->Compile();
+    ConfiguredDefault() = std::move(detector);
+    return true;
+}
+
+const KeywordDetector& KeywordDetector::Default() {
+    if (ConfiguredDefault()) return *ConfiguredDefault();
+
+    static const KeywordDetector detector = [] {
+        KeywordDetector built;
+        static const wchar_t* const kTermsPhrases[] = {
+            L"terms and conditions",
+            L"terms of service",
+            L"terms of use",
+            L"user agreement",
+            L"end user license",
+            L"eula",
+            L"license agreement",
+            L"service agreement",
+            L"subscription agreement",
+            L"membership agreement",
+            L"terms & conditions",
+            L"t&c",
+            L"legal terms",
+            L"agreement to terms",
+        };
+        static const wchar_t* const kPrivacyPhrases[] = {
+            L"privacy policy",
+            L"privacy notice",
+            L"data protection",
+            L"data collection",
+            L"personal data",
+            L"personal information",
+            L"privacy statement",
+            L"privacy practices",
+            L"information we collect",
+            L"how we use your information",
+            L"cookie policy",
+            L"data sharing",
+        };
+        for (const wchar_t* phrase : kTermsPhrases) built.AddPhrase(phrase, kKeywordCategoryTerms);
+        for (const wchar_t* phrase : kPrivacyPhrases) built.AddPhrase(phrase, kKeywordCategoryPrivacy);
+        built.Compile();
+        return built;
+    }();
+    return detector;
+}
@@ -0,0 +1,122 @@
+#ifndef RUNNER_KEYWORD_DETECTOR_H_
+#define RUNNER_KEYWORD_DETECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bit flags identifying what kind of legal text a phrase indicates.
+enum KeywordCategory : uint32_t {
+    kKeywordCategoryTerms = 1u << 0,
+    kKeywordCategoryPrivacy = 1u << 1,
+};
+
+// Case- and accent-insensitive multi-phrase matcher compiled into a single
+// Aho-Corasick automaton, so scan cost does not grow with the number of
+// phrases or languages. Characters are compared by FoldForMatching(), and
+// combining marks and invisible format characters are skipped. Runs of
+// whitespace in the input match a single space in a phrase, which lets
+// phrases span line breaks in extracted text.
+class KeywordDetector {
+public:
+    static constexpr int kPhraseFileVersion = 1;
+
+    // Matcher position carried between Feed() calls, so text that arrives in
+    // pieces matches exactly as if it were one string, including phrases
+    // that straddle two pieces.
+    struct ScanState {
+        int32_t row = 0;
+        uint32_t found = 0;
+    };
+
+    void AddPhrase(const std::wstring& phrase, uint32_t categories);
+
+    // Adds the phrases of a UTF-8 phrase file, one phrase per line, grouped
+    // by language:
+    //
+    //   version 1
+    //   [de]
+    //   terms = Allgemeine Geschäftsbedingungen
+    //   privacy = Datenschutzerklärung
+    //
+    // On failure nothing is added and |error| names the offending line.
+    bool LoadPhrases(const std::string& text, std::string& error);
+
+    void Compile();
+    bool IsCompiled() const { return !transitions_.empty(); }
+
+    // Returns the union of categories of every phrase found in |text|.
+    // Stops early once |stopMask| categories have all been seen.
+    uint32_t Scan(const wchar_t* text, size_t length, uint32_t stopMask = 0) const;
+    uint32_t Scan(const std::wstring& text, uint32_t stopMask = 0) const {
+        return Scan(text.data(), text.size(), stopMask);
+    }
+
+    // Continues a scan from |state| and returns state.found.
+    uint32_t Feed(ScanState& state, const wchar_t* text, size_t length, uint32_t stopMask = 0) const;
+
+    size_t PhraseCount() const { return phrases_.size(); }
+    // Language tags of the loaded phrase file sections, in file order.
+    const std::vector<std::string>& Languages() const { return languages_; }
+
+    // Shared detector. Uses the phrases set by ConfigureDefault() or, when
+    // none were, the built-in English terms and privacy phrases.
+    static const KeywordDetector& Default();
+
+    // Compiles |phraseFile| as the shared detector. Must be called before the
+    // first Default() call, while the process is still single-threaded.
+    static bool ConfigureDefault(const std::string& phraseFile, std::string& error);
+
+private:
+    uint16_t SymbolOf(wchar_t ch) const;
+
+    struct Phrase {
+        std::wstring text;
+        uint32_t categories;
+    };
+
+    std::vector<Phrase> phrases_;
+    std::vector<std::string> languages_;
+    std::vector<uint16_t> symbols_;
+    size_t symbolCount_ = 0;
+    std::vector<int32_t> transitions_;
+    std::vector<uint32_t> outputs_;
+    int32_t acceptingOffset_ = 0;
+    uint16_t spaceSymbol_ = 0;
+    uint16_t ignoreSymbol_ = 0;
+};
+
+// Classifies text that arrives element by element during a tree walk, so the
+// walk can stop as soon as the answer is known. Elements are separated by a
+// line break, as in extracted window text.
+class KeywordStream {
+public:
+    static constexpr size_t kNoElement = static_cast<size_t>(-1);
+
+    // |stopMask| 0 never reports completion.
+    KeywordStream(const KeywordDetector& detector, uint32_t stopMask);
+
+    void BeginElement();
+    // Feeds part of the current element. Returns false once every category
+    // in the stop mask has matched.
+    bool Feed(const wchar_t* text, size_t length);
+
+    uint32_t Categories() const { return state_.found; }
+    bool IsComplete() const { return stopMask_ != 0 && (state_.found & stopMask_) == stopMask_; }
+    size_t ElementCount() const { return elements_; }
+    // Index of the element in which the first phrase of any category, or of
+    // |category|, completed.
+    size_t FirstMatchElement() const { return firstMatch_; }
+    size_t FirstMatchElement(KeywordCategory category) const;
+
+private:
+    const KeywordDetector& detector_;
+    uint32_t stopMask_;
+    KeywordDetector::ScanState state_;
+    size_t elements_ = 0;
+    size_t firstMatch_ = kNoElement;
+    size_t categoryMatches_[32];
+};
+
+#endif
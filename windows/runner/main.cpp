@@ -3,10 +3,15 @@
 #include <windows.h>
 
 #include "flutter_window.h"
+#include "keyword_detector.h"
+#include "startup_trace.h"
 #include "utils.h"
 
 int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
                       _In_ wchar_t *command_line, _In_ int show_command) {
+  // Starts the clock that the rest of the start-up marks are measured from.
+  StartupTrace::Instance().Mark("main");
+
   // Attach to console when present (e.g., 'flutter run') or create a
   // new console when running with a debugger.
   if (!::AttachConsole(ATTACH_PARENT_PROCESS) && ::IsDebuggerPresent()) {
@@ -17,6 +22,16 @@ int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
   // plugins.
   ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 
+  // Load the multilingual keyword phrases before any thread can use the
+  // shared detector. Without them detection falls back to English.
+  std::string phrases;
+  if (ReadFileContents(GetExecutableDirectory() + L"data\\legal_phrases.txt", phrases)) {
+    std::string error;
+    if (!KeywordDetector::ConfigureDefault(phrases, error)) {
+      ::OutputDebugStringA(("Warning: keyword phrases not loaded: " + error + "\n").c_str());
+    }
+  }
+
   flutter::DartProject project(L"data");
 
   std::vector<std::string> command_line_arguments =
@@ -0,0 +1,269 @@
+#include "memory_governor.h"
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+MemoryGovernor::MemoryGovernor(MemoryGovernorOptions options)
+    : options_(options), budgetBytes_(options.budgetBytes) {}
+
+MemoryGovernor::~MemoryGovernor() {}
+
+MemoryGovernor& MemoryGovernor::Instance() {
+    static MemoryGovernor governor;
+    return governor;
+}
+
+void MemoryGovernor::SetBudget(size_t budgetBytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budgetBytes_ = budgetBytes;
+        Rebalance();
+        UpdateLevel();
+    }
+    Publish();
+}
+
+void MemoryGovernor::SetPressureCallback(PressureCallback callback) {
+    // Waits out a callback in progress, so the old one is not called again
+    // once this returns.
+    std::lock_guard<std::mutex> publish(publishMutex_);
+    callback_ = std::move(callback);
+}
+
+MemoryPressure MemoryGovernor::Level() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return level_;
+}
+
+MemoryGovernorStats MemoryGovernor::Stats() const {
+    MemoryGovernorStats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.budgetBytes = budgetBytes_;
+    stats.bytes = bytes_;
+    stats.peakBytes = peakBytes_;
+    stats.pendingBytes = pendingBytes_;
+    stats.level = level_;
+    stats.evictions = evictions_;
+    stats.evictedBytes = evictedBytes_;
+    stats.pools.reserve(pools_.size());
+    for (const auto& pool : pools_) {
+        MemoryPoolStats item;
+        item.name = pool->name;
+        item.priority = pool->priority;
+        item.bytes = pool->bytes;
+        item.entries = pool->index.size() + pool->condemned.size();
+        item.evictions = pool->evictions;
+        item.evictedBytes = pool->evictedBytes;
+        stats.pools.push_back(std::move(item));
+    }
+    return stats;
+}
+
+MemoryGovernor::PoolState* MemoryGovernor::AddPool(const std::string& name, PoolPriority priority) {
+    auto pool = std::make_unique<PoolState>();
+    pool->name = name;
+    pool->priority = priority;
+    std::lock_guard<std::mutex> lock(mutex_);
+    pools_.push_back(std::move(pool));
+    return pools_.back().get();
+}
+
+void MemoryGovernor::RemovePool(PoolState* pool) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : pool->condemned) {
+            pendingBytes_ -= entry.second;
+        }
+        bytes_ -= pool->bytes;
+        pools_.erase(std::remove_if(pools_.begin(), pools_.end(),
+                                    [pool](const std::unique_ptr<PoolState>& state) { return state.get() == pool; }),
+                     pools_.end());
+        UpdateLevel();
+    }
+    Publish();
+}
+
+// An entry that is charged or touched again before its owner has taken the
+// eviction is evidently still in use, so it is kept.
+bool MemoryGovernor::Uncondemn(PoolState* pool, uint64_t key) {
+    auto it = pool->condemned.find(key);
+    if (it == pool->condemned.end()) return false;
+    pendingBytes_ -= it->second;
+    pool->entries.push_back(Entry{key, it->second, ++clock_});
+    pool->index[key] = std::prev(pool->entries.end());
+    pool->condemned.erase(it);
+    if (pool->condemned.empty()) pool->hasEvictions.store(false, std::memory_order_release);
+    return true;
+}
+
+void MemoryGovernor::Charge(PoolState* pool, uint64_t key, size_t bytes) {
+    if (bytes == 0) {
+        Release(pool, key);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Uncondemn(pool, key);
+        auto it = pool->index.find(key);
+        if (it == pool->index.end()) {
+            pool->entries.push_back(Entry{key, 0, 0});
+            it = pool->index.emplace(key, std::prev(pool->entries.end())).first;
+        }
+        Entry& entry = *it->second;
+        bytes_ = bytes_ - entry.bytes + bytes;
+        pool->bytes = pool->bytes - entry.bytes + bytes;
+        entry.bytes = bytes;
+        entry.lastUse = ++clock_;
+        pool->entries.splice(pool->entries.end(), pool->entries, it->second);
+        peakBytes_ = std::max(peakBytes_, bytes_);
+        Rebalance();
+        UpdateLevel();
+    }
+    Publish();
+}
+
+void MemoryGovernor::Touch(PoolState* pool, uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Uncondemn(pool, key)) return;
+    auto it = pool->index.find(key);
+    if (it == pool->index.end()) return;
+    it->second->lastUse = ++clock_;
+    pool->entries.splice(pool->entries.end(), pool->entries, it->second);
+}
+
+void MemoryGovernor::Release(PoolState* pool, uint64_t key) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t bytes = 0;
+        auto condemned = pool->condemned.find(key);
+        if (condemned != pool->condemned.end()) {
+            bytes = condemned->second;
+            pendingBytes_ -= bytes;
+            pool->condemned.erase(condemned);
+            if (pool->condemned.empty()) pool->hasEvictions.store(false, std::memory_order_release);
+        } else {
+            auto it = pool->index.find(key);
+            if (it == pool->index.end()) return;
+            bytes = it->second->bytes;
+            pool->entries.erase(it->second);
+            pool->index.erase(it);
+        }
+        bytes_ -= bytes;
+        pool->bytes -= bytes;
+        UpdateLevel();
+    }
+    Publish();
+}
+
+bool MemoryGovernor::TakeEvictions(PoolState* pool, std::vector<uint64_t>& keys) {
+    if (!pool->hasEvictions.load(std::memory_order_acquire)) return false;
+    bool taken = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : pool->condemned) {
+            keys.push_back(entry.first);
+            bytes_ -= entry.second;
+            pool->bytes -= entry.second;
+            pendingBytes_ -= entry.second;
+            ++pool->evictions;
+            pool->evictedBytes += entry.second;
+            ++evictions_;
+            evictedBytes_ += entry.second;
+            taken = true;
+        }
+        pool->condemned.clear();
+        pool->hasEvictions.store(false, std::memory_order_release);
+        UpdateLevel();
+    }
+    Publish();
+    return taken;
+}
+
+void MemoryGovernor::Rebalance() {
+    if (bytes_ - pendingBytes_ <= budgetBytes_) return;
+    const size_t target = budgetBytes_ / 100 * options_.lowWaterPercent;
+    for (PoolPriority priority : {PoolPriority::kLow, PoolPriority::kHigh}) {
+        while (bytes_ - pendingBytes_ > target && CondemnOldest(priority)) {
+        }
+    }
+}
+
+// Picks the least recently used entry among all pools of |priority|.
+bool MemoryGovernor::CondemnOldest(PoolPriority priority) {
+    PoolState* oldest = nullptr;
+    for (const auto& pool : pools_) {
+        if (pool->priority != priority || pool->entries.empty()) continue;
+        if (!oldest || pool->entries.front().lastUse < oldest->entries.front().lastUse) {
+            oldest = pool.get();
+        }
+    }
+    if (!oldest) return false;
+
+    const Entry& entry = oldest->entries.front();
+    oldest->condemned[entry.key] = entry.bytes;
+    pendingBytes_ += entry.bytes;
+    oldest->index.erase(entry.key);
+    oldest->entries.pop_front();
+    oldest->hasEvictions.store(true, std::memory_order_release);
+    return true;
+}
+
+MemoryPressure MemoryGovernor::LevelFor(size_t bytes) const {
+    if (bytes > budgetBytes_) return MemoryPressure::kCritical;
+    if (bytes >= budgetBytes_ / 100 * options_.moderatePercent) return MemoryPressure::kModerate;
+    return MemoryPressure::kNone;
+}
+
+void MemoryGovernor::UpdateLevel() {
+    MemoryPressure level = LevelFor(bytes_);
+    if (level < level_) {
+        const size_t margin = budgetBytes_ / 100 * options_.hysteresisPercent;
+        level = std::min(level_, LevelFor(bytes_ + margin));
+    }
+    if (level == level_) return;
+    level_ = level;
+    unpublished_.store(true, std::memory_order_release);
+}
+
+void MemoryGovernor::Publish() {
+    if (!unpublished_.load(std::memory_order_acquire)) return;
+
+    std::lock_guard<std::mutex> publish(publishMutex_);
+    MemoryPressure level;
+    size_t bytes;
+    size_t budgetBytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unpublished_.store(false, std::memory_order_relaxed);
+        level = level_;
+        bytes = bytes_;
+        budgetBytes = budgetBytes_;
+    }
+    if (level == publishedLevel_) return;
+    publishedLevel_ = level;
+    if (callback_) callback_(level, bytes, budgetBytes);
+}
+
+MemoryPool::MemoryPool(MemoryGovernor& governor, const std::string& name, PoolPriority priority)
+    : governor_(governor), state_(governor.AddPool(name, priority)) {}
+
+MemoryPool::~MemoryPool() {
+    governor_.RemovePool(state_);
+}
+
+void MemoryPool::Charge(uint64_t key, size_t bytes) {
+    governor_.Charge(state_, key, bytes);
+}
+
+void MemoryPool::Touch(uint64_t key) {
+    governor_.Touch(state_, key);
+}
+
+void MemoryPool::Release(uint64_t key) {
+    governor_.Release(state_, key);
+}
+
+bool MemoryPool::TakeEvictions(std::vector<uint64_t>& keys) {
+    return governor_.TakeEvictions(state_, keys);
+}
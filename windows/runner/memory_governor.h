@@ -0,0 +1,179 @@
+#ifndef RUNNER_MEMORY_GOVERNOR_H_
+#define RUNNER_MEMORY_GOVERNOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class MemoryPressure : uint8_t {
+    kNone,
+    // Near the budget; callers should hold back on new work.
+    kModerate,
+    // Over the budget even after asking for evictions.
+    kCritical,
+};
+
+enum class PoolPriority : uint8_t {
+    // Cheap to rebuild; evicted first.
+    kLow,
+    // Costly to rebuild; evicted once no low-priority bytes are left.
+    kHigh,
+    // Counted against the budget but never evicted.
+    kPinned,
+};
+
+struct MemoryGovernorOptions {
+    size_t budgetBytes = 256 * 1024 * 1024;
+    // Once over budget, evictions are requested until usage is back down to
+    // this share of it, so the next few charges do not evict again.
+    uint32_t lowWaterPercent = 85;
+    // Usage from this share of the budget is moderate pressure; over the
+    // budget it is critical.
+    uint32_t moderatePercent = 75;
+    // A level is only left once usage is this far below its threshold.
+    uint32_t hysteresisPercent = 5;
+};
+
+struct MemoryPoolStats {
+    std::string name;
+    PoolPriority priority = PoolPriority::kLow;
+    size_t bytes = 0;
+    size_t entries = 0;
+    uint64_t evictions = 0;
+    uint64_t evictedBytes = 0;
+};
+
+struct MemoryGovernorStats {
+    size_t budgetBytes = 0;
+    size_t bytes = 0;
+    size_t peakBytes = 0;
+    // Asked to be evicted but not yet taken by their pools' owners.
+    size_t pendingBytes = 0;
+    MemoryPressure level = MemoryPressure::kNone;
+    uint64_t evictions = 0;
+    uint64_t evictedBytes = 0;
+    std::vector<MemoryPoolStats> pools;
+};
+
+class MemoryPool;
+
+// Holds the bytes of every registered native cache and buffer pool against
+// one budget. When a charge takes usage over it, the governor picks entries
+// to evict, lowest priority and then least recently used first across all
+// pools, and hands them to each pool's owner the next time it calls
+// TakeEvictions(). Thread safe; each pool is used from its owner's thread.
+class MemoryGovernor {
+public:
+    // Runs on the thread whose call changed the level, without the
+    // governor's lock held. Calls are serialised, and the last one always
+    // reports the current level.
+    using PressureCallback = std::function<void(MemoryPressure level, size_t bytes, size_t budgetBytes)>;
+
+    explicit MemoryGovernor(MemoryGovernorOptions options = MemoryGovernorOptions());
+    ~MemoryGovernor();
+
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor& operator=(const MemoryGovernor&) = delete;
+
+    // Governor the runner's caches register with.
+    static MemoryGovernor& Instance();
+
+    void SetBudget(size_t budgetBytes);
+    void SetPressureCallback(PressureCallback callback);
+
+    MemoryPressure Level() const;
+    MemoryGovernorStats Stats() const;
+
+private:
+    friend class MemoryPool;
+
+    struct Entry {
+        uint64_t key = 0;
+        size_t bytes = 0;
+        uint64_t lastUse = 0;
+    };
+
+    struct PoolState {
+        std::string name;
+        PoolPriority priority = PoolPriority::kLow;
+        size_t bytes = 0;
+        // Least recently used first.
+        std::list<Entry> entries;
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        // Entries chosen for eviction, with their bytes, until taken.
+        std::unordered_map<uint64_t, size_t> condemned;
+        std::atomic<bool> hasEvictions{false};
+        uint64_t evictions = 0;
+        uint64_t evictedBytes = 0;
+    };
+
+    PoolState* AddPool(const std::string& name, PoolPriority priority);
+    void RemovePool(PoolState* pool);
+    void Charge(PoolState* pool, uint64_t key, size_t bytes);
+    void Touch(PoolState* pool, uint64_t key);
+    void Release(PoolState* pool, uint64_t key);
+    bool TakeEvictions(PoolState* pool, std::vector<uint64_t>& keys);
+
+    // The rest run with mutex_ held, except Publish().
+    bool Uncondemn(PoolState* pool, uint64_t key);
+    void Rebalance();
+    bool CondemnOldest(PoolPriority priority);
+    MemoryPressure LevelFor(size_t bytes) const;
+    void UpdateLevel();
+    void Publish();
+
+    const MemoryGovernorOptions options_;
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<PoolState>> pools_;
+    size_t budgetBytes_;
+    size_t bytes_ = 0;
+    size_t peakBytes_ = 0;
+    size_t pendingBytes_ = 0;
+    uint64_t clock_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t evictedBytes_ = 0;
+    MemoryPressure level_ = MemoryPressure::kNone;
+
+    // Serialises Publish() and guards the callback.
+    std::mutex publishMutex_;
+    PressureCallback callback_;
+    MemoryPressure publishedLevel_ = MemoryPressure::kNone;
+    std::atomic<bool> unpublished_{false};
+};
+
+// One cache's account with a governor. Entries are keyed by the owner and
+// charged with an estimate of the bytes they hold; the owner frees what
+// TakeEvictions() returns at a point where that is safe. The pool's entries
+// are released when it is destroyed.
+class MemoryPool {
+public:
+    MemoryPool(MemoryGovernor& governor, const std::string& name, PoolPriority priority);
+    ~MemoryPool();
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    // Sets the size of |key|'s entry, adding it if need be, and marks it
+    // used. Charging 0 bytes releases it.
+    void Charge(uint64_t key, size_t bytes);
+    void Touch(uint64_t key);
+    void Release(uint64_t key);
+
+    // Appends the keys the governor wants freed and stops counting them;
+    // the owner must drop those entries. Returns false, without locking,
+    // when there are none.
+    bool TakeEvictions(std::vector<uint64_t>& keys);
+
+private:
+    MemoryGovernor& governor_;
+    MemoryGovernor::PoolState* const state_;
+};
+
+#endif
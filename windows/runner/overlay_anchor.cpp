@@ -0,0 +1,346 @@
+#include "overlay_anchor.h"
+
+#include <dwmapi.h>
+#include <flutter_windows.h>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Matches one frame at 60 Hz; the overlay's own geometry coalescer already
+// limits window moves to the display's refresh rate.
+constexpr DWORD kUpdateIntervalMs = 16;
+// Bounds on each cross-process call the worker makes, as for extraction.
+constexpr DWORD kConnectionTimeoutMillis = 1500;
+constexpr DWORD kTransactionTimeoutMillis = 4000;
+
+bool SameRect(const LayoutRect& a, const LayoutRect& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+LayoutRect FromRect(const RECT& rect) {
+    return LayoutRect{rect.left, rect.top, rect.right, rect.bottom};
+}
+
+BOOL CALLBACK CollectMonitor(HMONITOR monitor, HDC dc, LPRECT rect, LPARAM data) {
+    MONITORINFO info = {};
+    info.cbSize = sizeof(info);
+    if (!GetMonitorInfo(monitor, &info)) return TRUE;
+
+    LayoutMonitor layout;
+    layout.bounds = FromRect(info.rcMonitor);
+    layout.workArea = FromRect(info.rcWork);
+    layout.dpi = static_cast<int>(FlutterDesktopGetDpiForMonitor(monitor));
+    reinterpret_cast<std::vector<LayoutMonitor>*>(data)->push_back(layout);
+    return TRUE;
+}
+
+}  // namespace
+
+OverlayAnchor* OverlayAnchor::active_ = nullptr;
+
+OverlayAnchor::OverlayAnchor(PlacementCallback callback, Dispatcher dispatch)
+    : callback_(std::move(callback)), dispatch_(std::move(dispatch)) {}
+
+OverlayAnchor::~OverlayAnchor() {
+    Detach();
+    worker_.Stop();
+}
+
+void OverlayAnchor::EnsureWorker() {
+    if (worker_.IsStarted()) return;
+    worker_.Start([this] { return InitializeAutomation(); }, [this] { ShutdownAutomation(); });
+}
+
+bool OverlayAnchor::InitializeAutomation() {
+    comInitialized_ = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+    HRESULT hr = CoCreateInstance(__uuidof(CUIAutomation), nullptr, CLSCTX_INPROC_SERVER,
+                                  __uuidof(IUIAutomation), reinterpret_cast<void**>(&automation_));
+    if (FAILED(hr) || !automation_) return false;
+
+    // IUIAutomation2 needs Windows 8; earlier systems keep the defaults.
+    IUIAutomation2* automation2 = nullptr;
+    if (SUCCEEDED(automation_->QueryInterface(__uuidof(IUIAutomation2), reinterpret_cast<void**>(&automation2))) &&
+        automation2) {
+        automation2->put_ConnectionTimeout(kConnectionTimeoutMillis);
+        automation2->put_TransactionTimeout(kTransactionTimeoutMillis);
+        automation2->Release();
+    }
+    return true;
+}
+
+void OverlayAnchor::ShutdownAutomation() {
+    ReleaseTarget();
+    if (automation_) {
+        automation_->Release();
+        automation_ = nullptr;
+    }
+    if (comInitialized_) {
+        CoUninitialize();
+        comInitialized_ = false;
+    }
+}
+
+void OverlayAnchor::SetOptions(const AnchorLayoutOptions& options) {
+    options_ = options;
+    if (IsAttached() && !lastAnchor_.IsEmpty()) Place(lastAnchor_, true);
+}
+
+void OverlayAnchor::RefreshMonitors() {
+    monitors_.clear();
+    EnumDisplayMonitors(nullptr, nullptr, CollectMonitor, reinterpret_cast<LPARAM>(&monitors_));
+}
+
+void OverlayAnchor::OnDisplayChanged() {
+    RefreshMonitors();
+    if (IsAttached() && !lastAnchor_.IsEmpty()) Place(lastAnchor_, true);
+}
+
+bool OverlayAnchor::Attach(Target target, HWND window) {
+    Detach();
+
+    // The target is found on the worker; here only the window it lies in
+    // is checked, which needs no call into another process.
+    HWND owner = target == Target::kWindow ? window : GetForegroundWindow();
+    DWORD processId = 0;
+    if (!owner || !IsWindow(owner) || !GetWindowThreadProcessId(owner, &processId) || processId == 0 ||
+        processId == GetCurrentProcessId()) {
+        return false;
+    }
+
+    EnsureWorker();
+    attached_ = true;
+    active_ = this;
+    RefreshMonitors();
+    side_ = AnchorSide::kRight;
+    lastAnchor_ = LayoutRect();
+    PostRead([this, target, window] { return ResolveTarget(target, window); });
+    return true;
+}
+
+void OverlayAnchor::Detach() {
+    if (locationHook_) {
+        UnhookWinEvent(locationHook_);
+        locationHook_ = nullptr;
+    }
+    if (scrollHook_) {
+        UnhookWinEvent(scrollHook_);
+        scrollHook_ = nullptr;
+    }
+    if (timer_) {
+        KillTimer(nullptr, timer_);
+        timer_ = 0;
+    }
+    if (active_ == this) {
+        active_ = nullptr;
+    }
+    if (!attached_) return;
+    attached_ = false;
+    ++generation_;
+    readInFlight_ = false;
+    readAgain_ = false;
+    worker_.Post([this](bool) { ReleaseTarget(); });
+}
+
+void OverlayAnchor::Hook(DWORD processId) {
+    const DWORD flags = WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS;
+    locationHook_ = SetWinEventHook(EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, nullptr,
+                                    OverlayAnchor::WinEventProc, processId, 0, flags);
+    scrollHook_ = SetWinEventHook(EVENT_SYSTEM_SCROLLINGSTART, EVENT_SYSTEM_SCROLLINGEND, nullptr,
+                                  OverlayAnchor::WinEventProc, processId, 0, flags);
+}
+
+bool OverlayAnchor::PlaceNextToWindow(HWND window, AnchorPlacement& placement) {
+    if (monitors_.empty()) RefreshMonitors();
+
+    LayoutRect anchor;
+    RECT rect = {};
+    if (window && !IsIconic(window) &&
+        (SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS, &rect, sizeof(rect))) ||
+         GetWindowRect(window, &rect))) {
+        anchor = FromRect(rect);
+    }
+    if (anchor.IsEmpty()) {
+        POINT origin = {0, 0};
+        MONITORINFO info = {};
+        info.cbSize = sizeof(info);
+        if (!GetMonitorInfo(MonitorFromPoint(origin, MONITOR_DEFAULTTOPRIMARY), &info)) return false;
+        anchor = FromRect(info.rcWork);
+    }
+    return ComputeAnchoredPlacement(anchor, monitors_, options_, AnchorSide::kRight, placement);
+}
+
+void CALLBACK OverlayAnchor::WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                                          LONG idChild, DWORD eventThread, DWORD eventTime) {
+    if (idObject == OBJID_CURSOR || !active_) return;
+    // Coalesce bursts of location and scroll events into one read per frame.
+    active_->ScheduleUpdate();
+}
+
+void CALLBACK OverlayAnchor::TimerProc(HWND hwnd, UINT message, UINT_PTR id, DWORD time) {
+    KillTimer(nullptr, id);
+    if (!active_ || active_->timer_ != id) return;
+    active_->timer_ = 0;
+    active_->Update();
+}
+
+void OverlayAnchor::ScheduleUpdate() {
+    if (timer_) return;
+    const DWORD elapsed = GetTickCount() - lastUpdateTick_;
+    const DWORD delay = elapsed >= kUpdateIntervalMs ? 0 : kUpdateIntervalMs - elapsed;
+    timer_ = SetTimer(nullptr, 0, std::max<DWORD>(delay, USER_TIMER_MINIMUM), OverlayAnchor::TimerProc);
+}
+
+void OverlayAnchor::Update() {
+    if (!attached_) return;
+    if (readInFlight_) {
+        readAgain_ = true;
+        return;
+    }
+    PostRead(nullptr);
+}
+
+// Reads the anchor's rectangle on the worker, after running |resolve|
+// there if given, and hands the result back through dispatch_.
+void OverlayAnchor::PostRead(std::function<bool()> resolve) {
+    lastUpdateTick_ = GetTickCount();
+    readInFlight_ = true;
+    const uint64_t generation = generation_;
+    worker_.Post([this, generation, resolve](bool ready) {
+        AnchorRead read;
+        read.generation = generation;
+        if (ready && (!resolve || resolve())) {
+            read.status = ReadAnchorRect(read.rect);
+        }
+        read.processId = elementProcessId_;
+        dispatch_([this, read] { OnRead(read); });
+    });
+}
+
+void OverlayAnchor::OnRead(const AnchorRead& read) {
+    if (read.generation != generation_) return;
+    readInFlight_ = false;
+    if (read.status == ReadStatus::kGone) {
+        Detach();
+        return;
+    }
+    if (!locationHook_ && !scrollHook_) Hook(read.processId);
+    if (read.status == ReadStatus::kOk) Place(read.rect, false);
+    if (readAgain_) {
+        readAgain_ = false;
+        ScheduleUpdate();
+    }
+}
+
+void OverlayAnchor::Place(const LayoutRect& anchor, bool force) {
+    if (!force && SameRect(anchor, lastAnchor_)) return;
+    lastAnchor_ = anchor;
+
+    if (monitors_.empty()) RefreshMonitors();
+    AnchorPlacement placement;
+    if (!ComputeAnchoredPlacement(anchor, monitors_, options_, side_, placement)) return;
+    side_ = placement.side;
+    if (callback_) {
+        callback_(placement);
+    }
+}
+
+bool OverlayAnchor::ResolveTarget(Target target, HWND window) {
+    ReleaseTarget();
+    if (!automation_) return false;
+
+    IUIAutomationElement* element = nullptr;
+    HRESULT hr = E_FAIL;
+    if (target == Target::kWindow) {
+        if (window) hr = automation_->ElementFromHandle(window, &element);
+    } else {
+        hr = automation_->GetFocusedElement(&element);
+    }
+    if (FAILED(hr) || !element) return false;
+
+    int processId = 0;
+    element->get_CurrentProcessId(&processId);
+    if (processId == 0 || static_cast<DWORD>(processId) == GetCurrentProcessId()) {
+        element->Release();
+        return false;
+    }
+
+    if (target == Target::kSelection) {
+        IUIAutomationTextPattern* textPattern = nullptr;
+        hr = element->GetCurrentPatternAs(UIA_TextPatternId, __uuidof(IUIAutomationTextPattern),
+                                          reinterpret_cast<void**>(&textPattern));
+        IUIAutomationTextRangeArray* selection = nullptr;
+        if (SUCCEEDED(hr) && textPattern) {
+            textPattern->GetSelection(&selection);
+            textPattern->Release();
+        }
+        int length = 0;
+        if (selection && SUCCEEDED(selection->get_Length(&length)) && length > 0) {
+            selection->GetElement(0, &range_);
+        }
+        if (selection) selection->Release();
+        // Without a selection the focused element itself is the anchor.
+    }
+
+    element_ = element;
+    elementProcessId_ = static_cast<DWORD>(processId);
+    return true;
+}
+
+void OverlayAnchor::ReleaseTarget() {
+    if (range_) {
+        range_->Release();
+        range_ = nullptr;
+    }
+    if (element_) {
+        element_->Release();
+        element_ = nullptr;
+    }
+    elementProcessId_ = 0;
+}
+
+OverlayAnchor::ReadStatus OverlayAnchor::ReadAnchorRect(LayoutRect& rect) {
+    if (!element_) return ReadStatus::kGone;
+
+    if (range_) {
+        SAFEARRAY* rectangles = nullptr;
+        if (FAILED(range_->GetBoundingRectangles(&rectangles)) || !rectangles) return ReadStatus::kUnreadable;
+
+        // Four doubles per line of the range: left, top, width, height.
+        bool found = false;
+        double* values = nullptr;
+        LONG lower = 0, upper = -1;
+        SafeArrayGetLBound(rectangles, 1, &lower);
+        SafeArrayGetUBound(rectangles, 1, &upper);
+        if (SUCCEEDED(SafeArrayAccessData(rectangles, reinterpret_cast<void**>(&values)))) {
+            const LONG count = upper - lower + 1;
+            for (LONG i = 0; i + 3 < count; i += 4) {
+                if (values[i + 2] <= 0 || values[i + 3] <= 0) continue;
+                const LayoutRect line{static_cast<int>(values[i]), static_cast<int>(values[i + 1]),
+                                      static_cast<int>(values[i] + values[i + 2]),
+                                      static_cast<int>(values[i + 1] + values[i + 3])};
+                if (!found) {
+                    rect = line;
+                    found = true;
+                } else {
+                    rect.left = std::min(rect.left, line.left);
+                    rect.top = std::min(rect.top, line.top);
+                    rect.right = std::max(rect.right, line.right);
+                    rect.bottom = std::max(rect.bottom, line.bottom);
+                }
+            }
+            SafeArrayUnaccessData(rectangles);
+        }
+        SafeArrayDestroy(rectangles);
+        // An empty result means the range is scrolled out of view; the
+        // overlay stays where it is until it comes back.
+        return found ? ReadStatus::kOk : ReadStatus::kUnreadable;
+    }
+
+    RECT bounds = {};
+    HRESULT hr = element_->get_CurrentBoundingRectangle(&bounds);
+    if (hr == static_cast<HRESULT>(UIA_E_ELEMENTNOTAVAILABLE)) return ReadStatus::kGone;
+    if (FAILED(hr)) return ReadStatus::kUnreadable;
+    rect = FromRect(bounds);
+    return rect.IsEmpty() ? ReadStatus::kUnreadable : ReadStatus::kOk;
+}
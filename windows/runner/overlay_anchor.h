@@ -0,0 +1,129 @@
+#ifndef RUNNER_OVERLAY_ANCHOR_H_
+#define RUNNER_OVERLAY_ANCHOR_H_
+
+#include <windows.h>
+#include <objbase.h>
+#include <UIAutomation.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "deferred_worker.h"
+#include "overlay_layout.h"
+
+// Keeps the overlay next to a UIA element or text range in another
+// application. Out-of-context WinEvent hooks on the target's process report
+// location and scroll changes; the anchor's bounding rectangle is re-read at
+// most once per frame and the new placement handed to |callback|. Must be
+// used from a thread with a message loop, which is where the hooks and the
+// throttling timer are delivered.
+//
+// The UIA calls that resolve the target and read its rectangle go to the
+// target's provider, so they run on the anchor's own MTA thread, under the
+// UI Automation connection and transaction timeouts, one read at a time.
+// Only the rectangle comes back, through |dispatch|, so a slow or hung
+// application never stalls the thread the anchor is used from.
+class OverlayAnchor {
+public:
+    enum class Target {
+        kWindow,
+        kFocusedElement,
+        kSelection,
+    };
+
+    using PlacementCallback = std::function<void(const AnchorPlacement& placement)>;
+    // Runs |task| later on the thread the anchor is used from; called from
+    // the anchor's worker thread.
+    using Dispatcher = std::function<void(std::function<void()> task)>;
+
+    OverlayAnchor(PlacementCallback callback, Dispatcher dispatch);
+    ~OverlayAnchor();
+
+    OverlayAnchor(const OverlayAnchor&) = delete;
+    OverlayAnchor& operator=(const OverlayAnchor&) = delete;
+
+    // Attaches to |target|; |window| is only used for Target::kWindow.
+    // Returns false if the window the target lies in is missing or ours.
+    // The target itself is resolved on the worker; if it turns out to be
+    // gone, the anchor detaches again.
+    bool Attach(Target target, HWND window);
+    void Detach();
+    bool IsAttached() const { return attached_; }
+
+    void SetOptions(const AnchorLayoutOptions& options);
+    const AnchorLayoutOptions& Options() const { return options_; }
+
+    // One-off placement next to |window|, or on the primary monitor when
+    // |window| is null or minimized. Does not attach.
+    bool PlaceNextToWindow(HWND window, AnchorPlacement& placement);
+
+    // Call on display, DPI and work-area changes.
+    void OnDisplayChanged();
+
+private:
+    static void CALLBACK WinEventProc(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                                      LONG idChild, DWORD eventThread, DWORD eventTime);
+    static void CALLBACK TimerProc(HWND hwnd, UINT message, UINT_PTR id, DWORD time);
+
+    enum class ReadStatus {
+        kOk,
+        // Out of view or not answering; the overlay stays where it is.
+        kUnreadable,
+        // The target is gone, or was never found.
+        kGone,
+    };
+
+    struct AnchorRead {
+        uint64_t generation = 0;
+        ReadStatus status = ReadStatus::kGone;
+        DWORD processId = 0;
+        LayoutRect rect;
+    };
+
+    // Thread the anchor is used from.
+    void EnsureWorker();
+    void RefreshMonitors();
+    void ScheduleUpdate();
+    void Update();
+    void PostRead(std::function<bool()> resolve);
+    void OnRead(const AnchorRead& read);
+    void Place(const LayoutRect& anchor, bool force);
+    void Hook(DWORD processId);
+
+    // Worker thread.
+    bool InitializeAutomation();
+    void ShutdownAutomation();
+    bool ResolveTarget(Target target, HWND window);
+    void ReleaseTarget();
+    ReadStatus ReadAnchorRect(LayoutRect& rect);
+
+    static OverlayAnchor* active_;
+
+    PlacementCallback callback_;
+    Dispatcher dispatch_;
+    AnchorLayoutOptions options_;
+    std::vector<LayoutMonitor> monitors_;
+    AnchorSide side_ = AnchorSide::kRight;
+    LayoutRect lastAnchor_;
+
+    bool attached_ = false;
+    // Bumped by every Attach() and Detach(), so reads for an earlier target
+    // are dropped when they come back.
+    uint64_t generation_ = 0;
+    bool readInFlight_ = false;
+    // Another read was asked for while one was in flight.
+    bool readAgain_ = false;
+    HWINEVENTHOOK locationHook_ = nullptr;
+    HWINEVENTHOOK scrollHook_ = nullptr;
+    UINT_PTR timer_ = 0;
+    DWORD lastUpdateTick_ = 0;
+
+    // Owned by the worker thread.
+    DeferredWorker worker_;
+    bool comInitialized_ = false;
+    IUIAutomation* automation_ = nullptr;
+    IUIAutomationElement* element_ = nullptr;
+    IUIAutomationTextRange* range_ = nullptr;
+    DWORD elementProcessId_ = 0;
+};
+
+#endif
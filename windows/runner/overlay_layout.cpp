@@ -0,0 +1,154 @@
+#include "overlay_layout.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+int64_t OverlapArea(const LayoutRect& a, const LayoutRect& b) {
+    const int64_t width = std::min(a.right, b.right) - std::max(a.left, b.left);
+    const int64_t height = std::min(a.bottom, b.bottom) - std::max(a.top, b.top);
+    return width > 0 && height > 0 ? width * height : 0;
+}
+
+int64_t DistanceSquared(const LayoutRect& rect, int x, int y) {
+    const int64_t dx = x < rect.left ? rect.left - x : (x >= rect.right ? x - rect.right + 1 : 0);
+    const int64_t dy = y < rect.top ? rect.top - y : (y >= rect.bottom ? y - rect.bottom + 1 : 0);
+    return dx * dx + dy * dy;
+}
+
+int Scale(int dips, int dpi) {
+    return static_cast<int>((static_cast<int64_t>(dips) * dpi + 48) / 96);
+}
+
+int Clamp(int value, int low, int high) {
+    return high < low ? low : std::min(std::max(value, low), high);
+}
+
+struct Candidate {
+    int x;
+    int y;
+    bool fits;
+    // Free space on that side relative to the overlay's extent along it.
+    double room;
+};
+
+Candidate PlaceOnSide(AnchorSide side, const LayoutRect& anchor, const LayoutRect& area,
+                      int width, int height, int gap) {
+    Candidate candidate{};
+    switch (side) {
+        case AnchorSide::kRight:
+            candidate.x = anchor.right + gap;
+            candidate.y = Clamp(anchor.top, area.top, area.bottom - height);
+            candidate.room = static_cast<double>(area.right - candidate.x) / width;
+            break;
+        case AnchorSide::kLeft:
+            candidate.x = anchor.left - gap - width;
+            candidate.y = Clamp(anchor.top, area.top, area.bottom - height);
+            candidate.room = static_cast<double>(anchor.left - gap - area.left) / width;
+            break;
+        case AnchorSide::kBelow:
+            candidate.x = Clamp(anchor.left, area.left, area.right - width);
+            candidate.y = anchor.bottom + gap;
+            candidate.room = static_cast<double>(area.bottom - candidate.y) / height;
+            break;
+        case AnchorSide::kAbove:
+            candidate.x = Clamp(anchor.left, area.left, area.right - width);
+            candidate.y = anchor.top - gap - height;
+            candidate.room = static_cast<double>(anchor.top - gap - area.top) / height;
+            break;
+    }
+    candidate.fits = candidate.x >= area.left && candidate.x + width <= area.right &&
+                     candidate.y >= area.top && candidate.y + height <= area.bottom;
+    return candidate;
+}
+
+}  // namespace
+
+size_t MonitorForRect(const LayoutRect& rect, const std::vector<LayoutMonitor>& monitors) {
+    size_t best = monitors.size();
+    int64_t bestArea = 0;
+    for (size_t i = 0; i < monitors.size(); i++) {
+        const int64_t area = OverlapArea(rect, monitors[i].bounds);
+        if (area > bestArea) {
+            bestArea = area;
+            best = i;
+        }
+    }
+    if (best < monitors.size()) return best;
+
+    const int centerX = rect.left + rect.Width() / 2;
+    const int centerY = rect.top + rect.Height() / 2;
+    int64_t bestDistance = INT64_MAX;
+    for (size_t i = 0; i < monitors.size(); i++) {
+        const int64_t distance = DistanceSquared(monitors[i].bounds, centerX, centerY);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool ComputeAnchoredPlacement(const LayoutRect& anchor,
+                              const std::vector<LayoutMonitor>& monitors,
+                              const AnchorLayoutOptions& options,
+                              AnchorSide preferredSide,
+                              AnchorPlacement& placement) {
+    const size_t index = MonitorForRect(anchor, monitors);
+    if (index >= monitors.size()) return false;
+
+    const LayoutMonitor& monitor = monitors[index];
+    LayoutRect work = monitor.workArea.IsEmpty() ? monitor.bounds : monitor.workArea;
+    if (work.IsEmpty()) return false;
+
+    const int dpi = monitor.dpi > 0 ? monitor.dpi : 96;
+    int margin = Scale(options.margin, dpi);
+    if (work.Width() <= 2 * margin || work.Height() <= 2 * margin) margin = 0;
+    const LayoutRect area{work.left + margin, work.top + margin, work.right - margin, work.bottom - margin};
+
+    const int width = std::max(1, std::min(Scale(options.width, dpi), area.Width()));
+    const int height = std::max(1, std::min(Scale(options.height, dpi), area.Height()));
+    const int gap = Scale(options.gap, dpi);
+
+    // Only the visible part of the anchor matters; a document taller than
+    // the screen should not push the overlay off it.
+    LayoutRect visible{std::max(anchor.left, work.left), std::max(anchor.top, work.top),
+                       std::min(anchor.right, work.right), std::min(anchor.bottom, work.bottom)};
+    if (visible.IsEmpty()) visible = anchor;
+
+    const AnchorSide order[] = {preferredSide, AnchorSide::kRight, AnchorSide::kLeft,
+                                AnchorSide::kBelow, AnchorSide::kAbove};
+    bool found = false;
+    Candidate chosen{};
+    AnchorSide chosenSide = preferredSide;
+    double bestRoom = 0;
+    bool haveBest = false;
+    for (AnchorSide side : order) {
+        const Candidate candidate = PlaceOnSide(side, visible, area, width, height, gap);
+        if (candidate.fits) {
+            chosen = candidate;
+            chosenSide = side;
+            found = true;
+            break;
+        }
+        if (!haveBest || candidate.room > bestRoom) {
+            haveBest = true;
+            bestRoom = candidate.room;
+            chosen = candidate;
+            chosenSide = side;
+        }
+    }
+
+    if (!found) {
+        chosen.x = Clamp(chosen.x, area.left, area.right - width);
+        chosen.y = Clamp(chosen.y, area.top, area.bottom - height);
+    }
+
+    placement.rect = LayoutRect{chosen.x, chosen.y, chosen.x + width, chosen.y + height};
+    placement.monitor = index;
+    placement.dpi = dpi;
+    placement.side = chosenSide;
+    placement.clamped = !found;
+    return true;
+}
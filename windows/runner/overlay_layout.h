@@ -0,0 +1,65 @@
+#ifndef RUNNER_OVERLAY_LAYOUT_H_
+#define RUNNER_OVERLAY_LAYOUT_H_
+
+#include <cstddef>
+#include <vector>
+
+// Rectangle in physical screen pixels, right/bottom exclusive.
+struct LayoutRect {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    int Width() const { return right - left; }
+    int Height() const { return bottom - top; }
+    bool IsEmpty() const { return right <= left || bottom <= top; }
+};
+
+struct LayoutMonitor {
+    LayoutRect bounds;
+    LayoutRect workArea;
+    int dpi = 96;
+};
+
+enum class AnchorSide {
+    kRight,
+    kLeft,
+    kBelow,
+    kAbove,
+};
+
+// Overlay size and spacing in device-independent pixels; they are scaled by
+// the DPI of the monitor the overlay ends up on.
+struct AnchorLayoutOptions {
+    int width = 400;
+    int height = 500;
+    int gap = 8;
+    int margin = 8;
+};
+
+struct AnchorPlacement {
+    LayoutRect rect;
+    size_t monitor = 0;
+    int dpi = 96;
+    AnchorSide side = AnchorSide::kRight;
+    // True when no side had room and the overlay was pushed into the work
+    // area, possibly covering part of the anchor.
+    bool clamped = false;
+};
+
+// Index of the monitor sharing the most area with |rect|, or the nearest one
+// if |rect| is on none. Returns monitors.size() for an empty list.
+size_t MonitorForRect(const LayoutRect& rect, const std::vector<LayoutMonitor>& monitors);
+
+// Places the overlay next to |anchor| on the anchor's monitor: to the right,
+// left, below or above, trying |preferredSide| first so a moving anchor
+// does not make the overlay jump sides. When no side fits, the side with the
+// most room is used and the overlay is clamped into the work area.
+bool ComputeAnchoredPlacement(const LayoutRect& anchor,
+                              const std::vector<LayoutMonitor>& monitors,
+                              const AnchorLayoutOptions& options,
+                              AnchorSide preferredSide,
+                              AnchorPlacement& placement);
+
+#endif
@@ -1,12 +1,18 @@
 #include "overlay_plugin.h"
 #include <flutter/standard_method_codec.h>
 #include <windows.h>
+#include <optional>
 #include <string>
 #include <sstream>
 
 static const char* kMethodChannelName = "legalease_desktop_overlay";
 static const char* kEventChannelName = "legalease_desktop_overlay_events";
 
+// Event kinds on the event bus. Only the newest undelivered selection and
+// clipboard capture matter, so each supersedes the one before it.
+static const uint32_t kSelectionEvent = 1;
+static const uint32_t kClipboardEvent = 2;
+
 static std::string WstringToString(const std::wstring& wstr) {
     if (wstr.empty()) return std::string();
     int sizeNeeded = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), static_cast<int>(wstr.length()), nullptr, 0, nullptr, nullptr);
@@ -23,7 +29,25 @@ static std::wstring StringToWstring(const std::string& str) {
     return result;
 }
 
-void OverlayPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
+static bool FindDouble(const flutter::EncodableMap& map, const char* key, double& value) {
+    auto it = map.find(flutter::EncodableValue(key));
+    if (it == map.end()) return false;
+    const auto* number = std::get_if<double>(&it->second);
+    if (!number) return false;
+    value = *number;
+    return true;
+}
+
+static bool FindBool(const flutter::EncodableMap& map, const char* key, bool& value) {
+    auto it = map.find(flutter::EncodableValue(key));
+    if (it == map.end()) return false;
+    const auto* flag = std::get_if<bool>(&it->second);
+    if (!flag) return false;
+    value = *flag;
+    return true;
+}
+
+void OverlayPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar, EventBus& event_bus) {
     auto methodChannel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
         registrar->messenger(),
         kMethodChannelName,
@@ -36,12 +60,18 @@ void OverlayPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* regis
         &flutter::StandardMethodCodec::GetInstance()
     );
 
-    auto plugin = std::make_unique<OverlayPlugin>(registrar);
-
-    auto selectionHandler = std::make_unique<OverlayStreamHandler>(plugin.get(), true);
-    auto clipboardHandler = std::make_unique<OverlayStreamHandler>(plugin.get(), false);
+    auto plugin = std::make_unique<OverlayPlugin>(registrar, event_bus);
+    plugin->window_proc_delegate_id_ = registrar->RegisterTopLevelWindowProcDelegate(
+        [plugin_ptr = plugin.get()](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) -> std::optional<LRESULT> {
+            if (message == WM_DISPLAYCHANGE || message == WM_DPICHANGED ||
+                (message == WM_SETTINGCHANGE && wparam == SPI_SETWORKAREA)) {
+                plugin_ptr->anchor_->OnDisplayChanged();
+            }
+            return std::nullopt;
+        }
+    );
 
-    eventChannel->SetStreamHandler(std::move(selectionHandler));
+    eventChannel->SetStreamHandler(std::make_unique<OverlayStreamHandler>(plugin.get()));
 
     methodChannel->SetMethodCallHandler(
         [plugin_ptr = plugin.get()](const auto& call, auto result) {
@@ -52,10 +82,100 @@ void OverlayPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* regis
     registrar->AddPlugin(std::move(plugin));
 }
 
-OverlayPlugin::OverlayPlugin(flutter::PluginRegistrarWindows* registrar)
-    : registrar_(registrar), overlay_(std::make_unique<DesktopOverlay>()) {}
+OverlayPlugin::OverlayPlugin(flutter::PluginRegistrarWindows* registrar, EventBus& event_bus)
+    : registrar_(registrar), event_bus_(event_bus), overlay_(std::make_unique<DesktopOverlay>()) {
+    anchor_ = std::make_unique<OverlayAnchor>(
+        [this](const AnchorPlacement& placement) { ApplyPlacement(placement); },
+        [this](std::function<void()> task) { event_bus_.Post(this, std::move(task), EventBus::Priority::kUrgent); });
+}
 
-OverlayPlugin::~OverlayPlugin() {}
+OverlayPlugin::~OverlayPlugin() {
+    StopSelectionTracking();
+    StopClipboardWatching();
+    // Stops the anchor's worker, the last of its producers.
+    anchor_.reset();
+    event_bus_.Discard(this);
+    if (window_proc_delegate_id_ >= 0) {
+        registrar_->UnregisterTopLevelWindowProcDelegate(window_proc_delegate_id_);
+    }
+}
+
+void OverlayPlugin::StartSelectionTracking() {
+    if (!selection_monitor_) {
+        selection_monitor_ = std::make_unique<SelectionMonitor>(
+            [this](const std::wstring& text, int start, int end) {
+                // A burst that outruns the platform thread collapses into
+                // its newest selection.
+                event_bus_.Post(
+                    this, [this, text, start, end] { SendSelectionEvent(WstringToString(text), start, end); },
+                    EventBus::Priority::kNormal, kSelectionEvent);
+            }
+        );
+    }
+    selection_monitor_->Start();
+}
+
+void OverlayPlugin::StopSelectionTracking() {
+    if (selection_monitor_) {
+        selection_monitor_->Stop();
+    }
+}
+
+bool OverlayPlugin::AnchorOverlay(const flutter::EncodableMap& arguments) {
+    std::string target = "focus";
+    auto target_it = arguments.find(flutter::EncodableValue("target"));
+    if (target_it != arguments.end()) {
+        if (const auto* value = std::get_if<std::string>(&target_it->second)) target = *value;
+    }
+
+    HWND window = nullptr;
+    auto handle_it = arguments.find(flutter::EncodableValue("handle"));
+    if (handle_it != arguments.end()) {
+        window = reinterpret_cast<HWND>(static_cast<intptr_t>(handle_it->second.LongValue()));
+    }
+
+    AnchorLayoutOptions options = anchor_->Options();
+    double width = 0, height = 0;
+    if (FindDouble(arguments, "width", width) && width > 0) options.width = static_cast<int>(width);
+    if (FindDouble(arguments, "height", height) && height > 0) options.height = static_cast<int>(height);
+    anchor_->SetOptions(options);
+
+    OverlayAnchor::Target kind = OverlayAnchor::Target::kFocusedElement;
+    if (target == "window") {
+        kind = OverlayAnchor::Target::kWindow;
+    } else if (target == "selection") {
+        kind = OverlayAnchor::Target::kSelection;
+    }
+    return anchor_->Attach(kind, window);
+}
+
+void OverlayPlugin::ApplyPlacement(const AnchorPlacement& placement) {
+    overlay_->SetPosition(placement.rect.left, placement.rect.top);
+    overlay_->SetSize(placement.rect.Width(), placement.rect.Height());
+}
+
+void OverlayPlugin::StartClipboardWatching() {
+    if (!clipboard_monitor_) {
+        clipboard_monitor_ = std::make_unique<ClipboardMonitor>(
+            [this](const ClipboardCapture& capture) {
+                event_bus_.Post(
+                    this,
+                    [this, capture] {
+                        SendClipboardEvent(WstringToString(capture.text), static_cast<int64_t>(capture.originalLength),
+                                           capture.truncated, capture.categories);
+                    },
+                    EventBus::Priority::kNormal, kClipboardEvent);
+            }
+        );
+    }
+    clipboard_monitor_->Start();
+}
+
+void OverlayPlugin::StopClipboardWatching() {
+    if (clipboard_monitor_) {
+        clipboard_monitor_->Stop();
+    }
+}
 
 void OverlayPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue>& method_call,
@@ -65,13 +185,29 @@ void OverlayPlugin::HandleMethodCall(
 
     if (method_name == "showOverlay") {
         if (!overlay_->IsVisible()) {
-            int x = 100, y = 100, width = 400, height = 500;
-            overlay_->Create(x, y, width, height);
+            // Open next to whatever the overlay is anchored to, or else next
+            // to the foreground window, scaled for that monitor's DPI.
+            const OverlayGeometry& requested = overlay_->GetGeometry();
+            AnchorPlacement placement;
+            if (anchor_->IsAttached()) {
+                overlay_->Create(requested.x, requested.y, requested.width, requested.expandedHeight);
+            } else if (anchor_->PlaceNextToWindow(::GetForegroundWindow(), placement)) {
+                overlay_->Create(placement.rect.left, placement.rect.top,
+                                 placement.rect.Width(), placement.rect.Height());
+            } else {
+                overlay_->Create(requested.x, requested.y, requested.width, requested.expandedHeight);
+            }
             overlay_->Show();
         } else {
             overlay_->Show();
         }
         result->Success(flutter::EncodableValue(true));
+    } else if (method_name == "anchorOverlay") {
+        const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+        result->Success(flutter::EncodableValue(arguments != nullptr && AnchorOverlay(*arguments)));
+    } else if (method_name == "detachOverlay") {
+        anchor_->Detach();
+        result->Success(flutter::EncodableValue(true));
     } else if (method_name == "hideOverlay") {
         overlay_->Hide();
         result->Success(flutter::EncodableValue(true));
@@ -99,6 +235,42 @@ void OverlayPlugin::HandleMethodCall(
             }
         }
         result->Success(flutter::EncodableValue(true));
+    } else if (method_name == "applyGeometry") {
+        // Any subset of the geometry in one call; missing fields keep their
+        // requested value. The window is updated once on the next frame.
+        const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+        if (arguments) {
+            const OverlayGeometry current = overlay_->GetGeometry();
+
+            double x = current.x, y = current.y;
+            const bool has_x = FindDouble(*arguments, "x", x);
+            const bool has_y = FindDouble(*arguments, "y", y);
+            if (has_x || has_y) {
+                overlay_->SetPosition(static_cast<int>(x), static_cast<int>(y));
+            }
+
+            double width = current.width, height = current.expandedHeight;
+            const bool has_width = FindDouble(*arguments, "width", width);
+            const bool has_height = FindDouble(*arguments, "height", height);
+            if (has_width || has_height) {
+                overlay_->SetSize(static_cast<int>(width), static_cast<int>(height));
+            }
+
+            bool minimized = false;
+            if (FindBool(*arguments, "minimized", minimized)) {
+                if (minimized) {
+                    overlay_->Minimize();
+                } else {
+                    overlay_->Expand();
+                }
+            }
+
+            bool always_on_top = false;
+            if (FindBool(*arguments, "alwaysOnTop", always_on_top)) {
+                overlay_->SetAlwaysOnTop(always_on_top);
+            }
+        }
+        result->Success(flutter::EncodableValue(true));
     } else if (method_name == "setAlwaysOnTop") {
         const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
         if (arguments) {
@@ -147,27 +319,31 @@ void OverlayPlugin::HandleMethodCall(
 }
 
 void OverlayPlugin::SendSelectionEvent(const std::string& text, int start, int end) {
-    if (selection_sink_) {
+    if (event_sink_) {
         flutter::EncodableMap event;
         event[flutter::EncodableValue("type")] = flutter::EncodableValue("selection");
         event[flutter::EncodableValue("text")] = flutter::EncodableValue(text);
         event[flutter::EncodableValue("start")] = flutter::EncodableValue(start);
         event[flutter::EncodableValue("end")] = flutter::EncodableValue(end);
-        selection_sink_->Success(flutter::EncodableValue(event));
+        event_sink_->Success(flutter::EncodableValue(event));
     }
 }
 
-void OverlayPlugin::SendClipboardEvent(const std::string& text) {
-    if (clipboard_sink_) {
+void OverlayPlugin::SendClipboardEvent(const std::string& text, int64_t original_length, bool truncated, uint32_t categories) {
+    if (event_sink_) {
         flutter::EncodableMap event;
         event[flutter::EncodableValue("type")] = flutter::EncodableValue("clipboard");
         event[flutter::EncodableValue("text")] = flutter::EncodableValue(text);
-        clipboard_sink_->Success(flutter::EncodableValue(event));
+        event[flutter::EncodableValue("originalLength")] = flutter::EncodableValue(original_length);
+        event[flutter::EncodableValue("truncated")] = flutter::EncodableValue(truncated);
+        event[flutter::EncodableValue("hasTCKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryTerms) != 0);
+        event[flutter::EncodableValue("hasPrivacyKeywords")] = flutter::EncodableValue((categories & kKeywordCategoryPrivacy) != 0);
+        event_sink_->Success(flutter::EncodableValue(event));
     }
 }
 
-OverlayStreamHandler::OverlayStreamHandler(OverlayPlugin* plugin, bool is_selection)
-    : plugin_(plugin), is_selection_(is_selection) {}
+OverlayStreamHandler::OverlayStreamHandler(OverlayPlugin* plugin)
+    : plugin_(plugin) {}
 
 OverlayStreamHandler::~OverlayStreamHandler() {}
 
@@ -175,11 +351,9 @@ std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OverlayStr
     const flutter::EncodableValue* arguments,
     std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& events) {
     
-    if (is_selection_) {
-        plugin_->selection_sink_ = std::move(events);
-    } else {
-        plugin_->clipboard_sink_ = std::move(events);
-    }
+    plugin_->event_sink_ = std::move(events);
+    plugin_->StartSelectionTracking();
+    plugin_->StartClipboardWatching();
     
     return nullptr;
 }
@@ -187,11 +361,9 @@ std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OverlayStr
 std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> OverlayStreamHandler::OnCancelInternal(
     const flutter::EncodableValue* arguments) {
     
-    if (is_selection_) {
-        plugin_->selection_sink_.reset();
-    } else {
-        plugin_->clipboard_sink_.reset();
-    }
+    plugin_->StopSelectionTracking();
+    plugin_->StopClipboardWatching();
+    plugin_->event_sink_.reset();
     
     return nullptr;
 }
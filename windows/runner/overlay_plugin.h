@@ -7,35 +7,61 @@
 #include <flutter/event_stream_handler.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <memory>
+#include <string>
+#include "clipboard_monitor.h"
 #include "desktop_overlay.h"
+#include "event_bus.h"
+#include "overlay_anchor.h"
+#include "selection_monitor.h"
 
 class OverlayPlugin : public flutter::Plugin {
 public:
-    static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
+    // Selection and clipboard events reach the platform thread through
+    // |event_bus|, which must outlive the plugin.
+    static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar, EventBus& event_bus);
 
-    OverlayPlugin(flutter::PluginRegistrarWindows* registrar);
+    OverlayPlugin(flutter::PluginRegistrarWindows* registrar, EventBus& event_bus);
     virtual ~OverlayPlugin();
 
     OverlayPlugin(const OverlayPlugin&) = delete;
     OverlayPlugin& operator=(const OverlayPlugin&) = delete;
 
 private:
+    friend class OverlayStreamHandler;
+
     void HandleMethodCall(
         const flutter::MethodCall<flutter::EncodableValue>& method_call,
         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
     void SendSelectionEvent(const std::string& text, int start, int end);
-    void SendClipboardEvent(const std::string& text);
+    void SendClipboardEvent(const std::string& text, int64_t original_length, bool truncated, uint32_t categories);
+
+    void StartSelectionTracking();
+    void StopSelectionTracking();
+
+    bool AnchorOverlay(const flutter::EncodableMap& arguments);
+    void ApplyPlacement(const AnchorPlacement& placement);
+
+    void StartClipboardWatching();
+    void StopClipboardWatching();
 
-    std::unique_ptr<DesktopOverlay> overlay_;
     flutter::PluginRegistrarWindows* registrar_;
-    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> selection_sink_;
-    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> clipboard_sink_;
+    EventBus& event_bus_;
+    std::unique_ptr<DesktopOverlay> overlay_;
+    std::unique_ptr<OverlayAnchor> anchor_;
+    int window_proc_delegate_id_ = -1;
+
+    std::unique_ptr<SelectionMonitor> selection_monitor_;
+    std::unique_ptr<ClipboardMonitor> clipboard_monitor_;
+
+    // Selection and clipboard events share one channel and are told apart
+    // by their "type" field.
+    std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
 };
 
 class OverlayStreamHandler : public flutter::StreamHandler<flutter::EncodableValue> {
 public:
-    OverlayStreamHandler(OverlayPlugin* plugin, bool is_selection);
+    explicit OverlayStreamHandler(OverlayPlugin* plugin);
     virtual ~OverlayStreamHandler();
 
 protected:
@@ -48,7 +74,6 @@ protected:
 
 private:
     OverlayPlugin* plugin_;
-    bool is_selection_;
 };
 
 #endif
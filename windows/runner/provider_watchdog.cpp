@@ -0,0 +1,247 @@
+#include "provider_watchdog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <utility>
+
+ProcessCircuitBreaker::ProcessCircuitBreaker(CircuitBreakerOptions options) : options_(options) {}
+
+ProcessHealth& ProcessCircuitBreaker::Entry(uint32_t processId, int64_t nowMicros) {
+    auto inserted = processes_.emplace(processId, ProcessHealth());
+    ProcessHealth& health = inserted.first->second;
+    if (inserted.second) {
+        health.processId = processId;
+        health.lastUsedMicros = nowMicros;
+        Prune();
+    }
+    return health;
+}
+
+// Forgets the least recently used closed entries. Open ones are kept, since
+// forgetting them would let a hung process straight back in.
+void ProcessCircuitBreaker::Prune() {
+    while (processes_.size() > options_.maxProcesses) {
+        auto oldest = processes_.end();
+        for (auto it = processes_.begin(); it != processes_.end(); ++it) {
+            if (it->second.state != BreakerState::kClosed) continue;
+            if (oldest == processes_.end() || it->second.lastUsedMicros < oldest->second.lastUsedMicros) {
+                oldest = it;
+            }
+        }
+        if (oldest == processes_.end()) return;
+        processes_.erase(oldest);
+    }
+}
+
+void ProcessCircuitBreaker::Open(ProcessHealth& health, int64_t nowMicros) {
+    if (health.state == BreakerState::kOpen) return;
+    const uint32_t doublings = std::min<uint32_t>(health.openCount, 30);
+    ++health.openCount;
+    int64_t backoff = options_.initialBackoffMicros;
+    for (uint32_t i = 0; i < doublings && backoff < options_.maxBackoffMicros; i++) {
+        backoff *= 2;
+    }
+    health.state = BreakerState::kOpen;
+    health.retryAtMicros = nowMicros + std::min(backoff, options_.maxBackoffMicros);
+}
+
+bool ProcessCircuitBreaker::Allow(uint32_t processId, int64_t nowMicros) {
+    if (processId == 0) return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProcessHealth& health = Entry(processId, nowMicros);
+    health.lastUsedMicros = nowMicros;
+    switch (health.state) {
+    case BreakerState::kClosed:
+        return true;
+    case BreakerState::kOpen:
+        if (nowMicros >= health.retryAtMicros) {
+            health.state = BreakerState::kHalfOpen;
+            return true;
+        }
+        break;
+    case BreakerState::kHalfOpen:
+        break;
+    }
+    ++health.rejected;
+    return false;
+}
+
+void ProcessCircuitBreaker::RecordSuccess(uint32_t processId, int64_t latencyMicros, int64_t nowMicros) {
+    if (processId == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProcessHealth& health = Entry(processId, nowMicros);
+    ++health.successes;
+    health.consecutiveFailures = 0;
+    health.openCount = 0;
+    health.state = BreakerState::kClosed;
+    health.retryAtMicros = 0;
+    health.lastLatencyMicros = latencyMicros;
+}
+
+void ProcessCircuitBreaker::RecordFailure(uint32_t processId, int64_t nowMicros) {
+    if (processId == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProcessHealth& health = Entry(processId, nowMicros);
+    ++health.failures;
+    ++health.consecutiveFailures;
+    // A failed probe reopens at once, with a longer backoff.
+    if (health.state == BreakerState::kHalfOpen || health.consecutiveFailures >= options_.failureThreshold) {
+        Open(health, nowMicros);
+    }
+}
+
+void ProcessCircuitBreaker::RecordTimeout(uint32_t processId, int64_t nowMicros) {
+    if (processId == 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ProcessHealth& health = Entry(processId, nowMicros);
+    ++health.timeouts;
+    ++health.consecutiveFailures;
+    Open(health, nowMicros);
+}
+
+std::vector<ProcessHealth> ProcessCircuitBreaker::Snapshot() const {
+    std::vector<ProcessHealth> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result.reserve(processes_.size());
+        for (const auto& entry : processes_) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const ProcessHealth& a, const ProcessHealth& b) { return a.processId < b.processId; });
+    return result;
+}
+
+ProviderWatchdog::ProviderWatchdog(Canceller cancel, ProviderWatchdogOptions options)
+    : cancel_(std::move(cancel)), callTimeoutMicros_(options.callTimeoutMicros), breaker_(options.breaker) {}
+
+ProviderWatchdog::~ProviderWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+int64_t ProviderWatchdog::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t ProviderWatchdog::AbandonedCalls() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return abandoned_;
+}
+
+void ProviderWatchdog::CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!cancel_) return;
+    for (const auto& entry : calls_) {
+        if (!entry.second.abandoned) cancel_(entry.second.token);
+    }
+}
+
+uint64_t ProviderWatchdog::Begin(uint32_t processId, uint64_t token, std::function<void()> onAbandoned) {
+    const int64_t now = NowMicros();
+    if (!breaker_.Allow(processId, now)) return 0;
+
+    uint64_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) return 0;
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ProviderWatchdog::ThreadMain, this);
+        }
+        id = ++nextId_;
+        calls_.emplace(id, Watched{processId, token, now, now + callTimeoutMicros_, false, std::move(onAbandoned)});
+    }
+    wake_.notify_one();
+    return id;
+}
+
+bool ProviderWatchdog::End(uint64_t id, bool succeeded) {
+    Watched call;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = calls_.find(id);
+        if (it == calls_.end()) return false;
+        call = std::move(it->second);
+        calls_.erase(it);
+    }
+    // The timeout has already been recorded.
+    if (call.abandoned) return false;
+
+    const int64_t now = NowMicros();
+    if (succeeded) {
+        breaker_.RecordSuccess(call.processId, now - call.startedMicros, now);
+    } else {
+        breaker_.RecordFailure(call.processId, now);
+    }
+    return true;
+}
+
+// The watchdog thread is not woken: a later deadline only means that when
+// it next wakes it finds nothing due and sleeps again.
+bool ProviderWatchdog::Progress(uint64_t id) {
+    const int64_t now = NowMicros();
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = calls_.find(id);
+    if (it == calls_.end() || it->second.abandoned) return false;
+    it->second.deadlineMicros = now + callTimeoutMicros_;
+    return true;
+}
+
+void ProviderWatchdog::ThreadMain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        const int64_t now = NowMicros();
+        int64_t next = std::numeric_limits<int64_t>::max();
+        for (auto& entry : calls_) {
+            Watched& call = entry.second;
+            if (call.abandoned) continue;
+            if (call.deadlineMicros > now) {
+                next = std::min(next, call.deadlineMicros);
+                continue;
+            }
+            // The callbacks run under the lock so that End(), and with it
+            // the caller's teardown, cannot overtake them.
+            call.abandoned = true;
+            ++abandoned_;
+            breaker_.RecordTimeout(call.processId, now);
+            if (cancel_) cancel_(call.token);
+            if (call.onAbandoned) call.onAbandoned();
+        }
+
+        if (next == std::numeric_limits<int64_t>::max()) {
+            wake_.wait(lock);
+        } else {
+            wake_.wait_for(lock, std::chrono::microseconds(next - now));
+        }
+    }
+}
+
+ProviderCall::ProviderCall(ProviderWatchdog& watchdog, uint32_t processId, uint64_t token,
+                           std::function<void()> onAbandoned)
+    : watchdog_(watchdog), id_(watchdog.Begin(processId, token, std::move(onAbandoned))) {}
+
+ProviderCall::~ProviderCall() {
+    Finish(false);
+}
+
+bool ProviderCall::Progress() {
+    if (id_ == 0 || finished_) return false;
+    return watchdog_.Progress(id_);
+}
+
+bool ProviderCall::Finish(bool succeeded) {
+    if (id_ == 0 || finished_) return false;
+    finished_ = true;
+    return watchdog_.End(id_, succeeded);
+}
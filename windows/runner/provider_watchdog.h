@@ -0,0 +1,183 @@
+#ifndef RUNNER_PROVIDER_WATCHDOG_H_
+#define RUNNER_PROVIDER_WATCHDOG_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+enum class BreakerState : uint8_t {
+    kClosed,
+    kOpen,
+    // The backoff has elapsed and one probe call is in flight.
+    kHalfOpen,
+};
+
+struct CircuitBreakerOptions {
+    // Consecutive failed calls that open the breaker. A timeout opens it at
+    // once, since a hung provider would only hang the next call too.
+    uint32_t failureThreshold = 3;
+    // How long the breaker first stays open; each reopening without a
+    // success in between doubles it, up to the maximum.
+    int64_t initialBackoffMicros = 2000000;
+    int64_t maxBackoffMicros = 120000000;
+    // Beyond this many processes, closed entries are forgotten oldest first.
+    size_t maxProcesses = 128;
+};
+
+struct ProcessHealth {
+    uint32_t processId = 0;
+    BreakerState state = BreakerState::kClosed;
+    uint32_t consecutiveFailures = 0;
+    // Times opened since the last success; sets the next backoff.
+    uint32_t openCount = 0;
+    uint64_t successes = 0;
+    uint64_t failures = 0;
+    uint64_t timeouts = 0;
+    // Calls refused while open or while a probe was in flight.
+    uint64_t rejected = 0;
+    // While open, when the next probe may go ahead.
+    int64_t retryAtMicros = 0;
+    int64_t lastLatencyMicros = 0;
+    int64_t lastUsedMicros = 0;
+};
+
+// Tracks the health of UI Automation providers per target process, so one
+// hung application costs a single timeout rather than one per call. Thread
+// safe. Process id 0 stands for an unknown process and is never refused.
+class ProcessCircuitBreaker {
+public:
+    explicit ProcessCircuitBreaker(CircuitBreakerOptions options = CircuitBreakerOptions());
+
+    ProcessCircuitBreaker(const ProcessCircuitBreaker&) = delete;
+    ProcessCircuitBreaker& operator=(const ProcessCircuitBreaker&) = delete;
+
+    // Whether a call into |processId| may go ahead at |nowMicros|. Once the
+    // backoff of an open breaker has elapsed, exactly one caller is let
+    // through as a probe; its outcome closes or reopens the breaker.
+    bool Allow(uint32_t processId, int64_t nowMicros);
+
+    void RecordSuccess(uint32_t processId, int64_t latencyMicros, int64_t nowMicros);
+    void RecordFailure(uint32_t processId, int64_t nowMicros);
+    void RecordTimeout(uint32_t processId, int64_t nowMicros);
+
+    std::vector<ProcessHealth> Snapshot() const;
+
+private:
+    ProcessHealth& Entry(uint32_t processId, int64_t nowMicros);
+    void Open(ProcessHealth& health, int64_t nowMicros);
+    void Prune();
+
+    const CircuitBreakerOptions options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, ProcessHealth> processes_;
+};
+
+struct ProviderWatchdogOptions {
+    // Longest a guarded call may go without reporting progress before it is
+    // abandoned. A walk reports progress after each provider call returns,
+    // so this bounds a single cross-process call rather than the whole
+    // extraction. Above the UI Automation transaction timeout, so this only
+    // fires when a provider ignores that.
+    int64_t callTimeoutMicros = 8000000;
+    CircuitBreakerOptions breaker;
+};
+
+// Watches calls into UI Automation providers from any thread. A call that
+// goes a whole timeout without progress is abandoned: its process's breaker opens, the
+// canceller is asked to unblock the calling thread, and the call's own
+// abandon callback lets its caller answer without waiting any longer.
+//
+// The watchdog thread starts with the first guarded call.
+class ProviderWatchdog {
+public:
+    // Runs on the watchdog thread, with its lock held, for each abandoned
+    // call. |token| is the one the call was started with; in the runner it
+    // is the calling thread's id, for CoCancelCall.
+    using Canceller = std::function<void(uint64_t token)>;
+
+    explicit ProviderWatchdog(Canceller cancel, ProviderWatchdogOptions options = ProviderWatchdogOptions());
+    ~ProviderWatchdog();
+
+    ProviderWatchdog(const ProviderWatchdog&) = delete;
+    ProviderWatchdog& operator=(const ProviderWatchdog&) = delete;
+
+    // Asks the canceller to unblock every call in progress, without
+    // abandoning them or counting them against their processes. For
+    // shutdown, so joining the calling threads does not wait out the timeout.
+    void CancelAll();
+
+    std::vector<ProcessHealth> Snapshot() const { return breaker_.Snapshot(); }
+    uint64_t AbandonedCalls() const;
+
+    static int64_t NowMicros();
+
+private:
+    friend class ProviderCall;
+
+    struct Watched {
+        uint32_t processId = 0;
+        uint64_t token = 0;
+        int64_t startedMicros = 0;
+        int64_t deadlineMicros = 0;
+        bool abandoned = false;
+        std::function<void()> onAbandoned;
+    };
+
+    // Returns 0 if the breaker refuses the call.
+    uint64_t Begin(uint32_t processId, uint64_t token, std::function<void()> onAbandoned);
+    // Returns false if the call had been abandoned.
+    bool End(uint64_t id, bool succeeded);
+    // Pushes the call's deadline a full timeout past now. Returns false if
+    // the call had been abandoned.
+    bool Progress(uint64_t id);
+    void ThreadMain();
+
+    const Canceller cancel_;
+    const int64_t callTimeoutMicros_;
+    ProcessCircuitBreaker breaker_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unordered_map<uint64_t, Watched> calls_;
+    uint64_t nextId_ = 0;
+    uint64_t abandoned_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+// One guarded provider call. Check Allowed() before calling the provider,
+// then report the outcome with Finish(); a call that is never finished
+// counts as failed.
+class ProviderCall {
+public:
+    // |onAbandoned| follows the Canceller's rules: it must not block or call
+    // back into the watchdog.
+    ProviderCall(ProviderWatchdog& watchdog, uint32_t processId, uint64_t token,
+                 std::function<void()> onAbandoned = nullptr);
+    ~ProviderCall();
+
+    ProviderCall(const ProviderCall&) = delete;
+    ProviderCall& operator=(const ProviderCall&) = delete;
+
+    bool Allowed() const { return id_ != 0; }
+
+    // Reports that the provider is still answering, which restarts the
+    // timeout. Returns false once the call has been abandoned.
+    bool Progress();
+
+    // Returns false if the watchdog abandoned the call, in which case its
+    // result should be dropped.
+    bool Finish(bool succeeded);
+
+private:
+    ProviderWatchdog& watchdog_;
+    const uint64_t id_;
+    bool finished_ = false;
+};
+
+#endif
@@ -0,0 +1,296 @@
+#include "refresh_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr int64_t kNever = std::numeric_limits<int64_t>::max();
+// Beyond this many doublings every interval has reached its maximum.
+constexpr uint32_t kMaxBackoff = 20;
+
+}  // namespace
+
+RefreshPolicy::RefreshPolicy(RefreshPolicyOptions options) : options_(options) {}
+
+RefreshPolicy::Window* RefreshPolicy::Find(uint64_t window) {
+    for (auto& entry : windows_) {
+        if (entry.id == window) return &entry;
+    }
+    return nullptr;
+}
+
+uint32_t RefreshPolicy::PowerFactor() const {
+    if (batterySaver_) return options_.batterySaverFactor;
+    if (onBattery_) return options_.batteryFactor;
+    return 1;
+}
+
+int64_t RefreshPolicy::Interval(const Window& window, int64_t nowMicros) const {
+    const int64_t base = window.foreground ? options_.foregroundIntervalMicros : options_.backgroundIntervalMicros;
+    const int64_t max = window.foreground ? options_.maxForegroundIntervalMicros : options_.maxBackgroundIntervalMicros;
+    int64_t interval = base;
+    for (uint32_t i = 0; i < window.backoff && interval < max; i++) {
+        interval *= 2;
+    }
+    interval = std::min(interval, max);
+
+    int64_t factor = PowerFactor();
+    if (nowMicros - lastInputMicros_ > options_.idleAfterMicros) {
+        factor *= options_.idleFactor;
+    }
+    return interval * factor;
+}
+
+int64_t RefreshPolicy::Due(const Window& window, int64_t nowMicros) const {
+    if (!window.visible || window.inFlight) return kNever;
+    if (!window.checked) return nowMicros;
+
+    int64_t due = window.lastCheckMicros + Interval(window, nowMicros);
+    if (window.foreground && lastInputMicros_ > window.lastCheckMicros) {
+        // Input is the likeliest cause of a change, so look soon after it,
+        // but never closer together than the unbacked-off interval.
+        const int64_t afterInput = std::max(lastInputMicros_ + options_.inputSettleMicros,
+                                            window.lastCheckMicros + options_.foregroundIntervalMicros * PowerFactor());
+        due = std::min(due, afterInput);
+    }
+    return due;
+}
+
+void RefreshPolicy::SetForeground(uint64_t window, int64_t nowMicros) {
+    for (auto& entry : windows_) {
+        if (entry.foreground && entry.id != window) {
+            entry.foreground = false;
+            entry.lastForegroundMicros = nowMicros;
+        }
+    }
+    if (window == 0) return;
+
+    Window* entry = Find(window);
+    if (!entry) {
+        if (windows_.size() >= options_.maxWindows && !windows_.empty()) {
+            auto oldest = std::min_element(windows_.begin(), windows_.end(), [](const Window& a, const Window& b) {
+                return a.lastForegroundMicros < b.lastForegroundMicros;
+            });
+            windows_.erase(oldest);
+        }
+        windows_.emplace_back();
+        entry = &windows_.back();
+        entry->id = window;
+    } else if (!entry->foreground) {
+        entry->backoff = 0;
+    }
+    entry->foreground = true;
+    entry->visible = true;
+    entry->lastForegroundMicros = nowMicros;
+}
+
+void RefreshPolicy::SetVisible(uint64_t window, bool visible) {
+    Window* entry = Find(window);
+    if (!entry || entry->visible == visible) return;
+    entry->visible = visible;
+    // What changed while it was hidden is looked at straight away.
+    if (visible) entry->backoff = 0;
+}
+
+void RefreshPolicy::Forget(uint64_t window) {
+    windows_.erase(std::remove_if(windows_.begin(), windows_.end(),
+                                  [window](const Window& entry) { return entry.id == window; }),
+                   windows_.end());
+}
+
+void RefreshPolicy::SetPower(bool onBattery, bool batterySaver) {
+    onBattery_ = onBattery;
+    batterySaver_ = batterySaver;
+}
+
+void RefreshPolicy::NoteInput(int64_t inputMicros) {
+    lastInputMicros_ = std::max(lastInputMicros_, inputMicros);
+}
+
+void RefreshPolicy::TakeDue(int64_t nowMicros, std::vector<uint64_t>& due) {
+    for (auto& entry : windows_) {
+        if (Due(entry, nowMicros) <= nowMicros) {
+            entry.inFlight = true;
+            due.push_back(entry.id);
+        }
+    }
+}
+
+void RefreshPolicy::Finish(Window& window, int64_t nowMicros) {
+    window.inFlight = false;
+    window.checked = true;
+    window.lastCheckMicros = nowMicros;
+}
+
+bool RefreshPolicy::Complete(uint64_t window, uint64_t fingerprint, int64_t nowMicros) {
+    Window* entry = Find(window);
+    if (!entry) return false;
+
+    const bool first = !entry->hasFingerprint;
+    const bool changed = first || entry->fingerprint != fingerprint;
+    entry->hasFingerprint = true;
+    entry->fingerprint = fingerprint;
+    entry->backoff = changed ? 0 : std::min(entry->backoff + 1, kMaxBackoff);
+    ++stats_.refreshes;
+    if (changed && !first) ++stats_.changes;
+    Finish(*entry, nowMicros);
+    return changed;
+}
+
+void RefreshPolicy::Fail(uint64_t window, int64_t nowMicros) {
+    Window* entry = Find(window);
+    if (!entry) return;
+    entry->backoff = std::min(entry->backoff + 1, kMaxBackoff);
+    ++stats_.refreshes;
+    ++stats_.failures;
+    Finish(*entry, nowMicros);
+}
+
+void RefreshPolicy::Skip(uint64_t window, int64_t nowMicros) {
+    Window* entry = Find(window);
+    if (!entry) return;
+    Finish(*entry, nowMicros);
+}
+
+int64_t RefreshPolicy::NextDue(int64_t nowMicros) const {
+    int64_t next = kNever;
+    for (const auto& entry : windows_) {
+        next = std::min(next, Due(entry, nowMicros));
+    }
+    return next;
+}
+
+int64_t RefreshPolicy::SignalPollMicros() const {
+    return options_.signalPollMicros * PowerFactor();
+}
+
+std::vector<uint64_t> RefreshPolicy::Windows() const {
+    std::vector<uint64_t> result;
+    result.reserve(windows_.size());
+    for (const auto& entry : windows_) {
+        result.push_back(entry.id);
+    }
+    return result;
+}
+
+RefreshStats RefreshPolicy::Stats(int64_t nowMicros) const {
+    RefreshStats result = stats_;
+    result.windows.clear();
+    for (const auto& entry : windows_) {
+        result.windows.push_back({entry.id, entry.foreground, entry.visible, Interval(entry, nowMicros)});
+    }
+    return result;
+}
+
+RefreshScheduler::RefreshScheduler(Sampler sample, VisibilityProbe probe, Refresher refresh,
+                                   RefreshPolicyOptions options)
+    : sample_(std::move(sample)), probe_(std::move(probe)), refresh_(std::move(refresh)), policy_(options) {}
+
+RefreshScheduler::~RefreshScheduler() {
+    Stop();
+}
+
+int64_t RefreshScheduler::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RefreshScheduler::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return;
+    stopping_ = false;
+    thread_ = std::thread(&RefreshScheduler::ThreadMain, this);
+}
+
+void RefreshScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool RefreshScheduler::Complete(uint64_t window, uint64_t fingerprint) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_.Complete(window, fingerprint, NowMicros());
+}
+
+void RefreshScheduler::Fail(uint64_t window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_.Fail(window, NowMicros());
+}
+
+void RefreshScheduler::Skip(uint64_t window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_.Skip(window, NowMicros());
+}
+
+RefreshStats RefreshScheduler::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policy_.Stats(NowMicros());
+}
+
+void RefreshScheduler::ThreadMain() {
+    std::vector<uint64_t> windows;
+    std::vector<std::pair<uint64_t, int>> visibility;
+    std::vector<uint64_t> due;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            windows = policy_.Windows();
+        }
+
+        // Sampled without the lock: the callbacks may be slow to return.
+        const RefreshSignals signals = sample_();
+        visibility.clear();
+        for (uint64_t window : windows) {
+            bool visible = false;
+            const bool exists = probe_(window, visible);
+            visibility.emplace_back(window, exists ? (visible ? 1 : 0) : -1);
+        }
+
+        due.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            const int64_t now = NowMicros();
+            policy_.SetPower(signals.onBattery, signals.batterySaver);
+            policy_.NoteInput(signals.lastInputMicros);
+            for (const auto& entry : visibility) {
+                if (entry.second < 0) {
+                    policy_.Forget(entry.first);
+                } else {
+                    policy_.SetVisible(entry.first, entry.second != 0);
+                }
+            }
+            policy_.SetForeground(signals.foreground, now);
+            policy_.TakeDue(now, due);
+        }
+
+        for (uint64_t window : due) {
+            refresh_(window);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_) return;
+        const int64_t now = NowMicros();
+        const int64_t wakeAt = std::min(policy_.NextDue(now), now + policy_.SignalPollMicros());
+        if (wakeAt > now) {
+            wake_.wait_for(lock, std::chrono::microseconds(wakeAt - now));
+        }
+    }
+}
+
+uint64_t ContentFingerprint(const wchar_t* text, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint64_t>(text[i]);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
@@ -0,0 +1,173 @@
+#ifndef RUNNER_REFRESH_SCHEDULER_H_
+#define RUNNER_REFRESH_SCHEDULER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct RefreshPolicyOptions {
+    // Interval while a window's content keeps changing. Every check that
+    // finds it unchanged doubles the interval, up to the maximum.
+    int64_t foregroundIntervalMicros = 1000000;
+    int64_t maxForegroundIntervalMicros = 30000000;
+    int64_t backgroundIntervalMicros = 5000000;
+    int64_t maxBackgroundIntervalMicros = 300000000;
+    // Input in the foreground window brings its next check forward to this
+    // long after the input, giving the application time to redraw.
+    int64_t inputSettleMicros = 300000;
+    // Without input for this long the user is taken to be away, and every
+    // interval is multiplied by idleFactor.
+    int64_t idleAfterMicros = 120000000;
+    uint32_t idleFactor = 4;
+    // Multipliers on battery power and with battery saver on.
+    uint32_t batteryFactor = 2;
+    uint32_t batterySaverFactor = 4;
+    // Longest the scheduler sleeps between samples of the signals, on AC
+    // power; on battery it is stretched like the intervals.
+    int64_t signalPollMicros = 1000000;
+    // Windows tracked at most; the one longest out of the foreground goes.
+    size_t maxWindows = 8;
+};
+
+struct RefreshWindowState {
+    uint64_t window = 0;
+    bool foreground = false;
+    bool visible = true;
+    // Interval the next check is scheduled with.
+    int64_t intervalMicros = 0;
+};
+
+struct RefreshStats {
+    uint64_t refreshes = 0;
+    uint64_t changes = 0;
+    uint64_t failures = 0;
+    std::vector<RefreshWindowState> windows;
+};
+
+// Decides when each monitored window's content is read again. Checks come
+// often while content changes, the user is active, the window is in front
+// and the machine is on AC power, and back off exponentially otherwise.
+// Hidden and minimised windows are not checked. Not thread safe; all times
+// are the caller's, so it runs as well on a simulated clock.
+class RefreshPolicy {
+public:
+    explicit RefreshPolicy(RefreshPolicyOptions options = RefreshPolicyOptions());
+
+    // |window| 0 means no tracked window is in front. A window coming to
+    // the front is tracked if it was not, and checked again promptly.
+    void SetForeground(uint64_t window, int64_t nowMicros);
+    void SetVisible(uint64_t window, bool visible);
+    void Forget(uint64_t window);
+    void SetPower(bool onBattery, bool batterySaver);
+    void NoteInput(int64_t inputMicros);
+
+    // Appends the windows due at |nowMicros| to |due| and marks them in
+    // flight until Complete(), Fail() or Skip() is called for them.
+    void TakeDue(int64_t nowMicros, std::vector<uint64_t>& due);
+    // Records a check's content fingerprint and returns whether the content
+    // is new: changed, or read for the first time.
+    bool Complete(uint64_t window, uint64_t fingerprint, int64_t nowMicros);
+    // A check that could not read the window backs off like an unchanged one.
+    void Fail(uint64_t window, int64_t nowMicros);
+    // A check that was not carried out; it is not counted.
+    void Skip(uint64_t window, int64_t nowMicros);
+
+    // When the next window falls due, or INT64_MAX if none will.
+    int64_t NextDue(int64_t nowMicros) const;
+    // How long to sleep at most before sampling the signals again.
+    int64_t SignalPollMicros() const;
+
+    std::vector<uint64_t> Windows() const;
+    RefreshStats Stats(int64_t nowMicros) const;
+
+private:
+    struct Window {
+        uint64_t id = 0;
+        bool foreground = false;
+        bool visible = true;
+        bool inFlight = false;
+        // Whether any check has finished; until then the window is due.
+        bool checked = false;
+        bool hasFingerprint = false;
+        uint64_t fingerprint = 0;
+        // Unchanged checks since the last change; each doubles the interval.
+        uint32_t backoff = 0;
+        int64_t lastCheckMicros = 0;
+        int64_t lastForegroundMicros = 0;
+    };
+
+    Window* Find(uint64_t window);
+    uint32_t PowerFactor() const;
+    int64_t Interval(const Window& window, int64_t nowMicros) const;
+    int64_t Due(const Window& window, int64_t nowMicros) const;
+    void Finish(Window& window, int64_t nowMicros);
+
+    const RefreshPolicyOptions options_;
+    std::vector<Window> windows_;
+    bool onBattery_ = false;
+    bool batterySaver_ = false;
+    int64_t lastInputMicros_ = 0;
+    RefreshStats stats_;
+};
+
+// What the scheduler samples on every wake-up.
+struct RefreshSignals {
+    uint64_t foreground = 0;
+    bool onBattery = false;
+    bool batterySaver = false;
+    // Steady-clock microseconds of the last keyboard or mouse input.
+    int64_t lastInputMicros = 0;
+};
+
+// Runs a RefreshPolicy on its own thread against the real clock. The
+// callbacks run on that thread without the scheduler's lock held.
+class RefreshScheduler {
+public:
+    using Sampler = std::function<RefreshSignals()>;
+    // Returns false once |window| no longer exists.
+    using VisibilityProbe = std::function<bool(uint64_t window, bool& visible)>;
+    // Starts a check of |window|; Complete(), Fail() or Skip() must follow,
+    // from any thread.
+    using Refresher = std::function<void(uint64_t window)>;
+
+    RefreshScheduler(Sampler sample, VisibilityProbe probe, Refresher refresh,
+                     RefreshPolicyOptions options = RefreshPolicyOptions());
+    ~RefreshScheduler();
+
+    RefreshScheduler(const RefreshScheduler&) = delete;
+    RefreshScheduler& operator=(const RefreshScheduler&) = delete;
+
+    void Start();
+    void Stop();
+
+    bool Complete(uint64_t window, uint64_t fingerprint);
+    void Fail(uint64_t window);
+    void Skip(uint64_t window);
+
+    RefreshStats Stats() const;
+
+    static int64_t NowMicros();
+
+private:
+    void ThreadMain();
+
+    const Sampler sample_;
+    const VisibilityProbe probe_;
+    const Refresher refresh_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    RefreshPolicy policy_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+// 64-bit FNV-1a over |length| UTF-16 code units, for telling whether a
+// window's text changed between checks.
+uint64_t ContentFingerprint(const wchar_t* text, size_t length);
+
+#endif
@@ -0,0 +1,911 @@
+#include "report_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// A4, with the margins of the in-app report.
+constexpr double kPageWidth = 595.28;
+constexpr double kPageHeight = 841.89;
+constexpr double kMargin = 32.0;
+constexpr double kContentWidth = kPageWidth - 2 * kMargin;
+constexpr double kLineSpacing = 1.35;
+
+constexpr uint32_t kNoColor = 0xFFFFFFFF;
+constexpr uint32_t kBlack = 0x212121;
+constexpr uint32_t kBlue800 = 0x1565C0;
+constexpr uint32_t kBlue50 = 0xE3F2FD;
+constexpr uint32_t kGreen50 = 0xE8F5E9;
+constexpr uint32_t kGrey50 = 0xFAFAFA;
+constexpr uint32_t kGrey100 = 0xF5F5F5;
+constexpr uint32_t kGrey300 = 0xE0E0E0;
+constexpr uint32_t kGrey600 = 0x757575;
+constexpr uint32_t kGrey700 = 0x616161;
+
+enum Severity { kCritical = 0, kWarning = 1, kInfo = 2, kSeverityCount = 3 };
+
+struct SeverityColors {
+    const char* label;
+    uint32_t strong;
+    uint32_t light;      // badge and highlight
+    uint32_t lightest;   // count chip
+    uint32_t accent;     // card edge
+};
+
+const SeverityColors kSeverityColors[kSeverityCount] = {
+    {"Critical", 0xF44336, 0xFFCDD2, 0xFFEBEE, 0xEF9A9A},
+    {"Warning", 0xFF9800, 0xFFE0B2, 0xFFF3E0, 0xFFCC80},
+    {"Info", 0x2196F3, 0xBBDEFB, 0xE3F2FD, 0x90CAF9},
+};
+
+// Bounds-checked cursor over the report buffer; any overrun clears ok.
+class ReportReader {
+public:
+    ReportReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    bool ok() const { return ok_; }
+
+    uint8_t U8() {
+        if (!Has(1)) return 0;
+        return data_[at_++];
+    }
+    uint16_t U16() {
+        if (!Has(2)) return 0;
+        const uint16_t value = static_cast<uint16_t>(data_[at_] | (data_[at_ + 1] << 8));
+        at_ += 2;
+        return value;
+    }
+    uint32_t U32() {
+        const uint32_t low = U16();
+        return low | (static_cast<uint32_t>(U16()) << 16);
+    }
+    std::string_view String() {
+        const uint32_t length = U32();
+        if (!Has(length)) return std::string_view();
+        std::string_view value(reinterpret_cast<const char*>(data_ + at_), length);
+        at_ += length;
+        return value;
+    }
+    bool Magic(const char* magic) {
+        if (!Has(4) || std::memcmp(data_ + at_, magic, 4) != 0) return ok_ = false;
+        at_ += 4;
+        return true;
+    }
+
+private:
+    bool Has(size_t count) {
+        if (ok_ && count <= size_ - at_) return true;
+        ok_ = false;
+        return false;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t at_ = 0;
+    bool ok_ = true;
+};
+
+// Decodes UTF-8 one code point at a time, counting UTF-16 units so flag
+// offsets from Dart strings can be matched. Malformed bytes become U+FFFD.
+class Utf8Cursor {
+public:
+    explicit Utf8Cursor(std::string_view text) : text_(text) {}
+
+    bool Next(uint32_t& codepoint) {
+        if (at_ >= text_.size()) return false;
+        const auto lead = static_cast<uint8_t>(text_[at_]);
+        size_t length = 1;
+        uint32_t value = 0xFFFD;
+        if (lead < 0x80) {
+            value = lead;
+        } else if (lead >= 0xC2 && lead < 0xF5) {
+            const size_t expected = lead < 0xE0 ? 2 : (lead < 0xF0 ? 3 : 4);
+            uint32_t decoded = lead & (0x3F >> (expected - 1));
+            size_t i = 1;
+            for (; i < expected && at_ + i < text_.size(); i++) {
+                const auto next = static_cast<uint8_t>(text_[at_ + i]);
+                if ((next & 0xC0) != 0x80) break;
+                decoded = (decoded << 6) | (next & 0x3F);
+            }
+            if (i == expected && decoded <= 0x10FFFF && !(decoded >= 0xD800 && decoded < 0xE000) &&
+                decoded >= (expected == 2 ? 0x80u : (expected == 3 ? 0x800u : 0x10000u))) {
+                value = decoded;
+                length = expected;
+            }
+        }
+        at_ += length;
+        offset_ = nextOffset_;
+        nextOffset_ += value >= 0x10000 ? 2 : 1;
+        codepoint = value;
+        return true;
+    }
+
+    // UTF-16 offset of the code point last returned by Next().
+    uint32_t Utf16Offset() const { return offset_; }
+
+private:
+    std::string_view text_;
+    size_t at_ = 0;
+    uint32_t offset_ = 0;
+    uint32_t nextOffset_ = 0;
+};
+
+// Writes objects straight to the file and remembers only their offsets.
+class PdfOutput {
+public:
+    explicit PdfOutput(std::FILE* out) : out_(out) {}
+
+    uint32_t Reserve() {
+        offsets_.push_back(0);
+        return static_cast<uint32_t>(offsets_.size());
+    }
+
+    void Write(std::string_view text) {
+        if (text.empty()) return;
+        if (std::fwrite(text.data(), 1, text.size(), out_) != text.size()) failed_ = true;
+        position_ += text.size();
+    }
+
+    void Object(uint32_t object, std::string_view body) {
+        offsets_[object - 1] = position_;
+        Write(std::to_string(object));
+        Write(" 0 obj\n");
+        Write(body);
+        Write("\nendobj\n");
+    }
+
+    void Stream(uint32_t object, std::string_view dictionary, std::string_view data) {
+        offsets_[object - 1] = position_;
+        Write(std::to_string(object));
+        Write(" 0 obj\n<< ");
+        Write(dictionary);
+        Write(" /Length ");
+        Write(std::to_string(data.size()));
+        Write(" >>\nstream\n");
+        Write(data);
+        Write("\nendstream\nendobj\n");
+    }
+
+    bool Finish(uint32_t root, uint32_t info) {
+        const uint64_t xref = position_;
+        Write("xref\n0 ");
+        Write(std::to_string(offsets_.size() + 1));
+        Write("\n0000000000 65535 f \n");
+        char entry[24];
+        for (uint64_t offset : offsets_) {
+            std::snprintf(entry, sizeof(entry), "%010llu 00000 n \n", static_cast<unsigned long long>(offset));
+            Write(entry);
+        }
+        Write("trailer\n<< /Size ");
+        Write(std::to_string(offsets_.size() + 1));
+        Write(" /Root ");
+        Write(std::to_string(root));
+        Write(" 0 R /Info ");
+        Write(std::to_string(info));
+        Write(" 0 R >>\nstartxref\n");
+        Write(std::to_string(xref));
+        Write("\n%%EOF\n");
+        return !failed_ && std::fflush(out_) == 0;
+    }
+
+    uint64_t Position() const { return position_; }
+
+private:
+    std::FILE* out_;
+    uint64_t position_ = 0;
+    std::vector<uint64_t> offsets_;
+    bool failed_ = false;
+};
+
+// One embedded font: which glyphs the report used, and the character each
+// stands for so text can be copied out of the PDF.
+struct FontSlot {
+    const TrueTypeFont* font = nullptr;
+    const char* resource = "";
+    uint32_t object = 0;
+    std::vector<bool> used;
+    std::vector<uint32_t> unicode;
+
+    void Init(const TrueTypeFont* source, const char* name, uint32_t reserved) {
+        font = source;
+        resource = name;
+        object = reserved;
+        used.assign(font->GlyphCount(), false);
+        unicode.assign(font->GlyphCount(), 0);
+    }
+
+    uint16_t Use(uint32_t codepoint) {
+        const uint16_t glyph = font->GlyphFor(codepoint);
+        if (!used[glyph]) {
+            used[glyph] = true;
+            unicode[glyph] = codepoint;
+        }
+        return glyph;
+    }
+};
+
+struct Style {
+    FontSlot* font;
+    double size;
+    uint32_t color;
+
+    double LineHeight() const { return size * kLineSpacing; }
+};
+
+struct Glyph {
+    uint16_t id;
+    uint16_t width;    // thousandths of an em
+    uint8_t mark;      // highlight: 0 none, else severity + 1
+    bool space;
+};
+
+// Background and padding around a paragraph, drawn line by line so a box
+// can be split across pages without knowing its height in advance.
+struct Box {
+    double left = kMargin;
+    double width = kContentWidth;
+    double padding = 0.0;
+    uint32_t background = kNoColor;
+    // Bar along the left edge of the content area, as on flag cards.
+    uint32_t accent = kNoColor;
+};
+
+struct FlagSpan {
+    uint32_t start;
+    uint32_t end;
+    uint8_t severity;
+};
+
+// Severity of the strongest flag covering each UTF-16 offset, fed offsets
+// in increasing order.
+class MarkCursor {
+public:
+    explicit MarkCursor(std::vector<FlagSpan> spans) : spans_(std::move(spans)) {
+        std::sort(spans_.begin(), spans_.end(), [](const FlagSpan& a, const FlagSpan& b) { return a.start < b.start; });
+    }
+
+    uint8_t MarkAt(uint32_t offset) {
+        while (next_ < spans_.size() && spans_[next_].start <= offset) active_.push_back(spans_[next_++]);
+        active_.erase(std::remove_if(active_.begin(), active_.end(),
+                                     [offset](const FlagSpan& span) { return span.end <= offset; }),
+                      active_.end());
+        uint8_t mark = 0;
+        for (const auto& span : active_) {
+            const uint8_t candidate = static_cast<uint8_t>(kSeverityCount - span.severity);
+            if (candidate > mark) mark = candidate;
+        }
+        return static_cast<uint8_t>(mark == 0 ? 0 : kSeverityCount - mark + 1);
+    }
+
+private:
+    std::vector<FlagSpan> spans_;
+    std::vector<FlagSpan> active_;
+    size_t next_ = 0;
+};
+
+struct Chip {
+    std::string label;
+    std::string value;
+};
+
+class ReportLayout {
+public:
+    ReportLayout(PdfOutput& pdf, const ReportFonts& fonts) : pdf_(pdf) {
+        catalogObject_ = pdf_.Reserve();
+        pagesObject_ = pdf_.Reserve();
+        infoObject_ = pdf_.Reserve();
+        regular_.Init(fonts.regular, "F1", pdf_.Reserve());
+        bold_.Init(fonts.bold, "F2", pdf_.Reserve());
+        italic_.Init(fonts.italic ? fonts.italic : fonts.regular, "F3", pdf_.Reserve());
+        pdf_.Write("%PDF-1.7\n%\xE2\xE3\xCF\xD3\n");
+    }
+
+    void SetHeader(std::string_view documentName, std::string_view dateLabel, uint32_t wordCount) {
+        documentName_ = documentName;
+        dateLabel_ = dateLabel;
+        wordsLabel_ = std::to_string(wordCount) + " words";
+    }
+
+    Style Regular(double size, uint32_t color = kBlack) { return Style{&regular_, size, color}; }
+    Style Bold(double size, uint32_t color = kBlack) { return Style{&bold_, size, color}; }
+    Style Italic(double size, uint32_t color = kBlack) { return Style{&italic_, size, color}; }
+
+    void Heading(std::string_view text) {
+        const Style style = Bold(16);
+        // Keep a heading with at least two lines of what follows.
+        EnsureSpace(style.LineHeight() + 12 + 2 * 11 * kLineSpacing);
+        Paragraph(text, style, Box());
+        Gap(12);
+    }
+
+    void Gap(double height) { y_ -= height; }
+
+    // Flows |text| into lines of the box's width; '\n' starts a new line.
+    // With |marks|, characters inside flagged ranges are highlighted.
+    void Paragraph(std::string_view text, const Style& style, const Box& box, MarkCursor* marks = nullptr) {
+        EnsurePage();
+        const double lineHeight = style.LineHeight();
+        const double available = (box.width - 2 * box.padding) * 1000.0 / style.size;
+        if (box.padding > 0) {
+            EnsureSpace(box.padding + lineHeight);
+            Band(box, box.padding);
+            Gap(box.padding);
+        }
+
+        line_.clear();
+        double width = 0.0;
+        size_t breakAt = 0;
+        bool wrapped = false;
+        Utf8Cursor cursor(text);
+        uint32_t codepoint;
+        while (cursor.Next(codepoint)) {
+            if (codepoint == '\n') {
+                EmitLine(line_.size(), style, box);
+                line_.clear();
+                width = 0.0;
+                breakAt = 0;
+                wrapped = false;
+                continue;
+            }
+            if (codepoint == '\t') codepoint = ' ';
+            if (codepoint < 0x20 || codepoint == 0x7F) continue;
+            // A space that ended a wrapped line is not carried to the next.
+            if (codepoint == ' ' && wrapped && line_.empty()) continue;
+
+            const uint16_t glyph = style.font->Use(codepoint);
+            const auto advance = static_cast<uint16_t>(style.font->font->AdvanceWidth(glyph));
+            line_.push_back(Glyph{glyph, advance, marks ? marks->MarkAt(cursor.Utf16Offset()) : uint8_t{0},
+                                  codepoint == ' '});
+            width += advance;
+            if (codepoint == ' ') breakAt = line_.size();
+            if (width <= available || line_.size() == 1) continue;
+
+            // Break after the last space, or mid-word if there was none.
+            const size_t keep = breakAt > 0 ? breakAt : line_.size() - 1;
+            size_t shown = keep;
+            while (shown > 0 && line_[shown - 1].space) shown--;
+            EmitLine(shown, style, box);
+            line_.erase(line_.begin(), line_.begin() + static_cast<std::ptrdiff_t>(keep));
+            width = 0.0;
+            for (const auto& g : line_) width += g.width;
+            breakAt = 0;
+            wrapped = true;
+        }
+        if (!line_.empty() || !wrapped) EmitLine(line_.size(), style, box);
+
+        if (box.padding > 0) {
+            EnsureSpace(box.padding);
+            Band(box, box.padding);
+            Gap(box.padding);
+        }
+    }
+
+    // A row of labelled chips, wrapping onto further rows if needed.
+    void Chips(const std::vector<Chip>& chips, const Style& label, const Style& value,
+               const uint32_t* backgrounds, double spacing) {
+        EnsurePage();
+        const double padX = 8.0;
+        const double padY = 4.0;
+        const double height = std::max(label.LineHeight(), value.LineHeight()) + 2 * padY;
+        double x = kMargin;
+        EnsureSpace(height);
+        for (size_t i = 0; i < chips.size(); i++) {
+            const double labelWidth = Measure(chips[i].label, label);
+            const double valueWidth = Measure(chips[i].value, value);
+            const double chipWidth = labelWidth + valueWidth + 2 * padX;
+            if (x > kMargin && x + chipWidth > kMargin + kContentWidth) {
+                Gap(height + 4);
+                EnsureSpace(height);
+                x = kMargin;
+            }
+            FillRect(backgrounds[i], x, y_ - height, chipWidth, height);
+            const double baseline = Baseline(y_, height, std::max(label.size, value.size));
+            DrawText(chips[i].label, label, x + padX, baseline);
+            DrawText(chips[i].value, value, x + padX + labelWidth, baseline);
+            x += chipWidth + spacing;
+        }
+        Gap(height);
+    }
+
+    // One red flag: badge and confidence, quoted clause, explanation.
+    void FlagCard(uint8_t severity, uint8_t confidence, std::string_view clause, std::string_view explanation) {
+        const SeverityColors& colors = kSeverityColors[severity];
+        const Style badge = Bold(9, colors.strong);
+        const Style note = Regular(9, kGrey600);
+        const double rowHeight = badge.LineHeight() + 4;
+        const double inset = 12.0;
+        EnsureSpace(rowHeight + 8 + 3 * 10 * kLineSpacing);
+
+        Box edge;
+        edge.accent = colors.accent;
+        Band(edge, rowHeight);
+        std::string label = colors.label;
+        for (auto& ch : label) ch = static_cast<char>(ch >= 'a' && ch <= 'z' ? ch - 32 : ch);
+        const double badgeWidth = Measure(label, badge) + 16;
+        FillRect(colors.light, kMargin + inset, y_ - rowHeight, badgeWidth, rowHeight);
+        const double baseline = Baseline(y_, rowHeight, 9);
+        DrawText(label, badge, kMargin + inset + 8, baseline);
+        const std::string confidenceText = std::to_string(confidence) + "% confidence";
+        DrawText(confidenceText, note, kMargin + kContentWidth - Measure(confidenceText, note), baseline);
+        Gap(rowHeight);
+
+        Box spacer = edge;
+        EnsureSpace(8);
+        Band(spacer, 8);
+        Gap(8);
+
+        Box quote;
+        quote.left = kMargin + inset;
+        quote.width = kContentWidth - inset;
+        quote.padding = 8;
+        quote.background = kGrey100;
+        quote.accent = colors.accent;
+        Paragraph(clause, Italic(10), quote);
+
+        EnsureSpace(8);
+        Band(spacer, 8);
+        Gap(8);
+
+        Box body;
+        body.left = kMargin + inset;
+        body.width = kContentWidth - inset;
+        body.accent = colors.accent;
+        Paragraph(explanation, Regular(10), body);
+        Gap(12);
+    }
+
+    bool Finish(ReportWriteStats& stats) {
+        if (pageOpen_) FinishPage();
+
+        // Footer page totals are known only now.
+        const int total = static_cast<int>(pageObjects_.size());
+        const Style style = Regular(8, kGrey600);
+        for (int i = 0; i < total; i++) {
+            const std::string text = "Page " + std::to_string(i + 1) + " of " + std::to_string(total);
+            content_.clear();
+            DrawText(text, style, -Measure(text, style), 0.0);
+            pdf_.Stream(footerObjects_[static_cast<size_t>(i)],
+                        "/Type /XObject /Subtype /Form /BBox [-300 -4 0 12] /Resources << /Font << /F1 " +
+                            std::to_string(regular_.object) + " 0 R >> >>",
+                        content_);
+        }
+
+        WriteFont(regular_);
+        WriteFont(bold_);
+        WriteFont(italic_);
+
+        std::string kids;
+        for (uint32_t page : pageObjects_) kids += std::to_string(page) + " 0 R ";
+        pdf_.Object(pagesObject_, "<< /Type /Pages /Count " + std::to_string(total) + " /Kids [" + kids + "] >>");
+        pdf_.Object(catalogObject_, "<< /Type /Catalog /Pages " + std::to_string(pagesObject_) + " 0 R >>");
+        pdf_.Object(infoObject_, "<< /Title " + TextString(documentName_) +
+                                     " /Creator (LegalEase) /Producer (LegalEase) >>");
+        const bool ok = pdf_.Finish(catalogObject_, infoObject_);
+        stats.pages = total;
+        stats.bytes = pdf_.Position();
+        stats.peakPageBytes = peakPageBytes_;
+        return ok;
+    }
+
+private:
+    static constexpr double kHeaderHeight = 20 * 1.2 + 4 + 12 * 1.2 + 16;
+    static constexpr double kContentTop = kPageHeight - kMargin - kHeaderHeight - 16;
+    static constexpr double kFooterHeight = 8 * 1.2 + 16;
+    static constexpr double kContentBottom = kMargin + kFooterHeight + 12;
+
+    // Baseline that centres |size|-point text vertically in a band.
+    double Baseline(double top, double height, double size) const {
+        const TrueTypeFont& font = *regular_.font;
+        return top - height / 2 - (font.Ascent() + font.Descent()) / 2000.0 * size;
+    }
+
+    void EnsurePage() {
+        if (!pageOpen_) StartPage();
+    }
+
+    void EnsureSpace(double height) {
+        EnsurePage();
+        if (y_ - height < kContentBottom && y_ < kContentTop) {
+            FinishPage();
+            StartPage();
+        }
+    }
+
+    void StartPage() {
+        pageOpen_ = true;
+        content_.clear();
+        y_ = kContentTop;
+
+        const double top = kPageHeight - kMargin;
+        const Style title = Bold(20, kBlue800);
+        const Style small = Regular(10, kGrey600);
+        const double rightWidth = std::max(Measure(dateLabel_, small), Measure(wordsLabel_, small));
+        DrawText("LegalEase Analysis Report", title, kMargin, top - Ascent(title));
+        DrawFitted(documentName_.empty() ? "Document" : documentName_, Regular(12, kGrey600), kMargin,
+                   top - 20 * 1.2 - 4 - Ascent(Regular(12)), kContentWidth - rightWidth - 16);
+        DrawText(dateLabel_, small, kMargin + kContentWidth - Measure(dateLabel_, small), top - Ascent(small));
+        DrawText(wordsLabel_, small, kMargin + kContentWidth - Measure(wordsLabel_, small),
+                 top - 10 * 1.2 - Ascent(small));
+        HorizontalRule(top - kHeaderHeight);
+    }
+
+    void FinishPage() {
+        const Style small = Regular(8, kGrey600);
+        HorizontalRule(kMargin + kFooterHeight);
+        DrawText("Generated by LegalEase", small, kMargin, kMargin + 2);
+        char place[96];
+        std::snprintf(place, sizeof(place), "q 1 0 0 1 %.2f %.2f cm /Fp Do Q\n", kMargin + kContentWidth, kMargin + 2);
+        content_ += place;
+
+        const uint32_t contents = pdf_.Reserve();
+        pdf_.Stream(contents, "", content_);
+        peakPageBytes_ = std::max(peakPageBytes_, content_.size());
+        const uint32_t page = pdf_.Reserve();
+        const uint32_t footer = pdf_.Reserve();
+        char mediaBox[64];
+        std::snprintf(mediaBox, sizeof(mediaBox), "[0 0 %.2f %.2f]", kPageWidth, kPageHeight);
+        pdf_.Object(page, "<< /Type /Page /Parent " + std::to_string(pagesObject_) + " 0 R /MediaBox " + mediaBox +
+                              " /Resources << /Font << " + FontReference(regular_) + FontReference(bold_) +
+                              FontReference(italic_) + ">> /XObject << /Fp " + std::to_string(footer) +
+                              " 0 R >> >> /Contents " + std::to_string(contents) + " 0 R >>");
+        pageObjects_.push_back(page);
+        footerObjects_.push_back(footer);
+        pageOpen_ = false;
+    }
+
+    static std::string FontReference(const FontSlot& slot) {
+        return std::string("/") + slot.resource + " " + std::to_string(slot.object) + " 0 R ";
+    }
+
+    static double Ascent(const Style& style) { return style.font->font->Ascent() / 1000.0 * style.size; }
+
+    // Background band for the next |height| points of a box, plus its
+    // accent bar. Does not move the cursor.
+    void Band(const Box& box, double height) {
+        FillRect(box.background, box.left, y_ - height, box.width, height);
+        FillRect(box.accent, kMargin, y_ - height, 3, height);
+    }
+
+    void EmitLine(size_t count, const Style& style, const Box& box) {
+        const double lineHeight = style.LineHeight();
+        EnsureSpace(lineHeight);
+        FillRect(box.background, box.left, y_ - lineHeight, box.width, lineHeight);
+        FillRect(box.accent, kMargin, y_ - lineHeight, 3, lineHeight);
+
+        const double left = box.left + box.padding;
+        const double scale = style.size / 1000.0;
+        double x = left;
+        for (size_t i = 0; i < count;) {
+            size_t end = i;
+            double runWidth = 0.0;
+            while (end < count && line_[end].mark == line_[i].mark) runWidth += line_[end++].width * scale;
+            if (line_[i].mark != 0) FillRect(kSeverityColors[line_[i].mark - 1].light, x, y_ - lineHeight, runWidth, lineHeight);
+            x += runWidth;
+            i = end;
+        }
+        DrawGlyphs(line_.data(), count, style, left, Baseline(y_, lineHeight, style.size));
+        y_ -= lineHeight;
+    }
+
+    void DrawGlyphs(const Glyph* glyphs, size_t count, const Style& style, double x, double baseline) {
+        if (count == 0) return;
+        static const char kHex[] = "0123456789ABCDEF";
+        char prefix[160];
+        std::snprintf(prefix, sizeof(prefix), "BT /%s %.1f Tf %.3f %.3f %.3f rg %.2f %.2f Td <", style.font->resource,
+                      style.size, ((style.color >> 16) & 0xFF) / 255.0, ((style.color >> 8) & 0xFF) / 255.0,
+                      (style.color & 0xFF) / 255.0, x, baseline);
+        content_ += prefix;
+        for (size_t i = 0; i < count; i++) {
+            const uint16_t id = glyphs[i].id;
+            const char hex[4] = {kHex[id >> 12], kHex[(id >> 8) & 0xF], kHex[(id >> 4) & 0xF], kHex[id & 0xF]};
+            content_.append(hex, 4);
+        }
+        content_ += "> Tj ET\n";
+    }
+
+    void Shape(std::string_view text, const Style& style, std::vector<Glyph>& glyphs) {
+        glyphs.clear();
+        Utf8Cursor cursor(text);
+        uint32_t codepoint;
+        while (cursor.Next(codepoint)) {
+            if (codepoint < 0x20) continue;
+            const uint16_t glyph = style.font->Use(codepoint);
+            glyphs.push_back(Glyph{glyph, static_cast<uint16_t>(style.font->font->AdvanceWidth(glyph)), 0, codepoint == ' '});
+        }
+    }
+
+    double Measure(std::string_view text, const Style& style) {
+        double width = 0.0;
+        Utf8Cursor cursor(text);
+        uint32_t codepoint;
+        while (cursor.Next(codepoint)) {
+            if (codepoint >= 0x20) width += style.font->font->AdvanceWidth(style.font->font->GlyphFor(codepoint));
+        }
+        return width * style.size / 1000.0;
+    }
+
+    void DrawText(std::string_view text, const Style& style, double x, double baseline) {
+        Shape(text, style, scratch_);
+        DrawGlyphs(scratch_.data(), scratch_.size(), style, x, baseline);
+    }
+
+    // Draws |text| cut short with an ellipsis if it is wider than |maxWidth|.
+    void DrawFitted(std::string_view text, const Style& style, double x, double baseline, double maxWidth) {
+        Shape(text, style, scratch_);
+        const double limit = maxWidth * 1000.0 / style.size;
+        double width = 0.0;
+        for (const auto& g : scratch_) width += g.width;
+        if (width > limit) {
+            const uint16_t dot = style.font->Use('.');
+            const double dots = 3.0 * style.font->font->AdvanceWidth(dot);
+            while (!scratch_.empty() && width + dots > limit) {
+                width -= scratch_.back().width;
+                scratch_.pop_back();
+            }
+            for (int i = 0; i < 3; i++) scratch_.push_back(Glyph{dot, static_cast<uint16_t>(dots / 3), 0, false});
+        }
+        DrawGlyphs(scratch_.data(), scratch_.size(), style, x, baseline);
+    }
+
+    void FillRect(uint32_t color, double x, double y, double width, double height) {
+        if (color == kNoColor || width <= 0 || height <= 0) return;
+        char op[128];
+        std::snprintf(op, sizeof(op), "%.3f %.3f %.3f rg %.2f %.2f %.2f %.2f re f\n", ((color >> 16) & 0xFF) / 255.0,
+                      ((color >> 8) & 0xFF) / 255.0, (color & 0xFF) / 255.0, x, y, width, height);
+        content_ += op;
+    }
+
+    void HorizontalRule(double y) {
+        char op[128];
+        std::snprintf(op, sizeof(op), "%.3f %.3f %.3f RG 1 w %.2f %.2f m %.2f %.2f l S\n", ((kGrey300 >> 16) & 0xFF) / 255.0,
+                      ((kGrey300 >> 8) & 0xFF) / 255.0, (kGrey300 & 0xFF) / 255.0, kMargin, y, kMargin + kContentWidth, y);
+        content_ += op;
+    }
+
+    // PDF text string in UTF-16BE, as document information entries expect.
+    static std::string TextString(std::string_view text) {
+        static const char kHex[] = "0123456789ABCDEF";
+        std::string out = "<FEFF";
+        Utf8Cursor cursor(text);
+        uint32_t codepoint;
+        auto unit = [&out](uint32_t value) {
+            for (int shift = 12; shift >= 0; shift -= 4) out.push_back(kHex[(value >> shift) & 0xF]);
+        };
+        while (cursor.Next(codepoint)) {
+            if (codepoint >= 0x10000) {
+                unit(0xD800 + ((codepoint - 0x10000) >> 10));
+                unit(0xDC00 + ((codepoint - 0x10000) & 0x3FF));
+            } else {
+                unit(codepoint);
+            }
+        }
+        return out + ">";
+    }
+
+    void WriteFont(FontSlot& slot) {
+        const TrueTypeFont& font = *slot.font;
+        std::string program;
+        if (!font.Subset(slot.used, program)) program.clear();
+
+        // Subset tag: six letters derived from the glyphs kept.
+        uint32_t hash = 2166136261u;
+        for (size_t glyph = 0; glyph < slot.used.size(); glyph++) {
+            if (slot.used[glyph]) hash = (hash ^ static_cast<uint32_t>(glyph)) * 16777619u;
+        }
+        std::string name;
+        for (int i = 0; i < 6; i++) {
+            name.push_back(static_cast<char>('A' + hash % 26));
+            hash /= 26;
+        }
+        name += "+" + font.PostScriptName();
+
+        const uint32_t descendant = pdf_.Reserve();
+        const uint32_t descriptor = pdf_.Reserve();
+        const uint32_t file = pdf_.Reserve();
+        const uint32_t toUnicode = pdf_.Reserve();
+
+        pdf_.Object(slot.object, "<< /Type /Font /Subtype /Type0 /BaseFont /" + name +
+                                     " /Encoding /Identity-H /DescendantFonts [" + std::to_string(descendant) +
+                                     " 0 R] /ToUnicode " + std::to_string(toUnicode) + " 0 R >>");
+
+        std::string widths;
+        for (size_t glyph = 0; glyph < slot.used.size();) {
+            if (!slot.used[glyph]) {
+                glyph++;
+                continue;
+            }
+            widths += std::to_string(glyph) + " [";
+            while (glyph < slot.used.size() && slot.used[glyph]) {
+                widths += std::to_string(font.AdvanceWidth(static_cast<uint16_t>(glyph))) + " ";
+                glyph++;
+            }
+            widths += "] ";
+        }
+        pdf_.Object(descendant, "<< /Type /Font /Subtype /CIDFontType2 /BaseFont /" + name +
+                                    " /CIDSystemInfo << /Registry (Adobe) /Ordering (Identity) /Supplement 0 >>"
+                                    " /FontDescriptor " + std::to_string(descriptor) +
+                                    " 0 R /CIDToGIDMap /Identity /DW 1000 /W [" + widths + "] >>");
+
+        // Nonsymbolic, plus fixed pitch and italic where they apply.
+        int flags = 32;
+        if (font.IsFixedPitch()) flags |= 1;
+        if (font.ItalicAngle() != 0.0) flags |= 64;
+        char metrics[256];
+        std::snprintf(metrics, sizeof(metrics),
+                      " /Flags %d /FontBBox [%d %d %d %d] /ItalicAngle %.1f /Ascent %d /Descent %d /CapHeight %d"
+                      " /StemV %d",
+                      flags, font.BoundingBox(0), font.BoundingBox(1), font.BoundingBox(2), font.BoundingBox(3),
+                      font.ItalicAngle(), font.Ascent(), font.Descent(), font.CapHeight(), font.IsBold() ? 120 : 80);
+        pdf_.Object(descriptor, "<< /Type /FontDescriptor /FontName /" + name + metrics + " /FontFile2 " +
+                                    std::to_string(file) + " 0 R >>");
+        pdf_.Stream(file, "/Length1 " + std::to_string(program.size()), program);
+
+        static const char kHex[] = "0123456789ABCDEF";
+        auto hex16 = [](std::string& out, uint32_t value) {
+            for (int shift = 12; shift >= 0; shift -= 4) out.push_back(kHex[(value >> shift) & 0xF]);
+        };
+        std::string cmap =
+            "/CIDInit /ProcSet findresource begin\n12 dict begin\nbegincmap\n"
+            "/CIDSystemInfo << /Registry (Adobe) /Ordering (UCS) /Supplement 0 >> def\n"
+            "/CMapName /Adobe-Identity-UCS def\n/CMapType 2 def\n"
+            "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n";
+        std::vector<uint16_t> mapped;
+        for (size_t glyph = 1; glyph < slot.used.size(); glyph++) {
+            if (slot.used[glyph] && slot.unicode[glyph] != 0) mapped.push_back(static_cast<uint16_t>(glyph));
+        }
+        for (size_t i = 0; i < mapped.size(); i += 100) {
+            const size_t count = std::min<size_t>(100, mapped.size() - i);
+            cmap += std::to_string(count) + " beginbfchar\n";
+            for (size_t j = i; j < i + count; j++) {
+                const uint32_t codepoint = slot.unicode[mapped[j]];
+                cmap += "<";
+                hex16(cmap, mapped[j]);
+                cmap += "> <";
+                if (codepoint >= 0x10000) {
+                    hex16(cmap, 0xD800 + ((codepoint - 0x10000) >> 10));
+                    hex16(cmap, 0xDC00 + ((codepoint - 0x10000) & 0x3FF));
+                } else {
+                    hex16(cmap, codepoint);
+                }
+                cmap += ">\n";
+            }
+            cmap += "endbfchar\n";
+        }
+        cmap += "endcmap\nCMapName currentdict /CMap defineresource pop\nend\nend\n";
+        pdf_.Stream(toUnicode, "", cmap);
+    }
+
+    PdfOutput& pdf_;
+    FontSlot regular_;
+    FontSlot bold_;
+    FontSlot italic_;
+    uint32_t catalogObject_ = 0;
+    uint32_t pagesObject_ = 0;
+    uint32_t infoObject_ = 0;
+    std::string documentName_;
+    std::string dateLabel_;
+    std::string wordsLabel_;
+
+    bool pageOpen_ = false;
+    double y_ = 0.0;
+    std::string content_;
+    size_t peakPageBytes_ = 0;
+    std::vector<Glyph> line_;
+    std::vector<Glyph> scratch_;
+    std::vector<uint32_t> pageObjects_;
+    std::vector<uint32_t> footerObjects_;
+};
+
+}  // namespace
+
+bool WriteAnalysisReport(const uint8_t* report, size_t size, const ReportFonts& fonts,
+                         std::FILE* out, ReportWriteStats& stats) {
+    if (!report || !out || !fonts.regular || !fonts.bold || !fonts.regular->IsLoaded() || !fonts.bold->IsLoaded() ||
+        (fonts.italic && !fonts.italic->IsLoaded())) {
+        return false;
+    }
+
+    ReportReader reader(report, size);
+    if (!reader.Magic("LERP") || reader.U16() != 1) return false;
+    const std::string_view documentName = reader.String();
+    const std::string_view dateLabel = reader.String();
+    const uint32_t wordCount = reader.U32();
+    const std::string_view typeName = reader.String();
+    const uint8_t confidence = reader.U8();
+    const std::string_view summary = reader.String();
+    const std::string_view translation = reader.String();
+    const uint32_t flagCount = reader.U32();
+    if (!reader.ok()) return false;
+
+    // Flags are read twice, for the list and for highlighting the source,
+    // so note where they start instead of copying them.
+    const ReportReader flagsStart = reader;
+    std::vector<FlagSpan> spans;
+    int severityCounts[kSeverityCount] = {0, 0, 0};
+    for (uint32_t i = 0; i < flagCount && reader.ok(); i++) {
+        const uint8_t severity = reader.U8();
+        reader.U8();
+        const uint32_t start = reader.U32();
+        const uint32_t end = reader.U32();
+        reader.String();
+        reader.String();
+        if (severity >= kSeverityCount) return false;
+        severityCounts[severity]++;
+        if (end > start) spans.push_back(FlagSpan{start, end, severity});
+    }
+    const std::string_view sourceText = reader.String();
+    if (!reader.ok()) return false;
+
+    PdfOutput pdf(out);
+    ReportLayout layout(pdf, fonts);
+    layout.SetHeader(documentName, dateLabel, wordCount);
+
+    layout.Heading("Document Summary");
+    Box summaryBox;
+    summaryBox.padding = 12;
+    summaryBox.background = kGrey100;
+    layout.Paragraph(summary.empty() ? "No summary available." : summary, layout.Regular(11), summaryBox);
+    layout.Gap(16);
+    const uint32_t infoBackgrounds[] = {kBlue50, kBlue50, kBlue50};
+    layout.Chips({{"Type: ", std::string(typeName)},
+                  {"Red Flags: ", std::to_string(flagCount)},
+                  {"Confidence: ", std::to_string(confidence) + "%"}},
+                 layout.Regular(9, kGrey700), layout.Bold(9), infoBackgrounds, 8);
+    layout.Gap(20);
+
+    layout.Heading("Red Flags Analysis");
+    if (flagCount == 0) {
+        Box clear;
+        clear.padding = 12;
+        clear.background = kGreen50;
+        layout.Paragraph("No red flags detected in this document.", layout.Regular(11), clear);
+    } else {
+        std::vector<Chip> counts;
+        uint32_t countBackgrounds[kSeverityCount];
+        for (int s = 0; s < kSeverityCount; s++) {
+            counts.push_back({std::to_string(severityCounts[s]) + " ", kSeverityColors[s].label});
+            countBackgrounds[s] = kSeverityColors[s].lightest;
+        }
+        layout.Chips(counts, layout.Bold(11), layout.Regular(10, kGrey700), countBackgrounds, 16);
+        layout.Gap(16);
+        ReportReader flags = flagsStart;
+        for (uint32_t i = 0; i < flagCount; i++) {
+            const uint8_t severity = flags.U8();
+            const uint8_t flagConfidence = flags.U8();
+            flags.U32();
+            flags.U32();
+            const std::string_view clause = flags.String();
+            const std::string_view explanation = flags.String();
+            layout.FlagCard(severity, flagConfidence, clause, explanation);
+        }
+    }
+    layout.Gap(20);
+
+    layout.Heading("Plain English Translation");
+    Box translationBox;
+    translationBox.padding = 12;
+    translationBox.background = kGrey50;
+    layout.Paragraph(translation.empty() ? "Translation not available." : translation, layout.Regular(11),
+                     translationBox);
+
+    if (!sourceText.empty()) {
+        layout.Gap(20);
+        layout.Heading("Annotated Source Text");
+        std::vector<Chip> legend;
+        uint32_t legendBackgrounds[kSeverityCount];
+        for (int s = 0; s < kSeverityCount; s++) {
+            legend.push_back({"", kSeverityColors[s].label});
+            legendBackgrounds[s] = kSeverityColors[s].light;
+        }
+        layout.Chips(legend, layout.Regular(9), layout.Regular(9), legendBackgrounds, 8);
+        layout.Gap(12);
+        MarkCursor marks(std::move(spans));
+        layout.Paragraph(sourceText, layout.Regular(10), Box(), &marks);
+    }
+
+    return layout.Finish(stats);
+}
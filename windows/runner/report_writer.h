@@ -0,0 +1,47 @@
+#ifndef RUNNER_REPORT_WRITER_H_
+#define RUNNER_REPORT_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "truetype_font.h"
+
+// Fonts the report is set in; |italic| may be null, falling back to
+// |regular|.
+struct ReportFonts {
+    const TrueTypeFont* regular = nullptr;
+    const TrueTypeFont* bold = nullptr;
+    const TrueTypeFont* italic = nullptr;
+};
+
+struct ReportWriteStats {
+    int pages = 0;
+    uint64_t bytes = 0;
+    // Largest single page content stream: apart from the fonts and one
+    // cross-reference offset per object, all the writer keeps in memory.
+    size_t peakPageBytes = 0;
+};
+
+// Lays out an analysis report and writes it to |out| as a PDF, one page at
+// a time: each page is written as soon as it is full, and the font subsets,
+// page tree and cross-reference table follow at the end. Memory use does
+// not grow with the length of the report.
+//
+// |report| is the buffer encoded by the app's AnalysisReportBuffer, little
+// endian, with strings as a uint32 byte length followed by UTF-8:
+//   "LERP", uint16 version (1)
+//   string documentName, string dateLabel, uint32 wordCount,
+//   string typeName, uint8 confidencePercent, string summary,
+//   string translation
+//   uint32 flagCount, then per flag: uint8 severity (0 critical, 1 warning,
+//     2 info), uint8 confidencePercent, uint32 start, uint32 end (UTF-16
+//     offsets into the source text), string clause, string explanation
+//   string sourceText, empty to leave out the annotated source section
+//
+// Returns false if the buffer is malformed, a font is missing or writing
+// fails; |out| then holds a partial file.
+bool WriteAnalysisReport(const uint8_t* report, size_t size, const ReportFonts& fonts,
+                         std::FILE* out, ReportWriteStats& stats);
+
+#endif
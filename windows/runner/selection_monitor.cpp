@@ -0,0 +1,320 @@
+#include "selection_monitor.h"
+
+#include <chrono>
+#include <climits>
+#include <utility>
+
+namespace {
+
+// Longest selection read in one call; larger selections are truncated but
+// still report their true start and end offsets.
+constexpr int kMaxSelectionChars = 16384;
+constexpr int kMaxSelectionRanges = 16;
+// Longest distance from the last measured point that is read to find a new
+// offset; beyond it the offset is counted from the document start again.
+constexpr int kMaxOffsetGapChars = 16384;
+
+int64_t NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Counts characters between the document start and |endpoint| of |range|
+// by moving a clone's endpoint, which avoids transferring the text itself
+// but takes time linear in the offset.
+int OffsetFromDocumentStart(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint) {
+    IUIAutomationTextRange* probe = nullptr;
+    if (FAILED(range->Clone(&probe)) || !probe) return 0;
+
+    probe->MoveEndpointByRange(
+        endpoint == TextPatternRangeEndpoint_Start ? TextPatternRangeEndpoint_End : TextPatternRangeEndpoint_Start,
+        range, endpoint);
+    int moved = 0;
+    probe->MoveEndpointByUnit(TextPatternRangeEndpoint_Start, TextUnit_Character, INT_MIN + 1, &moved);
+    probe->Release();
+    return -moved;
+}
+
+}  // namespace
+
+class SelectionEventHandler : public IUIAutomationEventHandler, public IUIAutomationFocusChangedEventHandler {
+public:
+    explicit SelectionEventHandler(SelectionMonitor* owner) : refs_(1), owner_(owner) {}
+
+    ULONG STDMETHODCALLTYPE AddRef() override {
+        return InterlockedIncrement(&refs_);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG refs = InterlockedDecrement(&refs_);
+        if (refs == 0) delete this;
+        return refs;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IUIAutomationEventHandler)) {
+            *object = static_cast<IUIAutomationEventHandler*>(this);
+        } else if (riid == __uuidof(IUIAutomationFocusChangedEventHandler)) {
+            *object = static_cast<IUIAutomationFocusChangedEventHandler*>(this);
+        } else {
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        AddRef();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE HandleAutomationEvent(IUIAutomationElement* sender, EVENTID eventId) override {
+        if (eventId == UIA_Text_TextSelectionChangedEventId) {
+            owner_->OnSelectionChanged();
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE HandleFocusChangedEvent(IUIAutomationElement* sender) override {
+        owner_->OnFocusChanged();
+        return S_OK;
+    }
+
+private:
+    LONG refs_;
+    SelectionMonitor* owner_;
+};
+
+SelectionMonitor::SelectionMonitor(Callback callback) : callback_(std::move(callback)) {}
+
+SelectionMonitor::~SelectionMonitor() {
+    Stop();
+}
+
+bool SelectionMonitor::Start() {
+    if (thread_.joinable()) return true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = false;
+        focusChanged_ = true;
+    }
+    thread_ = std::thread(&SelectionMonitor::ThreadMain, this);
+    return true;
+}
+
+void SelectionMonitor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void SelectionMonitor::OnSelectionChanged() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        debouncer_.Notify(NowMicros());
+    }
+    wake_.notify_all();
+}
+
+void SelectionMonitor::OnFocusChanged() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        focusChanged_ = true;
+    }
+    wake_.notify_all();
+}
+
+void SelectionMonitor::ThreadMain() {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    const bool comInitialized = SUCCEEDED(hr);
+
+    hr = CoCreateInstance(__uuidof(CUIAutomation), nullptr, CLSCTX_INPROC_SERVER,
+                          __uuidof(IUIAutomation), reinterpret_cast<void**>(&automation_));
+    if (SUCCEEDED(hr) && automation_) {
+        handler_ = new SelectionEventHandler(this);
+        automation_->AddFocusChangedEventHandler(nullptr, handler_);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (focusChanged_) {
+                focusChanged_ = false;
+                lock.unlock();
+                AttachToFocusedElement();
+                lock.lock();
+                continue;
+            }
+
+            if (!debouncer_.IsPending()) {
+                wake_.wait(lock);
+                continue;
+            }
+
+            const int64_t now = NowMicros();
+            if (!debouncer_.IsDue(now)) {
+                wake_.wait_for(lock, std::chrono::microseconds(debouncer_.Deadline() - now));
+                continue;
+            }
+
+            debouncer_.Consume();
+            lock.unlock();
+            std::vector<SelectionRange> ranges;
+            const bool read = ReadSelection(ranges);
+            SelectionRange merged = MergeSelectionRanges(std::move(ranges));
+            lock.lock();
+
+            if (read && debouncer_.ShouldDeliver(merged) && callback_) {
+                lock.unlock();
+                callback_(merged.text, merged.start, merged.end);
+                lock.lock();
+            }
+        }
+        lock.unlock();
+
+        automation_->RemoveAllEventHandlers();
+        DetachFromElement();
+        handler_->Release();
+        handler_ = nullptr;
+        automation_->Release();
+        automation_ = nullptr;
+    }
+
+    if (comInitialized) {
+        CoUninitialize();
+    }
+}
+
+void SelectionMonitor::DetachFromElement() {
+    ClearAnchor();
+    if (!element_) return;
+    automation_->RemoveAutomationEventHandler(UIA_Text_TextSelectionChangedEventId, element_, handler_);
+    element_->Release();
+    element_ = nullptr;
+}
+
+void SelectionMonitor::AttachToFocusedElement() {
+    DetachFromElement();
+
+    IUIAutomationElement* focused = nullptr;
+    HRESULT hr = automation_->GetFocusedElement(&focused);
+    if (FAILED(hr) || !focused) return;
+
+    // Selections inside our own windows (including the overlay) are handled
+    // by Flutter and must not be echoed back.
+    int processId = 0;
+    focused->get_CurrentProcessId(&processId);
+    if (static_cast<DWORD>(processId) == GetCurrentProcessId()) {
+        focused->Release();
+        return;
+    }
+
+    hr = automation_->AddAutomationEventHandler(
+        UIA_Text_TextSelectionChangedEventId, focused, TreeScope_Element, nullptr, handler_);
+    if (FAILED(hr)) {
+        focused->Release();
+        return;
+    }
+    element_ = focused;
+}
+
+bool SelectionMonitor::ReadSelection(std::vector<SelectionRange>& ranges) {
+    if (!element_) return false;
+
+    IUIAutomationTextPattern* textPattern = nullptr;
+    HRESULT hr = element_->GetCurrentPatternAs(UIA_TextPatternId, __uuidof(IUIAutomationTextPattern),
+                                               reinterpret_cast<void**>(&textPattern));
+    if (FAILED(hr) || !textPattern) return false;
+
+    IUIAutomationTextRangeArray* selection = nullptr;
+    hr = textPattern->GetSelection(&selection);
+    textPattern->Release();
+    if (FAILED(hr) || !selection) return false;
+
+    int length = 0;
+    selection->get_Length(&length);
+    for (int i = 0; i < length && i < kMaxSelectionRanges; i++) {
+        IUIAutomationTextRange* range = nullptr;
+        if (FAILED(selection->GetElement(i, &range)) || !range) continue;
+
+        SelectionRange item;
+        BSTR text = nullptr;
+        if (SUCCEEDED(range->GetText(kMaxSelectionChars, &text)) && text) {
+            item.text.assign(text, SysStringLen(text));
+            SysFreeString(text);
+        }
+        item.start = MeasureOffset(range, TextPatternRangeEndpoint_Start);
+        if (static_cast<int>(item.text.size()) < kMaxSelectionChars) {
+            item.end = item.start + static_cast<int>(item.text.size());
+        } else {
+            item.end = OffsetFromDocumentStart(range, TextPatternRangeEndpoint_End);
+        }
+        ranges.push_back(std::move(item));
+        range->Release();
+    }
+    selection->Release();
+    return true;
+}
+
+// Offsets are measured from the last selection start rather than the
+// document start, so a drag whose start stays put costs one comparison and
+// a selection that moved costs a read of the text in between. Counting from
+// the document start is left for the first selection in an element and for
+// jumps too far to read.
+int SelectionMonitor::MeasureOffset(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint) {
+    if (anchor_) {
+        int order = 0;
+        if (SUCCEEDED(anchor_->CompareEndpoints(TextPatternRangeEndpoint_Start, range, endpoint, &order))) {
+            if (order == 0) return anchorOffset_;
+            int gap = 0;
+            if (MeasureGap(range, endpoint, order < 0, gap)) {
+                const int offset = order < 0 ? anchorOffset_ + gap : anchorOffset_ - gap;
+                MoveAnchor(range, endpoint, offset);
+                return offset;
+            }
+        }
+    }
+    const int offset = OffsetFromDocumentStart(range, endpoint);
+    MoveAnchor(range, endpoint, offset);
+    return offset;
+}
+
+// Reads the text between the anchor and |endpoint| of |range|, which lies
+// after the anchor if |forward|, and returns its length in |gap|.
+bool SelectionMonitor::MeasureGap(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint, bool forward,
+                                  int& gap) {
+    IUIAutomationTextRange* between = nullptr;
+    if (FAILED(anchor_->Clone(&between)) || !between) return false;
+    HRESULT hr = between->MoveEndpointByRange(
+        forward ? TextPatternRangeEndpoint_End : TextPatternRangeEndpoint_Start, range, endpoint);
+
+    BSTR text = nullptr;
+    if (SUCCEEDED(hr)) hr = between->GetText(kMaxOffsetGapChars + 1, &text);
+    between->Release();
+    if (FAILED(hr)) return false;
+
+    const int length = text ? static_cast<int>(SysStringLen(text)) : 0;
+    if (text) SysFreeString(text);
+    if (length > kMaxOffsetGapChars) return false;
+    gap = length;
+    return true;
+}
+
+void SelectionMonitor::MoveAnchor(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint, int offset) {
+    ClearAnchor();
+    IUIAutomationTextRange* anchor = nullptr;
+    if (FAILED(range->Clone(&anchor)) || !anchor) return;
+    if (FAILED(anchor->MoveEndpointByRange(TextPatternRangeEndpoint_Start, range, endpoint)) ||
+        FAILED(anchor->MoveEndpointByRange(TextPatternRangeEndpoint_End, range, endpoint))) {
+        anchor->Release();
+        return;
+    }
+    anchor_ = anchor;
+    anchorOffset_ = offset;
+}
+
+void SelectionMonitor::ClearAnchor() {
+    if (anchor_) {
+        anchor_->Release();
+        anchor_ = nullptr;
+    }
+}
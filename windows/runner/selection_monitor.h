@@ -0,0 +1,68 @@
+#ifndef RUNNER_SELECTION_MONITOR_H_
+#define RUNNER_SELECTION_MONITOR_H_
+
+#include <windows.h>
+#include <objbase.h>
+#include <UIAutomation.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "selection_tracker.h"
+
+class SelectionEventHandler;
+
+// Tracks the text selection of whichever element has keyboard focus in
+// another application. Runs on its own MTA thread: UIA event callbacks only
+// flag work, and the selection is read there once the debouncer says the
+// drag burst is over or a frame's worth of time has passed.
+class SelectionMonitor {
+public:
+    using Callback = std::function<void(const std::wstring& text, int start, int end)>;
+
+    explicit SelectionMonitor(Callback callback);
+    ~SelectionMonitor();
+
+    SelectionMonitor(const SelectionMonitor&) = delete;
+    SelectionMonitor& operator=(const SelectionMonitor&) = delete;
+
+    bool Start();
+    void Stop();
+    bool IsRunning() const { return thread_.joinable(); }
+
+private:
+    friend class SelectionEventHandler;
+
+    void OnSelectionChanged();
+    void OnFocusChanged();
+
+    void ThreadMain();
+    void AttachToFocusedElement();
+    void DetachFromElement();
+    bool ReadSelection(std::vector<SelectionRange>& ranges);
+    int MeasureOffset(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint);
+    bool MeasureGap(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint, bool forward, int& gap);
+    void MoveAnchor(IUIAutomationTextRange* range, TextPatternRangeEndpoint endpoint, int offset);
+    void ClearAnchor();
+
+    Callback callback_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    bool focusChanged_ = false;
+    SelectionDebouncer debouncer_;
+
+    // Owned by the monitor thread.
+    IUIAutomation* automation_ = nullptr;
+    IUIAutomationElement* element_ = nullptr;
+    SelectionEventHandler* handler_ = nullptr;
+    // Empty range at the last selection start measured in element_'s
+    // document, and its offset from the document start.
+    IUIAutomationTextRange* anchor_ = nullptr;
+    int anchorOffset_ = 0;
+};
+
+#endif
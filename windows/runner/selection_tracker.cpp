@@ -0,0 +1,73 @@
+#include "selection_tracker.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+uint64_t HashText(const std::wstring& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (wchar_t ch : text) {
+        hash ^= static_cast<uint64_t>(ch);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}  // namespace
+
+SelectionRange MergeSelectionRanges(std::vector<SelectionRange> ranges) {
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+                                [](const SelectionRange& r) { return r.end <= r.start; }),
+                 ranges.end());
+    if (ranges.empty()) return SelectionRange();
+    if (ranges.size() == 1) return std::move(ranges.front());
+
+    std::sort(ranges.begin(), ranges.end(), [](const SelectionRange& a, const SelectionRange& b) {
+        return a.start < b.start || (a.start == b.start && a.end > b.end);
+    });
+
+    SelectionRange merged = std::move(ranges.front());
+    for (size_t i = 1; i < ranges.size(); i++) {
+        SelectionRange& next = ranges[i];
+        if (next.end <= merged.end) continue;
+
+        if (next.start > merged.end) {
+            merged.text += L"\n";
+            merged.text += next.text;
+        } else {
+            const size_t overlap = std::min(static_cast<size_t>(merged.end - next.start), next.text.size());
+            merged.text.append(next.text, overlap, std::wstring::npos);
+        }
+        merged.end = next.end;
+    }
+    return merged;
+}
+
+SelectionDebouncer::SelectionDebouncer(int64_t quietMicros, int64_t maxDelayMicros)
+    : quietMicros_(quietMicros), maxDelayMicros_(maxDelayMicros) {}
+
+void SelectionDebouncer::Notify(int64_t nowMicros) {
+    if (!pending_) {
+        pending_ = true;
+        firstNotify_ = nowMicros;
+    }
+    lastNotify_ = nowMicros;
+}
+
+int64_t SelectionDebouncer::Deadline() const {
+    return std::min(lastNotify_ + quietMicros_, firstNotify_ + maxDelayMicros_);
+}
+
+void SelectionDebouncer::Consume() {
+    pending_ = false;
+}
+
+bool SelectionDebouncer::ShouldDeliver(const SelectionRange& range) {
+    const uint64_t hash = HashText(range.text);
+    const bool same = range.start == lastStart_ && range.end == lastEnd_ && hash == lastTextHash_;
+    lastStart_ = range.start;
+    lastEnd_ = range.end;
+    lastTextHash_ = hash;
+    return !same && !range.text.empty();
+}
@@ -0,0 +1,53 @@
+#ifndef RUNNER_SELECTION_TRACKER_H_
+#define RUNNER_SELECTION_TRACKER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A selected text range in character offsets from the start of the focused
+// document. |text| may be shorter than |end - start| when the read was capped.
+struct SelectionRange {
+    int start = 0;
+    int end = 0;
+    std::wstring text;
+};
+
+// Collapses a multi-range selection into one range covering all of it.
+// Overlapping ranges share text only once; disjoint ranges are joined with a
+// newline. Empty input yields an empty range.
+SelectionRange MergeSelectionRanges(std::vector<SelectionRange> ranges);
+
+// Debounce state for selection-changed notifications, driven by an external
+// microsecond clock. A drag produces a burst of notifications; the selection
+// is read once the burst has been quiet for |quietMicros|, but never later
+// than |maxDelayMicros| after the first notification of the burst, so a long
+// drag still updates at least once per frame.
+class SelectionDebouncer {
+public:
+    explicit SelectionDebouncer(int64_t quietMicros = 4000, int64_t maxDelayMicros = 16000);
+
+    void Notify(int64_t nowMicros);
+    bool IsPending() const { return pending_; }
+    int64_t Deadline() const;
+    bool IsDue(int64_t nowMicros) const { return pending_ && nowMicros >= Deadline(); }
+
+    // Marks the pending burst as consumed; call just before reading.
+    void Consume();
+
+    // Returns true if |range| differs from the last delivered selection and
+    // records it. Empty selections are recorded but never delivered.
+    bool ShouldDeliver(const SelectionRange& range);
+
+private:
+    int64_t quietMicros_;
+    int64_t maxDelayMicros_;
+    bool pending_ = false;
+    int64_t firstNotify_ = 0;
+    int64_t lastNotify_ = 0;
+    int lastStart_ = -1;
+    int lastEnd_ = -1;
+    uint64_t lastTextHash_ = 0;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "startup_trace.h"
+
+#include <cstdio>
+
+StartupTrace& StartupTrace::Instance() {
+    static StartupTrace trace;
+    return trace;
+}
+
+StartupTrace::StartupTrace() : origin_(std::chrono::steady_clock::now()) {}
+
+void StartupTrace::Mark(const std::string& name) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    MarkAt(name, now);
+}
+
+void StartupTrace::MarkAt(const std::string& name, int64_t steadyMicros) {
+    const int64_t origin = std::chrono::duration_cast<std::chrono::microseconds>(
+        origin_.time_since_epoch()).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const StartupMark& mark : marks_) {
+        if (mark.name == name) return;
+    }
+    marks_.push_back({name, steadyMicros - origin});
+}
+
+std::vector<StartupMark> StartupTrace::Marks() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return marks_;
+}
+
+std::string StartupTrace::Format() const {
+    std::string line;
+    for (const StartupMark& mark : Marks()) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "=+%.1fms", static_cast<double>(mark.micros) / 1000.0);
+        if (!line.empty()) line += ' ';
+        line += mark.name;
+        line += buffer;
+    }
+    return line;
+}
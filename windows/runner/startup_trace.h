@@ -0,0 +1,41 @@
+#ifndef RUNNER_STARTUP_TRACE_H_
+#define RUNNER_STARTUP_TRACE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct StartupMark {
+    std::string name;
+    // Microseconds since the trace's origin.
+    int64_t micros = 0;
+};
+
+// Process-wide record of start-up milestones for measuring cold start. The
+// origin is the first call to Instance(), which main() makes first thing.
+// Only the first mark of each name is kept, so marks in code that can run
+// more than once are harmless.
+class StartupTrace {
+public:
+    static StartupTrace& Instance();
+
+    void Mark(const std::string& name);
+    // Records a mark at an absolute steady-clock time in microseconds, for
+    // events timed on another thread.
+    void MarkAt(const std::string& name, int64_t steadyMicros);
+
+    std::vector<StartupMark> Marks() const;
+    // Single-line summary, e.g. "main=+0.0ms first_frame=+412.3ms".
+    std::string Format() const;
+
+private:
+    StartupTrace();
+
+    std::chrono::steady_clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::vector<StartupMark> marks_;
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "clipboard_filter.h"
+
+#include <string>
+
+#include "test_util.h"
+
+namespace {
+
+const std::wstring kTerms = L"Please read our Terms and Conditions before continuing.";
+const std::wstring kPrivacy = L"See the Privacy Policy for how we use your data.";
+const std::wstring kRecipe = L"Two eggs, a cup of flour and a pinch of salt.";
+
+ClipboardVerdict Process(ClipboardFilter& filter, const std::wstring& text, int64_t nowMicros,
+                         ClipboardCapture& capture) {
+    return filter.Process(text.data(), text.size(), nowMicros, capture);
+}
+
+ClipboardVerdict Process(ClipboardFilter& filter, const std::wstring& text, int64_t nowMicros) {
+    ClipboardCapture capture;
+    return Process(filter, text, nowMicros, capture);
+}
+
+}  // namespace
+
+TEST(EmptyAndNonLegalCopiesAreRejected) {
+    ClipboardFilter filter;
+    ClipboardCapture capture;
+    CHECK(filter.Process(nullptr, 0, 0, capture) == ClipboardVerdict::kEmpty);
+    CHECK(filter.Process(kTerms.data(), 0, 0, capture) == ClipboardVerdict::kEmpty);
+    CHECK(Process(filter, kRecipe, 0) == ClipboardVerdict::kNotLegal);
+
+    REQUIRE(Process(filter, kTerms, 0, capture) == ClipboardVerdict::kAccepted);
+    CHECK(capture.text == kTerms);
+    CHECK(capture.originalLength == kTerms.size());
+    CHECK(!capture.truncated);
+    CHECK((capture.categories & kKeywordCategoryTerms) != 0);
+    CHECK(capture.hash == HashClipboardText(kTerms.data(), kTerms.size()));
+}
+
+TEST(OnlyARepeatOfTheLastAcceptedCopyIsADuplicate) {
+    ClipboardFilterOptions options;
+    options.duplicateWindowMicros = 1000;
+    ClipboardFilter filter(options);
+
+    CHECK(Process(filter, kTerms, 0) == ClipboardVerdict::kAccepted);
+    CHECK(Process(filter, kTerms, 10) == ClipboardVerdict::kDuplicate);
+    // Each repeat restarts the window.
+    CHECK(Process(filter, kTerms, 900) == ClipboardVerdict::kDuplicate);
+    CHECK(Process(filter, kTerms, 1800) == ClipboardVerdict::kDuplicate);
+    CHECK(Process(filter, kTerms, 2800) == ClipboardVerdict::kAccepted);
+
+    // A, B, A captures A twice.
+    CHECK(Process(filter, kPrivacy, 2810) == ClipboardVerdict::kAccepted);
+    CHECK(Process(filter, kTerms, 2820) == ClipboardVerdict::kAccepted);
+
+    // A copy of the same length with different text is not a duplicate.
+    std::wstring changed = kTerms;
+    changed[0] = L'p';
+    CHECK(Process(filter, changed, 2830) == ClipboardVerdict::kAccepted);
+
+    filter.Reset();
+    CHECK(Process(filter, changed, 2840) == ClipboardVerdict::kAccepted);
+}
+
+TEST(LongCopiesAreCutAtTheShippingLimit) {
+    ClipboardFilterOptions options;
+    options.maxShippedChars = 64;
+    ClipboardFilter filter(options);
+
+    ClipboardCapture capture;
+    const std::wstring exact = kTerms + std::wstring(64 - kTerms.size(), L'x');
+    REQUIRE(Process(filter, exact, 0, capture) == ClipboardVerdict::kAccepted);
+    CHECK(capture.text == exact);
+    CHECK(capture.originalLength == 64);
+    CHECK(!capture.truncated);
+
+    const std::wstring longer = exact + L"y";
+    REQUIRE(Process(filter, longer, 0, capture) == ClipboardVerdict::kAccepted);
+    CHECK(capture.text == exact);
+    CHECK(capture.originalLength == 65);
+    CHECK(capture.truncated);
+}
+
+TEST(TheCutNeverSplitsASurrogatePair) {
+    ClipboardFilterOptions options;
+    options.maxShippedChars = 64;
+    ClipboardFilter filter(options);
+
+    // U+1F4C4 straddles the limit: its high surrogate is character 64.
+    std::wstring text = kTerms + std::wstring(63 - kTerms.size(), L'x');
+    text += L"\xD83D\xDCC4 tail";
+    ClipboardCapture capture;
+    REQUIRE(Process(filter, text, 0, capture) == ClipboardVerdict::kAccepted);
+    CHECK(capture.truncated);
+    CHECK(capture.originalLength == text.size());
+    CHECK(capture.text.size() == 63);
+    CHECK(capture.text == text.substr(0, 63));
+
+    // A pair that ends exactly at the limit is kept whole.
+    text = kTerms + std::wstring(62 - kTerms.size(), L'x') + L"\xD83D\xDCC4 tail";
+    REQUIRE(Process(filter, text, 0, capture) == ClipboardVerdict::kAccepted);
+    CHECK(capture.text.size() == 64);
+    CHECK(capture.text.back() == L'\xDCC4');
+}
+
+TEST(RejectedCopiesAreRememberedInARing) {
+    ClipboardFilterOptions options;
+    options.historySize = 3;
+    ClipboardFilter filter(options);
+
+    const std::wstring rejected[] = {L"one", L"two", L"three", L"four"};
+    for (int i = 0; i < 3; i++) {
+        CHECK(Process(filter, rejected[i], 0) == ClipboardVerdict::kNotLegal);
+    }
+    // Repeats are refused without a scan.
+    for (int i = 0; i < 3; i++) {
+        CHECK(Process(filter, rejected[i], 0) == ClipboardVerdict::kDuplicate);
+    }
+
+    // A fourth wraps around and overwrites the oldest slot.
+    CHECK(Process(filter, rejected[3], 0) == ClipboardVerdict::kNotLegal);
+    CHECK(Process(filter, rejected[0], 0) == ClipboardVerdict::kNotLegal);
+    // Seeing "one" again rescanned it into the slot of "two".
+    CHECK(Process(filter, rejected[2], 0) == ClipboardVerdict::kDuplicate);
+    CHECK(Process(filter, rejected[3], 0) == ClipboardVerdict::kDuplicate);
+    CHECK(Process(filter, rejected[1], 0) == ClipboardVerdict::kNotLegal);
+
+    // Accepted copies never occupy the ring.
+    CHECK(Process(filter, kTerms, 0) == ClipboardVerdict::kAccepted);
+    CHECK(Process(filter, rejected[0], 0) == ClipboardVerdict::kDuplicate);
+
+    ClipboardFilterOptions noHistory;
+    noHistory.historySize = 0;
+    ClipboardFilter forgetful(noHistory);
+    CHECK(Process(forgetful, rejected[0], 0) == ClipboardVerdict::kNotLegal);
+    CHECK(Process(forgetful, rejected[0], 0) == ClipboardVerdict::kNotLegal);
+}
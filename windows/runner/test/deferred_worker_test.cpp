@@ -0,0 +1,154 @@
+#include "deferred_worker.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+using State = DeferredWorker::State;
+
+constexpr std::chrono::seconds kTimeout(5);
+
+// Holds the initialiser until the test lets it go.
+class Gate {
+public:
+    Gate() : opened_(promise_.get_future().share()) {}
+
+    void Open() { promise_.set_value(); }
+    bool Wait() const { return opened_.wait_for(kTimeout) == std::future_status::ready; }
+
+private:
+    std::promise<void> promise_;
+    std::shared_future<void> opened_;
+};
+
+// Records what the tasks saw, in the order they ran.
+class Log {
+public:
+    void Add(int value, bool ready) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        values_.push_back(value);
+        ready_.push_back(ready);
+    }
+
+    std::vector<int> Values() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return values_;
+    }
+
+    std::vector<bool> Ready() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return ready_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<int> values_;
+    std::vector<bool> ready_;
+};
+
+// Posts a task that resolves the returned future once everything ahead of
+// it has run.
+std::future<void> Drain(DeferredWorker& worker) {
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> future = done->get_future();
+    worker.Post([done](bool) { done->set_value(); });
+    return future;
+}
+
+}  // namespace
+
+TEST(StartDoesNotWaitForTheInitialiser) {
+    Gate gate;
+    DeferredWorker worker;
+    CHECK(!worker.IsStarted());
+
+    const auto before = std::chrono::steady_clock::now();
+    worker.Start([&gate] { return gate.Wait(); });
+    CHECK(std::chrono::steady_clock::now() - before < std::chrono::seconds(1));
+    CHECK(worker.IsStarted());
+    CHECK(worker.GetState() == State::kInitializing);
+    CHECK(worker.Ready().wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout);
+
+    gate.Open();
+    REQUIRE(worker.Ready().wait_for(kTimeout) == std::future_status::ready);
+    CHECK(worker.Ready().get());
+    CHECK(worker.GetState() == State::kReady);
+    CHECK(worker.InitStartedMicros() != 0 && worker.InitFinishedMicros() >= worker.InitStartedMicros());
+}
+
+TEST(TasksPostedBeforeStartRunInOrderOnceReady) {
+    Log log;
+    DeferredWorker worker;
+    for (int i = 0; i < 5; i++) {
+        CHECK(worker.Post([&log, i](bool ready) { log.Add(i, ready); }));
+    }
+    std::future<void> drained = Drain(worker);
+
+    worker.Start([] { return true; });
+    REQUIRE(drained.wait_for(kTimeout) == std::future_status::ready);
+    CHECK((log.Values() == std::vector<int>{0, 1, 2, 3, 4}));
+    CHECK((log.Ready() == std::vector<bool>(5, true)));
+}
+
+TEST(FailedInitialisationPassesNotReadyAndStillTearsDown) {
+    Log log;
+    bool tornDown = false;
+    DeferredWorker worker;
+    worker.Post([&log](bool ready) { log.Add(1, ready); });
+    std::future<void> drained = Drain(worker);
+
+    worker.Start([] { return false; }, [&tornDown] { tornDown = true; });
+    REQUIRE(drained.wait_for(kTimeout) == std::future_status::ready);
+    CHECK((log.Ready() == std::vector<bool>{false}));
+    CHECK(!worker.Ready().get());
+    CHECK(worker.GetState() == State::kFailed);
+
+    worker.Stop();
+    CHECK(tornDown);
+}
+
+TEST(PostAfterStopIsRefused) {
+    DeferredWorker started;
+    started.Start([] { return true; });
+    started.Stop();
+    CHECK(!started.Post([](bool) {}));
+
+    // A worker that never started resolves its future instead of hanging.
+    DeferredWorker idle;
+    idle.Stop();
+    CHECK(!idle.Post([](bool) {}));
+    REQUIRE(idle.Ready().wait_for(std::chrono::milliseconds(0)) == std::future_status::ready);
+    CHECK(!idle.Ready().get());
+}
+
+TEST(StopDuringInitialisationJoinsCleanly) {
+    Gate entered;
+    Gate release;
+    bool ran = false;
+    bool tornDown = false;
+    DeferredWorker worker;
+    worker.Post([&ran](bool) { ran = true; });
+    worker.Start(
+        [&entered, &release] {
+            entered.Open();
+            return release.Wait();
+        },
+        [&tornDown] { tornDown = true; });
+    REQUIRE(entered.Wait());
+
+    std::future<void> stopped = std::async(std::launch::async, [&worker] { worker.Stop(); });
+    CHECK(stopped.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+    release.Open();
+    REQUIRE(stopped.wait_for(kTimeout) == std::future_status::ready);
+
+    // The queued task was dropped, but teardown still ran on the worker.
+    CHECK(!ran);
+    CHECK(tornDown);
+    CHECK(worker.Ready().get());
+}
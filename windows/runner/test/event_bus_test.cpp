@@ -0,0 +1,157 @@
+#include "event_bus.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+using Priority = EventBus::Priority;
+using Values = std::vector<int>;
+
+// Stands in for the platform thread's message queue.
+class Waker {
+public:
+    void Wake() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken_ = true;
+        }
+        condition_.notify_one();
+    }
+
+    void Wait(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait_for(lock, timeout, [this] { return woken_; });
+        woken_ = false;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    bool woken_ = false;
+};
+
+}  // namespace
+
+TEST(UrgentEventsGoFirstAndBatchesAreLimited) {
+    int wakes = 0;
+    EventBus bus([&] { wakes++; }, 4);
+    Values out;
+    int owner = 0;
+    for (int i = 0; i < 6; i++) bus.Post(&owner, [&out, i] { out.push_back(100 + i); }, Priority::kBulk);
+    bus.Post(&owner, [&] { out.push_back(1); }, Priority::kNormal);
+    bus.Post(&owner, [&] { out.push_back(10); }, Priority::kUrgent, 1, 7);
+    bus.Post(&owner, [&] { out.push_back(11); }, Priority::kUrgent, 1, 7);
+    bus.Post(&owner, [&] { out.push_back(12); }, Priority::kUrgent, 1, 8);
+    CHECK(wakes == 1);
+
+    CHECK(bus.Drain());
+    CHECK(out == Values({11, 12, 1, 100, 101, 102}));
+    CHECK(wakes == 2);
+    CHECK(!bus.Drain());
+    CHECK(out == Values({11, 12, 1, 100, 101, 102, 103, 104, 105}));
+    CHECK(bus.Stats().superseded == 1);
+    CHECK(bus.Stats().delivered == 9);
+}
+
+TEST(SupersedingIsPerOwner) {
+    EventBus bus([] {});
+    Values out;
+    int owner = 0;
+    int other = 0;
+    bus.Post(&owner, [&] { out.push_back(1); }, Priority::kNormal, 3, 0);
+    bus.Post(&other, [&] { out.push_back(2); }, Priority::kNormal, 3, 0);
+    bus.Drain();
+    CHECK(out == Values({1, 2}));
+}
+
+TEST(DiscardDropsOnlyThatOwner) {
+    EventBus bus([] {});
+    Values out;
+    int owner = 0;
+    int other = 0;
+    bus.Post(&owner, [&] { out.push_back(-1); });
+    bus.Post(&other, [&] { out.push_back(-2); });
+    bus.Post(&owner, [&] { out.push_back(-3); }, Priority::kUrgent, 2, 0);
+    bus.Discard(&owner);
+    bus.Drain();
+    CHECK(out == Values({-2}));
+    CHECK(bus.Stats().discarded == 2);
+}
+
+TEST(TasksMayPostMoreTasks) {
+    int wakes = 0;
+    EventBus bus([&] { wakes++; });
+    Values out;
+    int owner = 0;
+    bus.Post(&owner, [&] { bus.Post(&owner, [&] { out.push_back(77); }); });
+    bus.Drain();
+    CHECK(wakes == 2);
+    bus.Drain();
+    CHECK(out == Values({77}));
+}
+
+TEST(ConcurrentProducersKeepPerPriorityOrder) {
+    // Every fourth event supersedes by producer, the rest alternate between
+    // bulk and normal; each stream must arrive in the order it was posted.
+    constexpr int kProducers = 4;
+    constexpr uint64_t kPerProducer = 50000;
+    Waker waker;
+    EventBus bus([&] { waker.Wake(); });
+    std::vector<uint64_t> lastBulk(kProducers, 0);
+    std::vector<uint64_t> lastNormal(kProducers, 0);
+    std::vector<uint64_t> lastLatest(kProducers, 0);
+    uint64_t delivered = 0;
+    uint64_t orderErrors = 0;
+    int owner = 0;
+
+    std::atomic<int> finished{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&, p] {
+            for (uint64_t i = 1; i <= kPerProducer; i++) {
+                if (i % 4 == 0) {
+                    bus.Post(&owner, [&, p, i] {
+                        if (i < lastLatest[p]) orderErrors++;
+                        lastLatest[p] = i;
+                        delivered++;
+                    }, Priority::kUrgent, 1, static_cast<uint64_t>(p));
+                } else if (i % 2 != 0) {
+                    bus.Post(&owner, [&, p, i] {
+                        if (i <= lastBulk[p]) orderErrors++;
+                        lastBulk[p] = i;
+                        delivered++;
+                    }, Priority::kBulk);
+                } else {
+                    bus.Post(&owner, [&, p, i] {
+                        if (i <= lastNormal[p]) orderErrors++;
+                        lastNormal[p] = i;
+                        delivered++;
+                    }, Priority::kNormal);
+                }
+            }
+            finished++;
+        });
+    }
+
+    while (finished.load() < kProducers) {
+        waker.Wait(std::chrono::milliseconds(50));
+        while (bus.Drain()) {
+        }
+    }
+    for (std::thread& producer : producers) producer.join();
+    while (bus.Drain()) {
+    }
+
+    const EventBusStats& stats = bus.Stats();
+    CHECK(orderErrors == 0);
+    CHECK(delivered == stats.delivered);
+    CHECK(stats.delivered + stats.superseded == kProducers * kPerProducer);
+    for (int p = 0; p < kProducers; p++) CHECK(lastLatest[p] == kPerProducer);
+}
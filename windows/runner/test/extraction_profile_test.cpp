@@ -0,0 +1,104 @@
+#include "extraction_profile.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+constexpr int kButton = 50000;
+constexpr int kText = 50020;
+constexpr int kToolBar = 50021;
+constexpr int kGroup = 50026;
+constexpr int kDocument = 50030;
+
+bool LoadShippedProfiles(ExtractionProfileSet& set) {
+    std::ifstream file(RUNNER_RESOURCE_DIR "/extraction_profiles.txt");
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string error;
+    const bool parsed = set.Parse(contents.str(), error);
+    if (!parsed) std::fprintf(stderr, "extraction_profiles.txt: %s\n", error.c_str());
+    return parsed;
+}
+
+}  // namespace
+
+TEST(ShippedProfilesMatchByProcessThenWindowClass) {
+    ExtractionProfileSet set;
+    REQUIRE(LoadShippedProfiles(set));
+    CHECK(set.Version() == ExtractionProfileSet::kVersion);
+
+    const ExtractionProfile* chrome = set.Match(L"CHROME.EXE", L"");
+    REQUIRE(chrome != nullptr);
+    CHECK(chrome->name == "chromium");
+    const ExtractionProfile* edge = set.Match(L"msedge.exe", L"Chrome_WidgetWin_1");
+    REQUIRE(edge != nullptr);
+    CHECK(edge->name == "chromium");
+    const ExtractionProfile* slack = set.Match(L"slack.exe", L"Chrome_WidgetWin_1");
+    REQUIRE(slack != nullptr);
+    CHECK(slack->name == "electron");
+    const ExtractionProfile* word = set.Match(L"WINWORD.EXE", L"OpusApp");
+    REQUIRE(word != nullptr);
+    CHECK(word->name == "word");
+    CHECK(set.Match(L"notepad.exe", L"Notepad") == nullptr);
+}
+
+TEST(InvalidFilesLeaveTheSetUnchanged) {
+    ExtractionProfileSet set;
+    REQUIRE(LoadShippedProfiles(set));
+    const size_t size = set.Size();
+
+    const char* invalid[] = {
+        "[x]\nprocess = a.exe\n",
+        "version 2\n",
+        "version 1\n[x]\nprocess = a.exe\nskip = Bogus\n",
+        "version 1\n[x]\nskip = ToolBar\n",
+        "version 1\nprocess = a.exe\n",
+        "version 1\n[x]\nprocess = a.exe\nprefer = pdf\n",
+        "version 1\n[x]\nprocess = a.exe\ncolour = red\n",
+    };
+    for (const char* text : invalid) {
+        std::string error;
+        CHECK(!set.Parse(text, error));
+        CHECK(!error.empty());
+    }
+    CHECK(set.Size() == size);
+    CHECK(set.Match(L"chrome.exe", L"") != nullptr);
+}
+
+TEST(ControlTypeNamesMapToUiaIds) {
+    CHECK(ControlTypeIdFromName("Button") == 50000);
+    CHECK(ControlTypeIdFromName("AppBar") == 50040);
+    CHECK(ControlTypeIdFromName("x") == 0);
+}
+
+TEST(ProfileClassifiesElements) {
+    ExtractionProfileSet set;
+    std::string error;
+    REQUIRE(set.Parse("version 1\n[app]\nprocess = app.exe\nskip = ToolBar\nskip_class = Ribbon\n"
+                      "read = Text Document\nprefer = text\n", error));
+    const ExtractionProfile* profile = set.Match(L"app.exe", L"");
+    REQUIRE(profile != nullptr);
+
+    CHECK(profile->Classify(kToolBar, L"", false) == ProfileAction::kSkipSubtree);
+    CHECK(profile->Classify(kGroup, L"ribbon", false) == ProfileAction::kSkipSubtree);
+    CHECK(profile->Classify(kDocument, L"", true) == ProfileAction::kReadDocument);
+    CHECK(profile->Classify(kDocument, L"", false) == ProfileAction::kReadAndDescend);
+    CHECK(profile->Classify(kText, L"", false) == ProfileAction::kReadAndDescend);
+    CHECK(profile->Classify(kButton, L"", false) == ProfileAction::kDescend);
+    CHECK(profile->SkippedControlTypes() == std::vector<int>{kToolBar});
+}
+
+TEST(StrategyPrefersProfilesThenDocuments) {
+    const ExtractionProfile& generic = ExtractionProfile::GenericDocument();
+    CHECK(ChooseExtractionStrategy(&generic, false) == ExtractionStrategy::kProfileWalk);
+    CHECK(ChooseExtractionStrategy(nullptr, true) == ExtractionStrategy::kDocumentFastPath);
+    CHECK(ChooseExtractionStrategy(nullptr, false) == ExtractionStrategy::kFullWalk);
+    CHECK(generic.Classify(kDocument, L"", true) == ProfileAction::kReadDocument);
+    CHECK(generic.Classify(kToolBar, L"", false) == ProfileAction::kReadAndDescend);
+}
@@ -0,0 +1,199 @@
+#include "extraction_scheduler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+// Targets are numbered processId * 1000 + n. Targets of kHungProcess block
+// until Release() is called.
+constexpr uint32_t kHungProcess = 99;
+constexpr uint64_t kFailingTarget = 1007;
+
+class FakeWorld {
+public:
+    void Release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            released_ = true;
+        }
+        changed_.notify_all();
+    }
+
+    bool Extract(uint64_t target, std::wstring& text) {
+        const uint32_t processId = static_cast<uint32_t>(target / 1000);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (++running_[processId] > 1) overlapped_ = true;
+            changed_.notify_all();
+            if (processId == kHungProcess) {
+                changed_.wait(lock, [this] { return released_; });
+            }
+            --running_[processId];
+        }
+        text = std::to_wstring(target);
+        return target != kFailingTarget;
+    }
+
+    void Record(uint64_t target, bool success, const std::wstring& text) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (success && text != std::to_wstring(target)) wrongText_ = true;
+            if (!success) failures_++;
+            completed_.push_back(target);
+        }
+        changed_.notify_all();
+    }
+
+    void CompleteBatch(uint64_t batchId) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batches_.push_back(batchId);
+        }
+        changed_.notify_all();
+    }
+
+    // Waits until a target of |processId| is being extracted.
+    bool WaitForRunning(uint32_t processId) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(10), [&] { return running_[processId] > 0; });
+    }
+
+    // Waits until |count| targets have completed; false on timeout.
+    bool WaitForResults(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(10), [&] { return completed_.size() >= count; });
+    }
+
+    bool WaitForBatches(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(10), [&] { return batches_.size() >= count; });
+    }
+
+    std::vector<uint64_t> Completed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return completed_;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::unordered_map<uint32_t, int> running_;
+    std::vector<uint64_t> completed_;
+    std::vector<uint64_t> batches_;
+    int failures_ = 0;
+    bool released_ = false;
+    bool overlapped_ = false;
+    bool wrongText_ = false;
+};
+
+class FakeProvider : public TextExtractionProvider {
+public:
+    explicit FakeProvider(FakeWorld& world) : world_(world) {}
+    bool ExtractText(uint64_t target, std::wstring& text) override { return world_.Extract(target, text); }
+
+private:
+    FakeWorld& world_;
+};
+
+ExtractionScheduler::ProviderFactory FactoryFor(FakeWorld& world) {
+    return [&world] { return std::unique_ptr<TextExtractionProvider>(new FakeProvider(world)); };
+}
+
+}  // namespace
+
+TEST(HungProcessOccupiesOneWorker) {
+    FakeWorld world;
+    ExtractionScheduler scheduler([&](uint64_t, uint64_t target, bool success, std::wstring text) {
+        world.Record(target, success, text);
+    }, [&](uint64_t batchId) { world.CompleteBatch(batchId); });
+    REQUIRE(scheduler.Start(4, FactoryFor(world)));
+
+    std::vector<ExtractionTarget> targets;
+    for (uint64_t n = 0; n < 3; n++) {
+        targets.push_back({kHungProcess * 1000 + n, kHungProcess});
+    }
+    for (uint64_t n = 1; n <= 40; n++) {
+        const uint32_t processId = static_cast<uint32_t>(n % 6);
+        targets.push_back({processId * 1000 + n, processId});
+    }
+    scheduler.Submit(targets);
+
+    // Every other process drains while the hung one still holds its worker.
+    REQUIRE(world.WaitForResults(40));
+    for (uint64_t target : world.Completed()) {
+        CHECK(target / 1000 != kHungProcess);
+    }
+
+    world.Release();
+    REQUIRE(world.WaitForBatches(1));
+    CHECK(world.Completed().size() == 43);
+    CHECK(scheduler.PendingCount() == 0);
+    scheduler.Stop();
+
+    CHECK(world.failures_ == 1);
+    CHECK(!world.wrongText_);
+    CHECK(!world.overlapped_);
+}
+
+TEST(EmptyBatchCompletesImmediately) {
+    FakeWorld world;
+    ExtractionScheduler scheduler([&](uint64_t, uint64_t target, bool success, std::wstring text) {
+        world.Record(target, success, text);
+    }, [&](uint64_t batchId) { world.CompleteBatch(batchId); });
+    REQUIRE(scheduler.Start(2, FactoryFor(world)));
+
+    const uint64_t batchId = scheduler.Submit({});
+    REQUIRE(world.WaitForBatches(1));
+    CHECK(world.batches_[0] == batchId);
+    scheduler.Stop();
+}
+
+TEST(StopDropsQueuedWork) {
+    FakeWorld world;
+    ExtractionScheduler scheduler([&](uint64_t, uint64_t target, bool success, std::wstring text) {
+        world.Record(target, success, text);
+    }, nullptr);
+    REQUIRE(scheduler.Start(1, FactoryFor(world)));
+
+    std::vector<ExtractionTarget> targets;
+    for (uint64_t n = 0; n < 5; n++) {
+        targets.push_back({kHungProcess * 1000 + n, kHungProcess});
+    }
+    scheduler.Submit(targets);
+    world.Release();
+    scheduler.Stop();
+
+    CHECK(scheduler.PendingCount() == 0);
+    CHECK(!scheduler.IsRunning());
+    CHECK(!scheduler.Start(0, FactoryFor(world)));
+}
+
+// Stop() waits for a provider call in progress; in the runner the watchdog
+// cancels it, which Release() stands in for here.
+TEST(StopWaitsForTheCallInProgressToBeCancelled) {
+    FakeWorld world;
+    ExtractionScheduler scheduler([&](uint64_t, uint64_t target, bool success, std::wstring text) {
+        world.Record(target, success, text);
+    }, nullptr);
+    REQUIRE(scheduler.Start(2, FactoryFor(world)));
+
+    scheduler.Submit({{kHungProcess * 1000, kHungProcess}, {kHungProcess * 1000 + 1, kHungProcess}});
+    REQUIRE(world.WaitForRunning(kHungProcess));
+
+    std::future<void> stopped = std::async(std::launch::async, [&scheduler] { scheduler.Stop(); });
+    CHECK(stopped.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+    world.Release();
+    REQUIRE(stopped.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+
+    // The cancelled call's result is dropped, and the queued one never ran.
+    CHECK(world.Completed().empty());
+    CHECK(!scheduler.IsRunning());
+}
@@ -0,0 +1,112 @@
+#include "geometry_coalescer.h"
+
+#include <cstdint>
+#include <limits>
+
+#include "test_util.h"
+
+namespace {
+
+constexpr int64_t kFrame = 16667;
+
+}  // namespace
+
+TEST(RequestsWithinAFrameBecomeOneUpdate) {
+    GeometryCoalescer coalescer(kFrame);
+    coalescer.Reset(OverlayGeometry());
+    int64_t delay = -1;
+    GeometryUpdate update;
+    CHECK(!coalescer.ScheduleFlush(0, delay));
+
+    coalescer.SetPosition(10, 20);
+    coalescer.SetPosition(30, 40);
+    coalescer.SetSize(500, 600);
+    REQUIRE(coalescer.ScheduleFlush(1000, delay));
+    CHECK(delay == 0);
+    coalescer.SetAlwaysOnTop(false);
+    CHECK(!coalescer.ScheduleFlush(1000, delay));
+
+    REQUIRE(coalescer.TakeUpdate(1000, update));
+    CHECK(update.changes == (kGeometryMove | kGeometryResize | kGeometryZOrder));
+    CHECK(update.geometry.x == 30);
+    CHECK(update.geometry.Height() == 600);
+    CHECK(!update.geometry.alwaysOnTop);
+}
+
+TEST(NextUpdateWaitsForTheRestOfTheFrame) {
+    GeometryCoalescer coalescer(kFrame);
+    coalescer.Reset(OverlayGeometry());
+    int64_t delay = -1;
+    GeometryUpdate update;
+    coalescer.SetPosition(30, 40);
+    REQUIRE(coalescer.ScheduleFlush(1000, delay));
+    REQUIRE(coalescer.TakeUpdate(1000, update));
+
+    coalescer.SetPosition(31, 40);
+    REQUIRE(coalescer.ScheduleFlush(5000, delay));
+    CHECK(delay == 12667);
+    CHECK(!coalescer.TakeUpdate(5000, update));
+    REQUIRE(coalescer.ScheduleFlush(5000, delay));
+    CHECK(delay == 12667);
+    REQUIRE(coalescer.TakeUpdate(17667, update));
+    CHECK(update.changes == kGeometryMove);
+}
+
+TEST(RequestsThatCancelOutProduceNoUpdate) {
+    GeometryCoalescer coalescer(kFrame);
+    coalescer.Reset(OverlayGeometry());
+    int64_t delay = -1;
+    GeometryUpdate update;
+    coalescer.SetPosition(0, 0);
+    coalescer.SetPosition(100, 100);
+    REQUIRE(coalescer.ScheduleFlush(40000, delay));
+    CHECK(delay == 0);
+    CHECK(!coalescer.TakeUpdate(40000, update));
+    CHECK(!coalescer.HasPending());
+}
+
+TEST(MinimizingKeepsTheExpandedHeight) {
+    GeometryCoalescer coalescer(kFrame);
+    coalescer.Reset(OverlayGeometry());
+    int64_t delay = -1;
+    GeometryUpdate update;
+    coalescer.SetMinimized(true);
+    coalescer.SetSize(500, 700);
+    REQUIRE(coalescer.ScheduleFlush(50000, delay));
+    REQUIRE(coalescer.TakeUpdate(50000, update));
+    CHECK(update.geometry.Height() == 40);
+    CHECK(update.changes == kGeometryResize);
+
+    coalescer.SetMinimized(false);
+    REQUIRE(coalescer.ScheduleFlush(50001, delay));
+    REQUIRE(coalescer.TakeUpdate(50001, update, true));
+    CHECK(update.geometry.Height() == 700);
+}
+
+TEST(DragAppliesAtMostOncePerFrame) {
+    // 1000 Hz pointer input for 1.5s, woken as ScheduleFlush asks.
+    GeometryCoalescer coalescer(kFrame);
+    coalescer.Reset(OverlayGeometry());
+    GeometryUpdate update;
+    int64_t wake = -1;
+    int64_t lastApply = -kFrame;
+    int64_t minGap = std::numeric_limits<int64_t>::max();
+    int applies = 0;
+    for (int64_t now = 0; now < 2000000; now += 1000) {
+        if (wake >= 0 && now >= wake) {
+            wake = -1;
+            if (coalescer.TakeUpdate(now, update)) {
+                applies++;
+                if (now - lastApply < minGap) minGap = now - lastApply;
+                lastApply = now;
+            }
+        }
+        if (now < 1500000) coalescer.SetPosition(static_cast<int>(now / 1000), static_cast<int>(now % 3000));
+        int64_t delay = 0;
+        if (coalescer.ScheduleFlush(now, delay)) wake = now + delay;
+    }
+    CHECK(!coalescer.HasPending());
+    CHECK(minGap >= kFrame);
+    CHECK(applies > 80 && applies <= 1500000 / kFrame + 1);
+    CHECK(coalescer.Target().x == 1499);
+}
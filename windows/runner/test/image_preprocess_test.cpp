@@ -0,0 +1,195 @@
+#include "image_preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "test_util.h"
+
+using namespace image_kernels;
+
+namespace {
+
+uint8_t RandomByte(std::mt19937& rng) {
+    return static_cast<uint8_t>(rng() & 0xFF);
+}
+
+// Lines of dark "words" on white, rotated by |skew| degrees and lit unevenly
+// with noise, as a phone photo or a poor scan would be. |truth| receives the
+// rotated page before lighting and noise.
+void MakePage(int width, int height, double skew, std::vector<uint8_t>& rgba, GrayImage& truth) {
+    std::mt19937 rng(11);
+    GrayImage ink;
+    ink.Resize(width, height);
+    std::fill(ink.pixels.begin(), ink.pixels.end(), static_cast<uint8_t>(255));
+    const int margin = width / 8;
+    const int lineHeight = height / 60;
+    for (int y = height / 10; y + lineHeight < height - height / 10; y += lineHeight * 14 / 10) {
+        int x = margin;
+        while (true) {
+            const int wordWidth = lineHeight * static_cast<int>(2 + rng() % 6);
+            if (x + wordWidth > width - margin) break;
+            for (int yy = y; yy < y + lineHeight * 6 / 10; yy++) {
+                for (int xx = x; xx < x + wordWidth; xx++) {
+                    if ((xx / 3 + yy / 4) % 3 != 0) ink.Row(yy)[xx] = 0;
+                }
+            }
+            x += wordWidth + lineHeight / 2;
+        }
+    }
+    Rotate(ink, skew, true, truth);
+
+    rgba.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 4);
+    std::normal_distribution<double> noise(0, 8);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const double light = 235 - 90.0 * x / width - 40.0 * y / height;
+            double value = truth.Row(y)[x] < 128 ? light * 0.35 : light;
+            value = std::max(0.0, std::min(255.0, value + noise(rng)));
+            uint8_t* pixel = &rgba[(static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4];
+            pixel[0] = static_cast<uint8_t>(std::min(255.0, value * 1.05));
+            pixel[1] = static_cast<uint8_t>(value);
+            pixel[2] = static_cast<uint8_t>(value * 0.9);
+            pixel[3] = 255;
+        }
+    }
+}
+
+}  // namespace
+
+TEST(GrayIsRec601Luma) {
+    std::mt19937 rng(7);
+    const int width = 1001;
+    const int height = 37;
+    const size_t stride = static_cast<size_t>(width) * 4 + 8;
+    std::vector<uint8_t> rgba(stride * static_cast<size_t>(height));
+    for (uint8_t& byte : rgba) byte = RandomByte(rng);
+
+    GrayImage gray;
+    GrayFromRgba(rgba.data(), width, height, stride, gray);
+    REQUIRE(gray.width == width && gray.height == height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t* p = &rgba[static_cast<size_t>(y) * stride + static_cast<size_t>(x) * 4];
+            REQUIRE(gray.Row(y)[x] == ((p[0] * 77 + p[1] * 150 + p[2] * 29 + 128) >> 8));
+        }
+    }
+}
+
+TEST(DownscaleIsAnAreaAverageIndependentOfTiles) {
+    std::mt19937 rng(8);
+    const int sourceWidth = 997;
+    const int sourceHeight = 613;
+    const int targetWidth = 443;
+    const int targetHeight = 271;
+    GrayImage source;
+    source.Resize(sourceWidth, sourceHeight);
+    for (uint8_t& pixel : source.pixels) pixel = RandomByte(rng);
+
+    GrayImage target;
+    Downscale(source, targetWidth, targetHeight, 16, target);
+    REQUIRE(target.width == targetWidth && target.height == targetHeight);
+    const double sx = static_cast<double>(sourceWidth) / targetWidth;
+    const double sy = static_cast<double>(sourceHeight) / targetHeight;
+    for (int y = 0; y < targetHeight; y++) {
+        for (int x = 0; x < targetWidth; x++) {
+            double sum = 0;
+            const int lastRow = std::min(sourceHeight, static_cast<int>(std::ceil((y + 1) * sy)));
+            const int lastColumn = std::min(sourceWidth, static_cast<int>(std::ceil((x + 1) * sx)));
+            for (int j = static_cast<int>(y * sy); j < lastRow; j++) {
+                const double coverY = std::min((y + 1) * sy, j + 1.0) - std::max(y * sy, static_cast<double>(j));
+                for (int i = static_cast<int>(x * sx); i < lastColumn; i++) {
+                    const double coverX = std::min((x + 1) * sx, i + 1.0) - std::max(x * sx, static_cast<double>(i));
+                    sum += coverX * coverY * source.Row(j)[i];
+                }
+            }
+            REQUIRE(std::fabs(sum / (sx * sy) - target.Row(y)[x]) < 2.0);
+        }
+    }
+
+    GrayImage untiled;
+    Downscale(source, targetWidth, targetHeight, 1000, untiled);
+    CHECK(untiled.pixels == target.pixels);
+}
+
+TEST(BinarizeMatchesNaiveSauvola) {
+    std::mt19937 rng(9);
+    const int width = 211;
+    const int height = 97;
+    const int radius = 9;
+    GrayImage source;
+    source.Resize(width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const bool ink = (x * 7 + y * 3) % 50 < 10;
+            source.Row(y)[x] = static_cast<uint8_t>(ink ? 40 + rng() % 30 : 180 + rng() % 60);
+        }
+    }
+
+    GrayImage binary;
+    Binarize(source, radius, binary);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double sum = 0;
+            double squares = 0;
+            int count = 0;
+            for (int j = std::max(0, y - radius); j <= std::min(height - 1, y + radius); j++) {
+                for (int i = std::max(0, x - radius); i <= std::min(width - 1, x + radius); i++) {
+                    const double value = source.Row(j)[i];
+                    sum += value;
+                    squares += value * value;
+                    count++;
+                }
+            }
+            const double mean = sum / count;
+            const double deviation = std::sqrt(std::max(0.0, squares / count - mean * mean));
+            const double threshold = mean * (1 + 0.34 * (deviation / 128 - 1));
+            // Values within rounding of the threshold may go either way.
+            if (std::fabs(source.Row(y)[x] - threshold) <= 0.01) continue;
+            REQUIRE(binary.Row(y)[x] == (source.Row(y)[x] <= threshold ? 0 : 255));
+        }
+    }
+}
+
+TEST(PipelineBinarizesUnevenLightingAndRemovesSkew) {
+    const int width = 850;
+    const int height = 1100;
+    for (double skew : {0.0, -2.3, 3.7}) {
+        std::vector<uint8_t> rgba;
+        GrayImage truth;
+        MakePage(width, height, skew, rgba, truth);
+
+        OcrPreprocessOptions options;
+        options.sourceDpi = 100;
+        options.targetDpi = 100;
+        options.deskew = false;
+        options.crop = false;
+        OcrPreprocessResult plain;
+        REQUIRE(PreprocessForOcr(rgba.data(), width, height, static_cast<size_t>(width) * 4, options, plain));
+        REQUIRE(plain.image.pixels.size() == truth.pixels.size());
+        size_t errors = 0;
+        for (size_t i = 0; i < truth.pixels.size(); i++) {
+            if ((plain.image.pixels[i] < 128) != (truth.pixels[i] < 128)) errors++;
+        }
+        CHECK(errors * 100 < truth.pixels.size() * 3);
+
+        OcrPreprocessResult full;
+        options.deskew = true;
+        options.crop = true;
+        REQUIRE(PreprocessForOcr(rgba.data(), width, height, static_cast<size_t>(width) * 4, options, full));
+        CHECK(std::fabs(full.skewDegrees - skew) <= 0.15);
+        CHECK(std::fabs(EstimateSkew(full.image, 5)) <= 0.15);
+        CHECK(full.cropWidth < width && full.cropHeight < height);
+        CHECK(full.image.width == full.cropWidth && full.image.height == full.cropHeight);
+    }
+}
+
+TEST(InvalidInputIsRejected) {
+    const uint8_t pixel[4] = {0, 0, 0, 255};
+    OcrPreprocessResult result;
+    CHECK(!PreprocessForOcr(nullptr, 1, 1, 4, OcrPreprocessOptions(), result));
+    CHECK(!PreprocessForOcr(pixel, 0, 1, 4, OcrPreprocessOptions(), result));
+    CHECK(!PreprocessForOcr(pixel, 2, 1, 4, OcrPreprocessOptions(), result));
+}
@@ -0,0 +1,185 @@
+#include "keyword_detector.h"
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+#include "unicode_fold.h"
+
+namespace {
+
+std::string ReadPhraseFile() {
+    std::ifstream file(RUNNER_RESOURCE_DIR "/legal_phrases.txt", std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Reference matcher for the fuzz test: folds and collapses both sides, then
+// searches naively.
+std::wstring Normalize(const std::wstring& text, bool keepLeadingSpace) {
+    std::wstring normalized;
+    bool space = false;
+    for (wchar_t ch : text) {
+        const uint32_t codePoint = static_cast<uint32_t>(ch);
+        if (IsMatchingIgnorable(codePoint)) continue;
+        if (IsMatchingSpace(codePoint)) {
+            space = keepLeadingSpace || !normalized.empty();
+            continue;
+        }
+        if (space) normalized.push_back(L' ');
+        space = false;
+        normalized.push_back(static_cast<wchar_t>(FoldForMatching(codePoint)));
+    }
+    if (space && keepLeadingSpace) normalized.push_back(L' ');
+    return normalized;
+}
+
+}  // namespace
+
+TEST(FoldingIgnoresCaseAndAccentsAcrossScripts) {
+    CHECK(FoldForMatching(L'A') == L'a');
+    CHECK(FoldForMatching(0x130) == L'i');   // İ
+    CHECK(FoldForMatching(0x131) == L'i');   // ı
+    CHECK(FoldForMatching(0x3A3) == 0x3C3);  // Σ
+    CHECK(FoldForMatching(0x3C2) == 0x3C3);  // ς
+    CHECK(FoldForMatching(0x386) == 0x3B1);  // Ά
+    CHECK(FoldForMatching(0x1E9E) == 0xDF);  // ẞ
+    CHECK(FoldForMatching(0xC4) == L'a');    // Ä
+    CHECK(FoldForMatching(0xFF21) == L'a');  // Ａ
+    CHECK(FoldForMatching(0x2019) == L'\'');
+    CHECK(FoldForMatching(0x401) == 0x435);  // Ё
+    CHECK(FoldForMatching(0x15E) == L's');   // Ş
+    CHECK(FoldForMatching(0x141) == L'l');   // Ł
+    CHECK(FoldForMatching(0x4E2D) == 0x4E2D);
+    CHECK(IsMatchingSpace(0xA0) && IsMatchingSpace(0x3000) && !IsMatchingSpace(L'a'));
+    CHECK(IsMatchingIgnorable(0x301) && IsMatchingIgnorable(0xAD) && !IsMatchingIgnorable(L'a'));
+}
+
+TEST(FoldingIsIdempotent) {
+    for (uint32_t codePoint = 0; codePoint < 0x10000; codePoint++) {
+        const uint32_t folded = FoldForMatching(codePoint);
+        REQUIRE(FoldForMatching(folded) == folded);
+    }
+}
+
+TEST(ShippedPhrasesMatchInEveryLanguage) {
+    KeywordDetector detector;
+    std::string error;
+    REQUIRE(detector.LoadPhrases(ReadPhraseFile(), error));
+    detector.Compile();
+    CHECK(detector.Languages().size() == 10);
+
+    struct Case {
+        const wchar_t* text;
+        uint32_t categories;
+    };
+    const Case cases[] = {
+        {L"Bitte lesen Sie unsere ALLGEMEINE GESCH\u00C4FTSBEDINGUNGEN", kKeywordCategoryTerms},
+        {L"allgemeine geschaftsbedingungen", kKeywordCategoryTerms},
+        {L"Datenschutzerkla\u0308rung", kKeywordCategoryPrivacy},
+        {L"Conditions G\u00E9n\u00E9rales d\u2019Utilisation", kKeywordCategoryTerms},
+        {L"POLITIQUE DE CONFIDENTIALIT\u00C9", kKeywordCategoryPrivacy},
+        {L"T\u00E9rminos y\ncondiciones", kKeywordCategoryTerms},
+        {L"KULLANIM KO\u015EULLARI", kKeywordCategoryTerms},
+        {L"Kullan\u0131m Ko\u015Fullar\u0131", kKeywordCategoryTerms},
+        {L"K\u0130\u015E\u0130SEL VER\u0130LER\u0130N KORUNMASI", kKeywordCategoryPrivacy},
+        {L"\u03A0\u039F\u039B\u0399\u03A4\u0399\u039A\u0397 \u0391\u03A0\u039F\u03A1\u03A1\u0397\u03A4\u039F\u03A5",
+         kKeywordCategoryPrivacy},
+        {L"\u038C\u03C1\u03BF\u03B9 \u03A7\u03C1\u03AE\u03C3\u03B7\u03C2", kKeywordCategoryTerms},
+        {L"POLITYKA PRYWATNO\u015ACI", kKeywordCategoryPrivacy},
+        {L"Privacy\u00ADbeleid", kKeywordCategoryPrivacy},
+        {L"\uFF30\uFF52\uFF49\uFF56\uFF41\uFF43\uFF59 \uFF30\uFF4F\uFF4C\uFF49\uFF43\uFF59", kKeywordCategoryPrivacy},
+        {L"Termini e Condizioni", kKeywordCategoryTerms},
+        {L"Pol\u00EDtica de Privacidade", kKeywordCategoryPrivacy},
+        {L"Terms and\u200B conditions", kKeywordCategoryTerms},
+        {L"Der Hund l\u00E4uft im Park.", 0},
+        {L"\u00DCr\u00FCn a\u00E7\u0131klamas\u0131 ve fiyat", 0},
+    };
+    for (const Case& c : cases) {
+        const uint32_t categories = detector.Scan(std::wstring(c.text));
+        if (categories != c.categories) std::fprintf(stderr, "case %d:\n", static_cast<int>(&c - cases));
+        CHECK(categories == c.categories);
+    }
+}
+
+TEST(InvalidPhraseFilesAddNothing) {
+    KeywordDetector detector;
+    std::string error;
+    CHECK(!detector.LoadPhrases("version 2\n", error));
+    CHECK(!detector.LoadPhrases("version 1\nterms = x\n", error));
+    CHECK(!detector.LoadPhrases("version 1\n[x]\nfoo = x\n", error));
+    CHECK(!detector.LoadPhrases("version 1\n[x]\nterms = \xC3\n", error));
+    CHECK(!detector.LoadPhrases("version 1\n[x]\nterms = \xF0\x9F\x98\x80\n", error));
+    CHECK(!error.empty());
+    CHECK(detector.PhraseCount() == 0);
+    CHECK(detector.LoadPhrases("\xEF\xBB\xBFversion 1\n[x]\nterms = a b\n", error));
+    CHECK(detector.PhraseCount() == 1);
+}
+
+TEST(ScanMatchesAReferenceSearch) {
+    const std::wstring alphabet =
+        L"aA\u00E4\u00C4e\u00E9\u00C9 \u00A0\u0301\u0131I\u0130sS\u015F\u015E\u03C3\u03C2\u03A3o\u00F3\u038C\u00AD";
+    std::mt19937 rng(39);
+    std::vector<std::wstring> phrases;
+    KeywordDetector detector;
+    for (uint32_t i = 0; i < 40; i++) {
+        std::wstring phrase;
+        const auto length = 1 + rng() % 4;
+        for (decltype(rng()) k = 0; k < length; k++) phrase.push_back(alphabet[rng() % alphabet.size()]);
+        detector.AddPhrase(phrase, 1u << (i % 2));
+        phrases.push_back(Normalize(phrase, false));
+    }
+    detector.Compile();
+
+    for (int iteration = 0; iteration < 5000; iteration++) {
+        std::wstring text;
+        const auto length = rng() % 30;
+        for (decltype(rng()) k = 0; k < length; k++) text.push_back(alphabet[rng() % alphabet.size()]);
+        const std::wstring normalized = Normalize(text, true);
+        uint32_t expected = 0;
+        for (uint32_t i = 0; i < phrases.size(); i++) {
+            if (!phrases[i].empty() && normalized.find(phrases[i]) != std::wstring::npos) expected |= 1u << (i % 2);
+        }
+        REQUIRE(detector.Scan(text) == expected);
+    }
+}
+
+TEST(FeedMatchesPhrasesSplitAcrossPieces) {
+    KeywordDetector detector;
+    detector.AddPhrase(L"privacy policy", kKeywordCategoryPrivacy);
+    detector.Compile();
+    const std::wstring text = L"read our PRIVACY   POLICY today";
+    for (size_t split = 0; split <= text.size(); split++) {
+        KeywordDetector::ScanState state;
+        detector.Feed(state, text.data(), split);
+        REQUIRE(detector.Feed(state, text.data() + split, text.size() - split) == kKeywordCategoryPrivacy);
+    }
+}
+
+TEST(StreamStopsAtTheFirstAnswer) {
+    KeywordDetector detector;
+    detector.AddPhrase(L"terms of service", kKeywordCategoryTerms);
+    detector.AddPhrase(L"privacy policy", kKeywordCategoryPrivacy);
+    detector.Compile();
+
+    KeywordStream stream(detector, kKeywordCategoryTerms | kKeywordCategoryPrivacy);
+    stream.BeginElement();
+    CHECK(stream.Feed(L"Welcome", 7));
+    stream.BeginElement();
+    CHECK(stream.Feed(L"Terms of", 8));
+    CHECK(stream.Feed(L" Service", 8));
+    // Elements are separated by a line break, which matches a space.
+    CHECK(stream.Feed(L"privacy", 7));
+    stream.BeginElement();
+    CHECK(!stream.Feed(L"policy", 6));
+    CHECK(stream.IsComplete());
+    CHECK(stream.ElementCount() == 3);
+    CHECK(stream.FirstMatchElement() == 1);
+    CHECK(stream.FirstMatchElement(kKeywordCategoryTerms) == 1);
+    CHECK(stream.FirstMatchElement(kKeywordCategoryPrivacy) == 2);
+}
@@ -0,0 +1,200 @@
+#include "memory_governor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+constexpr size_t kMB = 1024 * 1024;
+
+// An owner-side cache that keeps the sizes it charged and frees what the
+// governor evicts.
+class Cache {
+public:
+    Cache(MemoryGovernor& governor, const char* name, PoolPriority priority) : pool_(governor, name, priority) {}
+
+    void Put(uint64_t key, size_t bytes) {
+        items[key] = bytes;
+        pool_.Charge(key, bytes);
+        Drain();
+    }
+
+    void Use(uint64_t key) {
+        if (items.count(key) != 0) pool_.Touch(key);
+    }
+
+    void Drop(uint64_t key) {
+        items.erase(key);
+        pool_.Release(key);
+    }
+
+    void Drain() {
+        keys_.clear();
+        if (!pool_.TakeEvictions(keys_)) return;
+        for (uint64_t key : keys_) {
+            items.erase(key);
+            evicted++;
+        }
+    }
+
+    bool Has(uint64_t key) const { return items.count(key) != 0; }
+
+    size_t Bytes() const {
+        size_t bytes = 0;
+        for (const auto& item : items) bytes += item.second;
+        return bytes;
+    }
+
+    std::unordered_map<uint64_t, size_t> items;
+    uint64_t evicted = 0;
+
+private:
+    MemoryPool pool_;
+    std::vector<uint64_t> keys_;
+};
+
+}  // namespace
+
+TEST(EvictsLowPriorityLeastRecentlyUsedFirst) {
+    MemoryGovernorOptions options;
+    options.budgetBytes = 100 * kMB;
+    MemoryGovernor governor(options);
+    Cache low(governor, "snapshots", PoolPriority::kLow);
+    Cache high(governor, "buffers", PoolPriority::kHigh);
+    Cache pinned(governor, "fonts", PoolPriority::kPinned);
+
+    pinned.Put(1, 10 * kMB);
+    high.Put(1, 20 * kMB);
+    for (uint64_t key = 1; key <= 6; key++) low.Put(key, 10 * kMB);
+    low.Use(1);
+    // 105 MB is over budget; eviction brings it down to the 85% low water.
+    low.Put(7, 15 * kMB);
+    CHECK(!low.Has(2));
+    CHECK(!low.Has(3));
+    CHECK(low.Has(1));
+    CHECK(low.Has(7));
+    CHECK(high.Has(1));
+    CHECK(pinned.Has(1));
+    CHECK(governor.Stats().bytes <= 85 * kMB);
+
+    // With only high and pinned entries left, high ones go and pinned stay.
+    for (uint64_t key = 1; key <= 7; key++) low.Drop(key);
+    pinned.Put(2, 80 * kMB);
+    high.Drain();
+    CHECK(!high.Has(1));
+    CHECK(pinned.items.size() == 2);
+
+    pinned.Put(3, 30 * kMB);
+    CHECK(governor.Level() == MemoryPressure::kCritical);
+    pinned.Drop(3);
+    pinned.Drop(2);
+    CHECK(governor.Level() == MemoryPressure::kNone);
+}
+
+TEST(PressureLevelsHaveHysteresis) {
+    MemoryGovernorOptions options;
+    options.budgetBytes = 100 * kMB;
+    MemoryGovernor governor(options);
+    std::vector<MemoryPressure> published;
+    governor.SetPressureCallback([&](MemoryPressure level, size_t, size_t) { published.push_back(level); });
+    MemoryPool pool(governor, "pinned", PoolPriority::kPinned);
+
+    pool.Charge(1, 76 * kMB);
+    pool.Charge(1, 74 * kMB);
+    pool.Charge(1, 71 * kMB);
+    pool.Charge(1, 69 * kMB);
+    pool.Charge(1, 101 * kMB);
+    pool.Charge(1, 97 * kMB);
+    pool.Charge(1, 94 * kMB);
+    CHECK(published == std::vector<MemoryPressure>({MemoryPressure::kModerate, MemoryPressure::kNone,
+                                                    MemoryPressure::kCritical, MemoryPressure::kModerate}));
+}
+
+TEST(PoolsWithTheSameNameAreSeparateAccounts) {
+    MemoryGovernor governor;
+    {
+        MemoryPool first(governor, "snapshots", PoolPriority::kLow);
+        MemoryPool second(governor, "snapshots", PoolPriority::kLow);
+        first.Charge(1, 100);
+        second.Charge(1, 200);
+        CHECK(governor.Stats().bytes == 300);
+        CHECK(governor.Stats().pools.size() == 2);
+    }
+    CHECK(governor.Stats().bytes == 0);
+    CHECK(governor.Stats().pools.empty());
+}
+
+TEST(AccountingHoldsUnderConcurrentOwners) {
+    constexpr int kThreads = 4;
+    constexpr int kOperations = 20000;
+    MemoryGovernorOptions options;
+    options.budgetBytes = 64 * kMB;
+    MemoryGovernor governor(options);
+    std::atomic<int> lastPublished{0};
+    governor.SetPressureCallback(
+        [&](MemoryPressure level, size_t, size_t) { lastPublished = static_cast<int>(level); });
+
+    std::vector<std::unique_ptr<Cache>> caches;
+    for (int t = 0; t < kThreads; t++) {
+        caches.emplace_back(new Cache(governor, "snapshots", PoolPriority::kLow));
+        caches.emplace_back(new Cache(governor, "buffers", PoolPriority::kHigh));
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng(static_cast<uint64_t>(t) * 7 + 1);
+            Cache& low = *caches[static_cast<size_t>(t) * 2];
+            Cache& high = *caches[static_cast<size_t>(t) * 2 + 1];
+            for (int i = 0; i < kOperations; i++) {
+                const uint64_t r = rng();
+                Cache& cache = (r & 3) == 0 ? high : low;
+                const uint64_t key = (r >> 8) % 200;
+                switch ((r >> 4) % 8) {
+                case 0:
+                    cache.Drop(key);
+                    break;
+                case 1:
+                case 2:
+                    cache.Use(key);
+                    break;
+                default: {
+                    // Mostly small entries, now and then a page-sized buffer.
+                    size_t bytes = static_cast<size_t>((r >> 20) % 4096 + 64);
+                    if ((r >> 40) % 50 == 0) bytes = static_cast<size_t>((r >> 48) % 8 + 1) * kMB;
+                    cache.Put(key, bytes);
+                    break;
+                }
+                }
+                low.Drain();
+                high.Drain();
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (auto& cache : caches) cache->Drain();
+
+    size_t bytes = 0;
+    uint64_t evicted = 0;
+    for (const auto& cache : caches) {
+        bytes += cache->Bytes();
+        evicted += cache->evicted;
+    }
+    const MemoryGovernorStats stats = governor.Stats();
+    CHECK(stats.bytes == bytes);
+    CHECK(stats.pendingBytes == 0);
+    CHECK(stats.evictions == evicted);
+    CHECK(evicted > 0);
+    CHECK(stats.bytes <= stats.budgetBytes);
+    CHECK(lastPublished.load() == static_cast<int>(governor.Level()));
+
+    caches.clear();
+    CHECK(governor.Stats().bytes == 0);
+    CHECK(governor.Stats().pools.empty());
+}
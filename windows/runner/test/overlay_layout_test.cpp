@@ -0,0 +1,117 @@
+#include "overlay_layout.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+// A 96 DPI primary with a taskbar, a 192 DPI monitor to its right that
+// starts above it, and a 120 DPI portrait monitor at a negative offset.
+std::vector<LayoutMonitor> Monitors() {
+    return {
+        {{0, 0, 1920, 1080}, {0, 0, 1920, 1040}, 96},
+        {{1920, -200, 5760, 1960}, {1920, -200, 5760, 1900}, 192},
+        {{-1080, 0, 0, 1920}, {-1080, 0, 0, 1920}, 120},
+    };
+}
+
+bool Inside(const LayoutRect& rect, const LayoutRect& area) {
+    return rect.left >= area.left && rect.top >= area.top && rect.right <= area.right && rect.bottom <= area.bottom;
+}
+
+bool Overlaps(const LayoutRect& a, const LayoutRect& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+}  // namespace
+
+TEST(PlacesBesideTheAnchorAtMonitorDpi) {
+    const std::vector<LayoutMonitor> monitors = Monitors();
+    const AnchorLayoutOptions options;
+    AnchorPlacement placement;
+
+    REQUIRE(ComputeAnchoredPlacement({100, 100, 600, 400}, monitors, options, AnchorSide::kRight, placement));
+    CHECK(placement.monitor == 0);
+    CHECK(placement.side == AnchorSide::kRight);
+    CHECK(placement.rect.left == 608 && placement.rect.top == 100);
+    CHECK(placement.rect.Width() == 400 && placement.rect.Height() == 500);
+    CHECK(!placement.clamped);
+
+    REQUIRE(ComputeAnchoredPlacement({2000, 0, 2400, 300}, monitors, options, AnchorSide::kRight, placement));
+    CHECK(placement.monitor == 1);
+    CHECK(placement.dpi == 192);
+    CHECK(placement.rect.left == 2416);
+    CHECK(placement.rect.Width() == 800 && placement.rect.Height() == 1000);
+
+    REQUIRE(ComputeAnchoredPlacement({-1000, 1700, -900, 1800}, monitors, options, AnchorSide::kRight, placement));
+    CHECK(placement.monitor == 2);
+    CHECK(placement.rect.Width() == 500 && placement.rect.Height() == 625);
+    CHECK(Inside(placement.rect, monitors[2].workArea));
+}
+
+TEST(ChoosesTheMostOverlappingOrNearestMonitor) {
+    const std::vector<LayoutMonitor> monitors = Monitors();
+    CHECK(MonitorForRect({1800, 100, 2300, 200}, monitors) == 1);
+    CHECK(MonitorForRect({-100, 100, 50, 200}, monitors) == 2);
+    CHECK(MonitorForRect({-3000, 500, -2900, 600}, monitors) == 2);
+    CHECK(MonitorForRect({900, 1300, 1000, 1400}, monitors) == 0);
+    CHECK(MonitorForRect({0, 0, 1, 1}, {}) == 0);
+
+    AnchorPlacement placement;
+    REQUIRE(ComputeAnchoredPlacement({1800, 100, 2300, 200}, monitors, AnchorLayoutOptions(), AnchorSide::kRight,
+                                     placement));
+    CHECK(placement.monitor == 1);
+    CHECK(!ComputeAnchoredPlacement({0, 0, 1, 1}, {}, AnchorLayoutOptions(), AnchorSide::kRight, placement));
+}
+
+TEST(KeepsThePreviousSideWhileItFits) {
+    const std::vector<LayoutMonitor> monitors = Monitors();
+    AnchorPlacement placement;
+    REQUIRE(ComputeAnchoredPlacement({700, 100, 900, 200}, monitors, AnchorLayoutOptions(), AnchorSide::kLeft,
+                                     placement));
+    CHECK(placement.side == AnchorSide::kLeft);
+    CHECK(placement.rect.right == 692);
+
+    // Without room on the right it moves to the left.
+    REQUIRE(ComputeAnchoredPlacement({1500, 100, 1910, 400}, monitors, AnchorLayoutOptions(), AnchorSide::kRight,
+                                     placement));
+    CHECK(placement.side == AnchorSide::kLeft);
+    CHECK(placement.rect.right == 1492);
+}
+
+TEST(ClampsIntoTheWorkAreaWhenNoSideFits) {
+    const std::vector<LayoutMonitor> monitors = Monitors();
+    AnchorPlacement placement;
+    REQUIRE(ComputeAnchoredPlacement({0, 0, 1920, 1040}, monitors, AnchorLayoutOptions(), AnchorSide::kRight,
+                                     placement));
+    CHECK(placement.clamped);
+    CHECK(Inside(placement.rect, monitors[0].workArea));
+
+    const std::vector<LayoutMonitor> tiny = {{{0, 0, 300, 200}, {0, 0, 300, 200}, 96}};
+    REQUIRE(ComputeAnchoredPlacement({10, 10, 50, 50}, tiny, AnchorLayoutOptions(), AnchorSide::kRight, placement));
+    CHECK(Inside(placement.rect, tiny[0].workArea));
+}
+
+TEST(RandomAnchorsStayInsideTheWorkArea) {
+    const std::vector<LayoutMonitor> monitors = Monitors();
+    const AnchorLayoutOptions options;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 20000; i++) {
+        const int x = static_cast<int>(rng() % 8000) - 2500;
+        const int y = static_cast<int>(rng() % 2600) - 400;
+        const LayoutRect anchor{x, y, x + static_cast<int>(rng() % 2500) + 1, y + static_cast<int>(rng() % 2000) + 1};
+        const AnchorSide preferred = static_cast<AnchorSide>(rng() % 4);
+        AnchorPlacement placement;
+        REQUIRE(ComputeAnchoredPlacement(anchor, monitors, options, preferred, placement));
+        const LayoutRect& work = monitors[placement.monitor].workArea;
+        REQUIRE(Inside(placement.rect, work));
+        if (placement.clamped) continue;
+        // An unclamped overlay never covers the visible part of the anchor.
+        const LayoutRect visible{std::max(anchor.left, work.left), std::max(anchor.top, work.top),
+                                 std::min(anchor.right, work.right), std::min(anchor.bottom, work.bottom)};
+        if (!visible.IsEmpty()) REQUIRE(!Overlaps(placement.rect, visible));
+    }
+}
@@ -0,0 +1,267 @@
+#include "provider_watchdog.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+const ProcessHealth* Find(const std::vector<ProcessHealth>& processes, uint32_t processId) {
+    for (const ProcessHealth& health : processes) {
+        if (health.processId == processId) return &health;
+    }
+    return nullptr;
+}
+
+// Providers that answer, fail, or hang until their call is cancelled, by
+// process id.
+class FakeProviders {
+public:
+    enum class Mode { kOk, kFail, kHang };
+
+    void Set(uint32_t processId, Mode mode) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        modes_[processId] = mode;
+    }
+
+    bool Call(uint32_t processId, uint64_t token) {
+        calls++;
+        std::unique_lock<std::mutex> lock(mutex_);
+        const Mode mode = modes_[processId];
+        if (mode != Mode::kHang) return mode == Mode::kOk;
+        cancelled_[token] = false;
+        cancelledChanged_.wait(lock, [&] { return cancelled_[token]; });
+        return false;
+    }
+
+    void Cancel(uint64_t token) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cancelled_[token] = true;
+        }
+        cancelledChanged_.notify_all();
+    }
+
+    std::atomic<int> calls{0};
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cancelledChanged_;
+    std::map<uint32_t, Mode> modes_;
+    std::map<uint64_t, bool> cancelled_;
+};
+
+enum class Outcome { kRejected, kFailed, kSucceeded, kAbandoned };
+
+Outcome Run(ProviderWatchdog& watchdog, FakeProviders& providers, uint32_t processId, uint64_t token,
+            std::function<void()> onAbandoned = nullptr) {
+    ProviderCall call(watchdog, processId, token, std::move(onAbandoned));
+    if (!call.Allowed()) return Outcome::kRejected;
+    const bool succeeded = providers.Call(processId, token);
+    if (!call.Finish(succeeded)) return Outcome::kAbandoned;
+    return succeeded ? Outcome::kSucceeded : Outcome::kFailed;
+}
+
+}  // namespace
+
+TEST(BreakerOpensAndBacksOffExponentially) {
+    CircuitBreakerOptions options;
+    options.failureThreshold = 3;
+    options.initialBackoffMicros = 100;
+    options.maxBackoffMicros = 1000;
+    ProcessCircuitBreaker breaker(options);
+
+    CHECK(breaker.Allow(7, 0));
+    breaker.RecordFailure(7, 1);
+    breaker.RecordFailure(7, 2);
+    CHECK(breaker.Allow(7, 3));
+    breaker.RecordFailure(7, 3);
+    CHECK(!breaker.Allow(7, 50));
+    CHECK(!breaker.Allow(7, 102));
+    // One probe once the backoff has passed, and no one else meanwhile.
+    CHECK(breaker.Allow(7, 103));
+    CHECK(!breaker.Allow(7, 104));
+    breaker.RecordFailure(7, 110);
+    CHECK(!breaker.Allow(7, 309));
+    CHECK(breaker.Allow(7, 310));
+    breaker.RecordTimeout(7, 320);
+    CHECK(!breaker.Allow(7, 719));
+    CHECK(breaker.Allow(7, 720));
+    breaker.RecordFailure(7, 720);
+    CHECK(breaker.Allow(7, 1520));
+    // 1600 is capped at the maximum.
+    breaker.RecordFailure(7, 1520);
+    CHECK(!breaker.Allow(7, 2519));
+    CHECK(breaker.Allow(7, 2520));
+    breaker.RecordSuccess(7, 5, 2530);
+    CHECK(breaker.Allow(7, 2531));
+
+    const std::vector<ProcessHealth> processes = breaker.Snapshot();
+    const ProcessHealth* health = Find(processes, 7);
+    REQUIRE(health != nullptr);
+    CHECK(health->state == BreakerState::kClosed);
+    CHECK(health->openCount == 0);
+    CHECK(health->consecutiveFailures == 0);
+    CHECK(health->failures == 6);
+    CHECK(health->timeouts == 1);
+    CHECK(health->successes == 1);
+    CHECK(health->rejected == 6);
+    CHECK(health->lastLatencyMicros == 5);
+
+    // The success reset the backoff.
+    breaker.RecordTimeout(7, 3000);
+    CHECK(!breaker.Allow(7, 3099));
+    CHECK(breaker.Allow(7, 3100));
+}
+
+TEST(TimeoutOpensAtOnceAndUnknownProcessesAreNeverRefused) {
+    ProcessCircuitBreaker breaker;
+    CHECK(breaker.Allow(8, 0));
+    breaker.RecordTimeout(8, 0);
+    CHECK(!breaker.Allow(8, 1));
+
+    breaker.RecordTimeout(0, 0);
+    CHECK(breaker.Allow(0, 1));
+    CHECK(Find(breaker.Snapshot(), 0) == nullptr);
+}
+
+TEST(PruningKeepsOpenBreakers) {
+    CircuitBreakerOptions options;
+    options.maxProcesses = 4;
+    ProcessCircuitBreaker breaker(options);
+    breaker.RecordTimeout(8, 0);
+    for (uint32_t processId = 100; processId < 110; processId++) breaker.Allow(processId, 5000 + processId);
+
+    const std::vector<ProcessHealth> processes = breaker.Snapshot();
+    CHECK(processes.size() == 4);
+    const ProcessHealth* open = Find(processes, 8);
+    REQUIRE(open != nullptr);
+    CHECK(open->state == BreakerState::kOpen);
+    CHECK(Find(processes, 109) != nullptr);
+}
+
+TEST(WatchdogAbandonsHungCallsAndRecovers) {
+    FakeProviders providers;
+    ProviderWatchdogOptions options;
+    options.callTimeoutMicros = 30000;
+    options.breaker.initialBackoffMicros = 60000;
+    options.breaker.failureThreshold = 2;
+    ProviderWatchdog watchdog([&](uint64_t token) { providers.Cancel(token); }, options);
+    providers.Set(1, FakeProviders::Mode::kOk);
+    providers.Set(2, FakeProviders::Mode::kFail);
+    providers.Set(3, FakeProviders::Mode::kHang);
+
+    CHECK(Run(watchdog, providers, 1, 10) == Outcome::kSucceeded);
+    CHECK(Run(watchdog, providers, 2, 11) == Outcome::kFailed);
+    CHECK(Run(watchdog, providers, 2, 11) == Outcome::kFailed);
+    CHECK(Run(watchdog, providers, 2, 11) == Outcome::kRejected);
+
+    std::atomic<int> abandonedHooks{0};
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(Run(watchdog, providers, 3, 12, [&] { abandonedHooks++; }) == Outcome::kAbandoned);
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(29));
+    CHECK(abandonedHooks == 1);
+
+    // The open breaker keeps further calls away from the hung process only.
+    const int calls = providers.calls;
+    CHECK(Run(watchdog, providers, 3, 12) == Outcome::kRejected);
+    CHECK(providers.calls == calls);
+    CHECK(Run(watchdog, providers, 1, 10) == Outcome::kSucceeded);
+
+    providers.Set(3, FakeProviders::Mode::kOk);
+    std::this_thread::sleep_for(std::chrono::milliseconds(70));
+    CHECK(Run(watchdog, providers, 3, 12) == Outcome::kSucceeded);
+    CHECK(Run(watchdog, providers, 3, 12) == Outcome::kSucceeded);
+    const std::vector<ProcessHealth> processes = watchdog.Snapshot();
+    const ProcessHealth* health = Find(processes, 3);
+    REQUIRE(health != nullptr);
+    CHECK(health->state == BreakerState::kClosed);
+    CHECK(health->timeouts == 1);
+    CHECK(health->successes == 2);
+    CHECK(watchdog.AbandonedCalls() == 1);
+
+    providers.Set(3, FakeProviders::Mode::kHang);
+    CHECK(Run(watchdog, providers, 3, 13) == Outcome::kAbandoned);
+    const std::vector<ProcessHealth> reopened = watchdog.Snapshot();
+    health = Find(reopened, 3);
+    REQUIRE(health != nullptr);
+    CHECK(health->openCount == 1);
+}
+
+TEST(ProgressKeepsALongCallAlive) {
+    ProviderWatchdogOptions options;
+    options.callTimeoutMicros = 100000;
+    std::atomic<int> cancelled{0};
+    ProviderWatchdog watchdog([&](uint64_t) { cancelled++; }, options);
+
+    // A walk three timeouts long that hears back from its provider every
+    // few milliseconds.
+    {
+        ProviderCall call(watchdog, 4, 20);
+        REQUIRE(call.Allowed());
+        const auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(300)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            CHECK(call.Progress());
+        }
+        CHECK(call.Finish(true));
+    }
+    CHECK(cancelled == 0);
+    CHECK(watchdog.AbandonedCalls() == 0);
+    const std::vector<ProcessHealth> processes = watchdog.Snapshot();
+    const ProcessHealth* health = Find(processes, 4);
+    REQUIRE(health != nullptr);
+    CHECK(health->state == BreakerState::kClosed);
+    CHECK(health->timeouts == 0);
+    CHECK(health->lastLatencyMicros >= 300000);
+
+    // Once the provider stops answering, a timeout from the last answer
+    // abandons the call.
+    ProviderCall call(watchdog, 5, 21);
+    REQUIRE(call.Allowed());
+    CHECK(call.Progress());
+    const auto stalled = std::chrono::steady_clock::now();
+    while (cancelled == 0 && std::chrono::steady_clock::now() - stalled < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(std::chrono::steady_clock::now() - stalled >= std::chrono::milliseconds(90));
+    CHECK(cancelled == 1);
+    CHECK(!call.Progress());
+    CHECK(!call.Finish(true));
+}
+
+TEST(CancelAllUnblocksCallsWithoutCountingThem) {
+    FakeProviders providers;
+    ProviderWatchdog watchdog([&](uint64_t token) { providers.Cancel(token); });
+    providers.Set(6, FakeProviders::Mode::kHang);
+
+    std::atomic<bool> finished{false};
+    Outcome outcome = Outcome::kRejected;
+    std::thread caller([&] {
+        outcome = Run(watchdog, providers, 6, 30);
+        finished = true;
+    });
+    while (providers.calls == 0) std::this_thread::yield();
+    // Cancelling before the call blocks would be lost, as it would be for
+    // CoCancelCall, so keep asking until it returns.
+    while (!finished) {
+        watchdog.CancelAll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    caller.join();
+
+    CHECK(outcome == Outcome::kFailed);
+    CHECK(watchdog.AbandonedCalls() == 0);
+    const std::vector<ProcessHealth> processes = watchdog.Snapshot();
+    const ProcessHealth* health = Find(processes, 6);
+    REQUIRE(health != nullptr);
+    CHECK(health->timeouts == 0);
+    CHECK(health->state == BreakerState::kClosed);
+}
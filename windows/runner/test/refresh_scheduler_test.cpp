@@ -0,0 +1,161 @@
+#include "refresh_scheduler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+constexpr int64_t kSecond = 1000000;
+constexpr int64_t kStart = 1000 * kSecond;
+
+// Takes the due windows at |now| and completes each with |fingerprint|.
+size_t CheckDue(RefreshPolicy& policy, int64_t now, uint64_t fingerprint) {
+    std::vector<uint64_t> due;
+    policy.TakeDue(now, due);
+    for (uint64_t window : due) policy.Complete(window, fingerprint, now);
+    return due.size();
+}
+
+}  // namespace
+
+TEST(UnchangedContentBacksOff) {
+    RefreshPolicy policy;
+    policy.NoteInput(kStart);
+    policy.SetForeground(7, kStart);
+
+    std::vector<uint64_t> due;
+    policy.TakeDue(kStart, due);
+    REQUIRE(due.size() == 1);
+    CHECK(policy.Complete(7, 1, kStart));
+    CHECK(policy.NextDue(kStart) == kStart + kSecond);
+
+    due.clear();
+    policy.TakeDue(kStart + kSecond, due);
+    REQUIRE(due.size() == 1);
+    CHECK(!policy.Complete(7, 1, kStart + kSecond));
+    CHECK(policy.NextDue(kStart + kSecond) == kStart + 3 * kSecond);
+
+    // Input pulls the check forward, but not closer than the base interval.
+    policy.NoteInput(kStart + kSecond + 100000);
+    CHECK(policy.NextDue(kStart + kSecond + 100000) == kStart + 2 * kSecond);
+
+    const RefreshStats stats = policy.Stats(kStart + 2 * kSecond);
+    CHECK(stats.refreshes == 2);
+    CHECK(stats.changes == 0);
+}
+
+TEST(HiddenWindowsAreNeverDue) {
+    RefreshPolicy policy;
+    policy.SetForeground(7, kStart);
+    CHECK(CheckDue(policy, kStart, 1) == 1);
+    policy.SetForeground(0, kStart);
+    policy.SetVisible(7, false);
+    CHECK(policy.NextDue(kStart) == std::numeric_limits<int64_t>::max());
+    policy.SetVisible(7, true);
+    CHECK(policy.NextDue(kStart) < std::numeric_limits<int64_t>::max());
+}
+
+TEST(BackoffIsCapped) {
+    RefreshPolicy policy;
+    policy.NoteInput(kStart);
+    policy.SetForeground(3, kStart);
+    int64_t now = kStart;
+    for (int i = 0; i < 30; i++) {
+        REQUIRE(CheckDue(policy, now, 5) == 1);
+        policy.NoteInput(now);
+        now = policy.NextDue(now);
+    }
+    const RefreshStats stats = policy.Stats(now);
+    REQUIRE(stats.windows.size() == 1);
+    CHECK(stats.windows[0].intervalMicros == 30 * kSecond);
+}
+
+TEST(PowerAndIdlenessStretchIntervals) {
+    RefreshPolicy policy;
+    policy.NoteInput(kStart);
+    policy.SetForeground(7, kStart);
+    CHECK(CheckDue(policy, kStart, 1) == 1);
+    CHECK(policy.NextDue(kStart) == kStart + kSecond);
+
+    policy.SetPower(true, false);
+    CHECK(policy.NextDue(kStart) == kStart + 2 * kSecond);
+    CHECK(policy.SignalPollMicros() == 2 * kSecond);
+    policy.SetPower(true, true);
+    CHECK(policy.NextDue(kStart) == kStart + 4 * kSecond);
+
+    policy.SetPower(false, false);
+    const int64_t idle = kStart + 121 * kSecond;
+    CHECK(policy.Stats(idle).windows[0].intervalMicros == 4 * kSecond);
+}
+
+TEST(ForegroundChangesEvictTheLongestInBackground) {
+    RefreshPolicy policy;
+    for (uint64_t window = 1; window <= 20; window++) {
+        policy.SetForeground(window, kStart + static_cast<int64_t>(window));
+    }
+    const std::vector<uint64_t> windows = policy.Windows();
+    CHECK(windows.size() == 8);
+    CHECK(windows.front() == 13);
+    CHECK(windows.back() == 20);
+}
+
+TEST(FingerprintTellsTextApart) {
+    const std::wstring a = L"Terms of Service";
+    const std::wstring b = L"Terms of service";
+    CHECK(ContentFingerprint(a.data(), a.size()) == ContentFingerprint(a.data(), a.size()));
+    CHECK(ContentFingerprint(a.data(), a.size()) != ContentFingerprint(b.data(), b.size()));
+    CHECK(ContentFingerprint(a.data(), 0) != ContentFingerprint(a.data(), 1));
+}
+
+TEST(SchedulerRefreshesTheForegroundWindow) {
+    std::mutex mutex;
+    std::condition_variable refreshed;
+    int refreshes = 0;
+    RefreshScheduler* scheduler = nullptr;
+
+    RefreshPolicyOptions options;
+    options.foregroundIntervalMicros = 20000;
+    options.maxForegroundIntervalMicros = 80000;
+    options.signalPollMicros = 10000;
+    RefreshScheduler refreshScheduler(
+        [] {
+            RefreshSignals signals;
+            signals.foreground = 42;
+            signals.lastInputMicros = RefreshScheduler::NowMicros();
+            return signals;
+        },
+        [](uint64_t window, bool& visible) {
+            visible = true;
+            return window == 42;
+        },
+        [&](uint64_t window) {
+            int count = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                count = ++refreshes;
+            }
+            scheduler->Complete(window, static_cast<uint64_t>(count / 2));
+            refreshed.notify_all();
+        },
+        options);
+    scheduler = &refreshScheduler;
+    refreshScheduler.Start();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        CHECK(refreshed.wait_for(lock, std::chrono::seconds(10), [&] { return refreshes >= 5; }));
+    }
+    refreshScheduler.Stop();
+
+    const RefreshStats stats = refreshScheduler.Stats();
+    CHECK(stats.refreshes >= 5);
+    CHECK(stats.changes >= 1);
+    REQUIRE(stats.windows.size() == 1);
+    CHECK(stats.windows[0].window == 42);
+}
@@ -0,0 +1,260 @@
+#include "report_writer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "test_util.h"
+
+namespace {
+
+void AppendU8(std::string& out, uint8_t value) {
+    out.push_back(static_cast<char>(value));
+}
+
+void AppendLE16(std::string& out, uint16_t value) {
+    AppendU8(out, static_cast<uint8_t>(value & 0xFF));
+    AppendU8(out, static_cast<uint8_t>(value >> 8));
+}
+
+void AppendLE32(std::string& out, uint32_t value) {
+    AppendLE16(out, static_cast<uint16_t>(value & 0xFFFF));
+    AppendLE16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void AppendString(std::string& out, const std::string& value) {
+    AppendLE32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+}
+
+void AppendBE16(std::string& out, uint16_t value) {
+    AppendU8(out, static_cast<uint8_t>(value >> 8));
+    AppendU8(out, static_cast<uint8_t>(value & 0xFF));
+}
+
+void AppendBE32(std::string& out, uint32_t value) {
+    AppendBE16(out, static_cast<uint16_t>(value >> 16));
+    AppendBE16(out, static_cast<uint16_t>(value & 0xFFFF));
+}
+
+// The smallest font the writer accepts: printable ASCII mapped to empty,
+// half-em glyphs. Table tags are in the sorted order a directory requires.
+std::string BuildTestFont() {
+    constexpr uint16_t kGlyphs = 96;
+    std::string cmap;
+    AppendBE16(cmap, 0);
+    AppendBE16(cmap, 1);
+    AppendBE16(cmap, 3);
+    AppendBE16(cmap, 10);
+    AppendBE32(cmap, 12);
+    AppendBE16(cmap, 12);
+    AppendBE16(cmap, 0);
+    AppendBE32(cmap, 28);
+    AppendBE32(cmap, 0);
+    AppendBE32(cmap, 1);
+    AppendBE32(cmap, 0x20);
+    AppendBE32(cmap, 0x7E);
+    AppendBE32(cmap, 1);
+
+    std::string head(54, '\0');
+    head[18] = 0x03;
+    head[19] = static_cast<char>(0xE8);  // 1000 units per em.
+    std::string hhea(36, '\0');
+    hhea[4] = 0x03;
+    hhea[5] = 0x20;  // Ascent 800.
+    hhea[6] = static_cast<char>(0xFF);
+    hhea[7] = 0x38;  // Descent -200.
+    hhea[35] = 1;
+    std::string hmtx;
+    AppendBE16(hmtx, 500);
+    AppendBE16(hmtx, 0);
+    hmtx.append((kGlyphs - 1) * 2, '\0');
+    const std::string loca((kGlyphs + 1) * 2, '\0');
+    std::string maxp;
+    AppendBE32(maxp, 0x00005000);
+    AppendBE16(maxp, kGlyphs);
+
+    const std::pair<const char*, std::string> tables[] = {
+        {"cmap", cmap}, {"glyf", std::string()}, {"head", head}, {"hhea", hhea},
+        {"hmtx", hmtx}, {"loca", loca}, {"maxp", maxp},
+    };
+    const uint16_t count = static_cast<uint16_t>(sizeof(tables) / sizeof(tables[0]));
+    std::string font;
+    AppendBE32(font, 0x00010000);
+    AppendBE16(font, count);
+    font.append(6, '\0');
+    size_t offset = 12 + count * 16u;
+    std::string data;
+    for (const auto& table : tables) {
+        font += table.first;
+        AppendBE32(font, 0);
+        AppendBE32(font, static_cast<uint32_t>(offset + data.size()));
+        AppendBE32(font, static_cast<uint32_t>(table.second.size()));
+        data += table.second;
+        data.append((4 - data.size() % 4) % 4, '\0');
+    }
+    return font + data;
+}
+
+// An analysis report buffer with |clauses| flagged paragraphs of source
+// text.
+std::string BuildReport(int clauses) {
+    const std::string paragraph =
+        "The Tenant shall indemnify and hold harmless the Landlord from any and all claims, damages, "
+        "losses and expenses arising out of the use of the premises. ";
+    std::string source;
+    std::string flags;
+    for (int i = 0; i < clauses; i++) {
+        const uint32_t at = static_cast<uint32_t>(source.size());
+        source += "Clause " + std::to_string(i + 1) + ". " + paragraph + paragraph + "\n\n";
+        AppendU8(flags, static_cast<uint8_t>(i % 3));
+        AppendU8(flags, 90);
+        AppendLE32(flags, at + 10);
+        AppendLE32(flags, at + 80);
+        AppendString(flags, "\"The Tenant shall indemnify and hold harmless the Landlord\"");
+        AppendString(flags, "Shifts all liability to you, even for the landlord's own negligence.");
+    }
+
+    std::string report = "LERP";
+    AppendLE16(report, 1);
+    AppendString(report, "Residential_Lease.pdf");
+    AppendString(report, "October 19, 2026");
+    AppendLE32(report, 1234);
+    AppendString(report, "Lease");
+    AppendU8(report, 87);
+    AppendString(report, "A lease setting out rent, deposit and termination terms.");
+    AppendString(report, "You pay rent monthly; the landlord may keep the deposit for damage.");
+    AppendLE32(report, static_cast<uint32_t>(clauses));
+    report += flags;
+    AppendString(report, source);
+    return report;
+}
+
+class TestFonts {
+public:
+    TestFonts() { loaded_ = font_.Load(BuildTestFont()); }
+
+    bool Loaded() const { return loaded_; }
+    ReportFonts Fonts() const { return {&font_, &font_, nullptr}; }
+
+private:
+    TrueTypeFont font_;
+    bool loaded_ = false;
+};
+
+// Writes |report| to a temporary file and reads the file back.
+bool Write(const std::string& report, const ReportFonts& fonts, std::string& pdf, ReportWriteStats& stats) {
+    std::FILE* file = std::tmpfile();
+    if (!file) return false;
+    const bool ok = WriteAnalysisReport(reinterpret_cast<const uint8_t*>(report.data()), report.size(), fonts, file,
+                                        stats);
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::rewind(file);
+    pdf.assign(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+    const size_t read = pdf.empty() ? 0 : std::fread(&pdf[0], 1, pdf.size(), file);
+    std::fclose(file);
+    return ok && read == pdf.size();
+}
+
+bool StartsWith(const std::string& text, size_t at, const std::string& prefix) {
+    return at <= text.size() && text.compare(at, prefix.size(), prefix) == 0;
+}
+
+size_t CountOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) count++;
+    return count;
+}
+
+// Number following |key| at its last occurrence, or -1.
+long NumberAfter(const std::string& text, const std::string& key) {
+    const size_t at = text.rfind(key);
+    if (at == std::string::npos) return -1;
+    return std::strtol(text.c_str() + at + key.size(), nullptr, 10);
+}
+
+}  // namespace
+
+TEST(WritesAWellFormedFile) {
+    TestFonts fonts;
+    REQUIRE(fonts.Loaded());
+    std::string pdf;
+    ReportWriteStats stats;
+    REQUIRE(Write(BuildReport(40), fonts.Fonts(), pdf, stats));
+
+    CHECK(StartsWith(pdf, 0, "%PDF-1.7\n"));
+    CHECK(pdf.size() >= 6 && pdf.compare(pdf.size() - 6, 6, "%%EOF\n") == 0);
+    CHECK(stats.bytes == pdf.size());
+
+    // startxref points at the table, and every entry at its object.
+    const long xref = NumberAfter(pdf, "startxref\n");
+    REQUIRE(xref > 0 && static_cast<size_t>(xref) < pdf.size());
+    REQUIRE(StartsWith(pdf, static_cast<size_t>(xref), "xref\n0 "));
+    const long size = NumberAfter(pdf, "/Size ");
+    REQUIRE(size > 1);
+    CHECK(std::strtol(pdf.c_str() + xref + 7, nullptr, 10) == size);
+    const size_t entries = pdf.find('\n', static_cast<size_t>(xref) + 5) + 1;
+    REQUIRE(StartsWith(pdf, entries, "0000000000 65535 f \n"));
+    for (long object = 1; object < size; object++) {
+        const size_t entry = entries + static_cast<size_t>(object) * 20;
+        REQUIRE(StartsWith(pdf, entry + 10, " 00000 n \n"));
+        const size_t offset = static_cast<size_t>(std::strtoull(pdf.c_str() + entry, nullptr, 10));
+        CHECK(StartsWith(pdf, offset, std::to_string(object) + " 0 obj\n"));
+    }
+    CHECK(StartsWith(pdf, entries + static_cast<size_t>(size) * 20, "trailer\n"));
+
+    // A report this long spans pages, and the page tree counts them all.
+    CHECK(stats.pages > 1);
+    CHECK(NumberAfter(pdf, "/Type /Pages /Count ") == stats.pages);
+    CHECK(CountOf(pdf, "/Type /Page /Parent ") == static_cast<size_t>(stats.pages));
+    CHECK(stats.peakPageBytes > 0 && stats.peakPageBytes < pdf.size());
+}
+
+TEST(ShortReportsFitOnOnePage) {
+    TestFonts fonts;
+    REQUIRE(fonts.Loaded());
+    std::string pdf;
+    ReportWriteStats stats;
+    REQUIRE(Write(BuildReport(0), fonts.Fonts(), pdf, stats));
+    CHECK(stats.pages == 1);
+    CHECK(NumberAfter(pdf, "/Type /Pages /Count ") == 1);
+}
+
+TEST(RejectsTruncatedAndMalformedBuffers) {
+    TestFonts fonts;
+    REQUIRE(fonts.Loaded());
+    const std::string report = BuildReport(3);
+    std::string pdf;
+    ReportWriteStats stats;
+    REQUIRE(Write(report, fonts.Fonts(), pdf, stats));
+
+    for (size_t cut : {size_t(0), size_t(3), size_t(5), size_t(10), report.size() / 2, report.size() - 1}) {
+        CHECK(!Write(report.substr(0, cut), fonts.Fonts(), pdf, stats));
+    }
+
+    std::string badMagic = report;
+    badMagic[0] = 'X';
+    CHECK(!Write(badMagic, fonts.Fonts(), pdf, stats));
+
+    std::string badVersion = report;
+    badVersion[4] = 2;
+    CHECK(!Write(badVersion, fonts.Fonts(), pdf, stats));
+
+    // A string length running past the end of the buffer.
+    std::string badLength = report;
+    badLength[6] = static_cast<char>(0xFF);
+    badLength[7] = static_cast<char>(0xFF);
+    CHECK(!Write(badLength, fonts.Fonts(), pdf, stats));
+
+    // The first flag's severity: its confidence, range and the clause's
+    // length lie between it and the clause.
+    std::string badSeverity = report;
+    const size_t severity = report.find("\"The Tenant shall") - 14;
+    REQUIRE(static_cast<uint8_t>(badSeverity[severity]) == 0);
+    badSeverity[severity] = 3;
+    CHECK(!Write(badSeverity, fonts.Fonts(), pdf, stats));
+
+    ReportFonts missing;
+    CHECK(!Write(report, missing, pdf, stats));
+}
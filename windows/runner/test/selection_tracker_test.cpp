@@ -0,0 +1,63 @@
+#include "selection_tracker.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "test_util.h"
+
+TEST(MergeJoinsOverlapsOnceAndDisjointRangesWithANewline) {
+    const SelectionRange merged =
+        MergeSelectionRanges({{10, 15, L"hello"}, {0, 5, L"abcde"}, {13, 20, L"lo worl"}, {5, 7, L"fg"}});
+    CHECK(merged.start == 0);
+    CHECK(merged.end == 20);
+    CHECK(merged.text == L"abcdefg\nhello worl");
+}
+
+TEST(MergeDropsNestedRanges) {
+    const SelectionRange merged = MergeSelectionRanges({{3, 9, L"nested"}, {4, 6, L"es"}});
+    CHECK(merged.text == L"nested");
+    CHECK(merged.end == 9);
+}
+
+TEST(MergeOfNothingIsEmpty) {
+    CHECK(MergeSelectionRanges({}).text.empty());
+    CHECK(MergeSelectionRanges({{4, 4, L""}}).end == 0);
+}
+
+TEST(DragIsReadAtLeastOncePerFrame) {
+    // Notifications every 2ms for 50ms, polled every 0.5ms.
+    SelectionDebouncer debouncer(4000, 16000);
+    CHECK(!debouncer.IsPending());
+    int reads = 0;
+    int64_t lastRead = 0;
+    int64_t maxGap = 0;
+    for (int64_t now = 0; now <= 70000; now += 500) {
+        if (now <= 50000 && now % 2000 == 0) debouncer.Notify(now);
+        if (debouncer.IsDue(now)) {
+            debouncer.Consume();
+            reads++;
+            if (lastRead != 0) maxGap = std::max(maxGap, now - lastRead);
+            lastRead = now;
+        }
+    }
+    CHECK(reads >= 3 && reads <= 5);
+    CHECK(maxGap <= 18000);
+    CHECK(lastRead >= 50000);
+    CHECK(!debouncer.IsPending());
+}
+
+TEST(SingleChangeIsReadAfterTheQuietPeriod) {
+    SelectionDebouncer debouncer;
+    debouncer.Notify(100);
+    CHECK(!debouncer.IsDue(4099));
+    CHECK(debouncer.IsDue(4100));
+}
+
+TEST(OnlyChangedNonEmptySelectionsAreDelivered) {
+    SelectionDebouncer debouncer;
+    const SelectionRange range{1, 3, L"ab"};
+    CHECK(debouncer.ShouldDeliver(range));
+    CHECK(!debouncer.ShouldDeliver(range));
+    CHECK(!debouncer.ShouldDeliver(SelectionRange()));
+    CHECK(debouncer.ShouldDeliver(range));
+}
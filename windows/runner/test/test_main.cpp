@@ -0,0 +1,10 @@
+#include "test_util.h"
+
+int main() {
+    for (const runner_test::TestCase& test : runner_test::Registry()) {
+        const int failuresBefore = runner_test::FailureCount();
+        test.body();
+        std::printf("%s %s\n", runner_test::FailureCount() == failuresBefore ? "[ OK ]" : "[FAIL]", test.name);
+    }
+    return runner_test::FailureCount() == 0 ? 0 : 1;
+}
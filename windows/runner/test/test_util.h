@@ -0,0 +1,60 @@
+#ifndef RUNNER_TEST_TEST_UTIL_H_
+#define RUNNER_TEST_TEST_UTIL_H_
+
+#include <cstdio>
+#include <vector>
+
+// Just enough of a test harness for the runner's modules, which build without
+// exceptions. TEST bodies register themselves; test_main.cpp runs them all and
+// exits non-zero if any CHECK failed. REQUIRE also ends the current test, for
+// checks that guard what follows.
+
+namespace runner_test {
+
+struct TestCase {
+    const char* name;
+    void (*body)();
+};
+
+inline std::vector<TestCase>& Registry() {
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline int& FailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+struct Registrar {
+    Registrar(const char* name, void (*body)()) { Registry().push_back({name, body}); }
+};
+
+inline void ReportFailure(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++FailureCount();
+}
+
+}  // namespace runner_test
+
+#define TEST(name)                                                        \
+    static void name();                                                   \
+    static const runner_test::Registrar name##Registrar(#name, &name);    \
+    static void name()
+
+#define CHECK(condition)                                                  \
+    do {                                                                  \
+        if (!(condition)) {                                               \
+            runner_test::ReportFailure(__FILE__, __LINE__, #condition);   \
+        }                                                                 \
+    } while (false)
+
+#define REQUIRE(condition)                                                \
+    do {                                                                  \
+        if (!(condition)) {                                               \
+            runner_test::ReportFailure(__FILE__, __LINE__, #condition);   \
+            return;                                                       \
+        }                                                                 \
+    } while (false)
+
+#endif
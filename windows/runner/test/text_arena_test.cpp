@@ -0,0 +1,103 @@
+#include "text_arena.h"
+
+#include <string>
+
+#include "test_util.h"
+
+TEST(AppendsAcrossSegmentsInOrder) {
+    TextArena arena(7);
+    std::wstring expected;
+    for (int i = 0; i < 100; i++) {
+        const std::wstring piece = L"element " + std::to_wstring(i);
+        arena.Append(piece.data(), piece.size());
+        arena.Append(L'\n');
+        expected += piece + L'\n';
+    }
+    CHECK(arena.Size() == expected.size());
+    CHECK(arena.CapacityChars() >= expected.size());
+    CHECK(arena.CapacityChars() < expected.size() + 7);
+
+    std::wstring text;
+    arena.CopyTo(text);
+    CHECK(text == expected);
+
+    std::wstring pieces;
+    arena.ForEachPiece([&](const wchar_t* piece, size_t length) {
+        CHECK(length <= 7);
+        pieces.append(piece, length);
+    });
+    CHECK(pieces == expected);
+}
+
+TEST(ClearKeepsSegmentsForReuse) {
+    TextArena arena(16);
+    const std::wstring text(100, L'x');
+    arena.Append(text.data(), text.size());
+    const size_t allocations = arena.SegmentAllocations();
+    arena.Clear();
+    CHECK(arena.Empty());
+    arena.Append(text.data(), text.size());
+    CHECK(arena.SegmentAllocations() == allocations);
+    CHECK(arena.PeakChars() == 100);
+
+    arena.Clear();
+    arena.ReleaseExcess(32);
+    CHECK(arena.CapacityChars() == 32);
+    arena.ReleaseExcess(0);
+    CHECK(arena.CapacityChars() == 0);
+}
+
+TEST(Utf8ConversionHandlesSurrogatesAcrossSegments) {
+    TextArena arena(3);
+    const std::wstring text = L"a\u00E4\u20AC";
+    arena.Append(text.data(), text.size());
+    // Unpaired surrogates, which providers do return, become U+FFFD.
+    arena.Append(static_cast<wchar_t>(0xD800));
+    arena.Append(L'b');
+    arena.Append(static_cast<wchar_t>(0xDC00));
+    std::string expected = "a\xC3\xA4\xE2\x82\xAC\xEF\xBF\xBD" "b" "\xEF\xBF\xBD";
+    if (sizeof(wchar_t) == 2) {
+        // U+1F600 as a pair split over a segment boundary.
+        arena.Append(L'c');
+        arena.Append(static_cast<wchar_t>(0xD83D));
+        arena.Append(static_cast<wchar_t>(0xDE00));
+        expected += "c\xF0\x9F\x98\x80";
+    }
+
+    std::string utf8;
+    arena.CopyToUtf8(utf8);
+    CHECK(utf8 == expected);
+}
+
+TEST(ContextStopsAllocatingOnceWarm) {
+    ExtractionContext context;
+    const std::wstring name(5000, L'n');
+    for (int extraction = 0; extraction < 3; extraction++) {
+        context.Begin();
+        for (int element = 0; element < 50; element++) {
+            std::wstring& scratch = context.Scratch();
+            scratch.assign(name);
+            context.Text().Append(scratch.data(), scratch.size());
+        }
+        context.End();
+        CHECK(context.Text().Empty());
+    }
+    const ExtractionContext::Stats stats = context.GetStats();
+    CHECK(stats.extractions == 3);
+    CHECK(stats.lastAllocations == 0);
+    CHECK(stats.peakBytes >= 250000 * sizeof(wchar_t));
+    CHECK(stats.retainedBytes > 0);
+
+    context.Trim();
+    CHECK(context.Text().CapacityChars() == 0);
+    CHECK(context.GetStats().retainedBytes < stats.retainedBytes);
+}
+
+TEST(ContextReleasesCapacityBeyondTheRetainedSize) {
+    ExtractionContext context;
+    context.Begin();
+    const std::wstring huge(4 * ExtractionContext::kRetainedChars, L'h');
+    context.Text().Append(huge.data(), huge.size());
+    context.End();
+    CHECK(context.Text().CapacityChars() <= ExtractionContext::kRetainedChars);
+}
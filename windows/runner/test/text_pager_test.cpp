@@ -0,0 +1,133 @@
+#include "text_pager.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+// Document of paragraphs; the range is [start_, end_) in characters and each
+// text unit is one paragraph.
+class FakeCursor : public TextRangeCursor {
+public:
+    explicit FakeCursor(const std::vector<std::wstring>& paragraphs) {
+        for (const std::wstring& paragraph : paragraphs) {
+            bounds_.push_back(document_.size());
+            document_ += paragraph;
+        }
+        bounds_.push_back(document_.size());
+    }
+
+    int ExtendEnd(int units) override {
+        int moved = 0;
+        while (moved < units && end_ < document_.size()) {
+            end_ = *std::upper_bound(bounds_.begin(), bounds_.end(), end_);
+            moved++;
+        }
+        return moved;
+    }
+
+    bool GetText(size_t maxLength, std::wstring& text) override {
+        const size_t length = std::min(maxLength, end_ - start_);
+        text.assign(document_, start_, length);
+        maxTransient = std::max(maxTransient, length);
+        return !failing;
+    }
+
+    void AdvanceStart(size_t count) override { start_ = std::min(end_, start_ + count); }
+    void CollapseToEnd() override { start_ = end_; }
+
+    const std::wstring& Document() const { return document_; }
+
+    size_t maxTransient = 0;
+    bool failing = false;
+
+private:
+    std::vector<size_t> bounds_;
+    std::wstring document_;
+    size_t start_ = 0;
+    size_t end_ = 0;
+};
+
+// Paragraphs of 50 to 850 characters; every |giantEvery|th one is 200k.
+std::vector<std::wstring> MakeDocument(std::mt19937& rng, size_t paragraphs, size_t giantEvery = 0) {
+    std::vector<std::wstring> document;
+    for (size_t i = 0; i < paragraphs; i++) {
+        const size_t length = giantEvery != 0 && i % giantEvery == 0 ? 200000 : 50 + rng() % 800;
+        std::wstring paragraph;
+        for (size_t j = 0; j < length; j++) paragraph += static_cast<wchar_t>(L'a' + rng() % 26);
+        paragraph += L'\n';
+        document.push_back(paragraph);
+    }
+    return document;
+}
+
+bool ReadAll(const wchar_t*, size_t) {
+    return true;
+}
+
+}  // namespace
+
+TEST(FullReadReproducesTheDocumentWithinTheChunkSize) {
+    std::mt19937 rng(11);
+    for (size_t chunk : {size_t(1), size_t(7), size_t(1000), size_t(65536)}) {
+        FakeCursor cursor(MakeDocument(rng, 60, 25));
+        TextPagerOptions options;
+        options.maxChunkChars = chunk;
+        options.unitsPerPage = 5;
+        TextPager pager(options);
+        std::wstring text;
+        const TextPagerResult result = pager.Read(cursor, [&](const wchar_t* chunkText, size_t length) {
+            text.append(chunkText, length);
+            return true;
+        });
+        CHECK(result == TextPagerResult::kComplete);
+        CHECK(text == cursor.Document());
+        CHECK(cursor.maxTransient <= chunk);
+        CHECK(pager.CharsRead() == text.size());
+    }
+}
+
+TEST(EmptyDocumentIsComplete) {
+    FakeCursor cursor({});
+    TextPager pager;
+    CHECK(pager.Read(cursor, ReadAll) == TextPagerResult::kComplete);
+    CHECK(pager.ChunksRead() == 0);
+}
+
+TEST(BudgetStopsAtExactlyMaxTotalChars) {
+    std::mt19937 rng(12);
+    FakeCursor cursor(MakeDocument(rng, 2000));
+    TextPagerOptions options;
+    options.maxTotalChars = 123457;
+    options.maxChunkChars = 4096;
+    TextPager pager(options);
+    std::wstring text;
+    const TextPagerResult result = pager.Read(cursor, [&](const wchar_t* chunkText, size_t length) {
+        text.append(chunkText, length);
+        return true;
+    });
+    CHECK(result == TextPagerResult::kBudget);
+    CHECK(text == cursor.Document().substr(0, 123457));
+}
+
+TEST(ConsumerStopsTheReadEarly) {
+    std::mt19937 rng(13);
+    FakeCursor cursor(MakeDocument(rng, 4000));
+    TextPager pager;
+    const TextPagerResult result = pager.Read(cursor, [](const wchar_t*, size_t) { return false; });
+    CHECK(result == TextPagerResult::kStopped);
+    CHECK(pager.ChunksRead() == 1);
+    CHECK(pager.CharsRead() < cursor.Document().size() / 10);
+}
+
+TEST(FailedReadIsReported) {
+    std::mt19937 rng(14);
+    FakeCursor cursor(MakeDocument(rng, 10));
+    cursor.failing = true;
+    TextPager pager;
+    CHECK(pager.Read(cursor, ReadAll) == TextPagerResult::kFailed);
+}
@@ -0,0 +1,96 @@
+#include "text_patch.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+std::wstring RandomText(std::mt19937& rng, size_t length) {
+    std::wstring text;
+    text.reserve(length);
+    for (size_t i = 0; i < length; ++i) {
+        const auto r = rng() % 30;
+        text += r < 26 ? static_cast<wchar_t>(L'a' + r) : (r < 28 ? L' ' : L'\n');
+    }
+    return text;
+}
+
+bool RoundTrips(const std::wstring& previous, const std::wstring& current) {
+    TextPatcher patcher;
+    std::vector<TextPatch> patches;
+    patcher.Compute(previous, current, patches);
+    std::wstring patched = previous;
+    return ApplyTextPatches(patched, patches) && patched == current;
+}
+
+}  // namespace
+
+TEST(RandomEditsRoundTrip) {
+    std::mt19937 rng(7);
+    for (int iteration = 0; iteration < 500; ++iteration) {
+        const std::wstring previous = RandomText(rng, rng() % 5000);
+        std::wstring current = previous;
+        const auto edits = rng() % 6;
+        for (decltype(rng()) e = 0; e < edits; ++e) {
+            const size_t pos = current.empty() ? 0 : rng() % current.size();
+            switch (rng() % 3) {
+            case 0:
+                current.insert(pos, RandomText(rng, rng() % 200));
+                break;
+            case 1:
+                current.erase(pos, rng() % 300);
+                break;
+            default: {
+                const std::wstring block = current.substr(pos, rng() % 400);
+                current.erase(pos, block.size());
+                current.insert(current.empty() ? 0 : rng() % current.size(), block);
+                break;
+            }
+            }
+        }
+        REQUIRE(RoundTrips(previous, current));
+    }
+}
+
+TEST(SmallEditToLargeTextIsAPatch) {
+    std::mt19937 rng(11);
+    const std::wstring previous = RandomText(rng, 200000);
+    std::wstring current = previous;
+    current.insert(50000, L"NEW PARAGRAPH");
+    current.erase(150000, 500);
+    current.replace(100000, 20, L"changed text here!!!");
+
+    TextPatcher patcher;
+    std::vector<TextPatch> patches;
+    REQUIRE(patcher.Compute(previous, current, patches));
+    CHECK(TextPatcher::PayloadSize(patches) < current.size() / 10);
+    std::wstring patched = previous;
+    CHECK(ApplyTextPatches(patched, patches));
+    CHECK(patched == current);
+}
+
+TEST(RewrittenTextFallsBackToFullText) {
+    std::mt19937 rng(13);
+    const std::wstring previous = RandomText(rng, 4000);
+    const std::wstring current = RandomText(rng, 4000);
+    TextPatcher patcher;
+    std::vector<TextPatch> patches;
+    CHECK(!patcher.Compute(previous, current, patches));
+}
+
+TEST(SurrogatePairsRoundTrip) {
+    CHECK(RoundTrips(L"ab\xD83D\xDE00xy", L"ab\xD83D\xDE01xy"));
+    CHECK(RoundTrips(L"ab\xD83D\xDE00xy", L"abxy"));
+}
+
+TEST(OutOfRangePatchIsRejected) {
+    std::wstring text = L"abc";
+    TextPatch patch;
+    patch.kind = TextPatch::Kind::kDelete;
+    patch.offset = 2;
+    patch.length = 5;
+    CHECK(!ApplyTextPatches(text, {patch}));
+}
@@ -0,0 +1,106 @@
+#include "text_segmenter.h"
+
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+std::vector<std::wstring> Pieces(const std::wstring& text, const std::vector<uint32_t>& bounds) {
+    std::vector<std::wstring> pieces;
+    for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+        pieces.push_back(text.substr(bounds[i], bounds[i + 1] - bounds[i]));
+    }
+    return pieces;
+}
+
+std::vector<std::wstring> Sentences(const std::wstring& text) {
+    TextSegmentation result;
+    SegmentLegalText(text.data(), text.size(), result);
+    return Pieces(text, result.sentences);
+}
+
+using Lines = std::vector<std::wstring>;
+
+}  // namespace
+
+TEST(AbbreviationsAndCitationsDoNotEndSentences) {
+    CHECK(Sentences(L"Acme Inc. shall comply with 42 U.S.C. \u00A7 1983 et seq. The Tenant shall pay rent.") ==
+          Lines({L"Acme Inc. shall comply with 42 U.S.C. \u00A7 1983 et seq.", L"The Tenant shall pay rent."}));
+    CHECK(Sentences(L"See \u00A7 4.2(a) of the Lease. Rent is due e.g. monthly, i.e., on the 1st.") ==
+          Lines({L"See \u00A7 4.2(a) of the Lease.", L"Rent is due e.g. monthly, i.e., on the 1st."}));
+    CHECK(Sentences(L"The parties are Smith v. Jones Ltd. and Acme Corp. They agree (as set out in Art. 5). "
+                    L"Is this binding? Yes!") ==
+          Lines({L"The parties are Smith v. Jones Ltd. and Acme Corp.", L"They agree (as set out in Art. 5).",
+                 L"Is this binding?", L"Yes!"}));
+    CHECK(Sentences(L"The value is 3.5 percent. No. 7 applies.") ==
+          Lines({L"The value is 3.5 percent.", L"No. 7 applies."}));
+    CHECK(Sentences(L"Wait... what happens now?") == Lines({L"Wait... what happens now?"}));
+}
+
+TEST(AbbreviationsBeforeANewSentenceEndIt) {
+    CHECK(Sentences(L"Payment is due under Section 4. Tenant shall pay on time.") ==
+          Lines({L"Payment is due under Section 4.", L"Tenant shall pay on time."}));
+    CHECK(Sentences(L"Delivered to the U.S. The buyer pays.") == Lines({L"Delivered to the U.S.", L"The buyer pays."}));
+    CHECK(Sentences(L"As described in Schedule B. Landlord shall repair.") ==
+          Lines({L"As described in Schedule B.", L"Landlord shall repair."}));
+    CHECK(Sentences(L"He said \"Stop.\" Then he left.") == Lines({L"He said \"Stop.\"", L"Then he left."}));
+}
+
+TEST(LineStructureEndsSentences) {
+    CHECK(Sentences(L"Definitions\n1. \"Lease\" means this agreement.\n2. \"Tenant\" means Mr. J. Smith.") ==
+          Lines({L"Definitions", L"1. \"Lease\" means this agreement.", L"2. \"Tenant\" means Mr. J. Smith."}));
+    CHECK(Sentences(L"ARTICLE 1\nDEFINITIONS\nIn this Lease the following terms apply.") ==
+          Lines({L"ARTICLE 1", L"DEFINITIONS", L"In this Lease the following terms apply."}));
+    CHECK(Sentences(L"First paragraph without end\n\nSecond one") ==
+          Lines({L"First paragraph without end", L"Second one"}));
+    CHECK(Sentences(L"The tenant must:\n(a) pay rent;\n(b) keep the premises clean.") ==
+          Lines({L"The tenant must:", L"(a) pay rent;", L"(b) keep the premises clean."}));
+    CHECK(Sentences(L"The term shall\nbe renewed annually.") == Lines({L"The term shall\nbe renewed annually."}));
+}
+
+TEST(OtherScriptsAndEmptyText) {
+    CHECK(Sentences(L"Der Mieter zahlt. \u00C9l paga.") == Lines({L"Der Mieter zahlt.", L"\u00C9l paga."}));
+    CHECK(Sentences(L"\u5951\u7D04\u306F\u6709\u52B9\u3067\u3059\u3002\u89E3\u9664\u3067\u304D\u307E\u3059\u3002") ==
+          Lines({L"\u5951\u7D04\u306F\u6709\u52B9\u3067\u3059\u3002", L"\u89E3\u9664\u3067\u304D\u307E\u3059\u3002"}));
+    CHECK(Sentences(L"").empty());
+    CHECK(Sentences(L"   \n  ").empty());
+}
+
+TEST(ClausesSplitAtPunctuationAndEnumerations) {
+    const std::wstring text =
+        L"The Tenant shall (a) pay rent when due; (b) not sublet; and (iii) comply with \u00A7 4.2(a) at 10:30 a.m.: "
+        L"all obligations are joint.";
+    TextSegmentation result;
+    SegmentLegalText(text.data(), text.size(), result);
+    CHECK(Pieces(text, result.clauses) ==
+          Lines({L"The Tenant shall", L"(a) pay rent when due;", L"(b) not sublet;", L"and",
+                 L"(iii) comply with \u00A7 4.2(a) at 10:30 a.m.:", L"all obligations are joint."}));
+    CHECK(result.metrics.sentences == 1);
+    CHECK(result.metrics.clauses == 6);
+    CHECK(result.metrics.words == 20);
+}
+
+TEST(MetricsCountPassivesAndReadability) {
+    const std::wstring text =
+        L"The rent shall be paid monthly. The deposit was not promptly returned. "
+        L"It is hereby agreed that fees are waived. The lease is void.";
+    TextSegmentation result;
+    SegmentLegalText(text.data(), text.size(), result);
+    const TextMetrics& metrics = result.metrics;
+    CHECK(metrics.words == 24);
+    CHECK(metrics.sentences == 4);
+    CHECK(metrics.passiveConstructions == 4);
+    CHECK(metrics.passiveSentences == 3);
+    CHECK(metrics.averageSentenceWords == 6.0);
+
+    const std::wstring dense =
+        L"Notwithstanding anything to the contrary contained herein, the indemnifying party shall indemnify, "
+        L"defend and hold harmless the indemnified parties from and against any and all liabilities.";
+    TextSegmentation denseResult;
+    SegmentLegalText(dense.data(), dense.size(), denseResult);
+    CHECK(denseResult.metrics.sentences == 1);
+    CHECK(denseResult.metrics.fleschReadingEase < 30.0);
+    CHECK(denseResult.metrics.fleschKincaidGrade > metrics.fleschKincaidGrade + 10.0);
+}
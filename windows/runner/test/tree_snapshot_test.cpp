@@ -0,0 +1,103 @@
+#include "tree_snapshot.h"
+
+#include <initializer_list>
+#include <string>
+
+#include "test_util.h"
+
+namespace {
+
+TreeSnapshot MakeSnapshot(std::initializer_list<SnapshotElement> elements) {
+    TreeSnapshot snapshot;
+    for (const SnapshotElement& element : elements) {
+        snapshot.Add(element.key, element.parentKey, element.controlType, element.text);
+    }
+    return snapshot;
+}
+
+bool ContainsKey(const std::vector<SnapshotElement>& elements, const std::string& key) {
+    for (const SnapshotElement& element : elements) {
+        if (element.key == key) return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(ReportsInsertedChangedAndRemovedElements) {
+    TreeSnapshot previous = MakeSnapshot({{"1", "", 0, L"root"}, {"1.1", "1", 1, L"x"}, {"1.2", "1", 1, L"y"}});
+    TreeSnapshot current = MakeSnapshot({{"1", "", 0, L"root"}, {"1.1", "1", 1, L"x2"}, {"1.3", "1", 1, L"z"}});
+    TreeDelta delta;
+    DiffTreeSnapshots(previous, current, delta);
+
+    REQUIRE(delta.inserted.size() == 1);
+    CHECK(delta.inserted[0].key == "1.3");
+    CHECK(delta.inserted[0].text == L"z");
+    REQUIRE(delta.changed.size() == 1);
+    CHECK(delta.changed[0].key == "1.1");
+    CHECK(delta.changed[0].text == L"x2");
+    REQUIRE(delta.removed.size() == 1);
+    CHECK(delta.removed[0] == "1.2");
+}
+
+TEST(TreatsMovesAndControlTypeChangesAsChanges) {
+    TreeSnapshot previous = MakeSnapshot({{"1", "", 0, L""}, {"1.1", "1", 1, L"a"}, {"1.2", "1", 1, L"b"}});
+    TreeSnapshot current = MakeSnapshot({{"1", "", 0, L""}, {"1.1", "1.2", 1, L"a"}, {"1.2", "1", 2, L"b"}});
+    TreeDelta delta;
+    DiffTreeSnapshots(previous, current, delta);
+
+    CHECK(delta.inserted.empty());
+    CHECK(delta.removed.empty());
+    CHECK(delta.changed.size() == 2);
+    CHECK(ContainsKey(delta.changed, "1.1"));
+    CHECK(ContainsKey(delta.changed, "1.2"));
+}
+
+TEST(IdenticalSnapshotsProduceAnEmptyDelta) {
+    TreeSnapshot snapshot = MakeSnapshot({{"1", "", 0, L"root"}, {"1.1", "1", 1, L"x"}});
+    TreeDelta delta;
+    delta.removed.push_back("stale");
+    DiffTreeSnapshots(snapshot, snapshot, delta);
+
+    CHECK(delta.IsEmpty());
+}
+
+TEST(EverythingIsInsertedAgainstAnEmptySnapshot) {
+    TreeSnapshot empty;
+    TreeSnapshot current = MakeSnapshot({{"1", "", 0, L"root"}, {"1.1", "1", 1, L"x"}, {"1.2", "1", 1, L"y"}});
+    TreeDelta delta;
+    DiffTreeSnapshots(empty, current, delta);
+
+    CHECK(delta.inserted.size() == 3);
+    CHECK(delta.changed.empty());
+    CHECK(delta.removed.empty());
+}
+
+TEST(DuplicateKeysKeepTheLaterEntry) {
+    TreeSnapshot snapshot;
+    snapshot.Add("1", "", 0, L"first");
+    snapshot.Add("1", "", 0, L"second");
+
+    REQUIRE(snapshot.Size() == 1);
+    const SnapshotElement* element = snapshot.Find("1");
+    REQUIRE(element != nullptr);
+    CHECK(element->text == L"second");
+    CHECK(element->textHash == HashSnapshotText(L"second"));
+}
+
+TEST(FallbackKeysFromSiblingSlotsDiffLikeRuntimeIds) {
+    // Elements without a runtime id are keyed by parent, sibling slot and
+    // ordinal, so one inserted in front of a differently typed sibling must
+    // not shift that sibling's key.
+    TreeSnapshot previous = MakeSnapshot({{"/root", "", 0, L""}, {"/root/ct:50020#0", "/root", 50020, L"Terms"}});
+    TreeSnapshot current = MakeSnapshot({{"/root", "", 0, L""},
+                                         {"/root/id:banner#0", "/root", 50004, L"Cookie notice"},
+                                         {"/root/ct:50020#0", "/root", 50020, L"Terms"}});
+    TreeDelta delta;
+    DiffTreeSnapshots(previous, current, delta);
+
+    REQUIRE(delta.inserted.size() == 1);
+    CHECK(delta.inserted[0].key == "/root/id:banner#0");
+    CHECK(delta.changed.empty());
+    CHECK(delta.removed.empty());
+}
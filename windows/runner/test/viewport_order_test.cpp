@@ -0,0 +1,94 @@
+#include "viewport_order.h"
+
+#include <vector>
+
+#include "test_util.h"
+
+namespace {
+
+// 1000 paragraphs of 40px each, of which y in [4000, 5000) is on screen,
+// followed by an element without bounds and one right of the viewport.
+constexpr size_t kParagraphs = 1000;
+constexpr size_t kUnbounded = kParagraphs;
+constexpr size_t kBeside = kParagraphs + 1;
+const ViewportRect kViewport{0, 4000, 1000, 5000};
+
+std::vector<ViewportElement> MakePage() {
+    std::vector<ViewportElement> elements;
+    for (int i = 0; i < static_cast<int>(kParagraphs); i++) {
+        ViewportElement element;
+        element.bounds = {0, i * 40, 800, i * 40 + 40};
+        element.offscreen = !(element.bounds.bottom > kViewport.top && element.bounds.top < kViewport.bottom);
+        elements.push_back(element);
+    }
+    elements.push_back(ViewportElement());
+    ViewportElement beside;
+    beside.bounds = {2000, 4100, 2100, 4200};
+    elements.push_back(beside);
+    return elements;
+}
+
+}  // namespace
+
+TEST(FirstBandIsTheVisibleTextInDocumentOrder) {
+    const std::vector<ViewportElement> elements = MakePage();
+    ViewportOrder order;
+    order.Build(elements, kViewport);
+
+    std::vector<size_t> band;
+    REQUIRE(order.NextBand(band));
+    REQUIRE(band.size() == 25);
+    for (size_t i = 0; i < band.size(); i++) {
+        CHECK(band[i] == 100 + i);
+    }
+}
+
+TEST(LaterBandsWidenOneViewportAtATime) {
+    const std::vector<ViewportElement> elements = MakePage();
+    ViewportOrder order;
+    order.Build(elements, kViewport);
+
+    std::vector<size_t> band;
+    std::vector<bool> seen(elements.size());
+    REQUIRE(order.NextBand(band));
+    for (size_t index : band) seen[index] = true;
+
+    REQUIRE(order.NextBand(band));
+    bool hasBeside = false;
+    for (size_t index : band) {
+        CHECK(!seen[index]);
+        seen[index] = true;
+        if (index == kBeside) hasBeside = true;
+        if (index < kParagraphs) {
+            const int top = elements[index].bounds.top;
+            CHECK(top >= 3000 - 40 && top < 6000 + 40);
+        }
+    }
+    CHECK(hasBeside);
+
+    size_t lastIndex = 0;
+    while (order.NextBand(band)) {
+        for (size_t index : band) {
+            CHECK(!seen[index]);
+            seen[index] = true;
+        }
+        lastIndex = band.back();
+    }
+    for (bool wasSeen : seen) CHECK(wasSeen);
+    CHECK(lastIndex == kUnbounded);
+    CHECK(order.Remaining() == 0);
+}
+
+TEST(EmptyViewportAndExtremeCoordinatesStillEmitEverything) {
+    std::vector<ViewportElement> elements(3);
+    elements[0].bounds = {0, -2000000000, 10, -1999999990};
+    elements[1].bounds = {0, 0, 10, 10};
+    elements[2].bounds = {0, 2000000000, 10, 2000000010};
+    ViewportOrder order;
+    order.Build(elements, ViewportRect());
+
+    std::vector<size_t> band;
+    size_t total = 0;
+    while (order.NextBand(band)) total += band.size();
+    CHECK(total == 3);
+}
@@ -0,0 +1,163 @@
+#include "text_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr uint32_t kReplacementCharacter = 0xFFFD;
+
+// Decodes the arena's UTF-16 (or UTF-32 where wchar_t is 32 bits) into code
+// points across piece boundaries, so a surrogate pair split between two
+// segments still decodes as one character.
+class CodePointReader {
+public:
+    template <typename Emit>
+    void Feed(const wchar_t* text, size_t length, Emit&& emit) {
+        for (size_t i = 0; i < length; i++) {
+            const uint32_t unit = static_cast<uint32_t>(text[i]);
+            if (sizeof(wchar_t) != 2) {
+                emit(unit > 0x10FFFF || (unit >= 0xD800 && unit <= 0xDFFF) ? kReplacementCharacter : unit);
+                continue;
+            }
+            if (pendingHigh_ != 0) {
+                const uint32_t high = pendingHigh_;
+                pendingHigh_ = 0;
+                if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                    emit(0x10000 + ((high - 0xD800) << 10) + (unit - 0xDC00));
+                    continue;
+                }
+                emit(kReplacementCharacter);
+            }
+            if (unit >= 0xD800 && unit <= 0xDBFF) {
+                pendingHigh_ = unit;
+            } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+                emit(kReplacementCharacter);
+            } else {
+                emit(unit);
+            }
+        }
+    }
+
+    template <typename Emit>
+    void Finish(Emit&& emit) {
+        if (pendingHigh_ != 0) emit(kReplacementCharacter);
+        pendingHigh_ = 0;
+    }
+
+private:
+    uint32_t pendingHigh_ = 0;
+};
+
+size_t Utf8Length(uint32_t codePoint) {
+    return codePoint < 0x80 ? 1 : codePoint < 0x800 ? 2 : codePoint < 0x10000 ? 3 : 4;
+}
+
+}  // namespace
+
+TextArena::TextArena(size_t segmentChars) : segmentChars_(std::max<size_t>(1, segmentChars)) {}
+
+void TextArena::Append(const wchar_t* text, size_t length) {
+    while (length > 0) {
+        const size_t segment = size_ / segmentChars_;
+        const size_t offset = size_ % segmentChars_;
+        if (segment == segments_.size()) {
+            segments_.emplace_back(new wchar_t[segmentChars_]);
+            allocations_++;
+        }
+        const size_t count = std::min(length, segmentChars_ - offset);
+        std::memcpy(segments_[segment].get() + offset, text, count * sizeof(wchar_t));
+        size_ += count;
+        text += count;
+        length -= count;
+    }
+    peak_ = std::max(peak_, size_);
+}
+
+void TextArena::CopyTo(std::wstring& text) const {
+    text.clear();
+    text.reserve(size_);
+    ForEachPiece([&text](const wchar_t* piece, size_t length) { text.append(piece, length); });
+}
+
+void TextArena::CopyToUtf8(std::string& text) const {
+    // Measure first so the string is allocated once at its final size.
+    size_t bytes = 0;
+    {
+        CodePointReader reader;
+        auto count = [&bytes](uint32_t codePoint) { bytes += Utf8Length(codePoint); };
+        ForEachPiece([&](const wchar_t* piece, size_t length) { reader.Feed(piece, length, count); });
+        reader.Finish(count);
+    }
+
+    text.clear();
+    text.resize(bytes);
+    char* out = &text[0];
+    auto write = [&out](uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            *out++ = static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    };
+    CodePointReader reader;
+    ForEachPiece([&](const wchar_t* piece, size_t length) { reader.Feed(piece, length, write); });
+    reader.Finish(write);
+}
+
+void TextArena::ReleaseExcess(size_t retainChars) {
+    const size_t used = (size_ + segmentChars_ - 1) / segmentChars_;
+    const size_t retained = std::max(used, retainChars / segmentChars_);
+    if (segments_.size() > retained) {
+        segments_.resize(retained);
+    }
+}
+
+void ExtractionContext::Begin() {
+    text_.Clear();
+    scratch_.clear();
+    allocationsAtBegin_ = text_.SegmentAllocations();
+    scratchCapacityAtBegin_ = scratch_.capacity();
+}
+
+void ExtractionContext::End() {
+    extractions_++;
+    lastAllocations_ = text_.SegmentAllocations() - allocationsAtBegin_;
+    if (scratch_.capacity() > scratchCapacityAtBegin_) lastAllocations_++;
+    peakScratchChars_ = std::max(peakScratchChars_, scratch_.capacity());
+
+    text_.Clear();
+    text_.ReleaseExcess(kRetainedChars);
+    scratch_.clear();
+    if (scratch_.capacity() > kRetainedChars) {
+        std::wstring().swap(scratch_);
+    }
+}
+
+void ExtractionContext::Trim() {
+    text_.Clear();
+    text_.ReleaseExcess(0);
+    std::wstring().swap(scratch_);
+}
+
+ExtractionContext::Stats ExtractionContext::GetStats() const {
+    Stats stats;
+    stats.extractions = extractions_;
+    stats.lastAllocations = lastAllocations_;
+    const size_t segmentChars = text_.SegmentChars();
+    const size_t peakTextChars = (text_.PeakChars() + segmentChars - 1) / segmentChars * segmentChars;
+    stats.peakBytes = (peakTextChars + peakScratchChars_) * sizeof(wchar_t);
+    stats.retainedBytes = (text_.CapacityChars() + scratch_.capacity()) * sizeof(wchar_t);
+    return stats;
+}
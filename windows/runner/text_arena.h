@@ -0,0 +1,107 @@
+#ifndef RUNNER_TEXT_ARENA_H_
+#define RUNNER_TEXT_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Append-only text buffer made of fixed-size segments that are kept between
+// uses. Growing never copies what is already written, and Clear() only
+// rewinds, so once the arena has reached the size of a typical extraction
+// further extractions append without touching the heap.
+class TextArena {
+public:
+    static constexpr size_t kDefaultSegmentChars = 32 * 1024;
+
+    explicit TextArena(size_t segmentChars = kDefaultSegmentChars);
+
+    TextArena(const TextArena&) = delete;
+    TextArena& operator=(const TextArena&) = delete;
+
+    void Append(const wchar_t* text, size_t length);
+    void Append(wchar_t ch) { Append(&ch, 1); }
+
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+
+    // Calls |visit(text, length)| for each contiguous piece, in order.
+    template <typename Visitor>
+    void ForEachPiece(Visitor&& visit) const {
+        size_t remaining = size_;
+        for (size_t i = 0; remaining > 0; i++) {
+            const size_t length = remaining < segmentChars_ ? remaining : segmentChars_;
+            visit(segments_[i].get(), length);
+            remaining -= length;
+        }
+    }
+
+    // Replaces |text| with the arena's contents in one allocation.
+    void CopyTo(std::wstring& text) const;
+    // Replaces |text| with the contents converted to UTF-8, sized exactly in
+    // one allocation. Unpaired surrogates become U+FFFD.
+    void CopyToUtf8(std::string& text) const;
+
+    // Empties the arena and keeps its segments for the next use.
+    void Clear() { size_ = 0; }
+    // Frees unused segments beyond |retainChars| of capacity, so one huge
+    // document does not pin its memory for the life of the process.
+    void ReleaseExcess(size_t retainChars);
+
+    size_t SegmentChars() const { return segmentChars_; }
+    size_t CapacityChars() const { return segments_.size() * segmentChars_; }
+    // Largest Size() since construction.
+    size_t PeakChars() const { return peak_; }
+    // Segments allocated since construction.
+    size_t SegmentAllocations() const { return allocations_; }
+
+private:
+    size_t segmentChars_;
+    std::vector<std::unique_ptr<wchar_t[]>> segments_;
+    size_t size_ = 0;
+    size_t peak_ = 0;
+    size_t allocations_ = 0;
+};
+
+// Buffers one UIAutomation instance reuses for every extraction: the arena
+// that collects a window's text and scratch space for the element being
+// read, whose name and value BSTRs are appended in place rather than
+// through temporary strings.
+class ExtractionContext {
+public:
+    struct Stats {
+        size_t extractions = 0;
+        // Arena segments allocated during the last extraction, plus one if
+        // the scratch buffer grew; 0 once both have reached working size.
+        size_t lastAllocations = 0;
+        size_t peakBytes = 0;
+        size_t retainedBytes = 0;
+    };
+
+    // Capacity kept between extractions by each buffer.
+    static constexpr size_t kRetainedChars = 1024 * 1024;
+
+    TextArena& Text() { return text_; }
+    std::wstring& Scratch() { return scratch_; }
+
+    // Brackets one extraction; copy the text out before End(), which empties
+    // the buffers, releases capacity beyond kRetainedChars and updates the
+    // statistics.
+    void Begin();
+    void End();
+    // Frees all retained capacity. Only between extractions.
+    void Trim();
+
+    Stats GetStats() const;
+
+private:
+    TextArena text_;
+    std::wstring scratch_;
+    size_t extractions_ = 0;
+    size_t lastAllocations_ = 0;
+    size_t allocationsAtBegin_ = 0;
+    size_t scratchCapacityAtBegin_ = 0;
+    size_t peakScratchChars_ = 0;
+};
+
+#endif
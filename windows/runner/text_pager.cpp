@@ -0,0 +1,45 @@
+#include "text_pager.h"
+
+#include <algorithm>
+
+TextPagerResult TextPager::Read(TextRangeCursor& cursor, const Consumer& consume) {
+    chunks_ = 0;
+    chars_ = 0;
+    const size_t chunkChars = std::max<size_t>(1, options_.maxChunkChars);
+    const int unitsPerPage = std::max(1, options_.unitsPerPage);
+
+    while (true) {
+        if (options_.maxTotalChars > 0 && chars_ >= options_.maxTotalChars) {
+            return TextPagerResult::kBudget;
+        }
+        if (cursor.ExtendEnd(unitsPerPage) <= 0) {
+            return TextPagerResult::kComplete;
+        }
+
+        // Drain the page in bounded chunks. A chunk shorter than the limit
+        // means the page is exhausted.
+        while (true) {
+            size_t limit = chunkChars;
+            if (options_.maxTotalChars > 0) {
+                limit = std::min(limit, options_.maxTotalChars - chars_);
+            }
+            if (!cursor.GetText(limit, buffer_)) {
+                return TextPagerResult::kFailed;
+            }
+            const size_t length = std::min(buffer_.size(), limit);
+            if (length == 0) break;
+
+            chunks_++;
+            chars_ += length;
+            if (!consume(buffer_.data(), length)) {
+                return TextPagerResult::kStopped;
+            }
+            if (length < limit) break;
+            if (options_.maxTotalChars > 0 && chars_ >= options_.maxTotalChars) {
+                return TextPagerResult::kBudget;
+            }
+            cursor.AdvanceStart(length);
+        }
+        cursor.CollapseToEnd();
+    }
+}
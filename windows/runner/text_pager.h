@@ -0,0 +1,66 @@
+#ifndef RUNNER_TEXT_PAGER_H_
+#define RUNNER_TEXT_PAGER_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// The subset of a text range the pager needs, so paging can be driven by
+// IUIAutomationTextRange on Windows and by a fake in tests. The range starts
+// collapsed at the beginning of the document.
+class TextRangeCursor {
+public:
+    virtual ~TextRangeCursor() = default;
+
+    // Moves the range's end forward by up to |units| text units (paragraphs
+    // or pages) and returns how many it moved; 0 at the end of the document.
+    virtual int ExtendEnd(int units) = 0;
+    // Copies at most |maxLength| characters of the range into |text|.
+    virtual bool GetText(size_t maxLength, std::wstring& text) = 0;
+    // Moves the range's start forward by |count| characters.
+    virtual void AdvanceStart(size_t count) = 0;
+    // Collapses the range to its end.
+    virtual void CollapseToEnd() = 0;
+};
+
+struct TextPagerOptions {
+    // Text units fetched per page.
+    int unitsPerPage = 32;
+    // Largest single GetText call; longer pages are read in several chunks.
+    size_t maxChunkChars = 64 * 1024;
+    // Total characters to read before stopping; 0 for no limit.
+    size_t maxTotalChars = 0;
+};
+
+enum class TextPagerResult {
+    kComplete,
+    // The consumer asked to stop.
+    kStopped,
+    // maxTotalChars was reached.
+    kBudget,
+    kFailed,
+};
+
+// Reads a document a page at a time through one reused buffer, so memory
+// stays bounded by maxChunkChars however large the document is, and stops
+// as soon as the consumer has what it needs.
+class TextPager {
+public:
+    // Receives each chunk in document order; returns false to stop reading.
+    using Consumer = std::function<bool(const wchar_t* text, size_t length)>;
+
+    explicit TextPager(const TextPagerOptions& options = TextPagerOptions()) : options_(options) {}
+
+    TextPagerResult Read(TextRangeCursor& cursor, const Consumer& consume);
+
+    size_t ChunksRead() const { return chunks_; }
+    size_t CharsRead() const { return chars_; }
+
+private:
+    TextPagerOptions options_;
+    std::wstring buffer_;
+    size_t chunks_ = 0;
+    size_t chars_ = 0;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "text_patch.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr size_t kMinChunkLength = 16;
+constexpr size_t kMaxChunkLength = 1024;
+// Tests the top six bits of the gear hash, giving a boundary on average every
+// 64 characters past the minimum. The high bits depend on the last 64 inputs
+// only, so chunk boundaries re-synchronise shortly after an edit.
+constexpr unsigned long long kBoundaryMask = 0xFC00000000000000ULL;
+constexpr size_t kPatchOverhead = 8;
+
+unsigned long long GearValue(wchar_t ch) {
+    unsigned long long x = static_cast<unsigned long long>(ch) + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool IsLowSurrogate(wchar_t ch) {
+    return ch >= 0xDC00 && ch <= 0xDFFF;
+}
+
+// A position is a safe cut if it does not separate a UTF-16 surrogate pair;
+// Dart receives the patch text as UTF-8 and cannot encode half a pair.
+bool IsSafeCut(const std::wstring& text, size_t pos) {
+    return pos == 0 || pos >= text.size() || !IsLowSurrogate(text[pos]);
+}
+
+bool RangesEqual(const std::wstring& a, size_t aBegin, size_t aEnd,
+                 const std::wstring& b, size_t bBegin, size_t bEnd) {
+    if (aEnd - aBegin != bEnd - bBegin) return false;
+    return std::equal(a.begin() + aBegin, a.begin() + aEnd, b.begin() + bBegin);
+}
+
+void EmitGap(const std::wstring& current, size_t oldBegin, size_t oldEnd,
+             size_t newBegin, size_t newEnd, std::vector<TextPatch>& patches) {
+    if (oldEnd > oldBegin) {
+        TextPatch patch;
+        patch.kind = TextPatch::Kind::kDelete;
+        patch.offset = newBegin;
+        patch.length = oldEnd - oldBegin;
+        patches.push_back(std::move(patch));
+    }
+    if (newEnd > newBegin) {
+        TextPatch patch;
+        patch.kind = TextPatch::Kind::kInsert;
+        patch.offset = newBegin;
+        patch.length = newEnd - newBegin;
+        patch.text.assign(current, newBegin, newEnd - newBegin);
+        patches.push_back(std::move(patch));
+    }
+}
+
+}  // namespace
+
+void TextPatcher::SplitChunks(const std::wstring& text, size_t begin, size_t end, std::vector<Chunk>& chunks) const {
+    unsigned long long gear = 0;
+    unsigned long long hash = 14695981039346656037ULL;
+    size_t chunkBegin = begin;
+
+    for (size_t i = begin; i < end; i++) {
+        const wchar_t ch = text[i];
+        gear = (gear << 1) + GearValue(ch);
+        hash = (hash ^ static_cast<unsigned long long>(ch)) * 1099511628211ULL;
+
+        const size_t length = i + 1 - chunkBegin;
+        if (length < kMinChunkLength) continue;
+        if ((gear & kBoundaryMask) != 0 && length < kMaxChunkLength) continue;
+        if (!IsSafeCut(text, i + 1)) continue;
+
+        chunks.push_back({chunkBegin, i + 1, hash});
+        chunkBegin = i + 1;
+        hash = 14695981039346656037ULL;
+    }
+    if (chunkBegin < end) {
+        chunks.push_back({chunkBegin, end, hash});
+    }
+}
+
+bool TextPatcher::Compute(const std::wstring& previous, const std::wstring& current, std::vector<TextPatch>& patches) const {
+    patches.clear();
+
+    const size_t shorter = std::min(previous.size(), current.size());
+    size_t prefix = 0;
+    while (prefix < shorter && previous[prefix] == current[prefix]) prefix++;
+    while (prefix > 0 && (!IsSafeCut(previous, prefix) || !IsSafeCut(current, prefix))) prefix--;
+
+    size_t suffix = 0;
+    while (suffix < shorter - prefix &&
+           previous[previous.size() - 1 - suffix] == current[current.size() - 1 - suffix]) {
+        suffix++;
+    }
+    while (suffix > 0 && !IsSafeCut(current, current.size() - suffix)) suffix--;
+
+    const size_t oldEnd = previous.size() - suffix;
+    const size_t newEnd = current.size() - suffix;
+    if (prefix == oldEnd && prefix == newEnd) return true;
+
+    std::vector<Chunk> oldChunks;
+    std::vector<Chunk> newChunks;
+    SplitChunks(previous, prefix, oldEnd, oldChunks);
+    SplitChunks(current, prefix, newEnd, newChunks);
+
+    std::unordered_map<unsigned long long, std::vector<size_t>> oldByHash;
+    oldByHash.reserve(oldChunks.size());
+    for (size_t i = 0; i < oldChunks.size(); i++) {
+        oldByHash[oldChunks[i].hash].push_back(i);
+    }
+
+    size_t oldPos = prefix;
+    size_t newPos = prefix;
+    size_t nextOldChunk = 0;
+    for (const Chunk& chunk : newChunks) {
+        auto it = oldByHash.find(chunk.hash);
+        if (it == oldByHash.end()) continue;
+
+        // Anchors must appear in the same order in both texts; take the
+        // earliest old chunk at or after the last anchor.
+        const auto& candidates = it->second;
+        auto candidate = std::lower_bound(candidates.begin(), candidates.end(), nextOldChunk);
+        for (; candidate != candidates.end(); ++candidate) {
+            const Chunk& old = oldChunks[*candidate];
+            if (RangesEqual(previous, old.begin, old.end, current, chunk.begin, chunk.end)) break;
+        }
+        if (candidate == candidates.end()) continue;
+
+        const Chunk& anchor = oldChunks[*candidate];
+        EmitGap(current, oldPos, anchor.begin, newPos, chunk.begin, patches);
+        oldPos = anchor.end;
+        newPos = chunk.end;
+        nextOldChunk = *candidate + 1;
+    }
+    EmitGap(current, oldPos, oldEnd, newPos, newEnd, patches);
+
+    return PayloadSize(patches) * 2 < current.size();
+}
+
+size_t TextPatcher::PayloadSize(const std::vector<TextPatch>& patches) {
+    size_t size = 0;
+    for (const auto& patch : patches) {
+        size += kPatchOverhead + patch.text.size();
+    }
+    return size;
+}
+
+bool ApplyTextPatches(std::wstring& text, const std::vector<TextPatch>& patches) {
+    for (const auto& patch : patches) {
+        if (patch.offset > text.size()) return false;
+        if (patch.kind == TextPatch::Kind::kDelete) {
+            if (patch.length > text.size() - patch.offset) return false;
+            text.erase(patch.offset, patch.length);
+        } else {
+            text.insert(patch.offset, patch.text);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef RUNNER_TEXT_PATCH_H_
+#define RUNNER_TEXT_PATCH_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A single edit. Offsets refer to the text as it stands after every earlier
+// patch in the same list has been applied, so a consumer can apply the list
+// front to back without re-basing anything.
+struct TextPatch {
+    enum class Kind { kInsert, kDelete };
+
+    Kind kind = Kind::kInsert;
+    size_t offset = 0;
+    size_t length = 0;
+    std::wstring text;
+};
+
+// Computes insert/delete patches between consecutive extractions of the same
+// window. After trimming the common prefix and suffix, the remaining middle is
+// cut into content-defined chunks with a rolling hash; identical chunks act as
+// anchors and only the gaps between anchors become patches. This is linear in
+// the input size and, unlike a full O(ND) diff, does not degrade when large
+// regions move or re-render.
+class TextPatcher {
+public:
+    // Returns false when the patch set would not be meaningfully smaller than
+    // |current| itself, in which case the caller should ship the full text.
+    bool Compute(const std::wstring& previous, const std::wstring& current, std::vector<TextPatch>& patches) const;
+
+    // Size of the patch payload in characters, used for the above decision.
+    static size_t PayloadSize(const std::vector<TextPatch>& patches);
+
+private:
+    struct Chunk {
+        size_t begin;
+        size_t end;
+        unsigned long long hash;
+    };
+
+    void SplitChunks(const std::wstring& text, size_t begin, size_t end, std::vector<Chunk>& chunks) const;
+};
+
+// Applies |patches| to |text| in order. Returns false if a patch is out of
+// range, leaving |text| partially patched.
+bool ApplyTextPatches(std::wstring& text, const std::vector<TextPatch>& patches);
+
+#endif
@@ -0,0 +1,624 @@
+#include "text_segmenter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "unicode_fold.h"
+
+namespace {
+
+constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+// Folded token text kept for lexicon lookups; longer tokens are never
+// abbreviations or be-forms, and participles only need their ending.
+constexpr size_t kKeyCapacity = 15;
+
+// All-caps lines of at most this many words are read as headings.
+constexpr uint32_t kMaxHeadingWords = 8;
+
+// Abbreviations after which a period never ends a sentence.
+const char* const kNeverEnding[] = {
+    "approx", "apr", "art", "arts", "aug", "cf", "ch", "chap", "cl", "cls", "dec", "dept", "dr",
+    "e.g", "feb", "fig", "figs", "hon", "i.e", "jan", "jul", "jun", "mar", "messrs", "mr", "mrs",
+    "ms", "nov", "oct", "p", "para", "paras", "pp", "prof", "pt", "reg", "regs", "rev", "sch",
+    "sec", "secs", "sep", "sept", "ss", "st", "subpara", "subsec", "v", "viz", "vol", "vols", "vs",
+};
+
+// Abbreviations that also end sentences ("... Acme Inc. The Buyer"); the
+// period ends one only if a capitalized word follows.
+const char* const kMaybeEnding[] = {
+    "al", "bros", "co", "corp", "esq", "etc", "ibid", "id", "inc", "jr",
+    "llc", "llp", "ltd", "no", "nos", "plc", "seq", "sr",
+};
+
+// Words that name a numbered or lettered provision, so the label after them
+// ("Section 4", "Schedule B") reads as part of a reference.
+const char* const kReferenceWords[] = {
+    "annex", "appendix", "art", "article", "articles", "chapter", "clause", "clauses", "exhibit",
+    "no", "para", "paragraph", "paragraphs", "part", "rule", "sch", "schedule", "sec", "section",
+    "sections", "subsection", "title",
+};
+
+// Common first words of a sentence, which tell an initial at the end of a
+// sentence ("... in the U.S. The Tenant") from one inside a name.
+const char* const kSentenceStarters[] = {
+    "a", "after", "all", "an", "any", "as", "at", "before", "both", "but", "by", "each",
+    "either", "except", "for", "from", "he", "however", "i", "if", "in", "it", "its", "neither",
+    "no", "none", "nothing", "notwithstanding", "on", "once", "our", "provided", "she", "should",
+    "since", "subject", "such", "that", "the", "their", "there", "these", "they", "this", "those",
+    "to", "under", "unless", "upon", "we", "when", "where", "whereas", "which", "while", "you",
+    "your",
+};
+
+const char* const kBeForms[] = {"am", "are", "be", "been", "being", "is", "was", "were"};
+
+// Words allowed between a be-form and its participle ("is not paid",
+// "shall be jointly and severally liable" aside).
+const char* const kPassiveModifiers[] = {
+    "also", "further", "hereby", "herein", "not", "then", "thereby", "therefore", "thus",
+};
+
+const char* const kIrregularParticiples[] = {
+    "arisen", "awoken", "beaten", "become", "begun", "bent", "bid", "bitten", "borne", "bought",
+    "bound", "broken", "brought", "built", "caught", "chosen", "cut", "dealt", "done", "drawn",
+    "driven", "eaten", "fallen", "felt", "forbidden", "foregone", "forgiven", "forgone",
+    "forgotten", "found", "frozen", "given", "got", "gotten", "grown", "heard", "held", "hidden",
+    "hit", "hung", "hurt", "kept", "known", "laid", "led", "left", "lent", "lost", "made", "meant",
+    "met", "overridden", "overtaken", "paid", "put", "read", "rid", "said", "seen", "sent", "set",
+    "shown", "shut", "sold", "sought", "spent", "spoken", "stolen", "struck", "sworn", "taken",
+    "taught", "thought", "thrown", "told", "torn", "undergone", "understood", "undertaken",
+    "upheld", "withdrawn", "withheld", "won", "worn", "written",
+};
+
+// "-eed" words that are participles; the rest ("exceed", "proceed",
+// "indeed") are not.
+const char* const kEedParticiples[] = {"agreed", "decreed", "freed", "guaranteed"};
+
+template <size_t N>
+bool Contains(const char* const (&words)[N], const char* key) {
+    return std::binary_search(std::begin(words), std::end(words), key,
+                              [](const char* a, const char* b) { return std::strcmp(a, b) < 0; });
+}
+
+bool IsAsciiUpper(uint32_t cp) { return cp >= 'A' && cp <= 'Z'; }
+bool IsAsciiLower(uint32_t cp) { return cp >= 'a' && cp <= 'z'; }
+bool IsDigit(uint32_t cp) { return cp >= '0' && cp <= '9'; }
+
+// FoldForMatching with the table search skipped for ASCII, which is nearly
+// all of a typical contract.
+uint32_t Fold(uint32_t cp) {
+    if (cp < 0x80) return IsAsciiUpper(cp) ? cp + 32 : cp;
+    return FoldForMatching(cp);
+}
+
+// Letters, digits and combining marks outside the punctuation and symbol
+// blocks. Surrogates are left out, so text beyond the BMP reads as symbols.
+bool IsWordUnit(uint32_t cp) {
+    if (cp < 0x80) return IsDigit(cp) || IsAsciiUpper(cp) || IsAsciiLower(cp);
+    if (cp < 0xC0 || cp == 0xD7 || cp == 0xF7) return false;
+    if (cp >= 0x2000 && cp <= 0x2BFF) return false;
+    if (cp >= 0x3000 && cp <= 0x303F) return false;
+    if (cp >= 0xD800 && cp <= 0xDFFF) return false;
+    if (cp >= 0xFF00 && cp <= 0xFF0F) return false;
+    return !IsMatchingSpace(cp);
+}
+
+bool IsWordJoiner(uint32_t cp) {
+    return cp == '\'' || cp == 0x2019 || cp == '-' || cp == 0x2010 || cp == 0x2011;
+}
+
+bool IsTerminator(uint32_t cp) {
+    return cp == '.' || cp == '!' || cp == '?' || cp == 0x2026 || cp == 0x3002 || cp == 0xFF01 ||
+           cp == 0xFF0E || cp == 0xFF1F;
+}
+
+// Ideographic terminators end a sentence without a following space.
+bool IsFullwidthTerminator(uint32_t cp) {
+    return cp == 0x3002 || cp == 0xFF01 || cp == 0xFF0E || cp == 0xFF1F;
+}
+
+bool IsCloser(uint32_t cp) {
+    return cp == '"' || cp == '\'' || cp == ')' || cp == ']' || cp == 0x2019 || cp == 0x201D ||
+           cp == 0xBB || cp == 0x203A;
+}
+
+bool IsOpener(uint32_t cp) {
+    return cp == '"' || cp == '\'' || cp == '(' || cp == '[' || cp == 0x2018 || cp == 0x201C ||
+           cp == 0xAB || cp == 0x2039;
+}
+
+bool IsBullet(uint32_t cp) {
+    return cp == 0x2022 || cp == 0x2023 || cp == 0x25E6 || cp == 0x2043 || cp == 0xB7 ||
+           cp == '-' || cp == '*' || cp == 0x2013 || cp == 0x2014;
+}
+
+bool IsLineBreak(uint32_t cp) {
+    return cp == '\n' || cp == 0x0B || cp == 0x0C || cp == 0x85 || cp == 0x2028 || cp == 0x2029;
+}
+
+// Lower case for Latin, Greek, Cyrillic and Armenian, where sentences start
+// capitalized; other scripts never read as lower case.
+bool IsLowerCase(uint32_t cp) {
+    if (cp < 0x80) return IsAsciiLower(cp);
+    if (cp < 0x100) return cp >= 0xDF && cp != 0xF7;
+    return cp < 0x0590 && IsWordUnit(cp) && !IsMatchingIgnorable(cp) && Fold(cp) == cp;
+}
+
+bool IsRomanNumeral(uint32_t folded) {
+    return folded == 'i' || folded == 'v' || folded == 'x' || folded == 'l' || folded == 'c';
+}
+
+// "(a)", "(iv)", "(12)": a lettered, roman or numbered item label starting
+// at |at|. Returns the offset after the closing parenthesis, or 0.
+size_t MatchParenLabel(const wchar_t* text, size_t length, size_t at) {
+    if (at >= length || text[at] != L'(') return 0;
+    size_t i = at + 1;
+    size_t digits = 0;
+    size_t romans = 0;
+    size_t letters = 0;
+    while (i < length && i - at <= 5) {
+        const uint32_t cp = static_cast<uint32_t>(text[i]);
+        if (cp == ')') break;
+        const uint32_t folded = Fold(cp);
+        if (IsDigit(cp)) {
+            ++digits;
+        } else if (cp < 0x80 && IsAsciiLower(folded)) {
+            ++letters;
+            if (IsRomanNumeral(folded)) ++romans;
+        } else {
+            return 0;
+        }
+        ++i;
+    }
+    if (i >= length || text[i] != L')') return 0;
+    const size_t inside = i - at - 1;
+    const bool label = (digits == inside && inside <= 3) || (letters == inside && inside == 1) ||
+                       (romans == inside && inside <= 4);
+    return label && inside > 0 ? i + 1 : 0;
+}
+
+// A list label at the start of a line: "(a)", "1.", "4.2)", "b.", "iv)" or
+// a bullet, followed by a space.
+bool IsLineLabelAt(const wchar_t* text, size_t length, size_t at) {
+    size_t end = MatchParenLabel(text, length, at);
+    if (end == 0) {
+        const uint32_t first = static_cast<uint32_t>(text[at]);
+        if (IsBullet(first)) {
+            end = at + 1;
+        } else {
+            size_t i = at;
+            size_t digits = 0;
+            size_t letters = 0;
+            size_t romans = 0;
+            while (i < length && i - at < 8) {
+                const uint32_t cp = static_cast<uint32_t>(text[i]);
+                if (IsDigit(cp)) {
+                    ++digits;
+                } else if (cp == '.' && digits > 0 && i + 1 < length && IsDigit(static_cast<uint32_t>(text[i + 1]))) {
+                    // "4.2" keeps going.
+                } else if (IsAsciiLower(Fold(cp)) && cp < 0x80) {
+                    ++letters;
+                    if (IsRomanNumeral(Fold(cp))) ++romans;
+                } else {
+                    break;
+                }
+                ++i;
+            }
+            if (i >= length || (text[i] != L'.' && text[i] != L')')) return false;
+            const bool label = (digits > 0 && letters == 0) || (digits == 0 && letters == 1) ||
+                               (digits == 0 && letters > 0 && romans == letters && letters <= 4);
+            if (!label) return false;
+            end = i + 1;
+        }
+    }
+    return end < length && IsMatchingSpace(static_cast<uint32_t>(text[end]));
+}
+
+enum class TokenKind { kWord, kNumber, kInitials };
+
+struct Token {
+    TokenKind kind = TokenKind::kWord;
+    char key[kKeyCapacity + 1] = {};
+    size_t keyLength = 0;
+    bool keyComplete = true;
+    bool hasLetter = false;
+    bool hasUpper = false;
+    bool hasLower = false;
+    uint32_t syllables = 0;
+    size_t end = 0;
+    bool atLineStart = false;
+    bool afterReference = false;
+};
+
+// What follows a candidate sentence end.
+struct Lookahead {
+    bool atEnd = false;
+    bool paragraph = false;
+    bool upper = false;
+    bool lower = false;
+    bool digit = false;
+    bool starter = false;
+};
+
+class Segmenter {
+public:
+    Segmenter(const wchar_t* text, size_t length, TextSegmentation& result)
+        : text_(text), length_(length), result_(result) {}
+
+    void Run();
+
+private:
+    uint32_t At(size_t i) const { return static_cast<uint32_t>(text_[i]); }
+
+    size_t ScanToken(size_t at, Token& token) const;
+    void CountWord(const Token& token);
+    bool EndsSentence(size_t terminatorStart, size_t terminatorEnd, size_t after) const;
+    Lookahead LookAt(size_t at) const;
+
+    void OpenAt(size_t at);
+    void BreakClause(size_t end);
+    void BreakSentence(size_t end);
+
+    const wchar_t* text_;
+    size_t length_;
+    TextSegmentation& result_;
+
+    uint32_t sentenceStart_ = kNone;
+    uint32_t clauseStart_ = kNone;
+    size_t contentEnd_ = 0;
+
+    Token last_;
+    bool hasLast_ = false;
+    bool referencePending_ = false;
+
+    // Words left in which a participle completes a passive after a be-form.
+    int passiveWindow_ = 0;
+    bool sentencePassive_ = false;
+
+    bool lineStart_ = true;
+    uint32_t lineWords_ = 0;
+    bool lineUpper_ = false;
+    bool lineLower_ = false;
+};
+
+size_t Segmenter::ScanToken(size_t at, Token& token) const {
+    token = Token();
+    size_t i = at;
+    size_t segmentLetters = 0;
+    size_t longestSegment = 0;
+    bool internalDot = false;
+    bool allDigits = true;
+    bool previousVowel = false;
+    bool previousWordUnit = false;
+    char tail[3] = {0, 0, 0};
+    uint32_t letters = 0;
+
+    while (i < length_) {
+        const uint32_t cp = At(i);
+        if (IsWordUnit(cp)) {
+            const uint32_t folded = Fold(cp);
+            if (!IsDigit(cp)) {
+                allDigits = false;
+                token.hasLetter = true;
+                if (IsLowerCase(cp)) {
+                    token.hasLower = true;
+                } else {
+                    token.hasUpper = true;
+                }
+                ++segmentLetters;
+                ++letters;
+                // Syllables are estimated from vowel groups; 'y' opening a
+                // word is a consonant.
+                const bool vowel = folded == 'a' || folded == 'e' || folded == 'i' || folded == 'o' ||
+                                   folded == 'u' || (folded == 'y' && letters > 1);
+                if (vowel && !previousVowel) ++token.syllables;
+                previousVowel = vowel;
+                tail[0] = tail[1];
+                tail[1] = tail[2];
+                tail[2] = folded < 0x80 ? static_cast<char>(folded) : '?';
+            }
+            if (token.keyLength < kKeyCapacity) {
+                token.key[token.keyLength++] = folded < 0x80 ? static_cast<char>(folded) : '?';
+            } else {
+                token.keyComplete = false;
+            }
+            previousWordUnit = true;
+            ++i;
+            continue;
+        }
+        if (IsMatchingIgnorable(cp) && previousWordUnit) {
+            ++i;
+            continue;
+        }
+        const bool joins = i + 1 < length_ && previousWordUnit && IsWordUnit(At(i + 1));
+        if (joins && (IsWordJoiner(cp) || cp == '.')) {
+            if (cp == '.') {
+                internalDot = true;
+                longestSegment = std::max(longestSegment, segmentLetters);
+                segmentLetters = 0;
+            } else {
+                previousVowel = false;
+            }
+            if (token.keyLength < kKeyCapacity) {
+                token.key[token.keyLength++] = static_cast<char>(cp < 0x80 ? cp : '\'');
+            } else {
+                token.keyComplete = false;
+            }
+            previousWordUnit = false;
+            ++i;
+            continue;
+        }
+        break;
+    }
+    longestSegment = std::max(longestSegment, segmentLetters);
+    token.key[token.keyLength] = '\0';
+    token.end = i;
+
+    if (!token.hasLetter || (allDigits && internalDot)) {
+        token.kind = TokenKind::kNumber;
+    } else if ((internalDot && longestSegment <= 2) || (!internalDot && letters == 1 && i - at == 1)) {
+        token.kind = TokenKind::kInitials;
+    }
+
+    if (token.hasLetter) {
+        // A final silent 'e' ("lease"), but not "-le" after a consonant
+        // ("table"), and the silent 'e' of "-ed" and "-es" endings.
+        const auto consonant = [](char c) {
+            return c >= 'a' && c <= 'z' && c != 'a' && c != 'e' && c != 'i' && c != 'o' && c != 'u' && c != 'y';
+        };
+        if (token.syllables > 1) {
+            if (tail[2] == 'e' && consonant(tail[1]) && !(tail[1] == 'l' && consonant(tail[0]))) {
+                --token.syllables;
+            } else if (tail[2] == 'd' && tail[1] == 'e' && consonant(tail[0]) && tail[0] != 't' && tail[0] != 'd') {
+                --token.syllables;
+            } else if (tail[2] == 's' && tail[1] == 'e' && consonant(tail[0]) && tail[0] != 's' &&
+                       tail[0] != 'x' && tail[0] != 'z' && tail[0] != 'c' && tail[0] != 'g' && tail[0] != 'h') {
+                --token.syllables;
+            }
+        }
+        token.syllables = std::max<uint32_t>(token.syllables, 1);
+    }
+    return i;
+}
+
+void Segmenter::CountWord(const Token& token) {
+    TextMetrics& metrics = result_.metrics;
+    ++metrics.words;
+    metrics.syllables += token.syllables;
+
+    const char* key = token.key;
+    if (token.keyComplete && Contains(kBeForms, key)) {
+        passiveWindow_ = 3;
+        return;
+    }
+    if (passiveWindow_ == 0) return;
+
+    const size_t n = token.keyLength;
+    bool participle = false;
+    if (token.keyComplete && Contains(kIrregularParticiples, key)) {
+        participle = true;
+    } else if (n >= 4 && key[n - 2] == 'e' && key[n - 1] == 'd') {
+        participle = key[n - 3] != 'e' || (token.keyComplete && Contains(kEedParticiples, key));
+    }
+    if (participle) {
+        ++metrics.passiveConstructions;
+        sentencePassive_ = true;
+        passiveWindow_ = 0;
+    } else if ((n > 3 && key[n - 2] == 'l' && key[n - 1] == 'y') ||
+               (token.keyComplete && Contains(kPassiveModifiers, key))) {
+        --passiveWindow_;
+    } else {
+        passiveWindow_ = 0;
+    }
+}
+
+Lookahead Segmenter::LookAt(size_t at) const {
+    Lookahead next;
+    size_t i = at;
+    uint32_t breaks = 0;
+    while (i < length_ && IsMatchingSpace(At(i))) {
+        const uint32_t cp = At(i);
+        if (IsLineBreak(cp) || (cp == '\r' && (i + 1 >= length_ || text_[i + 1] != L'\n'))) {
+            breaks += cp == 0x2029 ? 2 : 1;
+        }
+        ++i;
+    }
+    while (i < length_ && IsOpener(At(i))) ++i;
+    if (i >= length_) {
+        next.atEnd = true;
+        return next;
+    }
+    next.paragraph = breaks >= 2;
+
+    const uint32_t cp = At(i);
+    next.digit = IsDigit(cp);
+    next.lower = IsLowerCase(cp);
+    next.upper = IsWordUnit(cp) && !next.digit && !next.lower;
+
+    char word[kKeyCapacity + 1];
+    size_t n = 0;
+    while (i < length_ && n < kKeyCapacity && IsWordUnit(At(i)) && !IsDigit(At(i))) {
+        const uint32_t f = Fold(At(i));
+        word[n++] = f < 0x80 ? static_cast<char>(f) : '?';
+        ++i;
+    }
+    word[n] = '\0';
+    next.starter = n > 0 && (i >= length_ || !IsWordUnit(At(i))) && Contains(kSentenceStarters, word);
+    return next;
+}
+
+bool Segmenter::EndsSentence(size_t terminatorStart, size_t terminatorEnd, size_t after) const {
+    const Lookahead next = LookAt(after);
+    if (next.atEnd || next.paragraph) return true;
+    if (next.lower) return false;
+
+    const bool period = terminatorEnd - terminatorStart == 1 && text_[terminatorStart] == L'.';
+    if (!period || !hasLast_ || last_.end != terminatorStart) return true;
+
+    if (last_.keyComplete && Contains(kNeverEnding, last_.key)) return false;
+    if (last_.keyComplete && Contains(kMaybeEnding, last_.key)) return next.upper;
+
+    switch (last_.kind) {
+    case TokenKind::kInitials:
+        // "Schedule B." is a label, "J. Smith" and "U.S.C. 1983" are not ends.
+        if (last_.afterReference) return next.upper;
+        return next.starter;
+    case TokenKind::kNumber:
+        // "1." opening a line is a list label; "Section 4. 2" is a split
+        // decimal.
+        if (last_.atLineStart) return false;
+        return !next.digit;
+    case TokenKind::kWord:
+        break;
+    }
+    return true;
+}
+
+void Segmenter::OpenAt(size_t at) {
+    if (sentenceStart_ == kNone) {
+        sentenceStart_ = static_cast<uint32_t>(at);
+        sentencePassive_ = false;
+        passiveWindow_ = 0;
+    }
+    if (clauseStart_ == kNone) clauseStart_ = static_cast<uint32_t>(at);
+}
+
+void Segmenter::BreakClause(size_t end) {
+    if (clauseStart_ == kNone) return;
+    result_.clauses.push_back(clauseStart_);
+    result_.clauses.push_back(static_cast<uint32_t>(end));
+    clauseStart_ = kNone;
+}
+
+void Segmenter::BreakSentence(size_t end) {
+    if (sentenceStart_ == kNone) return;
+    BreakClause(end);
+    result_.sentences.push_back(sentenceStart_);
+    result_.sentences.push_back(static_cast<uint32_t>(end));
+    if (sentencePassive_) ++result_.metrics.passiveSentences;
+    sentenceStart_ = kNone;
+    sentencePassive_ = false;
+    passiveWindow_ = 0;
+    hasLast_ = false;
+    referencePending_ = false;
+}
+
+void Segmenter::Run() {
+    size_t i = 0;
+    uint32_t breaks = 0;
+    while (i < length_) {
+        const uint32_t cp = At(i);
+        if (IsMatchingSpace(cp)) {
+            if (IsLineBreak(cp) || (cp == '\r' && (i + 1 >= length_ || text_[i + 1] != L'\n'))) {
+                // A short all-caps line is a heading.
+                if (lineUpper_ && !lineLower_ && lineWords_ <= kMaxHeadingWords) BreakSentence(contentEnd_);
+                breaks += cp == 0x2029 ? 2 : 1;
+                lineStart_ = true;
+                lineWords_ = 0;
+                lineUpper_ = false;
+                lineLower_ = false;
+            }
+            ++i;
+            continue;
+        }
+        if (IsMatchingIgnorable(cp)) {
+            ++i;
+            continue;
+        }
+
+        if (breaks >= 2 || (lineStart_ && breaks > 0 && IsLineLabelAt(text_, length_, i))) {
+            BreakSentence(contentEnd_);
+        }
+        breaks = 0;
+        OpenAt(i);
+        const bool atLineStart = lineStart_;
+        lineStart_ = false;
+
+        if (IsWordUnit(cp)) {
+            Token token;
+            i = ScanToken(i, token);
+            token.atLineStart = atLineStart;
+            token.afterReference = referencePending_;
+            if (token.hasLetter) {
+                CountWord(token);
+                ++lineWords_;
+                lineUpper_ = lineUpper_ || token.hasUpper;
+                lineLower_ = lineLower_ || token.hasLower;
+            }
+            // The label after a reference word ("Section 4", "Art. 12")
+            // keeps the reference open for "(a)" after it.
+            referencePending_ = (token.keyComplete && Contains(kReferenceWords, token.key)) ||
+                                (token.afterReference && token.kind != TokenKind::kWord);
+            last_ = token;
+            hasLast_ = true;
+            contentEnd_ = i;
+            continue;
+        }
+
+        if (IsTerminator(cp)) {
+            size_t end = i;
+            while (end < length_ && IsTerminator(At(end))) ++end;
+            size_t after = end;
+            while (after < length_ && IsCloser(At(after))) ++after;
+            contentEnd_ = after;
+            const bool spaced = after >= length_ || IsMatchingSpace(At(after));
+            if ((spaced || IsFullwidthTerminator(At(end - 1))) && EndsSentence(i, end, after)) {
+                BreakSentence(after);
+            }
+            i = after;
+            continue;
+        }
+
+        if (cp == ';' || (cp == ':' && !(i > 0 && i + 1 < length_ && IsDigit(At(i - 1)) && IsDigit(At(i + 1))))) {
+            contentEnd_ = i + 1;
+            BreakClause(i + 1);
+            hasLast_ = false;
+            ++i;
+            continue;
+        }
+
+        if (cp == '(' && i > 0 && IsMatchingSpace(At(i - 1)) && clauseStart_ != i) {
+            // An inline item label opens a clause; "4.2(a)" is a reference.
+            const size_t end = MatchParenLabel(text_, length_, i);
+            if (end != 0 && !referencePending_) {
+                BreakClause(contentEnd_);
+                OpenAt(i);
+                contentEnd_ = end;
+                hasLast_ = false;
+                i = end;
+                continue;
+            }
+        }
+
+        // "§ 4.2" and "§§ 4-6" introduce references.
+        referencePending_ = cp == 0xA7 || (referencePending_ && cp == '(');
+        hasLast_ = hasLast_ && cp != ')' && cp != ']';
+        contentEnd_ = i + 1;
+        ++i;
+    }
+    BreakSentence(contentEnd_);
+}
+
+}  // namespace
+
+void SegmentLegalText(const wchar_t* text, size_t length, TextSegmentation& result) {
+    result.sentences.clear();
+    result.clauses.clear();
+    result.metrics = TextMetrics();
+
+    Segmenter(text, length, result).Run();
+
+    TextMetrics& metrics = result.metrics;
+    metrics.sentences = static_cast<uint32_t>(result.sentences.size() / 2);
+    metrics.clauses = static_cast<uint32_t>(result.clauses.size() / 2);
+    if (metrics.words == 0) return;
+
+    const double words = static_cast<double>(metrics.words);
+    const double sentences = static_cast<double>(std::max<uint32_t>(metrics.sentences, 1));
+    const double wordsPerSentence = words / sentences;
+    const double syllablesPerWord = static_cast<double>(metrics.syllables) / words;
+    metrics.averageSentenceWords = wordsPerSentence;
+    metrics.fleschReadingEase = 206.835 - 1.015 * wordsPerSentence - 84.6 * syllablesPerWord;
+    metrics.fleschKincaidGrade = 0.39 * wordsPerSentence + 11.8 * syllablesPerWord - 15.59;
+}
@@ -0,0 +1,44 @@
+#ifndef RUNNER_TEXT_SEGMENTER_H_
+#define RUNNER_TEXT_SEGMENTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TextMetrics {
+    uint32_t words = 0;
+    uint32_t syllables = 0;
+    uint32_t sentences = 0;
+    uint32_t clauses = 0;
+    // "be" followed by a past participle, e.g. "shall be deemed",
+    // "was not paid".
+    uint32_t passiveConstructions = 0;
+    uint32_t passiveSentences = 0;
+
+    double averageSentenceWords = 0.0;
+    double fleschReadingEase = 0.0;
+    double fleschKincaidGrade = 0.0;
+};
+
+// Sentences and clauses as [start, end) pairs of offsets into the text, in
+// UTF-16 code units, flattened: start0, end0, start1, end1, ...
+struct TextSegmentation {
+    std::vector<uint32_t> sentences;
+    std::vector<uint32_t> clauses;
+    TextMetrics metrics;
+};
+
+// Splits legal text into sentences and clauses and measures its readability
+// in one pass. Sentence ends are read the way a lawyer would:
+//   - abbreviations ("Inc.", "et seq.", "Art.", "v.") and initialisms
+//     ("U.S.C.", "e.g.") do not end a sentence unless what follows clearly
+//     starts one;
+//   - periods inside references ("§ 4.2(a)", "Section 12.3") and after
+//     list labels at the start of a line ("1.") are not ends;
+//   - a blank line, or a line starting with a list label, always ends one.
+// Clauses are split at semicolons, colons and inline enumerations
+// ("(a)", "(iii)"). Readability uses the Flesch formulas with an English
+// syllable estimate. |result|'s vectors are cleared and reused.
+void SegmentLegalText(const wchar_t* text, size_t length, TextSegmentation& result);
+
+#endif
@@ -0,0 +1,92 @@
+#include "tree_snapshot.h"
+
+#include <utility>
+
+uint64_t HashSnapshotText(const std::wstring& text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (wchar_t ch : text) {
+        hash ^= static_cast<uint64_t>(ch);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void TreeSnapshot::Clear() {
+    elements_.clear();
+    index_.clear();
+}
+
+void TreeSnapshot::Reserve(size_t count) {
+    elements_.reserve(count);
+    index_.reserve(count);
+}
+
+void TreeSnapshot::Add(std::string key, std::string parentKey, int controlType, std::wstring text) {
+    SnapshotElement element;
+    element.textHash = HashSnapshotText(text);
+    element.key = std::move(key);
+    element.parentKey = std::move(parentKey);
+    element.controlType = controlType;
+    element.text = std::move(text);
+
+    auto it = index_.find(element.key);
+    if (it != index_.end()) {
+        elements_[it->second] = std::move(element);
+        return;
+    }
+    index_.emplace(element.key, elements_.size());
+    elements_.push_back(std::move(element));
+}
+
+size_t TreeSnapshot::Bytes() const {
+    // Each element's key is stored twice, once more in the index, whose
+    // nodes cost roughly a pointer pair and a hash on top.
+    size_t bytes = elements_.capacity() * sizeof(SnapshotElement);
+    for (const SnapshotElement& element : elements_) {
+        bytes += element.key.capacity() * 2 + element.parentKey.capacity() +
+                 element.text.capacity() * sizeof(wchar_t) + sizeof(std::string) + 4 * sizeof(void*);
+    }
+    return bytes;
+}
+
+const SnapshotElement* TreeSnapshot::Find(const std::string& key) const {
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    return &elements_[it->second];
+}
+
+void TreeDelta::Clear() {
+    inserted.clear();
+    changed.clear();
+    removed.clear();
+}
+
+void DiffTreeSnapshots(const TreeSnapshot& previous, const TreeSnapshot& current, TreeDelta& delta) {
+    delta.Clear();
+
+    for (const auto& element : current.Elements()) {
+        const SnapshotElement* old = previous.Find(element.key);
+        if (!old) {
+            delta.inserted.push_back(element);
+            continue;
+        }
+        // Text is compared by its 64-bit hash only; a collision would merely
+        // delay one update until the element's text changes again.
+        if (old->textHash != element.textHash ||
+            old->controlType != element.controlType ||
+            old->parentKey != element.parentKey) {
+            delta.changed.push_back(element);
+        }
+    }
+
+    if (previous.Size() + delta.inserted.size() == current.Size()) {
+        // Every previous key survived, so there is nothing to remove.
+        return;
+    }
+
+    for (const auto& element : previous.Elements()) {
+        if (!current.Find(element.key)) {
+            delta.removed.push_back(element.key);
+        }
+    }
+}
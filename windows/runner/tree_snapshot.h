@@ -0,0 +1,60 @@
+#ifndef RUNNER_TREE_SNAPSHOT_H_
+#define RUNNER_TREE_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One element of a structured window snapshot. |key| is the element's UIA
+// runtime id rendered as a dotted string, which is stable for the lifetime of
+// the element and therefore usable as a diff key.
+struct SnapshotElement {
+    std::string key;
+    std::string parentKey;
+    int controlType = 0;
+    std::wstring text;
+    uint64_t textHash = 0;
+};
+
+// Flattened, keyed view of an accessibility tree in pre-order.
+class TreeSnapshot {
+public:
+    void Clear();
+    void Reserve(size_t count);
+
+    // Appends an element. A key that is already present replaces the earlier
+    // entry so providers that report duplicate runtime ids cannot skew a diff.
+    void Add(std::string key, std::string parentKey, int controlType, std::wstring text);
+
+    const SnapshotElement* Find(const std::string& key) const;
+    const std::vector<SnapshotElement>& Elements() const { return elements_; }
+    size_t Size() const { return elements_.size(); }
+    bool Empty() const { return elements_.empty(); }
+    // Approximate heap bytes held, for the memory governor.
+    size_t Bytes() const;
+
+private:
+    std::vector<SnapshotElement> elements_;
+    std::unordered_map<std::string, size_t> index_;
+};
+
+// Keyed difference between two snapshots of the same window. |changed| holds
+// elements whose text, control type or parent differ from the previous
+// snapshot; |removed| holds only keys because Dart already has their content.
+struct TreeDelta {
+    std::vector<SnapshotElement> inserted;
+    std::vector<SnapshotElement> changed;
+    std::vector<std::string> removed;
+
+    bool IsEmpty() const { return inserted.empty() && changed.empty() && removed.empty(); }
+    void Clear();
+};
+
+uint64_t HashSnapshotText(const std::wstring& text);
+
+// Computes |current| relative to |previous| in O(n) expected time.
+void DiffTreeSnapshots(const TreeSnapshot& previous, const TreeSnapshot& current, TreeDelta& delta);
+
+#endif
@@ -0,0 +1,354 @@
+#include "truetype_font.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint16_t ReadU16(const std::string& data, size_t offset) {
+    if (offset + 2 > data.size()) return 0;
+    const auto* p = reinterpret_cast<const uint8_t*>(data.data() + offset);
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+int16_t ReadS16(const std::string& data, size_t offset) {
+    return static_cast<int16_t>(ReadU16(data, offset));
+}
+
+uint32_t ReadU32(const std::string& data, size_t offset) {
+    return (static_cast<uint32_t>(ReadU16(data, offset)) << 16) | ReadU16(data, offset + 2);
+}
+
+void WriteU16(std::string& out, size_t offset, uint16_t value) {
+    out[offset] = static_cast<char>(value >> 8);
+    out[offset + 1] = static_cast<char>(value & 0xFF);
+}
+
+void WriteU32(std::string& out, size_t offset, uint32_t value) {
+    WriteU16(out, offset, static_cast<uint16_t>(value >> 16));
+    WriteU16(out, offset + 2, static_cast<uint16_t>(value & 0xFFFF));
+}
+
+void AppendU16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value & 0xFF));
+}
+
+void AppendU32(std::string& out, uint32_t value) {
+    AppendU16(out, static_cast<uint16_t>(value >> 16));
+    AppendU16(out, static_cast<uint16_t>(value & 0xFFFF));
+}
+
+uint32_t Checksum(const std::string& data, size_t offset, size_t length) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < length; i += 4) {
+        uint32_t word = 0;
+        for (size_t j = 0; j < 4; j++) {
+            const size_t at = offset + i + j;
+            word = (word << 8) | (j < length - i ? static_cast<uint8_t>(data[at]) : 0u);
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+// Composite glyph flags.
+constexpr uint16_t kArgsAreWords = 0x0001;
+constexpr uint16_t kHaveScale = 0x0008;
+constexpr uint16_t kMoreComponents = 0x0020;
+constexpr uint16_t kHaveXYScale = 0x0040;
+constexpr uint16_t kHaveTwoByTwo = 0x0080;
+
+// Tables copied into a subset, in the tag order a font directory requires.
+const char* const kSubsetTables[] = {"cvt ", "fpgm", "glyf", "head", "hhea", "hmtx", "loca", "maxp", "prep"};
+
+}  // namespace
+
+bool TrueTypeFont::FindTable(const char* tag, Table& table) const {
+    const uint16_t count = ReadU16(data_, 4);
+    for (uint16_t i = 0; i < count; i++) {
+        const size_t record = 12 + static_cast<size_t>(i) * 16;
+        if (record + 16 > data_.size()) return false;
+        if (std::memcmp(data_.data() + record, tag, 4) != 0) continue;
+        table.offset = ReadU32(data_, record + 8);
+        table.length = ReadU32(data_, record + 12);
+        return table.offset <= data_.size() && table.length <= data_.size() - table.offset;
+    }
+    return false;
+}
+
+bool TrueTypeFont::Load(std::string data) {
+    data_ = std::move(data);
+    glyphCount_ = 0;
+    if (data_.size() < 12) return false;
+    const uint32_t version = ReadU32(data_, 0);
+    if (version != 0x00010000 && version != 0x74727565) return false;  // 'true'
+
+    Table head, hhea, maxp, cmap;
+    if (!FindTable("head", head) || !FindTable("hhea", hhea) || !FindTable("maxp", maxp) ||
+        !FindTable("hmtx", hmtx_) || !FindTable("loca", loca_) || !FindTable("glyf", glyf_) ||
+        !FindTable("cmap", cmap) || head.length < 54 || hhea.length < 36 || maxp.length < 6) {
+        return false;
+    }
+
+    unitsPerEm_ = ReadU16(data_, head.offset + 18);
+    if (unitsPerEm_ < 16) return false;
+    for (int i = 0; i < 4; i++) bbox_[i] = ReadS16(data_, head.offset + 36 + static_cast<size_t>(i) * 2);
+    longLoca_ = ReadS16(data_, head.offset + 50) != 0;
+    ascent_ = ReadS16(data_, hhea.offset + 4);
+    descent_ = ReadS16(data_, hhea.offset + 6);
+    metricCount_ = ReadU16(data_, hhea.offset + 34);
+    const uint16_t glyphs = ReadU16(data_, maxp.offset + 4);
+    if (glyphs == 0 || metricCount_ == 0 || metricCount_ > glyphs ||
+        hmtx_.length < static_cast<size_t>(metricCount_) * 4 + static_cast<size_t>(glyphs - metricCount_) * 2 ||
+        loca_.length < (static_cast<size_t>(glyphs) + 1) * (longLoca_ ? 4 : 2)) {
+        return false;
+    }
+
+    capHeight_ = ascent_ * 7 / 10;
+    Table os2;
+    if (FindTable("OS/2", os2) && os2.length >= 6) {
+        weightClass_ = ReadU16(data_, os2.offset + 4);
+        if (ReadU16(data_, os2.offset) >= 2 && os2.length >= 90) capHeight_ = ReadS16(data_, os2.offset + 88);
+    }
+    Table post;
+    if (FindTable("post", post) && post.length >= 16) {
+        italicAngle_ = static_cast<int32_t>(ReadU32(data_, post.offset + 4)) / 65536.0;
+        fixedPitch_ = ReadU32(data_, post.offset + 12) != 0;
+    }
+
+    // PostScript name (name id 6), from a Macintosh Roman or Windows
+    // Unicode record.
+    postScriptName_.clear();
+    Table name;
+    if (FindTable("name", name) && name.length >= 6) {
+        const uint16_t count = ReadU16(data_, name.offset + 2);
+        const size_t strings = name.offset + ReadU16(data_, name.offset + 4);
+        for (uint16_t i = 0; i < count && postScriptName_.empty(); i++) {
+            const size_t record = name.offset + 6 + static_cast<size_t>(i) * 12;
+            if (record + 12 > name.offset + name.length) break;
+            const uint16_t platform = ReadU16(data_, record);
+            const uint16_t nameId = ReadU16(data_, record + 6);
+            const size_t length = ReadU16(data_, record + 8);
+            const size_t offset = strings + ReadU16(data_, record + 10);
+            if (nameId != 6 || offset + length > data_.size()) continue;
+            const size_t step = platform == 3 ? 2 : 1;
+            if (platform != 1 && platform != 3) continue;
+            for (size_t at = offset + step - 1; at < offset + length; at += step) {
+                const char ch = data_[at];
+                if (ch > ' ' && ch < 127 && ch != '/' && ch != '[' && ch != ']' && ch != '(' && ch != ')') {
+                    postScriptName_.push_back(ch);
+                }
+            }
+        }
+    }
+    if (postScriptName_.empty()) postScriptName_ = "EmbeddedFont";
+
+    // Prefer a full-Unicode (format 12) mapping, then a BMP (format 4) one.
+    cmapFormat_ = 0;
+    const uint16_t subtables = ReadU16(data_, cmap.offset + 2);
+    for (uint16_t i = 0; i < subtables; i++) {
+        const size_t record = cmap.offset + 4 + static_cast<size_t>(i) * 8;
+        if (record + 8 > cmap.offset + cmap.length) break;
+        const uint16_t platform = ReadU16(data_, record);
+        const uint16_t encoding = ReadU16(data_, record + 2);
+        const size_t offset = cmap.offset + ReadU32(data_, record + 4);
+        const uint16_t format = ReadU16(data_, offset);
+        const bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        if (!unicode || (format != 4 && format != 12)) continue;
+        if (format == 12 || cmapFormat_ == 0) {
+            cmapFormat_ = format;
+            cmapOffset_ = offset;
+        }
+    }
+    if (cmapFormat_ == 0) return false;
+
+    bmpCache_.assign(0x10000, 0xFFFF);
+    glyphCount_ = glyphs;
+    return true;
+}
+
+uint16_t TrueTypeFont::LookupGlyph(uint32_t codepoint) const {
+    if (cmapFormat_ == 12) {
+        const uint32_t groups = ReadU32(data_, cmapOffset_ + 12);
+        uint32_t low = 0, high = groups;
+        while (low < high) {
+            const uint32_t mid = (low + high) / 2;
+            const size_t group = cmapOffset_ + 16 + static_cast<size_t>(mid) * 12;
+            const uint32_t start = ReadU32(data_, group);
+            const uint32_t end = ReadU32(data_, group + 4);
+            if (codepoint < start) {
+                high = mid;
+            } else if (codepoint > end) {
+                low = mid + 1;
+            } else {
+                const uint32_t glyph = ReadU32(data_, group + 8) + (codepoint - start);
+                return glyph < glyphCount_ ? static_cast<uint16_t>(glyph) : 0;
+            }
+        }
+        return 0;
+    }
+
+    if (codepoint > 0xFFFF) return 0;
+    const size_t segments = ReadU16(data_, cmapOffset_ + 6) / 2;
+    const size_t ends = cmapOffset_ + 14;
+    const size_t starts = ends + segments * 2 + 2;
+    const size_t deltas = starts + segments * 2;
+    const size_t rangeOffsets = deltas + segments * 2;
+    size_t low = 0, high = segments;
+    while (low < high) {
+        const size_t mid = (low + high) / 2;
+        if (ReadU16(data_, ends + mid * 2) < codepoint) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low >= segments) return 0;
+    const uint16_t start = ReadU16(data_, starts + low * 2);
+    if (codepoint < start) return 0;
+    const uint16_t delta = ReadU16(data_, deltas + low * 2);
+    const size_t rangeOffsetAt = rangeOffsets + low * 2;
+    const uint16_t rangeOffset = ReadU16(data_, rangeOffsetAt);
+    uint16_t glyph;
+    if (rangeOffset == 0) {
+        glyph = static_cast<uint16_t>(codepoint + delta);
+    } else {
+        glyph = ReadU16(data_, rangeOffsetAt + rangeOffset + (codepoint - start) * 2);
+        if (glyph != 0) glyph = static_cast<uint16_t>(glyph + delta);
+    }
+    return glyph < glyphCount_ ? glyph : 0;
+}
+
+uint16_t TrueTypeFont::GlyphFor(uint32_t codepoint) const {
+    if (codepoint > 0xFFFF) return LookupGlyph(codepoint);
+    uint16_t& cached = bmpCache_[codepoint];
+    if (cached == 0xFFFF) cached = LookupGlyph(codepoint);
+    return cached;
+}
+
+int TrueTypeFont::AdvanceWidth(uint16_t glyph) const {
+    const uint16_t metric = glyph < metricCount_ ? glyph : static_cast<uint16_t>(metricCount_ - 1);
+    return Scale(ReadU16(data_, hmtx_.offset + static_cast<size_t>(metric) * 4));
+}
+
+bool TrueTypeFont::GlyphRange(uint16_t glyph, size_t& offset, size_t& length) const {
+    size_t start, end;
+    if (longLoca_) {
+        start = ReadU32(data_, loca_.offset + static_cast<size_t>(glyph) * 4);
+        end = ReadU32(data_, loca_.offset + static_cast<size_t>(glyph) * 4 + 4);
+    } else {
+        start = static_cast<size_t>(ReadU16(data_, loca_.offset + static_cast<size_t>(glyph) * 2)) * 2;
+        end = static_cast<size_t>(ReadU16(data_, loca_.offset + static_cast<size_t>(glyph) * 2 + 2)) * 2;
+    }
+    if (end < start || end > glyf_.length) return false;
+    offset = glyf_.offset + start;
+    length = end - start;
+    return true;
+}
+
+bool TrueTypeFont::Subset(const std::vector<bool>& used, std::string& out) const {
+    if (!IsLoaded()) return false;
+
+    // Close over composite glyphs' components.
+    std::vector<bool> keep(glyphCount_, false);
+    std::vector<uint16_t> pending;
+    keep[0] = true;
+    pending.push_back(0);
+    for (size_t glyph = 1; glyph < used.size() && glyph < glyphCount_; glyph++) {
+        if (used[glyph] && !keep[glyph]) {
+            keep[glyph] = true;
+            pending.push_back(static_cast<uint16_t>(glyph));
+        }
+    }
+    while (!pending.empty()) {
+        const uint16_t glyph = pending.back();
+        pending.pop_back();
+        size_t offset, length;
+        if (!GlyphRange(glyph, offset, length) || length < 10 || ReadS16(data_, offset) >= 0) continue;
+        size_t at = offset + 10;
+        const size_t end = offset + length;
+        while (at + 4 <= end) {
+            const uint16_t flags = ReadU16(data_, at);
+            const uint16_t component = ReadU16(data_, at + 2);
+            if (component < glyphCount_ && !keep[component]) {
+                keep[component] = true;
+                pending.push_back(component);
+            }
+            at += 4 + ((flags & kArgsAreWords) ? 4 : 2);
+            if (flags & kHaveScale) {
+                at += 2;
+            } else if (flags & kHaveXYScale) {
+                at += 4;
+            } else if (flags & kHaveTwoByTwo) {
+                at += 8;
+            }
+            if (!(flags & kMoreComponents)) break;
+        }
+    }
+
+    std::string glyf;
+    std::string loca;
+    loca.reserve((static_cast<size_t>(glyphCount_) + 1) * 4);
+    for (uint16_t glyph = 0; glyph < glyphCount_; glyph++) {
+        AppendU32(loca, static_cast<uint32_t>(glyf.size()));
+        size_t offset, length;
+        if (!keep[glyph] || !GlyphRange(glyph, offset, length)) continue;
+        glyf.append(data_, offset, length);
+        glyf.resize((glyf.size() + 3) & ~static_cast<size_t>(3), '\0');
+    }
+    AppendU32(loca, static_cast<uint32_t>(glyf.size()));
+
+    struct Output {
+        const char* tag;
+        std::string bytes;
+    };
+    std::vector<Output> tables;
+    for (const char* tag : kSubsetTables) {
+        Output table{tag, std::string()};
+        if (std::strcmp(tag, "glyf") == 0) {
+            table.bytes = std::move(glyf);
+        } else if (std::strcmp(tag, "loca") == 0) {
+            table.bytes = std::move(loca);
+        } else {
+            Table source;
+            if (!FindTable(tag, source)) continue;
+            table.bytes.assign(data_, source.offset, source.length);
+            if (std::strcmp(tag, "head") == 0) {
+                WriteU32(table.bytes, 8, 0);    // checkSumAdjustment, set below
+                WriteU16(table.bytes, 50, 1);   // long loca offsets
+            }
+        }
+        tables.push_back(std::move(table));
+    }
+
+    const uint16_t count = static_cast<uint16_t>(tables.size());
+    uint16_t entrySelector = 0;
+    while ((2u << entrySelector) <= count) entrySelector++;
+    const uint16_t searchRange = static_cast<uint16_t>((1u << entrySelector) * 16);
+
+    out.clear();
+    AppendU32(out, 0x00010000);
+    AppendU16(out, count);
+    AppendU16(out, searchRange);
+    AppendU16(out, entrySelector);
+    AppendU16(out, static_cast<uint16_t>(count * 16 - searchRange));
+    size_t offset = 12 + static_cast<size_t>(count) * 16;
+    for (const auto& table : tables) {
+        out.append(table.tag, 4);
+        AppendU32(out, Checksum(table.bytes, 0, table.bytes.size()));
+        AppendU32(out, static_cast<uint32_t>(offset));
+        AppendU32(out, static_cast<uint32_t>(table.bytes.size()));
+        offset += (table.bytes.size() + 3) & ~static_cast<size_t>(3);
+    }
+    size_t headOffset = 0;
+    for (const auto& table : tables) {
+        if (std::strcmp(table.tag, "head") == 0) headOffset = out.size();
+        out += table.bytes;
+        out.resize((out.size() + 3) & ~static_cast<size_t>(3), '\0');
+    }
+    if (headOffset != 0) {
+        WriteU32(out, headOffset + 8, 0xB1B0AFBA - Checksum(out, 0, out.size()));
+    }
+    return true;
+}
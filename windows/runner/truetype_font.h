@@ -0,0 +1,77 @@
+#ifndef RUNNER_TRUETYPE_FONT_H_
+#define RUNNER_TRUETYPE_FONT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a TrueType (glyf-outline) font: character to glyph
+// mapping, advance widths and the metrics a PDF font descriptor needs, plus
+// subsetting for embedding. CFF-flavoured and collection files are rejected.
+class TrueTypeFont {
+public:
+    // Takes ownership of the font file's bytes. Returns false if they are not
+    // a usable TrueType font.
+    bool Load(std::string data);
+
+    bool IsLoaded() const { return glyphCount_ > 0; }
+    size_t DataSize() const { return data_.size(); }
+    uint16_t GlyphCount() const { return glyphCount_; }
+
+    // Glyph for a Unicode code point; 0 (.notdef) when the font has none.
+    uint16_t GlyphFor(uint32_t codepoint) const;
+    // Advance width in thousandths of an em.
+    int AdvanceWidth(uint16_t glyph) const;
+
+    // Metrics in thousandths of an em, as PDF font descriptors expect.
+    int Ascent() const { return Scale(ascent_); }
+    int Descent() const { return Scale(descent_); }
+    int CapHeight() const { return Scale(capHeight_); }
+    int BoundingBox(int index) const { return Scale(bbox_[index]); }
+    double ItalicAngle() const { return italicAngle_; }
+    bool IsBold() const { return weightClass_ >= 600; }
+    bool IsFixedPitch() const { return fixedPitch_; }
+    const std::string& PostScriptName() const { return postScriptName_; }
+
+    // Writes a font program containing only the glyphs flagged in |used|,
+    // the components of any composite among them and .notdef. The other
+    // glyph slots are kept but empty, so glyph ids are unchanged and can be
+    // used as CIDs with an identity mapping.
+    bool Subset(const std::vector<bool>& used, std::string& out) const;
+
+private:
+    struct Table {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    bool FindTable(const char* tag, Table& table) const;
+    bool GlyphRange(uint16_t glyph, size_t& offset, size_t& length) const;
+    uint16_t LookupGlyph(uint32_t codepoint) const;
+    int Scale(int units) const { return static_cast<int>(units * 1000L / unitsPerEm_); }
+
+    std::string data_;
+    Table glyf_;
+    Table loca_;
+    Table hmtx_;
+    size_t cmapOffset_ = 0;
+    uint16_t cmapFormat_ = 0;
+    uint16_t glyphCount_ = 0;
+    uint16_t metricCount_ = 0;
+    bool longLoca_ = false;
+    int unitsPerEm_ = 1000;
+    int ascent_ = 0;
+    int descent_ = 0;
+    int capHeight_ = 0;
+    int bbox_[4] = {0, 0, 0, 0};
+    int weightClass_ = 400;
+    double italicAngle_ = 0.0;
+    bool fixedPitch_ = false;
+    std::string postScriptName_;
+    // Glyph ids of the Basic Multilingual Plane, filled in as characters
+    // are first looked up; 0xFFFF marks an entry not looked up yet.
+    mutable std::vector<uint16_t> bmpCache_;
+};
+
+#endif
@@ -1,14 +1,118 @@
 #include "ui_automation.h"
+#include "keyword_detector.h"
+#include "utils.h"
 #include <algorithm>
-#include <sstream>
+#include <atomic>
+#include <utility>
+
+namespace {
+
+// Cap on text read from one document. Larger documents are cut off here
+// rather than held in memory whole.
+constexpr size_t kMaxDocumentChars = 8 * 1024 * 1024;
+
+// Length to which the name of the first matching element is cut.
+constexpr size_t kMatchedNameChars = 120;
+
+// Limits on how long one cross-process call may wait for a provider to
+// accept the connection and to answer. The defaults (2 s and 20 s) would let
+// a single hung application stall an extraction for most of a minute.
+constexpr DWORD kConnectionTimeoutMillis = 1500;
+constexpr DWORD kTransactionTimeoutMillis = 4000;
+
+bool IsProviderFailure(HRESULT hr) {
+    return hr == static_cast<HRESULT>(UIA_E_TIMEOUT) || hr == RPC_E_CALL_CANCELED || hr == RPC_E_DISCONNECTED ||
+           hr == RPC_E_SERVERCALL_RETRYLATER || hr == RPC_E_SERVERFAULT || hr == CO_E_OBJNOTCONNECTED ||
+           hr == HRESULT_FROM_WIN32(RPC_S_SERVER_UNAVAILABLE) || hr == HRESULT_FROM_WIN32(RPC_S_CALL_FAILED);
+}
+
+// Appends a BSTR's characters directly, space-separated from any text
+// already there.
+void AppendBstr(std::wstring& text, BSTR value) {
+    const UINT length = value ? SysStringLen(value) : 0;
+    if (length == 0) return;
+    if (!text.empty()) text.push_back(L' ');
+    text.append(value, length);
+}
+
+// Pages through an IUIAutomationTextRange by paragraphs.
+class UIATextRangeCursor : public TextRangeCursor {
+public:
+    explicit UIATextRangeCursor(IUIAutomationTextRange* document) {
+        if (SUCCEEDED(document->Clone(&range_)) && range_) {
+            range_->MoveEndpointByRange(TextPatternRangeEndpoint_End, range_, TextPatternRangeEndpoint_Start);
+        }
+    }
+
+    ~UIATextRangeCursor() override {
+        if (range_) range_->Release();
+    }
+
+    bool IsValid() const { return range_ != nullptr; }
+
+    int ExtendEnd(int units) override {
+        int moved = 0;
+        if (FAILED(range_->MoveEndpointByUnit(TextPatternRangeEndpoint_End, TextUnit_Paragraph, units, &moved))) {
+            return 0;
+        }
+        return moved;
+    }
+
+    bool GetText(size_t maxLength, std::wstring& text) override {
+        BSTR value = nullptr;
+        if (FAILED(range_->GetText(static_cast<int>(maxLength), &value))) return false;
+        if (value) {
+            text.assign(value, SysStringLen(value));
+            SysFreeString(value);
+        } else {
+            text.clear();
+        }
+        return true;
+    }
+
+    // Providers count characters in their own units; for the rare chunk
+    // that ends mid surrogate pair this may skip or repeat one character.
+    void AdvanceStart(size_t count) override {
+        int moved = 0;
+        range_->MoveEndpointByUnit(TextPatternRangeEndpoint_Start, TextUnit_Character, static_cast<int>(count), &moved);
+    }
+
+    void CollapseToEnd() override {
+        range_->MoveEndpointByRange(TextPatternRangeEndpoint_Start, range_, TextPatternRangeEndpoint_End);
+    }
+
+private:
+    IUIAutomationTextRange* range_ = nullptr;
+};
+
+std::atomic<uint32_t> nextInstanceId{0};
+
+// "windowTexts#2" for the third instance's text cache.
+std::string PoolName(const char* base, uint32_t instanceId) {
+    return std::string(base) + "#" + std::to_string(instanceId);
+}
+
+}  // namespace
 
 UIAutomation::UIAutomation()
     : automation_(nullptr)
     , textCondition_(nullptr)
     , nameCondition_(nullptr)
+    , snapshotCacheRequest_(nullptr)
+    , viewportCacheRequest_(nullptr)
+    , onscreenCondition_(nullptr)
+    , offscreenCondition_(nullptr)
+    , documentCondition_(nullptr)
+    , profileCacheRequest_(nullptr)
     , comInitialized_(false)
+    , callCancellationEnabled_(false)
+    , providerError_(S_OK)
     , monitoring_(false)
-    , lastForegroundWindow_(nullptr) {
+    , lastForegroundWindow_(nullptr)
+    , instanceId_(nextInstanceId++)
+    , snapshotPool_(MemoryGovernor::Instance(), PoolName("windowSnapshots", instanceId_), PoolPriority::kLow)
+    , textPool_(MemoryGovernor::Instance(), PoolName("windowTexts", instanceId_), PoolPriority::kLow)
+    , bufferPool_(MemoryGovernor::Instance(), PoolName("extractionBuffers", instanceId_), PoolPriority::kHigh) {
 }
 
 UIAutomation::~UIAutomation() {
@@ -22,11 +126,39 @@ UIAutomation::~UIAutomation() {
         nameCondition_->Release();
         nameCondition_ = nullptr;
     }
+    if (snapshotCacheRequest_) {
+        snapshotCacheRequest_->Release();
+        snapshotCacheRequest_ = nullptr;
+    }
+    if (viewportCacheRequest_) {
+        viewportCacheRequest_->Release();
+        viewportCacheRequest_ = nullptr;
+    }
+    if (onscreenCondition_) {
+        onscreenCondition_->Release();
+        onscreenCondition_ = nullptr;
+    }
+    if (offscreenCondition_) {
+        offscreenCondition_->Release();
+        offscreenCondition_ = nullptr;
+    }
+    if (documentCondition_) {
+        documentCondition_->Release();
+        documentCondition_ = nullptr;
+    }
+    if (profileCacheRequest_) {
+        profileCacheRequest_->Release();
+        profileCacheRequest_ = nullptr;
+    }
+    ReleaseProfileConditions();
     if (automation_) {
         automation_->Release();
         automation_ = nullptr;
     }
     
+    if (callCancellationEnabled_) {
+        CoDisableCallCancellation(nullptr);
+    }
     if (comInitialized_) {
         CoUninitialize();
     }
@@ -39,6 +171,8 @@ bool UIAutomation::Initialize() {
     } else if (hr != RPC_E_CHANGED_MODE) {
         return false;
     }
+    // Lets the provider watchdog cancel a call this thread is blocked in.
+    callCancellationEnabled_ = SUCCEEDED(CoEnableCallCancellation(nullptr));
 
     hr = CoCreateInstance(
         __uuidof(CUIAutomation),
@@ -52,15 +186,76 @@ bool UIAutomation::Initialize() {
         return false;
     }
 
+    // IUIAutomation2 needs Windows 8; earlier systems keep the defaults.
+    IUIAutomation2* automation2 = nullptr;
+    if (SUCCEEDED(automation_->QueryInterface(__uuidof(IUIAutomation2), reinterpret_cast<void**>(&automation2))) &&
+        automation2) {
+        automation2->put_ConnectionTimeout(kConnectionTimeoutMillis);
+        automation2->put_TransactionTimeout(kTransactionTimeoutMillis);
+        automation2->Release();
+    }
+
+    const std::wstring directory = GetExecutableDirectory();
+    if (!directory.empty()) {
+        // Missing or invalid profiles only cost speed: every app is then read
+        // in full, as before profiles existed.
+        LoadExtractionProfiles(directory + L"data\\extraction_profiles.txt");
+    }
+
     return InitializeConditions();
 }
 
+void UIAutomation::NoteResult(HRESULT hr) {
+    if (IsProviderFailure(hr)) {
+        if (providerError_ == S_OK) providerError_ = hr;
+        return;
+    }
+    // Any other result, an error included, means the provider answered.
+    if (progress_) progress_();
+}
+
+bool UIAutomation::LoadExtractionProfiles(const std::wstring& path) {
+    std::string contents;
+    if (!ReadFileContents(path, contents)) return false;
+
+    std::string error;
+    ExtractionProfileSet profiles;
+    if (!profiles.Parse(contents, error)) {
+        OutputDebugStringA(("Warning: extraction profiles not loaded: " + error + "\n").c_str());
+        return false;
+    }
+
+    ReleaseProfileConditions();
+    profiles_ = std::move(profiles);
+    profileConditions_.assign(profiles_.Size(), nullptr);
+    return true;
+}
+
 bool UIAutomation::InitializeConditions() {
     if (!automation_) return false;
 
     HRESULT hr = automation_->CreateTrueCondition(&textCondition_);
     if (FAILED(hr)) return false;
 
+    VARIANT value;
+    VariantInit(&value);
+    value.vt = VT_I4;
+    value.lVal = UIA_DocumentControlTypeId;
+    IUIAutomationCondition* isDocument = nullptr;
+    hr = automation_->CreatePropertyCondition(UIA_ControlTypePropertyId, value, &isDocument);
+    if (FAILED(hr)) return false;
+
+    value.vt = VT_BOOL;
+    value.boolVal = VARIANT_TRUE;
+    IUIAutomationCondition* hasTextPattern = nullptr;
+    hr = automation_->CreatePropertyCondition(UIA_IsTextPatternAvailablePropertyId, value, &hasTextPattern);
+    if (SUCCEEDED(hr)) {
+        hr = automation_->CreateAndCondition(isDocument, hasTextPattern, &documentCondition_);
+        hasTextPattern->Release();
+    }
+    isDocument->Release();
+    if (FAILED(hr)) return false;
+
     return true;
 }
 
@@ -90,66 +285,85 @@ std::wstring UIAutomation::GetElementName(IUIAutomationElement* element) {
     return L"";
 }
 
-std::wstring UIAutomation::GetElementValue(IUIAutomationElement* element) {
-    if (!element) return L"";
+// Reads the element's document range in bounded pages rather than one
+// GetText(-1), which would marshal a whole 400-page PDF in a single call.
+bool UIAutomation::ReadElementTextPattern(IUIAutomationElement* element, const TextPager::Consumer& consume,
+                                          size_t maxChars) {
+    if (!element) return false;
 
-    VARIANT value;
-    VariantInit(&value);
-    HRESULT hr = element->GetCurrentPropertyValue(UIA_ValueValuePropertyId, &value);
-    if (SUCCEEDED(hr) && value.vt == VT_BSTR && value.bstrVal) {
-        std::wstring result(value.bstrVal);
-        VariantClear(&value);
-        return result;
-    }
-    VariantClear(&value);
-    return L"";
-}
+    IUIAutomationTextPattern* textPattern = nullptr;
+    HRESULT hr = element->GetCurrentPatternAs(UIA_TextPatternId, __uuidof(IUIAutomationTextPattern), reinterpret_cast<void**>(&textPattern));
+    NoteResult(hr);
+    if (FAILED(hr) || !textPattern) return false;
 
-std::wstring UIAutomation::GetElementTextPatternText(IUIAutomationElement* element) {
-    if (!element) return L"";
-
-    ITextProvider* textProvider = nullptr;
-    HRESULT hr = element->GetCurrentPatternAs(UIA_TextPatternId, __uuidof(ITextProvider), reinterpret_cast<void**>(&textProvider));
-    if (FAILED(hr) || !textProvider) return L"";
-
-    std::wstring result;
-    ITextRangeProvider* textRange = nullptr;
-    hr = textProvider->get_DocumentRange(&textRange);
+    bool ok = false;
+    IUIAutomationTextRange* textRange = nullptr;
+    hr = textPattern->get_DocumentRange(&textRange);
     if (SUCCEEDED(hr) && textRange) {
-        BSTR text = nullptr;
-        hr = textRange->GetText(-1, &text);
-        if (SUCCEEDED(hr) && text) {
-            result = std::wstring(text);
-            SysFreeString(text);
+        UIATextRangeCursor cursor(textRange);
+        if (cursor.IsValid()) {
+            TextPagerOptions options;
+            options.maxTotalChars = maxChars;
+            TextPager pager(options);
+            // Each page is a provider call of its own.
+            ok = pager.Read(cursor, [&](const wchar_t* page, size_t length) {
+                NoteResult(S_OK);
+                return consume(page, length);
+            }) != TextPagerResult::kFailed;
         }
         textRange->Release();
     }
-    textProvider->Release();
-    return result;
+    textPattern->Release();
+    return ok;
 }
 
-std::wstring UIAutomation::GetElementText(IUIAutomationElement* element) {
-    if (!element) return L"";
+// Asks for the pattern only when the element says it has one, so an
+// element without costs one property read rather than a failed pattern call.
+// Pages go to |sink| as they are read, so a sink that has seen enough stops
+// the read without the rest of the document being fetched or buffered.
+bool UIAutomation::StreamDocumentText(IUIAutomationElement* element, const ElementTextSink& sink, bool& continued,
+                                      bool& completed) {
+    if (!element) return false;
 
-    std::wstring result;
+    VARIANT available;
+    VariantInit(&available);
+    HRESULT hr = element->GetCurrentPropertyValue(UIA_IsTextPatternAvailablePropertyId, &available);
+    NoteResult(hr);
+    const bool hasTextPattern = SUCCEEDED(hr) && available.vt == VT_BOOL && available.boolVal == VARIANT_TRUE;
+    VariantClear(&available);
+    if (!hasTextPattern) return false;
 
-    std::wstring textPatternText = GetElementTextPatternText(element);
-    if (!textPatternText.empty()) {
-        result = textPatternText;
-    }
+    return ReadElementTextPattern(element, [&](const wchar_t* page, size_t length) {
+        completed = sink(element, page, length, continued);
+        continued = true;
+        return completed;
+    }, kMaxDocumentChars);
+}
+
+void UIAutomation::AppendElementText(IUIAutomationElement* element, std::wstring& text) {
+    if (!element) return;
 
-    std::wstring name = GetElementName(element);
-    if (!name.empty()) {
-        if (!result.empty()) result += L" ";
-        result += name;
+    BSTR name = nullptr;
+    HRESULT hr = element->get_CurrentName(&name);
+    NoteResult(hr);
+    if (SUCCEEDED(hr) && name) {
+        AppendBstr(text, name);
+        SysFreeString(name);
     }
 
-    std::wstring value = GetElementValue(element);
-    if (!value.empty()) {
-        if (!result.empty()) result += L" ";
-        result += value;
+    VARIANT value;
+    VariantInit(&value);
+    hr = element->GetCurrentPropertyValue(UIA_ValueValuePropertyId, &value);
+    NoteResult(hr);
+    if (SUCCEEDED(hr) && value.vt == VT_BSTR) {
+        AppendBstr(text, value.bstrVal);
     }
+    VariantClear(&value);
+}
 
+std::wstring UIAutomation::GetElementText(IUIAutomationElement* element) {
+    std::wstring result;
+    AppendElementText(element, result);
     return result;
 }
 
@@ -159,10 +373,12 @@ std::wstring UIAutomation::ExtractTextFromForegroundWindow() {
 }
 
 std::wstring UIAutomation::ExtractTextFromFocusedElement() {
+    providerError_ = S_OK;
     if (!automation_) return L"";
 
     IUIAutomationElement* focusedElement = nullptr;
     HRESULT hr = automation_->GetFocusedElement(&focusedElement);
+    NoteResult(hr);
     if (FAILED(hr) || !focusedElement) return L"";
 
     std::wstring result = ExtractAllTextFromElement(focusedElement);
@@ -171,10 +387,12 @@ std::wstring UIAutomation::ExtractTextFromFocusedElement() {
 }
 
 std::wstring UIAutomation::ExtractTextFromWindow(HWND hwnd) {
+    providerError_ = S_OK;
     if (!automation_ || !hwnd) return L"";
 
     IUIAutomationElement* rootElement = nullptr;
     HRESULT hr = automation_->ElementFromHandle(hwnd, &rootElement);
+    NoteResult(hr);
     if (FAILED(hr) || !rootElement) return L"";
 
     std::wstring result = ExtractAllTextFromElement(rootElement);
@@ -183,96 +401,751 @@ std::wstring UIAutomation::ExtractTextFromWindow(HWND hwnd) {
 }
 
 std::wstring UIAutomation::ExtractAllTextFromElement(IUIAutomationElement* element) {
-    if (!element || !automation_) return L"";
+    std::wstring result;
+    extraction_.Begin();
+    CollectAllText(element);
+    extraction_.Text().CopyTo(result);
+    EndExtraction();
+    return result;
+}
+
+bool UIAutomation::ExtractTextFromWindowUtf8(HWND hwnd, std::string& text) {
+    text.clear();
+    providerError_ = S_OK;
+    if (!automation_ || !hwnd) return false;
+
+    IUIAutomationElement* root = nullptr;
+    HRESULT hr = automation_->ElementFromHandle(hwnd, &root);
+    NoteResult(hr);
+    if (FAILED(hr) || !root) return false;
+
+    extraction_.Begin();
+    CollectAllText(root);
+    extraction_.Text().CopyToUtf8(text);
+    EndExtraction();
+    root->Release();
+    return true;
+}
+
+void UIAutomation::CollectAllText(IUIAutomationElement* element) {
+    TextArena& arena = extraction_.Text();
+    StreamElementText(element, [&arena](IUIAutomationElement*, const wchar_t* text, size_t length, bool continued) {
+        if (!continued && !arena.Empty()) arena.Append(L'\n');
+        arena.Append(text, length);
+        return true;
+    });
+}
 
-    std::wstring result = GetElementText(element);
+bool UIAutomation::StreamElementText(IUIAutomationElement* element, const ElementTextSink& sink) {
+    if (!element || !automation_) return true;
+
+    size_t profileIndex = 0;
+    const ExtractionProfile* profile = FindProfileForElement(element, profileIndex);
+    // A profile decides for itself whether documents are read whole, so the
+    // document probe is only needed without one.
+    const bool hasTextDocument = !profile && HasTextDocument(element);
+    switch (ChooseExtractionStrategy(profile, hasTextDocument)) {
+    case ExtractionStrategy::kProfileWalk:
+        return StreamTextWithProfile(element, *profile, GetProfileCondition(profileIndex), sink);
+    case ExtractionStrategy::kDocumentFastPath:
+        return StreamTextWithProfile(element, ExtractionProfile::GenericDocument(), textCondition_, sink);
+    case ExtractionStrategy::kFullWalk:
+        break;
+    }
+
+    // Only the element the walk starts from is read as a document. Its
+    // descendants hold the same text again, so once it has been read they
+    // are not visited, and theirs are never read as documents.
+    bool continued = false;
+    bool completed = true;
+    const bool readDocument = StreamDocumentText(element, sink, continued, completed);
+    if (!completed) return false;
+
+    // Each element is assembled in the same scratch buffer, which keeps its
+    // capacity from one element and one extraction to the next.
+    std::wstring& text = extraction_.Scratch();
+    text.clear();
+    AppendElementText(element, text);
+    if (!text.empty()) {
+        // Separates the name from the document's last page.
+        if (continued) text.insert(text.begin(), L' ');
+        if (!sink(element, text.data(), text.size(), continued)) return false;
+    }
+    if (readDocument) return true;
 
     IUIAutomationElementArray* children = nullptr;
     HRESULT hr = element->FindAll(TreeScope_Descendants, textCondition_, &children);
-    if (FAILED(hr) || !children) return result;
+    NoteResult(hr);
+    if (FAILED(hr) || !children) return true;
 
     int length = 0;
     hr = children->get_Length(&length);
     if (FAILED(hr)) {
         children->Release();
-        return result;
+        return true;
     }
 
-    for (int i = 0; i < length; i++) {
+    bool completed = true;
+    // A provider that stopped responding would only time out again on
+    // every remaining element.
+    for (int i = 0; i < length && completed && providerError_ == S_OK; i++) {
         IUIAutomationElement* child = nullptr;
         hr = children->GetElement(i, &child);
         if (SUCCEEDED(hr) && child) {
-            std::wstring childText = GetElementText(child);
-            if (!childText.empty()) {
-                if (!result.empty()) result += L"\n";
-                result += childText;
+            text.clear();
+            AppendElementText(child, text);
+            if (!text.empty()) {
+                completed = sink(child, text.data(), text.size(), false);
             }
             child->Release();
         }
     }
 
     children->Release();
+    return completed;
+}
+
+bool UIAutomation::InitializeProfileCacheRequest() {
+    if (!automation_) return false;
+    if (profileCacheRequest_) return true;
+
+    HRESULT hr = automation_->CreateCacheRequest(&profileCacheRequest_);
+    if (FAILED(hr) || !profileCacheRequest_) return false;
+
+    profileCacheRequest_->AddProperty(UIA_ControlTypePropertyId);
+    profileCacheRequest_->AddProperty(UIA_ClassNamePropertyId);
+    profileCacheRequest_->AddProperty(UIA_NamePropertyId);
+    profileCacheRequest_->AddProperty(UIA_ValueValuePropertyId);
+    profileCacheRequest_->AddProperty(UIA_IsTextPatternAvailablePropertyId);
+    return true;
+}
+
+void UIAutomation::ReleaseProfileConditions() {
+    for (auto*& condition : profileConditions_) {
+        if (condition) {
+            condition->Release();
+            condition = nullptr;
+        }
+    }
+}
+
+// Compiles a profile's skip-set into NOT(type == a OR ... OR class == x), so
+// providers drop skipped children before they cross the process boundary
+// and the walk never descends into them.
+IUIAutomationCondition* UIAutomation::GetProfileCondition(size_t index) {
+    if (index >= profileConditions_.size()) return nullptr;
+    if (profileConditions_[index]) return profileConditions_[index];
+
+    const ExtractionProfile& profile = profiles_.At(index);
+    std::vector<IUIAutomationCondition*> skipped;
+    for (int controlType : profile.SkippedControlTypes()) {
+        VARIANT value;
+        VariantInit(&value);
+        value.vt = VT_I4;
+        value.lVal = controlType;
+        IUIAutomationCondition* condition = nullptr;
+        if (SUCCEEDED(automation_->CreatePropertyCondition(UIA_ControlTypePropertyId, value, &condition))) {
+            skipped.push_back(condition);
+        }
+    }
+    for (const auto& className : profile.skipClasses) {
+        VARIANT value;
+        VariantInit(&value);
+        value.vt = VT_BSTR;
+        value.bstrVal = SysAllocString(className.c_str());
+        IUIAutomationCondition* condition = nullptr;
+        if (SUCCEEDED(automation_->CreatePropertyConditionEx(UIA_ClassNamePropertyId, value,
+                                                             PropertyConditionFlags_IgnoreCase, &condition))) {
+            skipped.push_back(condition);
+        }
+        VariantClear(&value);
+    }
+
+    IUIAutomationCondition* result = nullptr;
+    if (skipped.empty()) {
+        automation_->CreateTrueCondition(&result);
+    } else {
+        IUIAutomationCondition* anySkipped = nullptr;
+        if (SUCCEEDED(automation_->CreateOrConditionFromNativeArray(skipped.data(), static_cast<int>(skipped.size()), &anySkipped))) {
+            automation_->CreateNotCondition(anySkipped, &result);
+            anySkipped->Release();
+        }
+        for (auto* condition : skipped) {
+            condition->Release();
+        }
+    }
+    profileConditions_[index] = result;
     return result;
 }
 
-bool UIAutomation::ContainsTCKewords(const std::wstring& text) {
-    if (text.empty()) return false;
-
-    std::wstring lowerText = text;
-    std::transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::towlower);
-
-    const std::vector<std::wstring> keywords = {
-        L"terms and conditions",
-        L"terms of service",
-        L"terms of use",
-        L"user agreement",
-        L"end user license",
-        L"eula",
-        L"license agreement",
-        L"service agreement",
-        L"subscription agreement",
-        L"membership agreement",
-        L"terms & conditions",
-        L"t&c",
-        L"legal terms",
-        L"agreement to terms"
+const ExtractionProfile* UIAutomation::FindProfileForElement(IUIAutomationElement* element, size_t& index) {
+    if (profiles_.Empty()) return nullptr;
+
+    std::wstring processName;
+    int processId = 0;
+    if (SUCCEEDED(element->get_CurrentProcessId(&processId)) && processId != 0) {
+        HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(processId));
+        if (process) {
+            wchar_t path[MAX_PATH] = {0};
+            DWORD size = MAX_PATH;
+            if (QueryFullProcessImageNameW(process, 0, path, &size)) {
+                processName.assign(path, size);
+                processName.erase(0, processName.find_last_of(L'\\') + 1);
+            }
+            CloseHandle(process);
+        }
+    }
+
+    std::wstring windowClass;
+    UIA_HWND handle = nullptr;
+    if (SUCCEEDED(element->get_CurrentNativeWindowHandle(&handle)) && handle) {
+        wchar_t className[256] = {0};
+        HWND root = GetAncestor(static_cast<HWND>(handle), GA_ROOT);
+        if (root && GetClassNameW(root, className, 256) > 0) {
+            windowClass = className;
+        }
+    }
+
+    const ExtractionProfile* profile = profiles_.Match(processName, windowClass);
+    if (profile) {
+        index = static_cast<size_t>(profile - &profiles_.At(0));
+    }
+    return profile;
+}
+
+// Browsers expose the page as one document element with TextPattern. The
+// provider evaluates this search in-process, so probing costs one call.
+bool UIAutomation::HasTextDocument(IUIAutomationElement* root) {
+    if (!documentCondition_) return false;
+    IUIAutomationElement* document = nullptr;
+    HRESULT hr = root->FindFirst(TreeScope_Subtree, documentCondition_, &document);
+    NoteResult(hr);
+    if (FAILED(hr) || !document) return false;
+    document->Release();
+    return true;
+}
+
+bool UIAutomation::StreamTextWithProfile(IUIAutomationElement* root, const ExtractionProfile& profile,
+                                         IUIAutomationCondition* condition, const ElementTextSink& sink) {
+    if (!condition || !InitializeProfileCacheRequest()) return true;
+
+    IUIAutomationElement* cachedRoot = nullptr;
+    HRESULT hr = root->BuildUpdatedCache(profileCacheRequest_, &cachedRoot);
+    NoteResult(hr);
+    if (FAILED(hr) || !cachedRoot) return true;
+
+    bool completed = true;
+    auto emit = [&](IUIAutomationElement* element, const wchar_t* text, size_t length) {
+        if (length > 0 && completed) {
+            completed = sink(element, text, length, false);
+        }
     };
+    std::wstring& scratch = extraction_.Scratch();
+
+    // Depth-first in document order; each level's children come back in one
+    // call with their properties cached.
+    std::vector<IUIAutomationElement*> pending;
+    pending.push_back(cachedRoot);
+    while (!pending.empty()) {
+        IUIAutomationElement* element = pending.back();
+        pending.pop_back();
+
+        CONTROLTYPEID controlType = 0;
+        element->get_CachedControlType(&controlType);
+        BSTR className = nullptr;
+        element->get_CachedClassName(&className);
+        VARIANT textPattern;
+        VariantInit(&textPattern);
+        element->GetCachedPropertyValue(UIA_IsTextPatternAvailablePropertyId, &textPattern);
+        const bool hasTextPattern = textPattern.vt == VT_BOOL && textPattern.boolVal == VARIANT_TRUE;
+        VariantClear(&textPattern);
+
+        const ProfileAction action = profile.Classify(controlType, className ? className : L"", hasTextPattern);
+        if (className) SysFreeString(className);
+
+        bool descend = completed && providerError_ == S_OK && action != ProfileAction::kSkipSubtree;
+        if (!completed || providerError_ != S_OK) {
+            // Aborted, or the provider stopped responding: release what is
+            // still queued without visiting it.
+        } else if (action == ProfileAction::kReadDocument) {
+            // Pages of one document reach the sink as a single element.
+            bool continued = false;
+            ReadElementTextPattern(element, [&](const wchar_t* text, size_t length) {
+                completed = sink(element, text, length, continued);
+                continued = true;
+                return completed;
+            }, kMaxDocumentChars);
+            // Fall back to the children if the provider's text range is empty.
+            descend = completed && !continued;
+        } else if (action == ProfileAction::kReadAndDescend) {
+            if (profile.prefer == PreferredPattern::kName) {
+                BSTR name = nullptr;
+                if (SUCCEEDED(element->get_CachedName(&name)) && name) {
+                    emit(element, name, SysStringLen(name));
+                    SysFreeString(name);
+                }
+            } else if (profile.prefer == PreferredPattern::kValue) {
+                VARIANT value;
+                VariantInit(&value);
+                if (SUCCEEDED(element->GetCachedPropertyValue(UIA_ValueValuePropertyId, &value)) &&
+                    value.vt == VT_BSTR && value.bstrVal) {
+                    emit(element, value.bstrVal, SysStringLen(value.bstrVal));
+                }
+                VariantClear(&value);
+            } else {
+                scratch.clear();
+                AppendCachedElementText(element, scratch);
+                emit(element, scratch.data(), scratch.size());
+            }
+            descend = completed;
+        }
 
-    for (const auto& keyword : keywords) {
-        if (lowerText.find(keyword) != std::wstring::npos) {
-            return true;
+        if (descend) {
+            IUIAutomationElementArray* children = nullptr;
+            hr = element->FindAllBuildCache(TreeScope_Children, condition, profileCacheRequest_, &children);
+            NoteResult(hr);
+            if (SUCCEEDED(hr) && children) {
+                int length = 0;
+                children->get_Length(&length);
+                // Push in reverse so children pop in document order.
+                for (int i = length - 1; i >= 0; i--) {
+                    IUIAutomationElement* child = nullptr;
+                    if (SUCCEEDED(children->GetElement(i, &child)) && child) {
+                        pending.push_back(child);
+                    }
+                }
+                children->Release();
+            }
         }
+        element->Release();
     }
-    return false;
+
+    return completed;
 }
 
-bool UIAutomation::ContainsPrivacyKeywords(const std::wstring& text) {
-    if (text.empty()) return false;
-
-    std::wstring lowerText = text;
-    std::transform(lowerText.begin(), lowerText.end(), lowerText.begin(), ::towlower);
-
-    const std::vector<std::wstring> keywords = {
-        L"privacy policy",
-        L"privacy notice",
-        L"data protection",
-        L"data collection",
-        L"personal data",
-        L"personal information",
-        L"privacy statement",
-        L"privacy practices",
-        L"information we collect",
-        L"how we use your information",
-        L"cookie policy",
-        L"data sharing"
+bool UIAutomation::InitializeSnapshotCacheRequest() {
+    if (!automation_) return false;
+    if (snapshotCacheRequest_) return true;
+
+    HRESULT hr = automation_->CreateCacheRequest(&snapshotCacheRequest_);
+    if (FAILED(hr) || !snapshotCacheRequest_) return false;
+
+    snapshotCacheRequest_->AddProperty(UIA_RuntimeIdPropertyId);
+    snapshotCacheRequest_->AddProperty(UIA_ControlTypePropertyId);
+    snapshotCacheRequest_->AddProperty(UIA_AutomationIdPropertyId);
+    snapshotCacheRequest_->AddProperty(UIA_NamePropertyId);
+    snapshotCacheRequest_->AddProperty(UIA_ValueValuePropertyId);
+    snapshotCacheRequest_->put_TreeScope(TreeScope_Subtree);
+    return true;
+}
+
+std::string UIAutomation::GetCachedRuntimeIdKey(IUIAutomationElement* element) {
+    std::string key;
+    VARIANT value;
+    VariantInit(&value);
+    HRESULT hr = element->GetCachedPropertyValue(UIA_RuntimeIdPropertyId, &value);
+    if (SUCCEEDED(hr) && value.vt == (VT_I4 | VT_ARRAY) && value.parray) {
+        LONG lower = 0;
+        LONG upper = -1;
+        SafeArrayGetLBound(value.parray, 1, &lower);
+        SafeArrayGetUBound(value.parray, 1, &upper);
+        int* data = nullptr;
+        if (SUCCEEDED(SafeArrayAccessData(value.parray, reinterpret_cast<void**>(&data)))) {
+            for (LONG i = 0; i <= upper - lower; i++) {
+                if (i > 0) key += '.';
+                key += std::to_string(data[i]);
+            }
+            SafeArrayUnaccessData(value.parray);
+        }
+    }
+    VariantClear(&value);
+    return key;
+}
+
+std::string UIAutomation::GetCachedSiblingSlot(IUIAutomationElement* element) {
+    std::string slot;
+    BSTR automationId = nullptr;
+    if (SUCCEEDED(element->get_CachedAutomationId(&automationId)) && automationId) {
+        if (SysStringLen(automationId) > 0) {
+            slot = "id:" + Utf8FromUtf16(automationId);
+        }
+        SysFreeString(automationId);
+    }
+    if (slot.empty()) {
+        CONTROLTYPEID controlType = 0;
+        element->get_CachedControlType(&controlType);
+        slot = "ct:" + std::to_string(controlType);
+    }
+    return slot;
+}
+
+void UIAutomation::AppendCachedElementText(IUIAutomationElement* element, std::wstring& text) {
+    BSTR name = nullptr;
+    if (SUCCEEDED(element->get_CachedName(&name)) && name) {
+        AppendBstr(text, name);
+        SysFreeString(name);
+    }
+
+    VARIANT value;
+    VariantInit(&value);
+    HRESULT hr = element->GetCachedPropertyValue(UIA_ValueValuePropertyId, &value);
+    if (SUCCEEDED(hr) && value.vt == VT_BSTR) {
+        AppendBstr(text, value.bstrVal);
+    }
+    VariantClear(&value);
+}
+
+std::wstring UIAutomation::GetCachedElementText(IUIAutomationElement* element) {
+    std::wstring result;
+    AppendCachedElementText(element, result);
+    return result;
+}
+
+bool UIAutomation::CaptureWindowSnapshot(HWND hwnd, TreeSnapshot& snapshot) {
+    snapshot.Clear();
+    providerError_ = S_OK;
+    if (!automation_ || !hwnd) return false;
+    if (!InitializeSnapshotCacheRequest()) return false;
+
+    IUIAutomationElement* root = nullptr;
+    HRESULT hr = automation_->ElementFromHandleBuildCache(hwnd, snapshotCacheRequest_, &root);
+    NoteResult(hr);
+    if (FAILED(hr) || !root) return false;
+
+    // Walk the cached subtree iteratively; the whole tree was fetched in one
+    // cross-process call so no further round trips happen here.
+    struct PendingElement {
+        IUIAutomationElement* element;
+        std::string parentKey;
+        // Key for an element without a runtime id: its sibling slot and its
+        // ordinal among the parent's children with that slot, so the key
+        // survives unrelated siblings coming and going.
+        std::string fallbackKey;
     };
+    std::vector<PendingElement> pending;
+    pending.push_back({root, std::string(), std::string("/root")});
+    std::unordered_map<std::string, int> slotCounts;
+
+    while (!pending.empty()) {
+        IUIAutomationElement* element = pending.back().element;
+        std::string parentKey = std::move(pending.back().parentKey);
+        std::string key = GetCachedRuntimeIdKey(element);
+        if (key.empty()) {
+            key = std::move(pending.back().fallbackKey);
+        }
+        pending.pop_back();
+
+        CONTROLTYPEID controlType = 0;
+        element->get_CachedControlType(&controlType);
+        snapshot.Add(key, parentKey, controlType, GetCachedElementText(element));
+
+        IUIAutomationElementArray* children = nullptr;
+        hr = element->GetCachedChildren(&children);
+        if (SUCCEEDED(hr) && children) {
+            int length = 0;
+            children->get_Length(&length);
+            const size_t first = pending.size();
+            slotCounts.clear();
+            for (int i = 0; i < length; i++) {
+                IUIAutomationElement* child = nullptr;
+                if (SUCCEEDED(children->GetElement(i, &child)) && child) {
+                    std::string slot = GetCachedSiblingSlot(child);
+                    const int ordinal = slotCounts[slot]++;
+                    pending.push_back({child, key, key + "/" + slot + "#" + std::to_string(ordinal)});
+                }
+            }
+            // Reverse so children pop in document order.
+            std::reverse(pending.begin() + static_cast<std::ptrdiff_t>(first), pending.end());
+            children->Release();
+        }
+        element->Release();
+    }
+
+    return true;
+}
+
+static uint64_t WindowKey(HWND hwnd) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(hwnd));
+}
+
+static HWND WindowFromKey(uint64_t key) {
+    return reinterpret_cast<HWND>(static_cast<uintptr_t>(key));
+}
+
+void UIAutomation::PruneWindowSnapshots() {
+    for (auto it = windowSnapshots_.begin(); it != windowSnapshots_.end();) {
+        if (!IsWindow(it->first)) {
+            snapshotPool_.Release(WindowKey(it->first));
+            it = windowSnapshots_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = windowTexts_.begin(); it != windowTexts_.end();) {
+        if (!IsWindow(it->first)) {
+            textPool_.Release(WindowKey(it->first));
+            it = windowTexts_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void UIAutomation::ForgetWindowText(HWND hwnd) {
+    windowTexts_.erase(hwnd);
+    textPool_.Release(WindowKey(hwnd));
+}
 
-    for (const auto& keyword : keywords) {
-        if (lowerText.find(keyword) != std::wstring::npos) {
-            return true;
+void UIAutomation::ForgetWindowSnapshot(HWND hwnd) {
+    windowSnapshots_.erase(hwnd);
+    snapshotPool_.Release(WindowKey(hwnd));
+}
+
+void UIAutomation::ClearWindowSnapshots() {
+    for (const auto& entry : windowSnapshots_) {
+        snapshotPool_.Release(WindowKey(entry.first));
+    }
+    for (const auto& entry : windowTexts_) {
+        textPool_.Release(WindowKey(entry.first));
+    }
+    windowSnapshots_.clear();
+    windowTexts_.clear();
+}
+
+void UIAutomation::EndExtraction() {
+    extraction_.End();
+    bufferPool_.Charge(0, extraction_.GetStats().retainedBytes);
+    ApplyMemoryEvictions();
+}
+
+void UIAutomation::ApplyMemoryEvictions() {
+    evictedKeys_.clear();
+    if (snapshotPool_.TakeEvictions(evictedKeys_)) {
+        for (uint64_t key : evictedKeys_) {
+            windowSnapshots_.erase(WindowFromKey(key));
+        }
+    }
+    evictedKeys_.clear();
+    if (textPool_.TakeEvictions(evictedKeys_)) {
+        for (uint64_t key : evictedKeys_) {
+            windowTexts_.erase(WindowFromKey(key));
+        }
+    }
+    evictedKeys_.clear();
+    if (bufferPool_.TakeEvictions(evictedKeys_)) {
+        extraction_.Trim();
+    }
+}
+
+bool UIAutomation::ExtractWindowDelta(HWND hwnd, TreeDelta& delta, bool& isFullSnapshot) {
+    delta.Clear();
+    isFullSnapshot = false;
+
+    TreeSnapshot current;
+    if (!CaptureWindowSnapshot(hwnd, current)) return false;
+
+    PruneWindowSnapshots();
+    TreeSnapshot& previous = windowSnapshots_[hwnd];
+    isFullSnapshot = previous.Empty();
+    DiffTreeSnapshots(previous, current, delta);
+    previous = std::move(current);
+    // May evict this very snapshot; the next delta is then a full one.
+    snapshotPool_.Charge(WindowKey(hwnd), previous.Bytes());
+    ApplyMemoryEvictions();
+    return true;
+}
+
+bool UIAutomation::InitializeViewportCacheRequest() {
+    if (!automation_) return false;
+    if (viewportCacheRequest_) return true;
+
+    VARIANT flag;
+    VariantInit(&flag);
+    flag.vt = VT_BOOL;
+    flag.boolVal = VARIANT_FALSE;
+    HRESULT hr = automation_->CreatePropertyCondition(UIA_IsOffscreenPropertyId, flag, &onscreenCondition_);
+    if (FAILED(hr)) return false;
+    flag.boolVal = VARIANT_TRUE;
+    hr = automation_->CreatePropertyCondition(UIA_IsOffscreenPropertyId, flag, &offscreenCondition_);
+    if (FAILED(hr)) return false;
+
+    hr = automation_->CreateCacheRequest(&viewportCacheRequest_);
+    if (FAILED(hr) || !viewportCacheRequest_) return false;
+    viewportCacheRequest_->AddProperty(UIA_NamePropertyId);
+    viewportCacheRequest_->AddProperty(UIA_ValueValuePropertyId);
+    viewportCacheRequest_->AddProperty(UIA_BoundingRectanglePropertyId);
+    viewportCacheRequest_->AddProperty(UIA_IsOffscreenPropertyId);
+    return true;
+}
+
+void UIAutomation::CollectViewportElements(IUIAutomationElement* root, IUIAutomationCondition* condition,
+                                           std::vector<ViewportElement>& layout, std::vector<std::wstring>& texts) {
+    IUIAutomationElementArray* found = nullptr;
+    HRESULT hr = root->FindAllBuildCache(TreeScope_Descendants, condition, viewportCacheRequest_, &found);
+    NoteResult(hr);
+    if (FAILED(hr) || !found) return;
+
+    int length = 0;
+    found->get_Length(&length);
+    for (int i = 0; i < length; i++) {
+        IUIAutomationElement* element = nullptr;
+        if (FAILED(found->GetElement(i, &element)) || !element) continue;
+
+        std::wstring text = GetCachedElementText(element);
+        if (!text.empty()) {
+            RECT rect = {};
+            BOOL offscreen = FALSE;
+            element->get_CachedBoundingRectangle(&rect);
+            element->get_CachedIsOffscreen(&offscreen);
+
+            ViewportElement item;
+            item.bounds = {rect.left, rect.top, rect.right, rect.bottom};
+            item.offscreen = offscreen != FALSE;
+            layout.push_back(item);
+            texts.push_back(std::move(text));
+        }
+        element->Release();
+    }
+    found->Release();
+}
+
+bool UIAutomation::ExtractTextByViewport(HWND hwnd, const std::function<bool(size_t band, const std::wstring& text)>& onBand) {
+    providerError_ = S_OK;
+    if (!automation_ || !hwnd) return false;
+    if (!InitializeViewportCacheRequest()) return false;
+
+    IUIAutomationElement* root = nullptr;
+    HRESULT hr = automation_->ElementFromHandle(hwnd, &root);
+    NoteResult(hr);
+    if (FAILED(hr) || !root) return false;
+
+    RECT windowRect = {};
+    GetWindowRect(hwnd, &windowRect);
+    MONITORINFO monitorInfo = {};
+    monitorInfo.cbSize = sizeof(monitorInfo);
+    GetMonitorInfo(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST), &monitorInfo);
+    RECT visibleRect = {};
+    IntersectRect(&visibleRect, &windowRect, &monitorInfo.rcMonitor);
+    const ViewportRect viewport = {visibleRect.left, visibleRect.top, visibleRect.right, visibleRect.bottom};
+
+    auto joinBand = [](const std::vector<size_t>& indices, const std::vector<std::wstring>& texts, std::wstring& out) {
+        for (size_t index : indices) {
+            if (!out.empty()) out += L"\n";
+            out += texts[index];
         }
+    };
+
+    // Band 0 only asks the provider for on-screen elements, which is a small
+    // fraction of a long document and keeps the first answer fast.
+    std::vector<ViewportElement> layout;
+    std::vector<std::wstring> texts;
+    CollectViewportElements(root, onscreenCondition_, layout, texts);
+
+    ViewportOrder order;
+    std::vector<size_t> indices;
+    order.Build(layout, viewport);
+    order.NextBand(indices);
+
+    std::wstring visibleText = GetElementText(root);
+    joinBand(indices, texts, visibleText);
+    if (!onBand(0, visibleText)) {
+        root->Release();
+        return true;
     }
-    return false;
+
+    std::vector<bool> emitted(layout.size(), false);
+    for (size_t index : indices) emitted[index] = true;
+
+    std::vector<ViewportElement> restLayout;
+    std::vector<std::wstring> restTexts;
+    for (size_t i = 0; i < layout.size(); i++) {
+        if (emitted[i]) continue;
+        restLayout.push_back(layout[i]);
+        restTexts.push_back(std::move(texts[i]));
+    }
+    CollectViewportElements(root, offscreenCondition_, restLayout, restTexts);
+    root->Release();
+
+    order.Build(restLayout, viewport);
+    size_t band = 1;
+    while (order.NextBand(indices)) {
+        std::wstring bandText;
+        joinBand(indices, restTexts, bandText);
+        if (!onBand(band++, bandText)) break;
+    }
+    return true;
+}
+
+bool UIAutomation::ExtractWindowTextPatch(HWND hwnd, std::vector<TextPatch>& patches, std::wstring& fullText, bool& isFullText) {
+    patches.clear();
+    fullText.clear();
+    isFullText = true;
+    if (!automation_ || !hwnd) return false;
+
+    std::wstring current = ExtractTextFromWindow(hwnd);
+
+    PruneWindowSnapshots();
+    auto it = windowTexts_.find(hwnd);
+    if (it != windowTexts_.end() && textPatcher_.Compute(it->second, current, patches)) {
+        isFullText = false;
+    } else {
+        patches.clear();
+        fullText = current;
+    }
+    std::wstring& stored = windowTexts_[hwnd];
+    stored = std::move(current);
+    textPool_.Charge(WindowKey(hwnd), stored.capacity() * sizeof(wchar_t));
+    ApplyMemoryEvictions();
+    return true;
+}
+
+bool UIAutomation::ClassifyWindow(HWND hwnd, uint32_t stopMask, WindowClassification& result) {
+    result = WindowClassification();
+    providerError_ = S_OK;
+    if (!automation_ || !hwnd) return false;
+
+    IUIAutomationElement* root = nullptr;
+    HRESULT hr = automation_->ElementFromHandle(hwnd, &root);
+    NoteResult(hr);
+    if (FAILED(hr) || !root) return false;
+
+    // The matcher state carries across elements and document pages, so the
+    // walk can stop at the element, or the page of a large document, that
+    // completes the answer.
+    KeywordStream stream(KeywordDetector::Default(), stopMask);
+    extraction_.Begin();
+    const bool completed = StreamElementText(root, [&](IUIAutomationElement* element, const wchar_t* text,
+                                                       size_t length, bool continued) {
+        if (!continued) stream.BeginElement();
+        const bool hadMatch = stream.Categories() != 0;
+        const bool more = stream.Feed(text, length);
+        if (!hadMatch && stream.Categories() != 0) {
+            CONTROLTYPEID controlType = 0;
+            element->get_CurrentControlType(&controlType);
+            result.matchedControlType = controlType;
+            result.matchedName = GetElementName(element);
+            if (result.matchedName.size() > kMatchedNameChars) {
+                result.matchedName.resize(kMatchedNameChars);
+            }
+        }
+        return more;
+    });
+    EndExtraction();
+    root->Release();
+
+    result.categories = stream.Categories();
+    result.elementsVisited = stream.ElementCount();
+    result.matchedElement = stream.FirstMatchElement();
+    result.stoppedEarly = !completed;
+    return true;
+}
+
+bool UIAutomation::ContainsTCKewords(const std::wstring& text) {
+    return (KeywordDetector::Default().Scan(text, kKeywordCategoryTerms) & kKeywordCategoryTerms) != 0;
+}
+
+bool UIAutomation::ContainsPrivacyKeywords(const std::wstring& text) {
+    return (KeywordDetector::Default().Scan(text, kKeywordCategoryPrivacy) & kKeywordCategoryPrivacy) != 0;
 }
 
 void UIAutomation::SetForegroundWindowChangedCallback(std::function<void(HWND, const std::wstring&)> callback) {
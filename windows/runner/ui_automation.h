@@ -4,9 +4,30 @@
 #include <windows.h>
 #include <objbase.h>
 #include <UIAutomation.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <functional>
+#include <unordered_map>
+#include "extraction_profile.h"
+#include "memory_governor.h"
+#include "text_arena.h"
+#include "text_pager.h"
+#include "text_patch.h"
+#include "tree_snapshot.h"
+#include "viewport_order.h"
+
+struct WindowClassification {
+    uint32_t categories = 0;
+    size_t elementsVisited = 0;
+    // True when the walk stopped because every requested category matched.
+    bool stoppedEarly = false;
+    // Walk-order index, control type and name of the element in which the
+    // first phrase matched; index is KeywordStream::kNoElement if none did.
+    size_t matchedElement = static_cast<size_t>(-1);
+    int matchedControlType = 0;
+    std::wstring matchedName;
+};
 
 class UIAutomation {
 public:
@@ -16,6 +37,21 @@ public:
     bool Initialize();
     bool IsInitialized() const { return automation_ != nullptr; }
 
+    // Set by the last extraction, snapshot or classification if a provider
+    // stopped responding, as opposed to an element vanishing: a timeout, a
+    // cancelled call or a lost connection. The walk stops there. S_OK if
+    // there was none.
+    HRESULT ProviderError() const { return providerError_; }
+
+    // Called on this instance's thread whenever a provider answers during a
+    // walk, so a watchdog can tell a long walk from a hung provider.
+    void SetProgressCallback(std::function<void()> callback) { progress_ = std::move(callback); }
+
+    // Replaces the per-application extraction profiles with those in |path|.
+    // Initialize() loads data\extraction_profiles.txt next to the executable;
+    // on failure the previous profiles stay in effect.
+    bool LoadExtractionProfiles(const std::wstring& path);
+
     std::wstring GetForegroundWindowTitle();
     HWND GetForegroundWindowHandle();
     
@@ -23,7 +59,30 @@ public:
     std::wstring ExtractTextFromFocusedElement();
     std::wstring ExtractTextFromWindow(HWND hwnd);
     std::wstring ExtractAllTextFromElement(IUIAutomationElement* element);
+    // Extracts straight from the reusable arena into UTF-8, the form the
+    // text is sent to Dart in, without an intermediate std::wstring.
+    bool ExtractTextFromWindowUtf8(HWND hwnd, std::string& text);
+    ExtractionContext::Stats GetExtractionMemoryStats() const { return extraction_.GetStats(); }
+
+    // Reads elements visible on the window's monitor first and then widens
+    // outward one viewport at a time. |onBand| receives band 0 (the visible
+    // text, possibly empty) first and may return false to stop early.
+    bool ExtractTextByViewport(HWND hwnd, const std::function<bool(size_t band, const std::wstring& text)>& onBand);
+
+    bool CaptureWindowSnapshot(HWND hwnd, TreeSnapshot& snapshot);
+    bool ExtractWindowDelta(HWND hwnd, TreeDelta& delta, bool& isFullSnapshot);
+    bool ExtractWindowTextPatch(HWND hwnd, std::vector<TextPatch>& patches, std::wstring& fullText, bool& isFullText);
+    void ForgetWindowText(HWND hwnd);
+    void ForgetWindowSnapshot(HWND hwnd);
+    void ClearWindowSnapshots();
+    // Drops the snapshots, texts and buffers the memory governor asked this
+    // instance to free. Runs after every extraction; call it between calls
+    // too, on this instance's thread.
+    void ApplyMemoryEvictions();
 
+    // Streams the window's text through the keyword detector as it is
+    // walked and stops once every category in |stopMask| has matched.
+    bool ClassifyWindow(HWND hwnd, uint32_t stopMask, WindowClassification& result);
     bool ContainsTCKewords(const std::wstring& text);
     bool ContainsPrivacyKeywords(const std::wstring& text);
 
@@ -36,16 +95,81 @@ private:
     IUIAutomation* automation_;
     IUIAutomationCondition* textCondition_;
     IUIAutomationCondition* nameCondition_;
+    IUIAutomationCacheRequest* snapshotCacheRequest_;
+    IUIAutomationCacheRequest* viewportCacheRequest_;
+    IUIAutomationCondition* onscreenCondition_;
+    IUIAutomationCondition* offscreenCondition_;
+    IUIAutomationCondition* documentCondition_;
+    IUIAutomationCacheRequest* profileCacheRequest_;
+    ExtractionProfileSet profiles_;
+    // Compiled skip-set filter per profile, indexed like profiles_.
+    std::vector<IUIAutomationCondition*> profileConditions_;
     bool comInitialized_;
+    bool callCancellationEnabled_;
+    HRESULT providerError_;
+    std::function<void()> progress_;
     bool monitoring_;
     HWND lastForegroundWindow_;
     std::function<void(HWND, const std::wstring&)> foregroundWindowChangedCallback_;
+    std::unordered_map<HWND, TreeSnapshot> windowSnapshots_;
+    std::unordered_map<HWND, std::wstring> windowTexts_;
+    TextPatcher textPatcher_;
+    ExtractionContext extraction_;
+    // Numbers this instance's pool names, as every extraction worker has
+    // its own.
+    const uint32_t instanceId_;
+    // This instance's accounts with MemoryGovernor::Instance(), keyed by
+    // window handle; the buffers are one entry.
+    MemoryPool snapshotPool_;
+    MemoryPool textPool_;
+    MemoryPool bufferPool_;
+    std::vector<uint64_t> evictedKeys_;
 
+    // Remembers |hr| as the provider error if it is the first one, and
+    // reports progress otherwise.
+    void NoteResult(HRESULT hr);
     bool InitializeConditions();
+    bool InitializeSnapshotCacheRequest();
+    bool InitializeViewportCacheRequest();
+    bool InitializeProfileCacheRequest();
+    void ReleaseProfileConditions();
+    IUIAutomationCondition* GetProfileCondition(size_t index);
+    const ExtractionProfile* FindProfileForElement(IUIAutomationElement* element, size_t& index);
+    bool HasTextDocument(IUIAutomationElement* root);
+    // Receives a walk's text in document order. Later pages of the same
+    // document arrive with |continued| set. Returning false aborts the walk.
+    using ElementTextSink = std::function<bool(IUIAutomationElement* element, const wchar_t* text,
+                                               size_t length, bool continued)>;
+    // Returns false if the sink aborted the walk.
+    bool StreamElementText(IUIAutomationElement* element, const ElementTextSink& sink);
+    bool StreamTextWithProfile(IUIAutomationElement* root, const ExtractionProfile& profile,
+                               IUIAutomationCondition* condition, const ElementTextSink& sink);
+    void CollectViewportElements(IUIAutomationElement* root, IUIAutomationCondition* condition,
+                                 std::vector<ViewportElement>& layout, std::vector<std::wstring>& texts);
+    void PruneWindowSnapshots();
+    // Ends the extraction begun with extraction_.Begin() and charges what
+    // its buffers retain.
+    void EndExtraction();
+    std::string GetCachedRuntimeIdKey(IUIAutomationElement* element);
+    // What tells an element without a runtime id apart from its siblings:
+    // its AutomationId if it has one, otherwise its control type.
+    std::string GetCachedSiblingSlot(IUIAutomationElement* element);
+    // Walks |element| into extraction_'s arena, elements separated by line
+    // breaks. Must run between extraction_.Begin() and End().
+    void CollectAllText(IUIAutomationElement* element);
+    // Append the element's text to |text|, reading BSTRs in place; the Get
+    // forms return a new string for callers outside the extraction path.
+    void AppendCachedElementText(IUIAutomationElement* element, std::wstring& text);
+    void AppendElementText(IUIAutomationElement* element, std::wstring& text);
+    // Streams the element's TextPattern document, if it has one, to |sink|
+    // page by page and returns whether it was read. |continued| is set once
+    // a page has gone out; |completed| is cleared if the sink aborted.
+    bool StreamDocumentText(IUIAutomationElement* element, const ElementTextSink& sink, bool& continued,
+                            bool& completed);
+    std::wstring GetCachedElementText(IUIAutomationElement* element);
     std::wstring GetElementText(IUIAutomationElement* element);
     std::wstring GetElementName(IUIAutomationElement* element);
-    std::wstring GetElementValue(IUIAutomationElement* element);
-    std::wstring GetElementTextPatternText(IUIAutomationElement* element);
+    bool ReadElementTextPattern(IUIAutomationElement* element, const TextPager::Consumer& consume, size_t maxChars);
 };
 
 #endif
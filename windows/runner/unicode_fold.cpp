@@ -0,0 +1,221 @@
+#include "unicode_fold.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Code points whose matching form differs from themselves, as runs sorted by
+// first code point. A run either maps every code point to one |value|
+// (stride 0) or adds |value| to every code point, or to every second one
+// (stride 2, for alternating upper/lower case blocks). Generated from the
+// Unicode 14.0 character database; see FoldForMatching() for the rules.
+struct FoldRun {
+    uint16_t first;
+    uint16_t last;
+    uint8_t stride;
+    int32_t value;
+};
+
+const FoldRun kFoldRuns[] = {
+    {0x0041, 0x005A, 1, 32}, {0x00AA, 0x00AA, 1, -73}, {0x00AB, 0x00AB, 1, -137},
+    {0x00B5, 0x00B5, 1, 775}, {0x00BA, 0x00BA, 1, -75}, {0x00BB, 0x00BB, 1, -153},
+    {0x00C0, 0x00C5, 0, 97}, {0x00C6, 0x00C6, 1, 32}, {0x00C7, 0x00C7, 1, -100},
+    {0x00C8, 0x00CB, 0, 101}, {0x00CC, 0x00CF, 0, 105}, {0x00D0, 0x00D0, 1, 32},
+    {0x00D1, 0x00D2, 1, -99}, {0x00D3, 0x00D6, 0, 111}, {0x00D8, 0x00D8, 1, -105},
+    {0x00D9, 0x00DC, 0, 117}, {0x00DD, 0x00DD, 1, -100}, {0x00DE, 0x00DE, 1, 32},
+    {0x00E0, 0x00E5, 0, 97}, {0x00E7, 0x00E7, 1, -132}, {0x00E8, 0x00EB, 0, 101},
+    {0x00EC, 0x00EF, 0, 105}, {0x00F1, 0x00F2, 1, -131}, {0x00F3, 0x00F6, 0, 111},
+    {0x00F8, 0x00F8, 1, -137}, {0x00F9, 0x00FC, 0, 117}, {0x00FD, 0x00FD, 1, -132},
+    {0x00FF, 0x00FF, 1, -134}, {0x0100, 0x0105, 0, 97}, {0x0106, 0x010D, 0, 99},
+    {0x010E, 0x0111, 0, 100}, {0x0112, 0x011B, 0, 101}, {0x011C, 0x0123, 0, 103},
+    {0x0124, 0x0127, 0, 104}, {0x0128, 0x0131, 0, 105}, {0x0132, 0x0132, 1, 1},
+    {0x0134, 0x0135, 0, 106}, {0x0136, 0x0137, 0, 107}, {0x0139, 0x013E, 0, 108},
+    {0x013F, 0x013F, 1, 1}, {0x0141, 0x0142, 0, 108}, {0x0143, 0x0148, 0, 110},
+    {0x014A, 0x014A, 1, 1}, {0x014C, 0x0151, 0, 111}, {0x0152, 0x0152, 1, 1},
+    {0x0154, 0x0159, 0, 114}, {0x015A, 0x0161, 0, 115}, {0x0162, 0x0165, 0, 116},
+    {0x0166, 0x0166, 1, 1}, {0x0168, 0x0173, 0, 117}, {0x0174, 0x0175, 0, 119},
+    {0x0176, 0x0178, 0, 121}, {0x0179, 0x017E, 0, 122}, {0x017F, 0x017F, 1, -268},
+    {0x0181, 0x0181, 1, 210}, {0x0182, 0x0184, 2, 1}, {0x0186, 0x0186, 1, 206},
+    {0x0187, 0x0187, 1, 1}, {0x0189, 0x018A, 1, 205}, {0x018B, 0x018B, 1, 1},
+    {0x018E, 0x018E, 1, 79}, {0x018F, 0x018F, 1, 202}, {0x0190, 0x0190, 1, 203},
+    {0x0191, 0x0191, 1, 1}, {0x0193, 0x0193, 1, 205}, {0x0194, 0x0194, 1, 207},
+    {0x0196, 0x0196, 1, 211}, {0x0197, 0x0197, 1, 209}, {0x0198, 0x0198, 1, 1},
+    {0x019C, 0x019C, 1, 211}, {0x019D, 0x019D, 1, 213}, {0x019F, 0x019F, 1, 214},
+    {0x01A0, 0x01A1, 0, 111}, {0x01A2, 0x01A4, 2, 1}, {0x01A6, 0x01A6, 1, 218},
+    {0x01A7, 0x01A7, 1, 1}, {0x01A9, 0x01A9, 1, 218}, {0x01AC, 0x01AC, 1, 1},
+    {0x01AE, 0x01AE, 1, 218}, {0x01AF, 0x01B0, 0, 117}, {0x01B1, 0x01B2, 1, 217},
+    {0x01B3, 0x01B5, 2, 1}, {0x01B7, 0x01B7, 1, 219}, {0x01B8, 0x01B8, 1, 1},
+    {0x01BC, 0x01BC, 1, 1}, {0x01C4, 0x01C5, 0, 454}, {0x01C7, 0x01C8, 0, 457},
+    {0x01CA, 0x01CB, 0, 460}, {0x01CD, 0x01CE, 0, 97}, {0x01CF, 0x01D0, 0, 105},
+    {0x01D1, 0x01D2, 0, 111}, {0x01D3, 0x01DC, 0, 117}, {0x01DE, 0x01E1, 0, 97},
+    {0x01E2, 0x01E3, 0, 230}, {0x01E4, 0x01E4, 1, 1}, {0x01E6, 0x01E7, 0, 103},
+    {0x01E8, 0x01E9, 0, 107}, {0x01EA, 0x01ED, 0, 111}, {0x01EE, 0x01EF, 0, 658},
+    {0x01F0, 0x01F0, 1, -390}, {0x01F1, 0x01F2, 0, 499}, {0x01F4, 0x01F5, 0, 103},
+    {0x01F6, 0x01F6, 1, -97}, {0x01F7, 0x01F7, 1, -56}, {0x01F8, 0x01F9, 0, 110},
+    {0x01FA, 0x01FB, 0, 97}, {0x01FC, 0x01FD, 0, 230}, {0x01FE, 0x01FF, 0, 111},
+    {0x0200, 0x0203, 0, 97}, {0x0204, 0x0207, 0, 101}, {0x0208, 0x020B, 0, 105},
+    {0x020C, 0x020F, 0, 111}, {0x0210, 0x0213, 0, 114}, {0x0214, 0x0217, 0, 117},
+    {0x0218, 0x0219, 0, 115}, {0x021A, 0x021B, 0, 116}, {0x021C, 0x021C, 1, 1},
+    {0x021E, 0x021F, 0, 104}, {0x0220, 0x0220, 1, -130}, {0x0222, 0x0224, 2, 1},
+    {0x0226, 0x0227, 0, 97}, {0x0228, 0x0229, 0, 101}, {0x022A, 0x0231, 0, 111},
+    {0x0232, 0x0233, 0, 121}, {0x023A, 0x023A, 1, 10795}, {0x023B, 0x023B, 1, 1},
+    {0x023D, 0x023D, 1, -163}, {0x023E, 0x023E, 1, 10792}, {0x0241, 0x0241, 1, 1},
+    {0x0243, 0x0243, 1, -195}, {0x0244, 0x0244, 1, 69}, {0x0245, 0x0245, 1, 71},
+    {0x0246, 0x024E, 2, 1}, {0x02B0, 0x02B0, 1, -584}, {0x02B1, 0x02B1, 1, -75},
+    {0x02B2, 0x02B2, 1, -584}, {0x02B3, 0x02B3, 1, -577}, {0x02B4, 0x02B4, 1, -59},
+    {0x02B5, 0x02B5, 1, -58}, {0x02B6, 0x02B6, 1, -53}, {0x02B7, 0x02B7, 1, -576},
+    {0x02B8, 0x02B8, 1, -575}, {0x02BC, 0x02BC, 1, -661}, {0x02E0, 0x02E0, 1, -125},
+    {0x02E1, 0x02E1, 1, -629}, {0x02E2, 0x02E2, 1, -623}, {0x02E3, 0x02E3, 1, -619},
+    {0x02E4, 0x02E4, 1, -79}, {0x0345, 0x0345, 1, 116}, {0x0370, 0x0372, 2, 1},
+    {0x0374, 0x0374, 1, -187}, {0x0376, 0x0376, 1, 1}, {0x037A, 0x037A, 1, -858},
+    {0x037F, 0x037F, 1, 116}, {0x0386, 0x0386, 1, 43}, {0x0388, 0x0388, 1, 45},
+    {0x0389, 0x0389, 1, 46}, {0x038A, 0x038A, 1, 47}, {0x038C, 0x038C, 1, 51},
+    {0x038E, 0x038E, 1, 55}, {0x038F, 0x038F, 1, 58}, {0x0390, 0x0390, 1, 41},
+    {0x0391, 0x03A1, 1, 32}, {0x03A3, 0x03A9, 1, 32}, {0x03AA, 0x03AA, 1, 15},
+    {0x03AB, 0x03AB, 1, 26}, {0x03AC, 0x03AC, 1, 5}, {0x03AD, 0x03AD, 1, 8},
+    {0x03AE, 0x03AE, 1, 9}, {0x03AF, 0x03AF, 1, 10}, {0x03B0, 0x03B0, 1, 21},
+    {0x03C2, 0x03C2, 1, 1}, {0x03CA, 0x03CA, 1, -17}, {0x03CB, 0x03CB, 1, -6},
+    {0x03CC, 0x03CC, 1, -13}, {0x03CD, 0x03CD, 1, -8}, {0x03CE, 0x03CE, 1, -5},
+    {0x03CF, 0x03CF, 1, 8}, {0x03D0, 0x03D0, 1, -30}, {0x03D1, 0x03D1, 1, -25},
+    {0x03D2, 0x03D4, 0, 965}, {0x03D5, 0x03D5, 1, -15}, {0x03D6, 0x03D6, 1, -22},
+    {0x03D8, 0x03EE, 2, 1}, {0x03F0, 0x03F0, 1, -54}, {0x03F1, 0x03F1, 1, -48},
+    {0x03F2, 0x03F2, 1, -47}, {0x03F4, 0x03F4, 1, -60}, {0x03F5, 0x03F5, 1, -64},
+    {0x03F7, 0x03F7, 1, 1}, {0x03F9, 0x03F9, 1, -54}, {0x03FA, 0x03FA, 1, 1},
+    {0x03FD, 0x03FF, 1, -130}, {0x0400, 0x0401, 0, 1077}, {0x0402, 0x0402, 1, 80},
+    {0x0403, 0x0403, 1, 48}, {0x0404, 0x0406, 1, 80}, {0x0407, 0x0407, 1, 79},
+    {0x0408, 0x040B, 1, 80}, {0x040C, 0x040C, 1, 46}, {0x040D, 0x040D, 1, 43},
+    {0x040E, 0x040E, 1, 53}, {0x040F, 0x040F, 1, 80}, {0x0410, 0x0418, 1, 32},
+    {0x0419, 0x0419, 1, 31}, {0x041A, 0x042F, 1, 32}, {0x0439, 0x0439, 1, -1},
+    {0x0450, 0x0451, 0, 1077}, {0x0453, 0x0453, 1, -32}, {0x0457, 0x0457, 1, -1},
+    {0x045C, 0x045C, 1, -34}, {0x045D, 0x045D, 1, -37}, {0x045E, 0x045E, 1, -27},
+    {0x0460, 0x0474, 2, 1}, {0x0476, 0x0477, 0, 1141}, {0x0478, 0x0480, 2, 1},
+    {0x048A, 0x04BE, 2, 1}, {0x04C0, 0x04C0, 1, 15}, {0x04C1, 0x04C2, 0, 1078},
+    {0x04C3, 0x04CD, 2, 1}, {0x04D0, 0x04D3, 0, 1072}, {0x04D4, 0x04D4, 1, 1},
+    {0x04D6, 0x04D7, 0, 1077}, {0x04D8, 0x04D8, 1, 1}, {0x04DA, 0x04DB, 0, 1241},
+    {0x04DC, 0x04DD, 0, 1078}, {0x04DE, 0x04DF, 0, 1079}, {0x04E0, 0x04E0, 1, 1},
+    {0x04E2, 0x04E5, 0, 1080}, {0x04E6, 0x04E7, 0, 1086}, {0x04E8, 0x04E8, 1, 1},
+    {0x04EA, 0x04EB, 0, 1257}, {0x04EC, 0x04ED, 0, 1101}, {0x04EE, 0x04F3, 0, 1091},
+    {0x04F4, 0x04F5, 0, 1095}, {0x04F6, 0x04F6, 1, 1}, {0x04F8, 0x04F9, 0, 1099},
+    {0x04FA, 0x052E, 2, 1}, {0x0531, 0x0556, 1, 48}, {0x10A0, 0x10C5, 1, 7264},
+    {0x10C7, 0x10C7, 1, 7264}, {0x10CD, 0x10CD, 1, 7264}, {0x13F8, 0x13FD, 1, -8},
+    {0x1C80, 0x1C80, 1, -6222}, {0x1C81, 0x1C81, 1, -6221}, {0x1C82, 0x1C82, 1, -6212},
+    {0x1C83, 0x1C84, 1, -6210}, {0x1C85, 0x1C85, 1, -6211}, {0x1C86, 0x1C86, 1, -6204},
+    {0x1C87, 0x1C87, 1, -6180}, {0x1C88, 0x1C88, 1, 35267}, {0x1C90, 0x1CBA, 1, -3008},
+    {0x1CBD, 0x1CBF, 1, -3008}, {0x1D2C, 0x1D2C, 1, -7371}, {0x1D2D, 0x1D2D, 1, -7239},
+    {0x1D2E, 0x1D30, 2, -7372}, {0x1D31, 0x1D31, 1, -7372}, {0x1D32, 0x1D32, 1, -6997},
+    {0x1D33, 0x1D3A, 1, -7372}, {0x1D3C, 0x1D3C, 1, -7373}, {0x1D3D, 0x1D3D, 1, -6938},
+    {0x1D3E, 0x1D3E, 1, -7374}, {0x1D3F, 0x1D3F, 1, -7373}, {0x1D40, 0x1D41, 1, -7372},
+    {0x1D42, 0x1D42, 1, -7371}, {0x1D43, 0x1D43, 1, -7394}, {0x1D44, 0x1D45, 1, -6900},
+    {0x1D47, 0x1D47, 1, -7397}, {0x1D48, 0x1D49, 1, -7396}, {0x1D4A, 0x1D4A, 1, -6897},
+    {0x1D4B, 0x1D4C, 1, -6896}, {0x1D4D, 0x1D4D, 1, -7398}, {0x1D4F, 0x1D4F, 1, -7396},
+    {0x1D50, 0x1D50, 1, -7395}, {0x1D51, 0x1D51, 1, -7174}, {0x1D52, 0x1D52, 1, -7395},
+    {0x1D53, 0x1D53, 1, -6911}, {0x1D56, 0x1D56, 1, -7398}, {0x1D57, 0x1D58, 1, -7395},
+    {0x1D5A, 0x1D5A, 1, -6891}, {0x1D5B, 0x1D5B, 1, -7397}, {0x1D5D, 0x1D5F, 1, -6571},
+    {0x1D60, 0x1D61, 1, -6554}, {0x1D62, 0x1D62, 1, -7417}, {0x1D63, 0x1D63, 1, -7409},
+    {0x1D64, 0x1D65, 1, -7407}, {0x1D66, 0x1D67, 1, -6580}, {0x1D68, 0x1D68, 1, -6567},
+    {0x1D69, 0x1D6A, 1, -6563}, {0x1D78, 0x1D78, 1, -6459}, {0x1D9B, 0x1D9B, 1, -6985},
+    {0x1D9C, 0x1D9C, 1, -7481}, {0x1D9D, 0x1D9D, 1, -6984}, {0x1D9E, 0x1D9E, 1, -7342},
+    {0x1D9F, 0x1D9F, 1, -6979}, {0x1DA0, 0x1DA0, 1, -7482}, {0x1DA1, 0x1DA1, 1, -6978},
+    {0x1DA2, 0x1DA2, 1, -6977}, {0x1DA3, 0x1DA3, 1, -6974}, {0x1DA4, 0x1DA6, 1, -6972},
+    {0x1DA8, 0x1DA8, 1, -6923}, {0x1DA9, 0x1DA9, 1, -6972}, {0x1DAB, 0x1DAB, 1, -6924},
+    {0x1DAC, 0x1DAC, 1, -6971}, {0x1DAD, 0x1DAD, 1, -6973}, {0x1DAE, 0x1DB1, 1, -6972},
+    {0x1DB2, 0x1DB2, 1, -6970}, {0x1DB3, 0x1DB4, 1, -6961}, {0x1DB5, 0x1DB5, 1, -7178},
+    {0x1DB6, 0x1DB7, 1, -6957}, {0x1DB9, 0x1DBA, 1, -6958}, {0x1DBB, 0x1DBB, 1, -7489},
+    {0x1DBC, 0x1DBE, 1, -6956}, {0x1DBF, 0x1DBF, 1, -6663}, {0x1E00, 0x1E01, 0, 97},
+    {0x1E02, 0x1E07, 0, 98}, {0x1E08, 0x1E09, 0, 99}, {0x1E0A, 0x1E13, 0, 100},
+    {0x1E14, 0x1E1D, 0, 101}, {0x1E1E, 0x1E1F, 0, 102}, {0x1E20, 0x1E21, 0, 103},
+    {0x1E22, 0x1E2B, 0, 104}, {0x1E2C, 0x1E2F, 0, 105}, {0x1E30, 0x1E35, 0, 107},
+    {0x1E36, 0x1E3D, 0, 108}, {0x1E3E, 0x1E43, 0, 109}, {0x1E44, 0x1E4B, 0, 110},
+    {0x1E4C, 0x1E53, 0, 111}, {0x1E54, 0x1E57, 0, 112}, {0x1E58, 0x1E5F, 0, 114},
+    {0x1E60, 0x1E69, 0, 115}, {0x1E6A, 0x1E71, 0, 116}, {0x1E72, 0x1E7B, 0, 117},
+    {0x1E7C, 0x1E7F, 0, 118}, {0x1E80, 0x1E89, 0, 119}, {0x1E8A, 0x1E8D, 0, 120},
+    {0x1E8E, 0x1E8F, 0, 121}, {0x1E90, 0x1E95, 0, 122}, {0x1E96, 0x1E96, 1, -7726},
+    {0x1E97, 0x1E97, 1, -7715}, {0x1E98, 0x1E98, 1, -7713}, {0x1E99, 0x1E99, 1, -7712},
+    {0x1E9B, 0x1E9B, 1, -7720}, {0x1E9E, 0x1E9E, 1, -7615}, {0x1EA0, 0x1EB7, 0, 97},
+    {0x1EB8, 0x1EC7, 0, 101}, {0x1EC8, 0x1ECB, 0, 105}, {0x1ECC, 0x1EE3, 0, 111},
+    {0x1EE4, 0x1EF1, 0, 117}, {0x1EF2, 0x1EF9, 0, 121}, {0x1EFA, 0x1EFE, 2, 1},
+    {0x1F00, 0x1F0F, 0, 945}, {0x1F10, 0x1F15, 0, 949}, {0x1F18, 0x1F1D, 0, 949},
+    {0x1F20, 0x1F2F, 0, 951}, {0x1F30, 0x1F3F, 0, 953}, {0x1F40, 0x1F45, 0, 959},
+    {0x1F48, 0x1F4D, 0, 959}, {0x1F50, 0x1F57, 0, 965}, {0x1F59, 0x1F59, 1, -7060},
+    {0x1F5B, 0x1F5B, 1, -7062}, {0x1F5D, 0x1F5D, 1, -7064}, {0x1F5F, 0x1F5F, 1, -7066},
+    {0x1F60, 0x1F6F, 0, 969}, {0x1F70, 0x1F71, 0, 945}, {0x1F72, 0x1F73, 0, 949},
+    {0x1F74, 0x1F75, 0, 951}, {0x1F76, 0x1F77, 0, 953}, {0x1F78, 0x1F79, 0, 959},
+    {0x1F7A, 0x1F7B, 0, 965}, {0x1F7C, 0x1F7D, 0, 969}, {0x1F80, 0x1F8F, 0, 945},
+    {0x1F90, 0x1F9F, 0, 951}, {0x1FA0, 0x1FAF, 0, 969}, {0x1FB0, 0x1FB4, 0, 945},
+    {0x1FB6, 0x1FBC, 0, 945}, {0x1FBE, 0x1FBE, 1, -7173}, {0x1FC2, 0x1FC4, 0, 951},
+    {0x1FC6, 0x1FC7, 0, 951}, {0x1FC8, 0x1FC9, 0, 949}, {0x1FCA, 0x1FCC, 0, 951},
+    {0x1FD0, 0x1FD3, 0, 953}, {0x1FD6, 0x1FDB, 0, 953}, {0x1FE0, 0x1FE3, 0, 965},
+    {0x1FE4, 0x1FE5, 0, 961}, {0x1FE6, 0x1FEB, 0, 965}, {0x1FEC, 0x1FEC, 1, -7211},
+    {0x1FF2, 0x1FF4, 0, 969}, {0x1FF6, 0x1FF7, 0, 969}, {0x1FF8, 0x1FF9, 0, 959},
+    {0x1FFA, 0x1FFC, 0, 969}, {0x2018, 0x2019, 0, 39}, {0x201C, 0x201E, 0, 34},
+    {0x2071, 0x2071, 1, -8200}, {0x207F, 0x207F, 1, -8209}, {0x2090, 0x2090, 1, -8239},
+    {0x2091, 0x2091, 1, -8236}, {0x2092, 0x2092, 1, -8227}, {0x2093, 0x2093, 1, -8219},
+    {0x2094, 0x2094, 1, -7739}, {0x2095, 0x2095, 1, -8237}, {0x2096, 0x2099, 1, -8235},
+    {0x209A, 0x209A, 1, -8234}, {0x209B, 0x209C, 1, -8232}, {0x2102, 0x2102, 1, -8351},
+    {0x2107, 0x2107, 1, -7852}, {0x210A, 0x210B, 1, -8355}, {0x210C, 0x210F, 0, 104},
+    {0x2110, 0x2111, 0, 105}, {0x2112, 0x2113, 0, 108}, {0x2115, 0x2115, 1, -8359},
+    {0x2119, 0x211B, 1, -8361}, {0x211C, 0x211D, 0, 114}, {0x2124, 0x2124, 1, -8362},
+    {0x2126, 0x2126, 1, -7517}, {0x2128, 0x2128, 1, -8366}, {0x212A, 0x212A, 1, -8383},
+    {0x212B, 0x212D, 1, -8394}, {0x212F, 0x2130, 0, 101}, {0x2131, 0x2131, 1, -8395},
+    {0x2132, 0x2132, 1, 28}, {0x2133, 0x2133, 1, -8390}, {0x2134, 0x2134, 1, -8389},
+    {0x2139, 0x2139, 1, -8400}, {0x213C, 0x213C, 1, -7548}, {0x213D, 0x213E, 0, 947},
+    {0x213F, 0x213F, 1, -7551}, {0x2145, 0x2146, 0, 100}, {0x2147, 0x2147, 1, -8418},
+    {0x2148, 0x2149, 1, -8415}, {0x2160, 0x216F, 1, 16}, {0x2183, 0x2183, 1, 1},
+    {0x24B6, 0x24CF, 1, 26}, {0x2C00, 0x2C2F, 1, 48}, {0x2C60, 0x2C60, 1, 1},
+    {0x2C62, 0x2C62, 1, -10743}, {0x2C63, 0x2C63, 1, -3814}, {0x2C64, 0x2C64, 1, -10727},
+    {0x2C67, 0x2C6B, 2, 1}, {0x2C6D, 0x2C6D, 1, -10780}, {0x2C6E, 0x2C6E, 1, -10749},
+    {0x2C6F, 0x2C6F, 1, -10783}, {0x2C70, 0x2C70, 1, -10782}, {0x2C72, 0x2C72, 1, 1},
+    {0x2C75, 0x2C75, 1, 1}, {0x2C7C, 0x2C7C, 1, -11282}, {0x2C7D, 0x2C7D, 1, -11271},
+    {0x2C7E, 0x2C7F, 1, -10815}, {0x2C80, 0x2CE2, 2, 1}, {0x2CEB, 0x2CED, 2, 1},
+    {0x2CF2, 0x2CF2, 1, 1}, {0xA640, 0xA66C, 2, 1}, {0xA680, 0xA69A, 2, 1},
+    {0xA69C, 0xA69C, 1, -41554}, {0xA69D, 0xA69D, 1, -41553}, {0xA722, 0xA72E, 2, 1},
+    {0xA732, 0xA76E, 2, 1}, {0xA779, 0xA77B, 2, 1}, {0xA77D, 0xA77D, 1, -35332},
+    {0xA77E, 0xA786, 2, 1}, {0xA78B, 0xA78B, 1, 1}, {0xA78D, 0xA78D, 1, -42280},
+    {0xA790, 0xA792, 2, 1}, {0xA796, 0xA7A8, 2, 1}, {0xA7AA, 0xA7AA, 1, -42308},
+    {0xA7AB, 0xA7AB, 1, -42319}, {0xA7AC, 0xA7AC, 1, -42315}, {0xA7AD, 0xA7AD, 1, -42305},
+    {0xA7AE, 0xA7AE, 1, -42308}, {0xA7B0, 0xA7B0, 1, -42258}, {0xA7B1, 0xA7B1, 1, -42282},
+    {0xA7B2, 0xA7B2, 1, -42261}, {0xA7B3, 0xA7B3, 1, 928}, {0xA7B4, 0xA7C2, 2, 1},
+    {0xA7C4, 0xA7C4, 1, -48}, {0xA7C5, 0xA7C5, 1, -42307}, {0xA7C6, 0xA7C6, 1, -35384},
+    {0xA7C7, 0xA7C9, 2, 1}, {0xA7D0, 0xA7D0, 1, 1}, {0xA7D6, 0xA7D8, 2, 1},
+    {0xA7F2, 0xA7F2, 1, -42895}, {0xA7F3, 0xA7F3, 1, -42893}, {0xA7F4, 0xA7F4, 1, -42883},
+    {0xA7F5, 0xA7F5, 1, 1}, {0xA7F8, 0xA7F8, 1, -42896}, {0xA7F9, 0xA7F9, 1, -42662},
+    {0xAB5E, 0xAB5E, 1, -43251}, {0xAB69, 0xAB69, 1, -43228}, {0xAB70, 0xABBF, 1, -38864},
+    {0xFC5E, 0xFC63, 0, 32}, {0xFE70, 0xFE70, 1, -65104}, {0xFE72, 0xFE72, 1, -65106},
+    {0xFE74, 0xFE74, 1, -65108}, {0xFE76, 0xFE76, 1, -65110}, {0xFE78, 0xFE78, 1, -65112},
+    {0xFE7A, 0xFE7A, 1, -65114}, {0xFE7C, 0xFE7C, 1, -65116}, {0xFE7E, 0xFE7E, 1, -65118},
+    {0xFF21, 0xFF3A, 1, -65216}, {0xFF41, 0xFF5A, 1, -65248},
+};
+
+}  // namespace
+
+uint32_t FoldForMatching(uint32_t codePoint) {
+    if (codePoint < 0x41 || codePoint > 0xFFFF) return codePoint;
+    // Last run starting at or before the code point.
+    const FoldRun* run = std::upper_bound(
+        std::begin(kFoldRuns), std::end(kFoldRuns), codePoint,
+        [](uint32_t value, const FoldRun& candidate) { return value < candidate.first; });
+    if (run == std::begin(kFoldRuns)) return codePoint;
+    --run;
+    if (codePoint > run->last) return codePoint;
+    if (run->stride == 0) return static_cast<uint32_t>(run->value);
+    if (run->stride == 2 && ((codePoint - run->first) & 1) != 0) return codePoint;
+    return static_cast<uint32_t>(static_cast<int32_t>(codePoint) + run->value);
+}
+
+bool IsMatchingSpace(uint32_t codePoint) {
+    if (codePoint <= 0x20) return codePoint == 0x20 || (codePoint >= 0x09 && codePoint <= 0x0D);
+    if (codePoint < 0x85) return false;
+    return codePoint == 0x85 || codePoint == 0xA0 || codePoint == 0x1680 ||
+           (codePoint >= 0x2000 && codePoint <= 0x200A) || codePoint == 0x2028 || codePoint == 0x2029 ||
+           codePoint == 0x202F || codePoint == 0x205F || codePoint == 0x3000;
+}
+
+bool IsMatchingIgnorable(uint32_t codePoint) {
+    if (codePoint < 0xAD) return false;
+    return codePoint == 0xAD || (codePoint >= 0x0300 && codePoint <= 0x036F) ||
+           (codePoint >= 0x1AB0 && codePoint <= 0x1AFF) || (codePoint >= 0x1DC0 && codePoint <= 0x1DFF) ||
+           (codePoint >= 0x200B && codePoint <= 0x200D) || codePoint == 0x2060 ||
+           (codePoint >= 0x20D0 && codePoint <= 0x20FF) || (codePoint >= 0xFE20 && codePoint <= 0xFE2F) ||
+           codePoint == 0xFEFF;
+}
@@ -0,0 +1,28 @@
+#ifndef RUNNER_UNICODE_FOLD_H_
+#define RUNNER_UNICODE_FOLD_H_
+
+#include <cstdint>
+
+// Character equivalence used for keyword matching. Case and accents are
+// ignored the same way for every language, independent of the C runtime
+// locale, so "DATENSCHUTZERKLÄRUNG", "Datenschutzerklarung" and a decomposed
+// "Datenschutzerklärung" all read alike.
+
+// Maps a BMP code point to its matching form: Unicode simple case folding
+// (Σ and ς to σ, ẞ to ß, İ and I to i), then compatibility decomposition
+// with the diacritics dropped for Latin, Greek and Cyrillic letters and
+// fullwidth forms (É to e, ά to α, ё to е, Ａ to a). Letters that readers
+// treat as accented forms but that have no decomposition (ı ø ł đ ħ) fold
+// to their base letter, and typographic quotes to ASCII quotes. Other code
+// points map to themselves.
+uint32_t FoldForMatching(uint32_t codePoint);
+
+// Unicode white space, which matches a single space in a phrase.
+bool IsMatchingSpace(uint32_t codePoint);
+
+// Combining marks and invisible format characters (soft hyphen, zero-width
+// space and joiners, word joiner, byte order mark) that matching skips, so
+// decomposed accents and hyphenation hints do not split a phrase.
+bool IsMatchingIgnorable(uint32_t codePoint);
+
+#endif
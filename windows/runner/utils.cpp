@@ -5,7 +5,9 @@
 #include <stdio.h>
 #include <windows.h>
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 
 void CreateAndAttachConsole() {
   if (::AllocConsole()) {
@@ -63,3 +65,25 @@ std::string Utf8FromUtf16(const wchar_t* utf16_string) {
   }
   return utf8_string;
 }
+
+std::wstring GetExecutableDirectory() {
+  wchar_t module_path[MAX_PATH] = {0};
+  const DWORD length = ::GetModuleFileNameW(nullptr, module_path, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::wstring();
+  }
+  std::wstring directory(module_path, length);
+  directory.erase(directory.find_last_of(L'\\') + 1);
+  return directory;
+}
+
+bool ReadFileContents(const std::wstring& path, std::string& contents) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  contents = stream.str();
+  return true;
+}
@@ -16,4 +16,12 @@ std::string Utf8FromUtf16(const wchar_t* utf16_string);
 // encoded in UTF-8. Returns an empty std::vector<std::string> on failure.
 std::vector<std::string> GetCommandLineArguments();
 
+// Returns the directory containing the running executable, with a trailing
+// backslash. Returns an empty std::wstring on failure.
+std::wstring GetExecutableDirectory();
+
+// Reads the whole file at |path| into |contents|. Returns false if the file
+// cannot be read.
+bool ReadFileContents(const std::wstring& path, std::string& contents);
+
 #endif  // RUNNER_UTILS_H_
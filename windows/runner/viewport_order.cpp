@@ -0,0 +1,136 @@
+#include "viewport_order.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+constexpr int kMinStripHeight = 64;
+constexpr int kDefaultViewportHeight = 1024;
+// Anything further than this from the viewport is treated as having no
+// usable position; some providers report sentinel coordinates.
+constexpr int64_t kMaxScrollDistance = 1 << 20;
+
+}  // namespace
+
+int ViewportOrder::StripOf(int y) const {
+    const int64_t value = y;
+    const int64_t height = stripHeight_;
+    const int64_t strip = value >= 0 ? value / height : -((-value + height - 1) / height);
+    return static_cast<int>(strip);
+}
+
+void ViewportOrder::Build(const std::vector<ViewportElement>& elements, const ViewportRect& viewport) {
+    elements_ = &elements;
+    viewport_ = viewport;
+    strips_.clear();
+    unplaced_.clear();
+    deferred_.clear();
+    emitted_.assign(elements.size(), false);
+    remaining_ = elements.size();
+    band_ = 0;
+
+    const int viewportHeight = viewport.IsEmpty() ? kDefaultViewportHeight : viewport.bottom - viewport.top;
+    stripHeight_ = std::max(kMinStripHeight, viewportHeight / 2);
+    stripsPerBand_ = std::max(1, (viewportHeight + stripHeight_ - 1) / stripHeight_);
+
+    const int64_t lowLimit = static_cast<int64_t>(viewport.top) - kMaxScrollDistance;
+    const int64_t highLimit = static_cast<int64_t>(viewport.bottom) + kMaxScrollDistance;
+
+    int minStrip = StripOf(viewport.top);
+    int maxStrip = viewport.IsEmpty() ? minStrip : StripOf(viewport.bottom - 1);
+    for (const auto& element : elements) {
+        const ViewportRect& r = element.bounds;
+        if (r.IsEmpty() || r.bottom <= lowLimit || r.top >= highLimit) continue;
+        minStrip = std::min(minStrip, StripOf(static_cast<int>(std::max<int64_t>(r.top, lowLimit))));
+        maxStrip = std::max(maxStrip, StripOf(static_cast<int>(std::min<int64_t>(r.bottom, highLimit) - 1)));
+    }
+
+    firstStrip_ = minStrip;
+    strips_.resize(static_cast<size_t>(maxStrip - minStrip + 1));
+    for (size_t i = 0; i < elements.size(); i++) {
+        const ViewportRect& r = elements[i].bounds;
+        if (r.IsEmpty() || r.bottom <= lowLimit || r.top >= highLimit) {
+            unplaced_.push_back(i);
+            continue;
+        }
+        const int top = StripOf(static_cast<int>(std::max<int64_t>(r.top, lowLimit)));
+        const int bottom = StripOf(static_cast<int>(std::min<int64_t>(r.bottom, highLimit) - 1));
+        for (int strip = top; strip <= bottom; strip++) {
+            strips_[static_cast<size_t>(strip - firstStrip_)].push_back(i);
+        }
+    }
+
+    // Strips scanned so far, as a half-open range of relative indices.
+    coveredTop_ = StripOf(viewport.top) - firstStrip_;
+    coveredBottom_ = coveredTop_;
+}
+
+void ViewportOrder::CollectStrip(int strip, std::vector<size_t>& indices) {
+    for (size_t index : strips_[static_cast<size_t>(strip)]) {
+        if (emitted_[index]) continue;
+        emitted_[index] = true;
+        indices.push_back(index);
+    }
+}
+
+bool ViewportOrder::NextBand(std::vector<size_t>& indices) {
+    indices.clear();
+    if (!elements_ || remaining_ == 0) return false;
+
+    const int stripCount = static_cast<int>(strips_.size());
+    while (indices.empty() && remaining_ > 0) {
+        if (band_ == 0) {
+            if (!viewport_.IsEmpty()) {
+                const int top = StripOf(viewport_.top) - firstStrip_;
+                const int bottom = StripOf(viewport_.bottom - 1) - firstStrip_ + 1;
+                for (int strip = top; strip < bottom; strip++) {
+                    for (size_t index : strips_[static_cast<size_t>(strip)]) {
+                        if (emitted_[index]) continue;
+                        const ViewportElement& element = (*elements_)[index];
+                        if (!element.offscreen && element.bounds.Intersects(viewport_)) {
+                            emitted_[index] = true;
+                            indices.push_back(index);
+                        } else {
+                            deferred_.push_back(index);
+                        }
+                    }
+                }
+                coveredTop_ = top;
+                coveredBottom_ = bottom;
+            }
+        } else if (coveredTop_ > 0 || coveredBottom_ < stripCount) {
+            for (size_t index : deferred_) {
+                if (emitted_[index]) continue;
+                emitted_[index] = true;
+                indices.push_back(index);
+            }
+            deferred_.clear();
+
+            // Widen by one viewport height in each direction.
+            for (int step = 0; step < stripsPerBand_; step++) {
+                if (coveredTop_ > 0) CollectStrip(--coveredTop_, indices);
+                if (coveredBottom_ < stripCount) CollectStrip(coveredBottom_++, indices);
+            }
+        } else {
+            for (size_t index : deferred_) {
+                if (emitted_[index]) continue;
+                emitted_[index] = true;
+                indices.push_back(index);
+            }
+            deferred_.clear();
+            for (size_t index : unplaced_) {
+                if (emitted_[index]) continue;
+                emitted_[index] = true;
+                indices.push_back(index);
+            }
+            band_++;
+            break;
+        }
+        band_++;
+    }
+
+    std::sort(indices.begin(), indices.end());
+    remaining_ -= indices.size();
+    return !indices.empty();
+}
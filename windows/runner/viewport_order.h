@@ -0,0 +1,62 @@
+#ifndef RUNNER_VIEWPORT_ORDER_H_
+#define RUNNER_VIEWPORT_ORDER_H_
+
+#include <cstddef>
+#include <vector>
+
+// Screen rectangle in physical pixels, right/bottom exclusive like RECT.
+struct ViewportRect {
+    int left = 0;
+    int top = 0;
+    int right = 0;
+    int bottom = 0;
+
+    bool IsEmpty() const { return right <= left || bottom <= top; }
+    bool Intersects(const ViewportRect& other) const {
+        return left < other.right && other.left < right && top < other.bottom && other.top < bottom;
+    }
+};
+
+struct ViewportElement {
+    ViewportRect bounds;
+    bool offscreen = false;
+};
+
+// Orders elements for visibility-first extraction. The first band holds the
+// elements that are on screen and intersect the viewport; each following band
+// widens the covered area by one viewport height above and below, so text is
+// produced in the order a reader would scroll to it. Elements without usable
+// bounds come last. Within a band, elements keep their document order.
+//
+// Elements are bucketed into horizontal strips, so each band only touches the
+// strips it newly covers rather than rescanning the whole tree.
+class ViewportOrder {
+public:
+    void Build(const std::vector<ViewportElement>& elements, const ViewportRect& viewport);
+
+    // Fills |indices| with the next band. Returns false once every element
+    // has been handed out.
+    bool NextBand(std::vector<size_t>& indices);
+
+    size_t Remaining() const { return remaining_; }
+
+private:
+    int StripOf(int y) const;
+    void CollectStrip(int strip, std::vector<size_t>& indices);
+
+    const std::vector<ViewportElement>* elements_ = nullptr;
+    ViewportRect viewport_;
+    int stripHeight_ = 1;
+    int stripsPerBand_ = 1;
+    int firstStrip_ = 0;
+    std::vector<std::vector<size_t>> strips_;
+    std::vector<size_t> unplaced_;
+    std::vector<size_t> deferred_;
+    std::vector<bool> emitted_;
+    size_t remaining_ = 0;
+    int band_ = 0;
+    int coveredTop_ = 0;
+    int coveredBottom_ = 0;
+};
+
+#endif